@@ -0,0 +1,398 @@
+#include "calibration_transfer.h"
+#include "protocol_adapter_refactored.h"
+#include "protocol/state/calibration_snapshot.h"
+#include <QDebug>
+#include <QPointer>
+
+namespace Protocol {
+
+// 常量定义
+const int CalibrationTransfer::DEFAULT_WINDOW_SIZE = 4;
+const int CalibrationTransfer::DEFAULT_MAX_RETRIES = 2;
+
+CalibrationTransfer::CalibrationTransfer(ProtocolAdapterRefactored* adapter, QObject* parent)
+    : QObject(parent)
+    , adapter_(adapter)
+    , mode_(Mode::Transfer)
+    , running_(false)
+    , pumping_(false)
+    , generation_(0)
+    , inFlight_(0)
+    , windowSize_(DEFAULT_WINDOW_SIZE)
+    , maxRetries_(DEFAULT_MAX_RETRIES)
+    , messageTimeoutMs_(0)
+    , skipUnchanged_(true)
+    , autoRollback_(true)
+{
+}
+
+CalibrationTransfer::~CalibrationTransfer() {
+    if (running_) {
+        cancelInFlight();
+    }
+}
+
+QList<MessageType> CalibrationTransfer::calibrationMessageTypes() {
+    // 阶次开关先于阶次参数，系统范围先于滤波器范围
+    return {
+        MessageType::ORDER_FLAG,
+        MessageType::ORDER2_PARAMS,
+        MessageType::ORDER4_PARAMS,
+        MessageType::ORDER6_PARAMS,
+        MessageType::ALPHA_PARAMS,
+        MessageType::FREQ_DIVISION,
+        MessageType::THRESHOLDS,
+        MessageType::SYSTEM_RANGES,
+        MessageType::FILTER_RANGES
+    };
+}
+
+CalibrationTransfer::Calibration CalibrationTransfer::currentCalibration() const {
+    Calibration calibration;
+    if (!adapter_) {
+        return calibration;
+    }
+
+    for (MessageType messageType : calibrationMessageTypes()) {
+        QVariantMap parameters;
+        if (adapter_->cachedParameters(messageType, parameters)) {
+            calibration.insert(messageType, parameters);
+        }
+    }
+    return calibration;
+}
+
+void CalibrationTransfer::setWindowSize(int messages) {
+    if (messages <= 0) {
+        qWarning() << "Invalid calibration transfer window size:" << messages;
+        return;
+    }
+    windowSize_ = messages;
+}
+
+void CalibrationTransfer::setMaxRetries(int retries) {
+    if (retries < 0) {
+        qWarning() << "Invalid calibration transfer retry count:" << retries;
+        return;
+    }
+    maxRetries_ = retries;
+}
+
+void CalibrationTransfer::setMessageTimeout(int ms) {
+    if (ms < 0) {
+        qWarning() << "Invalid calibration transfer timeout:" << ms;
+        return;
+    }
+    messageTimeoutMs_ = ms;
+}
+
+bool CalibrationTransfer::start(const Calibration& target) {
+    if (running_) {
+        qWarning() << "Calibration transfer already running";
+        return false;
+    }
+
+    if (!adapter_ || !adapter_->isConnected()) {
+        qWarning() << "Calibration transfer requires a connected adapter";
+        return false;
+    }
+
+    QList<Item> plan;
+    int skipped = 0;
+    QString error;
+    if (!buildPlan(target, skipUnchanged_, plan, skipped, error)) {
+        qWarning() << "Calibration transfer rejected:" << error;
+        result_ = Result();
+        result_.error = error;
+        return false;
+    }
+
+    // 回滚快照：只能恢复影子状态已知的消息
+    snapshot_.clear();
+    touched_.clear();
+    for (const Item& item : plan) {
+        QVariantMap original;
+        if (adapter_->cachedParameters(item.messageType, original)) {
+            snapshot_.insert(item.messageType, original);
+        } else {
+            qWarning() << "No known device state for" << MessageTypeUtils::toString(item.messageType)
+                       << "- it cannot be rolled back";
+        }
+    }
+
+    qInfo() << "Calibration transfer started:" << plan.size() << "messages to send,"
+            << skipped << "unchanged";
+
+    begin(Mode::Transfer, plan, skipped);
+    return true;
+}
+
+bool CalibrationTransfer::start(const CalibrationSnapshot& snapshot) {
+    if (!adapter_ || !adapter_->messageSerializer()) {
+        qWarning() << "Calibration transfer requires an adapter";
+        return false;
+    }
+
+    Calibration target = snapshot.toParameters(*adapter_->messageSerializer());
+    if (target.isEmpty()) {
+        qWarning() << "Calibration snapshot contains no transferable messages";
+        return false;
+    }
+    return start(target);
+}
+
+void CalibrationTransfer::abort() {
+    if (!running_) {
+        return;
+    }
+
+    cancelInFlight();
+    fail("Aborted", false);
+}
+
+bool CalibrationTransfer::rollback() {
+    if (running_) {
+        qWarning() << "Cannot roll back while a transfer is running";
+        return false;
+    }
+
+    if (!adapter_ || !adapter_->isConnected()) {
+        qWarning() << "Calibration rollback requires a connected adapter";
+        return false;
+    }
+
+    Calibration original;
+    for (MessageType messageType : touched_) {
+        auto it = snapshot_.constFind(messageType);
+        if (it != snapshot_.constEnd()) {
+            original.insert(messageType, it.value());
+        }
+    }
+
+    // 失败的消息设备上的值未知，不做差异比较，全部重发
+    QList<Item> plan;
+    int skipped = 0;
+    QString error;
+    if (!buildPlan(original, false, plan, skipped, error)) {
+        qWarning() << "Calibration rollback rejected:" << error;
+        emit rollbackFinished(false, error);
+        return false;
+    }
+
+    qInfo() << "Calibration rollback started:" << plan.size() << "messages";
+    begin(Mode::Rollback, plan, skipped);
+    return true;
+}
+
+bool CalibrationTransfer::buildPlan(const Calibration& target, bool diff, QList<Item>& plan,
+                                    int& skipped, QString& error) const {
+    MessageSerializer* serializer = adapter_->messageSerializer();
+
+    // 标定消息按固定顺序发送，其余消息类型排在后面
+    QList<MessageType> order;
+    for (MessageType messageType : calibrationMessageTypes()) {
+        if (target.contains(messageType)) {
+            order.append(messageType);
+        }
+    }
+    for (auto it = target.constBegin(); it != target.constEnd(); ++it) {
+        if (!order.contains(it.key())) {
+            order.append(it.key());
+        }
+    }
+
+    for (MessageType messageType : order) {
+        // 与设备已知值合并为完整消息，未给出的字段保持原值
+        QVariantMap cached;
+        const bool known = adapter_->cachedParameters(messageType, cached);
+        QVariantMap parameters = cached;
+        const QVariantMap& requested = target.value(messageType);
+        for (auto it = requested.constBegin(); it != requested.constEnd(); ++it) {
+            parameters.insert(it.key(), it.value());
+        }
+
+        if (diff && known && parameters == cached) {
+            skipped++;
+            continue;
+        }
+
+        Item item;
+        item.messageType = messageType;
+        item.parameters = parameters;
+        item.payload = serializer->serialize(messageType, parameters);
+        if (item.payload.isNull()) {
+            error = QString("Failed to serialize calibration message: %1").arg(MessageTypeUtils::toString(messageType));
+            return false;
+        }
+        plan.append(item);
+    }
+    return true;
+}
+
+void CalibrationTransfer::begin(Mode mode, QList<Item> plan, int skipped) {
+    mode_ = mode;
+    running_ = true;
+    generation_++;
+    plan_ = std::move(plan);
+    sendQueue_.clear();
+    for (int i = 0; i < plan_.size(); ++i) {
+        sendQueue_.enqueue(i);
+    }
+    inFlight_ = 0;
+
+    current_ = Result();
+    current_.plannedMessages = plan_.size();
+    current_.skippedMessages = skipped;
+    clock_.start();
+
+    emit progress(0, plan_.size(), 0, 0.0);
+    pump();
+}
+
+void CalibrationTransfer::pump() {
+    // 请求失败可能在sendRequest内同步回调，避免重入
+    if (pumping_) {
+        return;
+    }
+    pumping_ = true;
+
+    while (running_ && inFlight_ < windowSize_ && !sendQueue_.isEmpty()) {
+        sendItem(sendQueue_.dequeue());
+    }
+
+    pumping_ = false;
+
+    if (running_ && inFlight_ == 0 && sendQueue_.isEmpty()) {
+        complete();
+    }
+}
+
+void CalibrationTransfer::sendItem(int index) {
+    Item& item = plan_[index];
+    item.attempts++;
+    item.inFlight = true;
+    inFlight_++;
+
+    if (mode_ == Mode::Transfer && !touched_.contains(item.messageType)) {
+        touched_.append(item.messageType);
+    }
+
+    const quint64 generation = generation_;
+    QPointer<CalibrationTransfer> self(this);
+    quint32 requestId = adapter_->sendRequest(item.messageType, item.parameters,
+        [self, generation, index](const ProtocolAdapterRefactored::RequestResult& result) {
+            if (self) {
+                self->handleItemResult(generation, index, result.success, result.roundTripMs, result.error);
+            }
+        },
+        messageTimeoutMs_ > 0 ? messageTimeoutMs_ : -1);
+
+    if (requestId == 0) {
+        handleItemResult(generation, index, false, 0, "Failed to send request");
+        return;
+    }
+
+    // 回调可能已同步执行（甚至已失败并开始回滚），只为仍在途的条目记录请求ID
+    if (generation == generation_ && plan_[index].inFlight) {
+        plan_[index].requestId = requestId;
+    }
+}
+
+void CalibrationTransfer::handleItemResult(quint64 generation, int index, bool success,
+                                           int roundTripMs, const QString& error) {
+    if (!running_ || generation != generation_ || index < 0 || index >= plan_.size()) {
+        return;
+    }
+
+    Item& item = plan_[index];
+    if (!item.inFlight) {
+        return;
+    }
+    item.inFlight = false;
+    item.requestId = 0;
+    inFlight_--;
+
+    if (success) {
+        item.acknowledged = true;
+        current_.sentMessages++;
+        current_.bytesSent += item.payload.size();
+        updateThroughput();
+
+        emit messageTransferred(item.messageType, roundTripMs);
+        emit progress(current_.sentMessages, current_.plannedMessages, current_.bytesSent, current_.bytesPerSec);
+    } else if (item.attempts <= maxRetries_ && adapter_->isConnected()) {
+        qWarning() << "Calibration message" << MessageTypeUtils::toString(item.messageType)
+                   << "failed (" << error << "), retrying";
+        current_.retries++;
+        sendQueue_.enqueue(index);
+    } else {
+        cancelInFlight();
+        fail(QString("%1: %2").arg(MessageTypeUtils::toString(item.messageType), error));
+        return;
+    }
+
+    pump();
+}
+
+void CalibrationTransfer::complete() {
+    running_ = false;
+    current_.success = true;
+    updateThroughput();
+
+    if (mode_ == Mode::Rollback) {
+        result_.rolledBack = true;
+        qInfo() << "Calibration rollback completed:" << current_.sentMessages << "messages";
+        emit rollbackFinished(true, QString());
+        return;
+    }
+
+    result_ = current_;
+    qInfo() << "Calibration transfer completed:" << current_.sentMessages << "sent,"
+            << current_.skippedMessages << "unchanged," << current_.retries << "retries,"
+            << current_.bytesSent << "bytes in" << current_.elapsedMs << "ms";
+    emit finished(true, QString());
+}
+
+void CalibrationTransfer::fail(const QString& error, bool rollbackAllowed) {
+    running_ = false;
+    sendQueue_.clear();
+    current_.success = false;
+    current_.error = error;
+    updateThroughput();
+
+    if (mode_ == Mode::Rollback) {
+        qWarning() << "Calibration rollback failed:" << error;
+        emit rollbackFinished(false, error);
+        return;
+    }
+
+    result_ = current_;
+    qWarning() << "Calibration transfer failed:" << error;
+    emit finished(false, error);
+
+    if (rollbackAllowed && autoRollback_ && !touched_.isEmpty()) {
+        rollback();
+    }
+}
+
+void CalibrationTransfer::cancelInFlight() {
+    for (Item& item : plan_) {
+        if (item.inFlight) {
+            if (item.requestId != 0) {
+                adapter_->cancelRequest(item.requestId);
+            }
+            item.inFlight = false;
+            item.requestId = 0;
+        }
+    }
+    inFlight_ = 0;
+}
+
+void CalibrationTransfer::updateThroughput() {
+    current_.elapsedMs = clock_.elapsed();
+    current_.bytesPerSec = current_.elapsedMs > 0
+                           ? current_.bytesSent * 1000.0 / current_.elapsedMs
+                           : 0.0;
+}
+
+} // namespace Protocol
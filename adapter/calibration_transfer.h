@@ -0,0 +1,206 @@
+#ifndef CALIBRATION_TRANSFER_H
+#define CALIBRATION_TRANSFER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QQueue>
+#include <QVariantMap>
+#include <QElapsedTimer>
+#include "protocol/core/message_types.h"
+
+namespace Protocol {
+
+class ProtocolAdapterRefactored;
+class CalibrationSnapshot;
+
+/**
+ * @brief 批量标定传输引擎
+ *
+ * 接收一份完整的目标标定（ORDER_FLAG、ORDER2/4/6_PARAMS、ALPHA_PARAMS、FREQ_DIVISION、
+ * THRESHOLDS、SYSTEM_RANGES、FILTER_RANGES等），与影子状态中的设备已知值比较，
+ * 只发送有差异的消息。消息以异步REQUEST发送，在流控窗口内流水线化，每条消息等待设备RESPONSE确认，
+ * 超时按次数重试。开始前保存涉及消息的回滚快照，传输失败时可自动把已发送的消息恢复为原值。
+ * 影子状态只由设备应答经适配器接收链路更新，引擎不写入。
+ *
+ * 引擎必须与适配器位于同一线程。
+ */
+class CalibrationTransfer : public QObject {
+    Q_OBJECT
+
+public:
+    // 目标标定：消息类型 -> 参数映射（参数路径为键）
+    using Calibration = QHash<MessageType, QVariantMap>;
+
+    /**
+     * @brief 传输结果
+     */
+    struct Result {
+        bool success = false;
+        int plannedMessages = 0;        // 需要发送的消息数
+        int skippedMessages = 0;        // 与设备已知值相同而跳过的消息数
+        int sentMessages = 0;           // 已确认的消息数
+        int retries = 0;                // 重试次数
+        qint64 bytesSent = 0;           // 已确认消息的载荷字节数
+        qint64 elapsedMs = 0;
+        double bytesPerSec = 0.0;
+        QString error;
+        bool rolledBack = false;        // 失败后是否已成功回滚
+    };
+
+    explicit CalibrationTransfer(ProtocolAdapterRefactored* adapter, QObject* parent = nullptr);
+    ~CalibrationTransfer() override;
+
+    /**
+     * @brief 标定相关的消息类型（按发送顺序）
+     */
+    static QList<MessageType> calibrationMessageTypes();
+
+    /**
+     * @brief 从影子状态读取当前设备标定（只包含影子状态可用的消息类型）
+     */
+    Calibration currentCalibration() const;
+
+    /**
+     * @brief 开始传输
+     *
+     * 每种消息的参数与影子状态合并为完整消息后再比较和发送；所有消息在发送前先完成序列化校验，
+     * 任何一条无法序列化时不发送任何数据并返回false。没有需要发送的消息时立即以成功结束。
+     * @param target 目标标定
+     * @return 已开始（或已立即完成）返回true
+     */
+    bool start(const Calibration& target);
+
+    /**
+     * @brief 以标定快照为目标开始传输
+     *
+     * 快照中的每种消息经序列化器转换为参数映射后按start(const Calibration&)传输。
+     * 抓取设备当前标定可先requestAllMessages()回读，再用CalibrationSnapshot::capture()从影子状态抓取。
+     */
+    bool start(const CalibrationSnapshot& snapshot);
+
+    /**
+     * @brief 中止传输（不回滚，已在途的请求被取消）
+     */
+    void abort();
+
+    /**
+     * @brief 把本次传输涉及的消息恢复为开始前的值
+     * @return 回滚已开始返回true
+     */
+    bool rollback();
+
+    bool isRunning() const { return running_; }
+
+    /**
+     * @brief 开始前保存的回滚快照（影子状态未知的消息不在快照中）
+     */
+    Calibration rollbackSnapshot() const { return snapshot_; }
+
+    Result lastResult() const { return result_; }
+
+    /**
+     * @brief 传输配置
+     */
+
+    // 同时在途的消息数
+    void setWindowSize(int messages);
+    int windowSize() const { return windowSize_; }
+
+    // 每条消息的最大重试次数
+    void setMaxRetries(int retries);
+    int maxRetries() const { return maxRetries_; }
+
+    // 每条消息的确认超时（毫秒），0表示使用适配器的默认请求超时
+    void setMessageTimeout(int ms);
+    int messageTimeout() const { return messageTimeoutMs_; }
+
+    // 与设备已知值相同的消息是否跳过（默认跳过）
+    void setSkipUnchanged(bool skip) { skipUnchanged_ = skip; }
+    bool skipUnchanged() const { return skipUnchanged_; }
+
+    // 失败时是否自动回滚（默认回滚）
+    void setAutoRollback(bool enabled) { autoRollback_ = enabled; }
+    bool autoRollback() const { return autoRollback_; }
+
+signals:
+    /**
+     * @brief 传输进度（回滚过程同样报告）
+     * @param completed 已确认的消息数
+     * @param total 需要发送的消息数
+     * @param bytesSent 已确认的载荷字节数
+     * @param bytesPerSec 平均吞吐量
+     */
+    void progress(int completed, int total, qint64 bytesSent, double bytesPerSec);
+
+    /**
+     * @brief 单条消息已被设备确认
+     */
+    void messageTransferred(MessageType messageType, int roundTripMs);
+
+    /**
+     * @brief 传输结束，详细结果见lastResult()
+     */
+    void finished(bool success, const QString& error);
+
+    /**
+     * @brief 回滚结束
+     */
+    void rollbackFinished(bool success, const QString& error);
+
+private:
+    enum class Mode {
+        Transfer,
+        Rollback
+    };
+
+    struct Item {
+        MessageType messageType = MessageType::ANC_SWITCH;
+        QVariantMap parameters;         // 完整消息参数
+        QByteArray payload;             // 序列化校验得到的载荷
+        quint32 requestId = 0;
+        int attempts = 0;
+        bool inFlight = false;
+        bool acknowledged = false;
+    };
+
+    bool buildPlan(const Calibration& target, bool diff, QList<Item>& plan, int& skipped, QString& error) const;
+    void begin(Mode mode, QList<Item> plan, int skipped);
+    void pump();
+    void sendItem(int index);
+    void handleItemResult(quint64 generation, int index, bool success, int roundTripMs, const QString& error);
+    void complete();
+    void fail(const QString& error, bool rollbackAllowed = true);
+    void cancelInFlight();
+    void updateThroughput();
+
+    ProtocolAdapterRefactored* adapter_;
+
+    Mode mode_;
+    bool running_;
+    bool pumping_;
+    quint64 generation_;            // 每次开始递增，忽略旧传输的迟到回调
+    QList<Item> plan_;
+    QQueue<int> sendQueue_;         // 待发送（含重试）的条目
+    int inFlight_;
+    QElapsedTimer clock_;
+    Calibration snapshot_;
+    QList<MessageType> touched_;    // 最近一次传输中已发出过的消息类型
+    Result current_;                // 本次运行（传输或回滚）的计数
+    Result result_;                 // 最近一次传输的结果
+
+    int windowSize_;
+    int maxRetries_;
+    int messageTimeoutMs_;
+    bool skipUnchanged_;
+    bool autoRollback_;
+
+    // 常量
+    static const int DEFAULT_WINDOW_SIZE;
+    static const int DEFAULT_MAX_RETRIES;
+};
+
+} // namespace Protocol
+
+#endif // CALIBRATION_TRANSFER_H
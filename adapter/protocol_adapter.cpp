@@ -1,5 +1,6 @@
 #include "protocol_adapter.h"
 #include "protocol/transport/serial_transport.h"
+#include "protocol/serialization/message_codec.h"
 #include <QDebug>
 #include <QJsonDocument>
 #include <QJsonObject>
@@ -134,6 +135,12 @@ QByteArray ProtocolAdapter::serializeParameters(const QVariantMap& parameters)
 }
 
 bool ProtocolAdapter::deserializeParameters(const QByteArray& data, QVariantMap& parameters)
+{
+    MessageType messageType;
+    return deserializeParameters(data, messageType, parameters);
+}
+
+bool ProtocolAdapter::deserializeParameters(const QByteArray& data, MessageType& messageType, QVariantMap& parameters)
 {
     if (data.isEmpty()) {
         return false;
@@ -155,6 +162,7 @@ bool ProtocolAdapter::deserializeParameters(const QByteArray& data, QVariantMap&
     for (MessageType type : typesToTry) {
         QVariantMap tempParams;
         if (deserializeMessage(type, data, tempParams)) {
+            messageType = type;
             parameters = tempParams;
             return true;
         }
@@ -297,6 +305,11 @@ void ProtocolAdapter::handleTransportError(const QString& error)
 void ProtocolAdapter::handleTransportConnectionChanged(bool connected)
 {
     qDebug() << "Transport connection status changed:" << connected;
+    if (!connected) {
+        // 断线期间设备状态未知，重连后收到的消息全部视为变化
+        receivedState_.clear();
+        receivedParameters_.clear();
+    }
     emit connectionStatusChanged(connected);
 }
 
@@ -466,13 +479,37 @@ void ProtocolAdapter::processReceivedData(const QByteArray& data)
     emit dataReceived(data);
 
     // 尝试反序列化接收到的数据
+    MessageType messageType;
     QVariantMap parameters;
-    if (deserializeParameters(data, parameters)) {
-        // 发出参数变更信号
-        for (auto it = parameters.begin(); it != parameters.end(); ++it) {
-            emit parameterAcknowledged(it.key());
+    if (!deserializeParameters(data, messageType, parameters)) {
+        return;
+    }
+
+    // 先逐字比较消息结构体，内容未变化的消息不产生任何信号
+    Protocol::ShadowStateStore::ChangeSet changes;
+    if (receivedState_.update(messageType, data, &changes) && changes.isEmpty()) {
+        return;
+    }
+
+    // 内容变化时只通知值变化的参数
+    QVariantMap& previous = receivedParameters_[messageType];
+    QStringList changedPaths;
+    for (auto it = parameters.constBegin(); it != parameters.constEnd(); ++it) {
+        auto old = previous.constFind(it.key());
+        if (old == previous.constEnd() || old.value() != it.value()) {
+            changedPaths.append(it.key());
         }
     }
+    previous = parameters;
+
+    if (changedPaths.isEmpty()) {
+        return;
+    }
+
+    for (const QString& path : changedPaths) {
+        emit parameterAcknowledged(path);
+    }
+    emit parametersChanged(changedPaths);
 }
 
 // 具体消息序列化实现
@@ -491,16 +528,13 @@ QByteArray ProtocolAdapter::serializeAncSwitch(const QVariantMap& parameters)
         message.anc_off = true; // 默认值为关闭
     }
 
-    uint8_t buffer[MSG_AncSwitch_size];
-    pb_ostream_t stream = pb_ostream_from_buffer(buffer, sizeof(buffer));
-
-    bool success = pb_encode(&stream, MSG_AncSwitch_fields, &message);
-    if (!success) {
-        qWarning() << "Failed to encode MSG_AncSwitch:" << PB_GET_ERROR(&stream);
+    QByteArray payload;
+    if (!Protocol::MessageCodec::encode(message, payload)) {
+        qWarning() << "Failed to encode MSG_AncSwitch";
         return QByteArray();
     }
 
-    return QByteArray(reinterpret_cast<const char*>(buffer), stream.bytes_written);
+    return payload;
 }
 
 // 注意：此函数已被合并到serializeAncSwitch中处理
@@ -512,16 +546,13 @@ QByteArray ProtocolAdapter::serializeCheckMod(uint32_t checkMod)
     MSG_CheckMod message = MSG_CheckMod_init_zero;
     message.check_mod = checkMod;
 
-    uint8_t buffer[MSG_CheckMod_size];
-    pb_ostream_t stream = pb_ostream_from_buffer(buffer, sizeof(buffer));
-
-    bool success = pb_encode(&stream, MSG_CheckMod_fields, &message);
-    if (!success) {
-        qWarning() << "Failed to encode MSG_CheckMod:" << PB_GET_ERROR(&stream);
+    QByteArray payload;
+    if (!Protocol::MessageCodec::encode(message, payload)) {
+        qWarning() << "Failed to encode MSG_CheckMod";
         return QByteArray();
     }
 
-    return QByteArray(reinterpret_cast<const char*>(buffer), stream.bytes_written);
+    return payload;
 }
 
 QByteArray ProtocolAdapter::serializeAlphaParams(const QVariantMap& parameters)
@@ -539,16 +570,13 @@ QByteArray ProtocolAdapter::serializeAlphaParams(const QVariantMap& parameters)
     message.alpha4_10 = parameters.value("tuning.alpha.alpha4_10", 0).toUInt();
     message.alpha5_10 = parameters.value("tuning.alpha.alpha5_10", 0).toUInt();
 
-    uint8_t buffer[MSG_AlphaParams_size];
-    pb_ostream_t stream = pb_ostream_from_buffer(buffer, sizeof(buffer));
-
-    bool success = pb_encode(&stream, MSG_AlphaParams_fields, &message);
-    if (!success) {
-        qWarning() << "Failed to encode MSG_AlphaParams:" << PB_GET_ERROR(&stream);
+    QByteArray payload;
+    if (!Protocol::MessageCodec::encode(message, payload)) {
+        qWarning() << "Failed to encode MSG_AlphaParams";
         return QByteArray();
     }
 
-    return QByteArray(reinterpret_cast<const char*>(buffer), stream.bytes_written);
+    return payload;
 }
 
 QByteArray ProtocolAdapter::serializeOrder2Params(const QVariantMap& parameters)
@@ -575,16 +603,13 @@ QByteArray ProtocolAdapter::serializeOrder2Params(const QVariantMap& parameters)
     message.err_wei1 = parameters.value("tuning.set1.gamma", 0).toUInt(); // 使用gamma值替代
     message.delta1 = parameters.value("tuning.set1.delta", 0).toUInt();
 
-    uint8_t buffer[MSG_Order2Params_size];
-    pb_ostream_t stream = pb_ostream_from_buffer(buffer, sizeof(buffer));
-
-    bool success = pb_encode(&stream, MSG_Order2Params_fields, &message);
-    if (!success) {
-        qWarning() << "Failed to encode MSG_Order2Params:" << PB_GET_ERROR(&stream);
+    QByteArray payload;
+    if (!Protocol::MessageCodec::encode(message, payload)) {
+        qWarning() << "Failed to encode MSG_Order2Params";
         return QByteArray();
     }
 
-    return QByteArray(reinterpret_cast<const char*>(buffer), stream.bytes_written);
+    return payload;
 }
 
 QByteArray ProtocolAdapter::serializeChannelAmplitude(const QVariantMap& parameters)
@@ -594,16 +619,13 @@ QByteArray ProtocolAdapter::serializeChannelAmplitude(const QVariantMap& paramet
     // 这里简化处理，实际需要根据具体的数组参数来填充
     // 示例代码，需要根据实际参数结构调整
 
-    uint8_t buffer[MSG_ChannelAmplitude_size];
-    pb_ostream_t stream = pb_ostream_from_buffer(buffer, sizeof(buffer));
-
-    bool success = pb_encode(&stream, MSG_ChannelAmplitude_fields, &message);
-    if (!success) {
-        qWarning() << "Failed to encode MSG_ChannelAmplitude:" << PB_GET_ERROR(&stream);
+    QByteArray payload;
+    if (!Protocol::MessageCodec::encode(message, payload)) {
+        qWarning() << "Failed to encode MSG_ChannelAmplitude";
         return QByteArray();
     }
 
-    return QByteArray(reinterpret_cast<const char*>(buffer), stream.bytes_written);
+    return payload;
 }
 
 QByteArray ProtocolAdapter::serializeSystemRanges(const QVariantMap& parameters)
@@ -612,28 +634,21 @@ QByteArray ProtocolAdapter::serializeSystemRanges(const QVariantMap& parameters)
 
     // 这里简化处理，实际需要根据具体的参数来填充
 
-    uint8_t buffer[MSG_SystemRanges_size];
-    pb_ostream_t stream = pb_ostream_from_buffer(buffer, sizeof(buffer));
-
-    bool success = pb_encode(&stream, MSG_SystemRanges_fields, &message);
-    if (!success) {
-        qWarning() << "Failed to encode MSG_SystemRanges:" << PB_GET_ERROR(&stream);
+    QByteArray payload;
+    if (!Protocol::MessageCodec::encode(message, payload)) {
+        qWarning() << "Failed to encode MSG_SystemRanges";
         return QByteArray();
     }
 
-    return QByteArray(reinterpret_cast<const char*>(buffer), stream.bytes_written);
+    return payload;
 }
 
 // 具体消息反序列化实现
 bool ProtocolAdapter::deserializeAncSwitch(const QByteArray& data, QVariantMap& parameters)
 {
     MSG_AncSwitch message = MSG_AncSwitch_init_zero;
-    pb_istream_t stream = pb_istream_from_buffer(
-        reinterpret_cast<const uint8_t*>(data.constData()), data.size());
-
-    bool success = pb_decode(&stream, MSG_AncSwitch_fields, &message);
-    if (!success) {
-        qWarning() << "Failed to decode MSG_AncSwitch:" << PB_GET_ERROR(&stream);
+    if (!Protocol::MessageCodec::decode(data, message)) {
+        qWarning() << "Failed to decode MSG_AncSwitch";
         return false;
     }
 
@@ -648,12 +663,8 @@ bool ProtocolAdapter::deserializeAncSwitch(const QByteArray& data, QVariantMap&
 bool ProtocolAdapter::deserializeCheckMod(const QByteArray& data, QVariantMap& parameters)
 {
     MSG_CheckMod message = MSG_CheckMod_init_zero;
-    pb_istream_t stream = pb_istream_from_buffer(
-        reinterpret_cast<const uint8_t*>(data.constData()), data.size());
-
-    bool success = pb_decode(&stream, MSG_CheckMod_fields, &message);
-    if (!success) {
-        qWarning() << "Failed to decode MSG_CheckMod:" << PB_GET_ERROR(&stream);
+    if (!Protocol::MessageCodec::decode(data, message)) {
+        qWarning() << "Failed to decode MSG_CheckMod";
         return false;
     }
 
@@ -664,12 +675,8 @@ bool ProtocolAdapter::deserializeCheckMod(const QByteArray& data, QVariantMap& p
 bool ProtocolAdapter::deserializeAlphaParams(const QByteArray& data, QVariantMap& parameters)
 {
     MSG_AlphaParams message = MSG_AlphaParams_init_zero;
-    pb_istream_t stream = pb_istream_from_buffer(
-        reinterpret_cast<const uint8_t*>(data.constData()), data.size());
-
-    bool success = pb_decode(&stream, MSG_AlphaParams_fields, &message);
-    if (!success) {
-        qWarning() << "Failed to decode MSG_AlphaParams:" << PB_GET_ERROR(&stream);
+    if (!Protocol::MessageCodec::decode(data, message)) {
+        qWarning() << "Failed to decode MSG_AlphaParams";
         return false;
     }
 
@@ -690,12 +697,8 @@ bool ProtocolAdapter::deserializeAlphaParams(const QByteArray& data, QVariantMap
 bool ProtocolAdapter::deserializeOrder2Params(const QByteArray& data, QVariantMap& parameters)
 {
     MSG_Order2Params message = MSG_Order2Params_init_zero;
-    pb_istream_t stream = pb_istream_from_buffer(
-        reinterpret_cast<const uint8_t*>(data.constData()), data.size());
-
-    bool success = pb_decode(&stream, MSG_Order2Params_fields, &message);
-    if (!success) {
-        qWarning() << "Failed to decode MSG_Order2Params:" << PB_GET_ERROR(&stream);
+    if (!Protocol::MessageCodec::decode(data, message)) {
+        qWarning() << "Failed to decode MSG_Order2Params";
         return false;
     }
 
@@ -715,12 +718,8 @@ bool ProtocolAdapter::deserializeOrder2Params(const QByteArray& data, QVariantMa
 bool ProtocolAdapter::deserializeChannelAmplitude(const QByteArray& data, QVariantMap& parameters)
 {
     MSG_ChannelAmplitude message = MSG_ChannelAmplitude_init_zero;
-    pb_istream_t stream = pb_istream_from_buffer(
-        reinterpret_cast<const uint8_t*>(data.constData()), data.size());
-
-    bool success = pb_decode(&stream, MSG_ChannelAmplitude_fields, &message);
-    if (!success) {
-        qWarning() << "Failed to decode MSG_ChannelAmplitude:" << PB_GET_ERROR(&stream);
+    if (!Protocol::MessageCodec::decode(data, message)) {
+        qWarning() << "Failed to decode MSG_ChannelAmplitude";
         return false;
     }
 
@@ -731,12 +730,8 @@ bool ProtocolAdapter::deserializeChannelAmplitude(const QByteArray& data, QVaria
 bool ProtocolAdapter::deserializeSystemRanges(const QByteArray& data, QVariantMap& parameters)
 {
     MSG_SystemRanges message = MSG_SystemRanges_init_zero;
-    pb_istream_t stream = pb_istream_from_buffer(
-        reinterpret_cast<const uint8_t*>(data.constData()), data.size());
-
-    bool success = pb_decode(&stream, MSG_SystemRanges_fields, &message);
-    if (!success) {
-        qWarning() << "Failed to decode MSG_SystemRanges:" << PB_GET_ERROR(&stream);
+    if (!Protocol::MessageCodec::decode(data, message)) {
+        qWarning() << "Failed to decode MSG_SystemRanges";
         return false;
     }
 
@@ -12,6 +12,7 @@
 #include <QScopedPointer>
 #include "protocol/transport/itransport.h"
 #include "protocol/core/message_types.h"
+#include "protocol/state/shadow_state_store.h"
 
 extern "C" {
 #include "protocol/nanopb/pb.h"
@@ -106,9 +107,12 @@ public:
     using FunctionCode = Protocol::FunctionCode;
 
 signals:
-    // 参数确认信号
+    // 参数确认信号（接收方向只针对值实际变化的参数）
     void parameterAcknowledged(const QString& path);
 
+    // 参数变化信号：每条内容变化的接收消息发出一次
+    void parametersChanged(const QStringList& paths);
+
     // 通信错误信号
     void communicationError(const QString& error);
 
@@ -160,6 +164,9 @@ private:
     // 反序列化具体消息类型
     bool deserializeMessage(MessageType type, const QByteArray& data, QVariantMap& parameters);
 
+    // 反序列化参数并返回识别出的消息类型
+    bool deserializeParameters(const QByteArray& data, MessageType& messageType, QVariantMap& parameters);
+
     // 参数路径到消息类型的映射
     MessageType getMessageTypeFromPath(const QString& parameterPath) const;
 
@@ -253,6 +260,8 @@ private:
     QString protocolVersion_;                           // 协议版本
     QByteArray receiveBuffer_;                          // 接收缓冲区
     bool transportOwned_;                               // 是否拥有传输层对象的所有权
+    Protocol::ShadowStateStore receivedState_;          // 最后收到的各消息结构体，用于变化检测
+    QHash<MessageType, QVariantMap> receivedParameters_; // 最后收到的各消息参数
 
     // 协议常量
     static const QString PROTOCOL_VERSION;
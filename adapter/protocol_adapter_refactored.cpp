@@ -1,5 +1,8 @@
 #include "protocol_adapter_refactored.h"
+#include "protocol/serialization/protocol_packager.h"
 #include <QDebug>
+#include <QMetaMethod>
+#include <QThread>
 
 namespace Protocol {
 
@@ -23,138 +26,102 @@ ProtocolAdapterRefactored::ProtocolAdapterRefactored(ITransport* transport, QObj
 
 ProtocolAdapterRefactored::~ProtocolAdapterRefactored() {
     disconnectComponentSignals();
+    if (requestTimer_) {
+        requestTimer_->stop();
+    }
     qDebug() << "ProtocolAdapterRefactored destroyed";
 }
 
 bool ProtocolAdapterRefactored::sendParameterUpdate(const QString& parameterPath, const QVariant& value) {
-    qDebug() << "=== Starting parameter update ===";
-    qDebug() << "Input parameter:" << parameterPath << "=" << value;
-
-    // 检查初始化状态
-    qDebug() << "Checking initialization status...";
     if (!initialized_) {
-        qDebug() << "✗ EARLY RETURN: ProtocolAdapter not initialized";
         qWarning() << "ProtocolAdapter not initialized";
         emit communicationError("ProtocolAdapter not initialized");
         return false;
     }
-    qDebug() << "✓ ProtocolAdapter is initialized";
 
-    // 检查连接状态
-    qDebug() << "Checking connection status...";
     if (!isConnected()) {
-        qDebug() << "✗ EARLY RETURN: Not connected, cannot send parameter update";
         qWarning() << "Not connected, cannot send parameter update";
         emit communicationError("Not connected");
         return false;
     }
-    qDebug() << "✓ Connection is active";
 
-    // 检查参数是否支持
-    qDebug() << "Checking parameter support for:" << parameterPath;
     if (!parameterMapper_->isParameterSupported(parameterPath)) {
-        qDebug() << "✗ EARLY RETURN: Parameter not supported:" << parameterPath;
-        qDebug() << "Available parameters:" << parameterMapper_->getSupportedParameters();
         QString error = QString("Unsupported parameter: %1").arg(parameterPath);
         qWarning() << error;
         emit communicationError(error);
         return false;
     }
-    qDebug() << "✓ Parameter is supported";
 
-    // 获取参数信息
-    qDebug() << "Getting parameter information for:" << parameterPath;
     auto paramInfo = parameterMapper_->getParameterInfo(parameterPath);
     if (!paramInfo.isValid()) {
-        qDebug() << "✗ EARLY RETURN: Invalid parameter info for:" << parameterPath;
-        qDebug() << "Parameter info details: messageType=" << static_cast<int>(paramInfo.messageType)
-                 << "protobufPath=" << paramInfo.protobufPath;
         QString error = QString("Invalid parameter info for: %1").arg(parameterPath);
         qWarning() << error;
         emit communicationError(error);
         return false;
     }
-    qDebug() << "✓ Parameter info valid - messageType:" << static_cast<int>(paramInfo.messageType)
-             << "protobufPath:" << paramInfo.protobufPath;
 
-    // 准备参数映射
-    QVariantMap parameters;
-    parameters[parameterPath] = value;
+    // 合并模式：缓冲到窗口结束时与同类型的其他更新一起发送
+    auto slot = coalescing_.find(paramInfo.messageType);
+    if (slot != coalescing_.end() && slot->windowMs > 0) {
+        slot->pending.insert(parameterPath, value);
+        if (!slot->timer->isActive()) {
+            slot->timer->start(slot->windowMs);
+        }
+        return true;
+    }
 
-    // 序列化消息
-    qDebug() << "=== Starting parameter serialization ===";
-    qDebug() << "Parameter path:" << parameterPath;
-    qDebug() << "Message type:" << static_cast<int>(paramInfo.messageType);
-    qDebug() << "Parameter value:" << parameters.value(parameterPath)
-             << QString("(type: %1)").arg(parameters.value(parameterPath).typeName());
-    qDebug() << "Parameter map size:" << parameters.size();
+    // 读-改-写、增量模式、序列化和发送与其他发送路径共用
+    QVariantMap parameters;
+    parameters.insert(parameterPath, value);
+    return sendMessageParameters(paramInfo.messageType, parameters);
+}
 
-    // 打印完整的参数映射
-    qDebug() << "Complete parameter map:";
-    for (auto it = parameters.begin(); it != parameters.end(); ++it) {
-        qDebug() << "  -" << it.key() << "=" << it.value()
-                 << QString("(type: %1)").arg(it.value().typeName());
+bool ProtocolAdapterRefactored::sendParameterUpdate(ParamId id, const QVariant& value) {
+    if (!initialized_) {
+        qWarning() << "ProtocolAdapter not initialized";
+        emit communicationError("ProtocolAdapter not initialized");
+        return false;
     }
 
-    qDebug() << "Attempting serialization with message serializer...";
-    // 使用新的序列化方法，生成完整的MsgRequestResponse格式
-    QByteArray data = messageSerializer_->serialize(paramInfo.messageType, parameters, FunctionCode::REQUEST, true);
+    if (!isConnected()) {
+        qWarning() << "Not connected, cannot send parameter update";
+        emit communicationError("Not connected");
+        return false;
+    }
 
-    if (data.isEmpty()) {
-        qDebug() << "✗ SERIALIZATION FAILED";
-        qDebug() << "Failed parameter path:" << parameterPath;
-        qDebug() << "Failed message type:" << static_cast<int>(paramInfo.messageType);
-        qDebug() << "Parameter value that failed:" << parameters.value(parameterPath);
-        QString error = QString("Failed to serialize parameter: %1").arg(parameterPath);
+    const ParameterHotInfo hot = parameterMapper_->hotInfo(id);
+    const ParameterInfo* info = parameterMapper_->findParameterInfo(id);
+    if (!hot.isValid() || !info) {
+        QString error = QString("Invalid parameter id: %1").arg(id);
         qWarning() << error;
         emit communicationError(error);
         return false;
     }
 
-    qDebug() << "✓ SERIALIZATION SUCCESSFUL";
-    qDebug() << "Serialized data size:" << data.size() << "bytes";
-    qDebug() << "Serialized data (hex):" << data.toHex(' ');
-    qDebug() << "First 16 bytes:" << data.left(16).toHex(' ');
-
-    // 发送数据
-    qDebug() << "=== Starting data transmission ===";
-    qDebug() << "Sending data via connection manager...";
-    qDebug() << "Data to send size:" << data.size() << "bytes";
-    qDebug() << "Data content (hex):" << data.toHex();
-    qDebug() << "Data content (hex with spaces):" << data.toHex(' ');
-    qDebug() << "Data content (raw bytes):";
-    for (int i = 0; i < data.size(); ++i) {
-        qDebug() << "  Byte[" << i << "]:" << QString("0x%1").arg((unsigned char)data[i], 2, 16, QChar('0'));
+    if (hot.isDeprecated()) {
+        emit parameterMapper_->deprecatedParameterUsed(info->logicalPath, info->replacedBy);
     }
-    bool success = connectionManager_->sendData(data);
 
-    qDebug() << "=== Data transmission result ===";
-    if (success) {
-        qDebug() << "✓ TRANSMISSION SUCCESSFUL";
-        qDebug() << "Successfully sent parameter:" << parameterPath;
-        qDebug() << "Parameter value:" << value;
-        qDebug() << "Message type:" << static_cast<int>(paramInfo.messageType);
-        qDebug() << "Data size transmitted:" << data.size() << "bytes";
-        qDebug() << "Emitting parameterAcknowledged signal for:" << parameterPath;
-        qDebug() << "Parameter update sent successfully:" << parameterPath << "=" << value;
-        emit parameterAcknowledged(parameterPath);
-        qDebug() << "✓ Parameter acknowledgment signal emitted";
-    } else {
-        qDebug() << "✗ TRANSMISSION FAILED";
-        qDebug() << "Failed to send parameter:" << parameterPath;
-        qDebug() << "Parameter value:" << value;
-        qDebug() << "Message type:" << static_cast<int>(paramInfo.messageType);
-        qDebug() << "Data size that failed:" << data.size() << "bytes";
-        qDebug() << "Failed data (hex):" << data.toHex(' ');
-        QString error = QString("Failed to send parameter update: %1").arg(parameterPath);
-        qWarning() << error;
-        qDebug() << "Emitting communicationError signal with error:" << error;
-        emit communicationError(error);
+    const MessageType messageType = hot.messageType();
+
+    // 合并模式：缓冲到窗口结束时与同类型的其他更新一起发送
+    auto slot = coalescing_.find(messageType);
+    if (slot != coalescing_.end() && slot->windowMs > 0) {
+        slot->pending.insert(info->logicalPath, value);
+        if (!slot->timer->isActive()) {
+            slot->timer->start(slot->windowMs);
+        }
+        return true;
     }
-    qDebug() << "=== End of parameter transmission ===";
-    qDebug() << "";
 
-    return success;
+    // 处理器接口以路径为键：驻留的路径是隐式共享的，不做查找，但仍需分配一项映射
+    QVariantMap parameters;
+    parameters.insert(info->logicalPath, value);
+    return sendMessageParameters(messageType, parameters);
+}
+
+ParamId ProtocolAdapterRefactored::parameterId(const QString& parameterPath) const {
+    return parameterMapper_ ? parameterMapper_->parameterId(parameterPath) : INVALID_PARAM_ID;
 }
 
 bool ProtocolAdapterRefactored::sendParameterGroup(const QStringList& paths, const QVariantMap& values) {
@@ -203,29 +170,8 @@ bool ProtocolAdapterRefactored::sendParameterGroup(const QStringList& paths, con
     // 逐个发送不同类型的消息
     bool allSuccess = true;
     for (auto it = messageGroups.begin(); it != messageGroups.end(); ++it) {
-        MessageType messageType = it.key();
-        const QVariantMap& groupParams = it.value();
-
-        QByteArray data = messageSerializer_->serialize(messageType, groupParams, FunctionCode::REQUEST, true);
-        if (data.isEmpty()) {
-            QString error = QString("Failed to serialize message type: %1").arg(static_cast<int>(messageType));
-            qWarning() << error;
-            emit communicationError(error);
-            allSuccess = false;
-            continue;
-        }
-
-        bool success = connectionManager_->sendData(data);
-        if (!success) {
-            QString error = QString("Failed to send message type: %1").arg(static_cast<int>(messageType));
-            qWarning() << error;
-            emit communicationError(error);
+        if (!sendMessageParameters(it.key(), it.value())) {
             allSuccess = false;
-        } else {
-            // 发送成功，通知每个参数
-            for (const QString& path : groupParams.keys()) {
-                emit parameterAcknowledged(path);
-            }
         }
     }
 
@@ -300,6 +246,323 @@ bool ProtocolAdapterRefactored::deserializeParameters(const QByteArray& data, QV
     return false;
 }
 
+quint32 ProtocolAdapterRefactored::sendRequest(MessageType messageType, const QVariantMap& parameters,
+                                               RequestCallback callback, int timeoutMs) {
+    if (!initialized_) {
+        qWarning() << "ProtocolAdapter not initialized";
+        emit communicationError("ProtocolAdapter not initialized");
+        return 0;
+    }
+
+    if (!isConnected()) {
+        qWarning() << "Not connected, cannot send request";
+        emit communicationError("Not connected");
+        return 0;
+    }
+
+    QByteArray data = messageSerializer_->serialize(messageType, parameters, FunctionCode::REQUEST, true);
+    if (data.isEmpty()) {
+        QString error = QString("Failed to serialize message type: %1").arg(static_cast<int>(messageType));
+        qWarning() << error;
+        emit communicationError(error);
+        return 0;
+    }
+
+    return enqueueRequest(messageType, data, std::move(callback), timeoutMs);
+}
+
+quint32 ProtocolAdapterRefactored::sendParameterUpdateAsync(const QString& parameterPath, const QVariant& value,
+                                                            RequestCallback callback, int timeoutMs) {
+    if (!parameterMapper_ || !parameterMapper_->isParameterSupported(parameterPath)) {
+        QString error = QString("Unsupported parameter: %1").arg(parameterPath);
+        qWarning() << error;
+        emit communicationError(error);
+        return 0;
+    }
+
+    auto paramInfo = parameterMapper_->getParameterInfo(parameterPath);
+    if (!paramInfo.isValid()) {
+        QString error = QString("Invalid parameter info for: %1").arg(parameterPath);
+        qWarning() << error;
+        emit communicationError(error);
+        return 0;
+    }
+
+    QVariantMap parameters;
+    parameters[parameterPath] = value;
+    return sendRequest(paramInfo.messageType, parameters, std::move(callback), timeoutMs);
+}
+
+quint32 ProtocolAdapterRefactored::requestMessage(MessageType messageType, RequestCallback callback, int timeoutMs) {
+    if (!initialized_) {
+        qWarning() << "ProtocolAdapter not initialized";
+        emit communicationError("ProtocolAdapter not initialized");
+        return 0;
+    }
+
+    if (!isConnected()) {
+        qWarning() << "Not connected, cannot request message";
+        emit communicationError("Not connected");
+        return 0;
+    }
+
+    // 不带载荷字段的REQUEST，设备以携带当前值的RESPONSE应答
+    QByteArray data = messageSerializer_->packageReadRequest(messageType);
+    if (data.isEmpty()) {
+        QString error = QString("Failed to package read request: %1").arg(static_cast<int>(messageType));
+        qWarning() << error;
+        emit communicationError(error);
+        return 0;
+    }
+
+    return enqueueRequest(messageType, data, std::move(callback), timeoutMs);
+}
+
+QList<quint32> ProtocolAdapterRefactored::requestAllMessages(RequestCallback callback, int timeoutMs) {
+    QList<quint32> requestIds;
+    if (!messageSerializer_) {
+        return requestIds;
+    }
+
+    for (MessageType messageType : messageSerializer_->getSupportedMessageTypes()) {
+        quint32 requestId = requestMessage(messageType, callback, timeoutMs);
+        if (requestId != 0) {
+            requestIds.append(requestId);
+        }
+    }
+
+    qDebug() << "Requested readback of" << requestIds.size() << "message types";
+    return requestIds;
+}
+
+bool ProtocolAdapterRefactored::cancelRequest(quint32 requestId) {
+    // 已发出的请求留在在途列表中直到应答或超时，迟到的应答由它吸收，不会记到后续请求上
+    for (PendingRequest& request : outstandingRequests_) {
+        if (request.requestId == requestId && !request.cancelled) {
+            request.cancelled = true;
+            request.callback = RequestCallback();
+            return true;
+        }
+    }
+
+    for (int i = 0; i < queuedRequests_.size(); ++i) {
+        if (queuedRequests_[i].requestId == requestId) {
+            queuedRequests_.removeAt(i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ProtocolAdapterRefactored::setMaxOutstandingRequests(int count) {
+    if (count <= 0) {
+        qWarning() << "Invalid max outstanding requests:" << count;
+        return;
+    }
+
+    maxOutstandingRequests_ = count;
+    dispatchQueuedRequests();
+    rearmRequestTimer();
+}
+
+void ProtocolAdapterRefactored::setRequestTimeout(int ms) {
+    if (ms <= 0) {
+        qWarning() << "Invalid request timeout:" << ms;
+        return;
+    }
+    requestTimeoutMs_ = ms;
+}
+
+void ProtocolAdapterRefactored::setCoalescingWindow(MessageType messageType, int ms) {
+    if (ms <= 0) {
+        auto slot = coalescing_.find(messageType);
+        if (slot == coalescing_.end()) {
+            return;
+        }
+
+        // 关闭前先发出已缓冲的更新
+        flushCoalesced(messageType);
+        slot = coalescing_.find(messageType);
+        if (slot != coalescing_.end()) {
+            slot->timer->deleteLater();
+            coalescing_.erase(slot);
+        }
+        qDebug() << "Coalescing disabled for message type:" << MessageTypeUtils::toString(messageType);
+        return;
+    }
+
+    CoalescingSlot& slot = coalescing_[messageType];
+    if (!slot.timer) {
+        slot.timer = new QTimer(this);
+        slot.timer->setSingleShot(true);
+        slot.timer->setTimerType(Qt::PreciseTimer);
+        connect(slot.timer, &QTimer::timeout, this, [this, messageType]() {
+            flushCoalesced(messageType);
+        });
+    }
+    slot.windowMs = ms;
+
+    qDebug() << "Coalescing window for" << MessageTypeUtils::toString(messageType) << "set to" << ms << "ms";
+}
+
+int ProtocolAdapterRefactored::coalescingWindow(MessageType messageType) const {
+    auto slot = coalescing_.constFind(messageType);
+    return slot != coalescing_.constEnd() ? slot->windowMs : 0;
+}
+
+bool ProtocolAdapterRefactored::sendParameterUpdateImmediate(const QString& parameterPath, const QVariant& value) {
+    if (!initialized_) {
+        qWarning() << "ProtocolAdapter not initialized";
+        emit communicationError("ProtocolAdapter not initialized");
+        return false;
+    }
+
+    if (!isConnected()) {
+        qWarning() << "Not connected, cannot send parameter update";
+        emit communicationError("Not connected");
+        return false;
+    }
+
+    auto paramInfo = parameterMapper_->getParameterInfo(parameterPath);
+    if (!paramInfo.isValid()) {
+        QString error = QString("Unsupported parameter: %1").arg(parameterPath);
+        qWarning() << error;
+        emit communicationError(error);
+        return false;
+    }
+
+    QVariantMap parameters;
+    parameters[parameterPath] = value;
+    return sendMessageParameters(paramInfo.messageType, parameters);
+}
+
+bool ProtocolAdapterRefactored::flushPendingUpdates() {
+    bool allSuccess = true;
+    const QList<MessageType> types = coalescing_.keys();
+    for (MessageType messageType : types) {
+        if (!flushCoalesced(messageType)) {
+            allSuccess = false;
+        }
+    }
+    return allSuccess;
+}
+
+void ProtocolAdapterRefactored::setOutboundSchedulingEnabled(bool enabled) {
+    if (schedulingEnabled_ == enabled) {
+        return;
+    }
+
+    schedulingEnabled_ = enabled;
+    if (!enabled && outboundScheduler_) {
+        outboundScheduler_->clear();
+    }
+    qInfo() << "Outbound scheduling" << (enabled ? "enabled" : "disabled");
+}
+
+void ProtocolAdapterRefactored::setDeltaMode(MessageType messageType, bool enabled) {
+    if (deltaEncoder_) {
+        deltaEncoder_->setEnabled(messageType, enabled);
+    }
+}
+
+bool ProtocolAdapterRefactored::isDeltaModeEnabled(MessageType messageType) const {
+    return deltaEncoder_ ? deltaEncoder_->isEnabled(messageType) : false;
+}
+
+void ProtocolAdapterRefactored::setKeyframeInterval(int ms) {
+    if (deltaEncoder_) {
+        deltaEncoder_->setKeyframeInterval(ms);
+    }
+}
+
+void ProtocolAdapterRefactored::setReadModifyWrite(MessageType messageType, bool enabled) {
+    if (enabled) {
+        readModifyWriteTypes_.insert(messageType);
+    } else {
+        readModifyWriteTypes_.remove(messageType);
+    }
+
+    qDebug() << "Read-modify-write" << (enabled ? "enabled" : "disabled")
+             << "for message type:" << MessageTypeUtils::toString(messageType);
+}
+
+bool ProtocolAdapterRefactored::isReadModifyWriteEnabled(MessageType messageType) const {
+    return readModifyWriteTypes_.contains(messageType);
+}
+
+void ProtocolAdapterRefactored::setStalenessPolicy(StalenessPolicy policy) {
+    stalenessPolicy_ = policy;
+}
+
+void ProtocolAdapterRefactored::setMaxStateAge(int ms) {
+    if (ms < 0) {
+        qWarning() << "Invalid max state age:" << ms;
+        return;
+    }
+    maxStateAgeMs_ = ms;
+}
+
+bool ProtocolAdapterRefactored::sendParameterElementUpdate(const QString& parameterPath, int index, const QVariant& value) {
+    if (!initialized_) {
+        qWarning() << "ProtocolAdapter not initialized";
+        emit communicationError("ProtocolAdapter not initialized");
+        return false;
+    }
+
+    if (!isConnected()) {
+        qWarning() << "Not connected, cannot send parameter update";
+        emit communicationError("Not connected");
+        return false;
+    }
+
+    auto paramInfo = parameterMapper_->getParameterInfo(parameterPath);
+    if (!paramInfo.isValid() || index < 0) {
+        QString error = QString("Invalid parameter element: %1[%2]").arg(parameterPath).arg(index);
+        qWarning() << error;
+        emit communicationError(error);
+        return false;
+    }
+
+    const MessageType messageType = paramInfo.messageType;
+
+    // 基础数组：合并窗口中尚未发出的值优先，其次取影子状态
+    QVariantList elements;
+    auto slot = coalescing_.find(messageType);
+    if (slot != coalescing_.end() && slot->pending.contains(parameterPath)) {
+        elements = slot->pending.value(parameterPath).toList();
+    } else {
+        QVariantMap cached;
+        if (writeBase(messageType, cached)) {
+            elements = cached.value(parameterPath).toList();
+        } else if (stalenessPolicy_ == StalenessPolicy::RefreshFirst) {
+            refreshThen(messageType, [this, parameterPath, index, value, messageType](bool refreshed) {
+                if (refreshed && isCachedStateUsable(messageType)) {
+                    sendParameterElementUpdate(parameterPath, index, value);
+                    return;
+                }
+                QString error = QString("Read-back failed, update dropped: %1[%2]").arg(parameterPath).arg(index);
+                qWarning() << error;
+                emit communicationError(error);
+            });
+            return true;
+        } else if (stalenessPolicy_ == StalenessPolicy::Reject) {
+            QString error = QString("Cached state unavailable for: %1").arg(parameterPath);
+            qWarning() << error;
+            emit communicationError(error);
+            return false;
+        }
+    }
+
+    // 定长数组未给出的元素为零值
+    while (elements.size() <= index) {
+        elements.append(0);
+    }
+    elements[index] = value;
+
+    return sendParameterUpdate(parameterPath, elements);
+}
+
 QString ProtocolAdapterRefactored::getProtocolVersion() const {
     return versionManager_ ? versionManager_->getCurrentVersion() : PROTOCOL_VERSION;
 }
@@ -351,19 +614,40 @@ QString ProtocolAdapterRefactored::getProtobufPath(const QString& parameterPath)
     return paramInfo.isValid() ? paramInfo.protobufPath : QString();
 }
 
-void ProtocolAdapterRefactored::handleConnectionDataReceived(const QByteArray& data) {
-    qDebug() << "Data received:" << data.size() << "bytes";
-
+void ProtocolAdapterRefactored::handleConnectionFrame(const ScatterSpan& frame) {
     // 验证协议版本（如果数据包含版本信息）
-    if (!validateProtocolVersion(data)) {
+    if (!validateProtocolVersion(frame)) {
         return; // 版本验证失败，已发出相应信号
     }
 
-    // 处理协议数据
-    processProtocolData(data);
+    // 批量帧：拆分后逐条就地处理
+    if (ProtocolPackager::isBatch(frame)) {
+        if (!ProtocolPackager::parseBatch(frame, [this](const ScatterSpan& envelope) {
+                processEnvelope(envelope);
+            })) {
+            qWarning() << "Malformed batch frame, size:" << frame.size();
+        }
+    } else {
+        processEnvelope(frame);
+    }
+
+    // 转发原始数据信号（仅在有连接时复制）
+    if (isSignalConnected(QMetaMethod::fromSignal(&ProtocolAdapterRefactored::dataReceived))) {
+        emit dataReceived(frame.toByteArray());
+    }
+}
 
-    // 转发原始数据信号
-    emit dataReceived(data);
+void ProtocolAdapterRefactored::handleFrameAcknowledged(quint32 sequence, int protoId, int roundTripMs) {
+    Q_UNUSED(protoId);
+    Q_UNUSED(roundTripMs);
+    finishWrite(sequence, true);
+}
+
+void ProtocolAdapterRefactored::handleFrameFailed(quint32 sequence, const QString& error) {
+    if (sentWrites_.contains(sequence)) {
+        qDebug() << "Write frame" << sequence << "not confirmed:" << error;
+        finishWrite(sequence, false);
+    }
 }
 
 void ProtocolAdapterRefactored::handleConnectionError(const QString& error) {
@@ -373,6 +657,28 @@ void ProtocolAdapterRefactored::handleConnectionError(const QString& error) {
 
 void ProtocolAdapterRefactored::handleConnectionStatusChanged(bool connected) {
     qInfo() << "Connection status changed:" << connected;
+
+    // 链路状态变化后设备端状态未知，下一帧必须是关键帧
+    deltaEncoder_->invalidateAll();
+    sentWrites_.clear();
+
+    // 可能换了设备，重新协商能力，之前设备的状态不能再作为读-改-写的基础
+    messageSerializer_->resetNegotiation();
+    outboundScheduler_->setBatchingEnabled(false);
+    shadowState_->clear();
+    unconfirmedWrites_.clear();
+
+    if (!connected) {
+        outboundScheduler_->clear();
+
+        // 断线后缓冲的更新已无法送达
+        for (auto it = coalescing_.begin(); it != coalescing_.end(); ++it) {
+            it->timer->stop();
+            it->pending.clear();
+        }
+
+        failAllRequests("Connection lost");
+    }
     emit connectionStatusChanged(connected);
 }
 
@@ -388,19 +694,66 @@ void ProtocolAdapterRefactored::handleMappingLoaded(bool success, const QString&
     if (!success) {
         qWarning() << "Mapping load error:" << errorMessage;
     }
+
+    // 重新加载映射后参数ID失效
+    rebuildChangeRouting();
     emit mappingLoaded(success, errorMessage);
 }
 
+void ProtocolAdapterRefactored::handleRequestTimeout() {
+    const qint64 now = requestClock_.elapsed();
+
+    // 先取出所有超时的请求，回调中可能发起新请求
+    QList<PendingRequest> expired;
+    for (int i = 0; i < outstandingRequests_.size();) {
+        if (outstandingRequests_[i].deadlineMs <= now) {
+            expired.append(outstandingRequests_.takeAt(i));
+        } else {
+            ++i;
+        }
+    }
+
+    for (const PendingRequest& request : expired) {
+        if (!request.cancelled) {
+            qWarning() << "Request" << request.requestId << "timed out after" << request.timeoutMs << "ms";
+        }
+        finishRequest(request, false, QString("Request timed out after %1 ms").arg(request.timeoutMs));
+    }
+
+    dispatchQueuedRequests();
+    rearmRequestTimer();
+}
+
 void ProtocolAdapterRefactored::initializeComponents() {
     // 创建组件
     parameterMapper_ = std::make_unique<ParameterMapper>(this);
+    shadowState_ = std::make_unique<ShadowStateStore>();
+    timeSeries_ = std::make_unique<TimeSeriesStore>();
+    messageBus_ = std::make_unique<MessageBus>(this);
     messageSerializer_ = std::make_unique<MessageSerializer>(this);
+    messageSerializer_->setShadowStateStore(shadowState_.get());
+    messageSerializer_->setTimeSeriesStore(timeSeries_.get());
+    messageSerializer_->setMessageBus(messageBus_.get());
+    shadowState_->setChangeListener([this](const ShadowStateStore::ChangeSet& changes) {
+        handleStateChanged(changes);
+    });
     connectionManager_ = std::make_unique<ConnectionManager>(this);
     versionManager_ = std::make_unique<VersionManager>(this);
+    deltaEncoder_ = std::make_unique<DeltaEncoder>();
+    outboundScheduler_ = std::make_unique<OutboundScheduler>(connectionManager_.get(), this);
+
+    // 异步请求超时定时器
+    requestTimer_ = new QTimer(this);
+    requestTimer_->setSingleShot(true);
+    connect(requestTimer_, &QTimer::timeout, this, &ProtocolAdapterRefactored::handleRequestTimeout);
+    requestClock_.start();
 
     // 设置版本管理器
     versionManager_->setCurrentVersion(PROTOCOL_VERSION);
 
+    // 默认映射的变化通知路由
+    rebuildChangeRouting();
+
     // 连接组件信号
     connectComponentSignals();
 
@@ -409,17 +762,23 @@ void ProtocolAdapterRefactored::initializeComponents() {
 }
 
 void ProtocolAdapterRefactored::connectComponentSignals() {
-    if (!initialized_) {
-        return;
-    }
-
     // 连接ConnectionManager信号
-    connect(connectionManager_.get(), &ConnectionManager::dataReceived,
-            this, &ProtocolAdapterRefactored::handleConnectionDataReceived);
+    frameSinkId_ = connectionManager_->addFrameSink([this](const ScatterSpan& frame) {
+        handleConnectionFrame(frame);
+    });
     connect(connectionManager_.get(), &ConnectionManager::communicationError,
             this, &ProtocolAdapterRefactored::handleConnectionError);
     connect(connectionManager_.get(), &ConnectionManager::connectionStatusChanged,
             this, &ProtocolAdapterRefactored::handleConnectionStatusChanged);
+    connect(connectionManager_.get(), &ConnectionManager::frameAcknowledged,
+            this, &ProtocolAdapterRefactored::handleFrameAcknowledged);
+    connect(connectionManager_.get(), &ConnectionManager::frameFailed,
+            this, &ProtocolAdapterRefactored::handleFrameFailed);
+
+    // 对端支持批量帧时启用合并发送
+    connect(messageSerializer_.get(), &MessageSerializer::capabilitiesNegotiated, this, [this](quint32 capabilities) {
+        outboundScheduler_->setBatchingEnabled((capabilities & ProtocolPackager::CAPABILITY_BATCH) != 0);
+    });
 
     // 连接VersionManager信号
     connect(versionManager_.get(), &VersionManager::versionIncompatible,
@@ -439,6 +798,8 @@ void ProtocolAdapterRefactored::disconnectComponentSignals() {
 
     // 断开所有组件信号
     if (connectionManager_) {
+        connectionManager_->removeFrameSink(frameSinkId_);
+        frameSinkId_ = -1;
         disconnect(connectionManager_.get(), nullptr, this, nullptr);
     }
     if (versionManager_) {
@@ -447,10 +808,78 @@ void ProtocolAdapterRefactored::disconnectComponentSignals() {
     if (parameterMapper_) {
         disconnect(parameterMapper_.get(), nullptr, this, nullptr);
     }
+    if (messageSerializer_) {
+        disconnect(messageSerializer_.get(), nullptr, this, nullptr);
+    }
 
     qDebug() << "Component signals disconnected";
 }
 
+void ProtocolAdapterRefactored::handleStateChanged(const ShadowStateStore::ChangeSet& changes) {
+    // 影子状态可能在其他线程写入，路由表只在适配器线程访问
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [this, changes]() {
+            handleStateChanged(changes);
+        }, Qt::QueuedConnection);
+        return;
+    }
+
+    auto it = changeRouting_.constFind(changes.messageType);
+    if (it == changeRouting_.constEnd()) {
+        return;
+    }
+
+    const QVector<QList<ParamId>>& routing = it.value();
+    QList<ParamId> ids;
+    for (int field = 0; field < routing.size(); ++field) {
+        if (changes.contains(field)) {
+            ids.append(routing[field]);
+        }
+    }
+
+    if (!ids.isEmpty()) {
+        emit parametersChanged(changes.messageType, ids);
+    }
+}
+
+void ProtocolAdapterRefactored::rebuildChangeRouting() {
+    changeRouting_.clear();
+    if (!parameterMapper_) {
+        return;
+    }
+
+    int routed = 0;
+    for (int id = 0; id < parameterMapper_->parameterIdCount(); ++id) {
+        const ParameterInfo* info = parameterMapper_->findParameterInfo(static_cast<ParamId>(id));
+        if (!info || !ShadowStateStore::isTracked(info->messageType)) {
+            continue;
+        }
+
+        // protobuf路径可能带数组下标或子字段，只取顶层字段名
+        QString fieldName = info->protobufPath;
+        for (int i = 0; i < fieldName.size(); ++i) {
+            if (fieldName[i] == QLatin1Char('[') || fieldName[i] == QLatin1Char('.')) {
+                fieldName.truncate(i);
+                break;
+            }
+        }
+
+        const int field = ShadowStateStore::fieldIndex(info->messageType, fieldName);
+        if (field < 0) {
+            continue;
+        }
+
+        QVector<QList<ParamId>>& routing = changeRouting_[info->messageType];
+        if (routing.isEmpty()) {
+            routing.resize(ShadowStateStore::fieldCount(info->messageType));
+        }
+        routing[field].append(static_cast<ParamId>(id));
+        routed++;
+    }
+
+    qDebug() << "Change notification routing rebuilt:" << routed << "parameters";
+}
+
 MessageType ProtocolAdapterRefactored::getMessageTypeFromPath(const QString& parameterPath) const {
     if (!parameterMapper_) {
         return MessageType::ANC_SWITCH; // 默认类型
@@ -460,20 +889,47 @@ MessageType ProtocolAdapterRefactored::getMessageTypeFromPath(const QString& par
     return paramInfo.isValid() ? paramInfo.messageType : MessageType::ANC_SWITCH;
 }
 
-void ProtocolAdapterRefactored::processProtocolData(const QByteArray& data) {
-    // 尝试反序列化数据
+void ProtocolAdapterRefactored::processEnvelope(const ScatterSpan& envelope) {
+    int protoId = 0;
+    FunctionCode functionCode = FunctionCode::REQUEST;
+    quint32 sequence = 0;
+    if (!ProtocolPackager::peekEnvelope(envelope, protoId, functionCode, &sequence)) {
+        // 不是MsgRequestResponse格式：尝试按旧格式反序列化
+        QVariantMap parameters;
+        if (deserializeParameters(envelope.toByteArray(), parameters)) {
+            qDebug() << "Protocol data processed successfully, parameters:" << parameters.size();
+        } else {
+            qWarning() << "Failed to process protocol data";
+        }
+        return;
+    }
+
+    // RESPONSE用于完成对应的异步请求，只有此时才需要参数映射
+    const bool wantsParameters = functionCode == FunctionCode::RESPONSE
+                                 && awaitsResponse(static_cast<MessageType>(protoId));
     QVariantMap parameters;
-    if (deserializeParameters(data, parameters)) {
-        qDebug() << "Protocol data processed successfully, parameters:" << parameters.size();
+    MessageType messageType;
+    if (!messageSerializer_->receive(envelope, messageType, functionCode, wantsParameters ? &parameters : nullptr)) {
+        qWarning() << "Failed to process protocol data, ProtoID:" << protoId;
+        return;
+    }
 
-        // 可以在这里添加特定的协议处理逻辑
-        // 例如自动回复、状态更新等
-    } else {
-        qWarning() << "Failed to process protocol data";
+    // 写入由ConnectionManager按序号（旧版设备按ProtoID）匹配应答后经frameAcknowledged确认
+    if (wantsParameters) {
+        completeRequest(messageType, sequence, parameters);
+    }
+}
+
+bool ProtocolAdapterRefactored::awaitsResponse(MessageType messageType) const {
+    for (const PendingRequest& request : outstandingRequests_) {
+        if (request.messageType == messageType) {
+            return true;
+        }
     }
+    return false;
 }
 
-bool ProtocolAdapterRefactored::validateProtocolVersion(const QByteArray& data) {
+bool ProtocolAdapterRefactored::validateProtocolVersion(const ScatterSpan& data) {
     // 简化实现：假设数据包不包含版本信息
     // 实际实现中可能需要解析数据包头部的版本字段
     Q_UNUSED(data)
@@ -484,4 +940,377 @@ bool ProtocolAdapterRefactored::validateProtocolVersion(const QByteArray& data)
     return true; // 暂时总是返回true
 }
 
+quint32 ProtocolAdapterRefactored::enqueueRequest(MessageType messageType, const QByteArray& data,
+                                                  RequestCallback callback, int timeoutMs) {
+    PendingRequest request;
+    request.requestId = nextRequestId_++;
+    if (nextRequestId_ == 0) {
+        nextRequestId_ = 1; // 0保留为无效ID
+    }
+    request.messageType = messageType;
+    request.sequence = connectionManager_->allocateSequence();
+    request.data = ProtocolPackager::appendSequence(data, request.sequence);
+    request.callback = std::move(callback);
+    request.timeoutMs = timeoutMs > 0 ? timeoutMs : requestTimeoutMs_;
+
+    quint32 requestId = request.requestId;
+    queuedRequests_.enqueue(std::move(request));
+
+    dispatchQueuedRequests();
+    rearmRequestTimer();
+    return requestId;
+}
+
+void ProtocolAdapterRefactored::dispatchQueuedRequests() {
+    while (outstandingRequests_.size() < maxOutstandingRequests_ && !queuedRequests_.isEmpty()) {
+        PendingRequest request = queuedRequests_.dequeue();
+
+        if (!transmit(request.messageType, request.data)) {
+            finishRequest(request, false, "Failed to send request");
+            continue;
+        }
+
+        request.sentAtMs = requestClock_.elapsed();
+        request.deadlineMs = request.sentAtMs + request.timeoutMs;
+        outstandingRequests_.append(std::move(request));
+    }
+}
+
+void ProtocolAdapterRefactored::completeRequest(MessageType messageType, quint32 sequence,
+                                                const QVariantMap& parameters) {
+    // 设备带回序号时按序号匹配；旧版设备不带回序号，同一ProtoID的请求按发送顺序匹配
+    for (int i = 0; i < outstandingRequests_.size(); ++i) {
+        if (outstandingRequests_[i].messageType != messageType
+            || (sequence != 0 && outstandingRequests_[i].sequence != sequence)) {
+            continue;
+        }
+
+        PendingRequest request = outstandingRequests_.takeAt(i);
+        finishRequest(request, true, QString(), parameters);
+        dispatchQueuedRequests();
+        rearmRequestTimer();
+        return;
+    }
+
+    qDebug() << "Unsolicited response for message type:" << static_cast<int>(messageType)
+             << "sequence:" << sequence;
+}
+
+void ProtocolAdapterRefactored::finishRequest(const PendingRequest& request, bool success,
+                                              const QString& error, const QVariantMap& parameters) {
+    if (request.cancelled) {
+        return;
+    }
+
+    RequestResult result;
+    result.requestId = request.requestId;
+    result.messageType = request.messageType;
+    result.success = success;
+    result.parameters = parameters;
+    result.error = error;
+    if (success) {
+        result.roundTripMs = static_cast<int>(requestClock_.elapsed() - request.sentAtMs);
+    }
+
+    if (request.callback) {
+        request.callback(result);
+    }
+    emit requestCompleted(request.requestId, success, error);
+}
+
+void ProtocolAdapterRefactored::rearmRequestTimer() {
+    if (!requestTimer_) {
+        return;
+    }
+
+    if (outstandingRequests_.isEmpty()) {
+        requestTimer_->stop();
+        return;
+    }
+
+    qint64 earliest = outstandingRequests_.first().deadlineMs;
+    for (const PendingRequest& request : outstandingRequests_) {
+        earliest = qMin(earliest, request.deadlineMs);
+    }
+
+    qint64 delay = qMax<qint64>(0, earliest - requestClock_.elapsed());
+    requestTimer_->start(static_cast<int>(delay));
+}
+
+void ProtocolAdapterRefactored::failAllRequests(const QString& error) {
+    if (requestTimer_) {
+        requestTimer_->stop();
+    }
+
+    if (outstandingRequests_.isEmpty() && queuedRequests_.isEmpty()) {
+        return;
+    }
+
+    QList<PendingRequest> dropped;
+    dropped.swap(outstandingRequests_);
+    while (!queuedRequests_.isEmpty()) {
+        dropped.append(queuedRequests_.dequeue());
+    }
+
+    qWarning() << "Failing" << dropped.size() << "pending requests:" << error;
+    for (const PendingRequest& request : dropped) {
+        finishRequest(request, false, error);
+    }
+}
+
+bool ProtocolAdapterRefactored::sendMessageParameters(MessageType messageType, const QVariantMap& parameters) {
+    // 先并入该类型尚在合并窗口中的更新，避免稍后发出的旧值覆盖本次的新值
+    QVariantMap groupParams = takePendingUpdates(messageType);
+    for (auto it = parameters.constBegin(); it != parameters.constEnd(); ++it) {
+        groupParams.insert(it.key(), it.value());
+    }
+
+    if (groupParams.isEmpty()) {
+        return true;
+    }
+
+    if (!isConnected()) {
+        qWarning() << "Not connected, cannot send message type:" << static_cast<int>(messageType);
+        emit communicationError("Not connected");
+        return false;
+    }
+
+    const QStringList paths = groupParams.keys();
+
+    // 读-改-写：以最后已知值补全未给出的字段
+    bool readModifyWrite = readModifyWriteTypes_.contains(messageType);
+    if (readModifyWrite) {
+        QVariantMap cached;
+        if (writeBase(messageType, cached)) {
+            for (auto it = groupParams.constBegin(); it != groupParams.constEnd(); ++it) {
+                cached.insert(it.key(), it.value());
+            }
+            groupParams.swap(cached);
+        } else if (stalenessPolicy_ == StalenessPolicy::RefreshFirst) {
+            qDebug() << "Cached state unavailable, reading back before write:"
+                     << MessageTypeUtils::toString(messageType);
+            refreshThen(messageType, [this, messageType, groupParams](bool refreshed) {
+                if (refreshed && isCachedStateUsable(messageType)) {
+                    sendMessageParameters(messageType, groupParams);
+                    return;
+                }
+                QString error = QString("Read-back failed, update dropped for message type: %1")
+                                    .arg(MessageTypeUtils::toString(messageType));
+                qWarning() << error;
+                emit communicationError(error);
+            });
+            return true;
+        } else if (stalenessPolicy_ == StalenessPolicy::Reject) {
+            QString error = QString("Cached state unavailable for message type: %1")
+                                .arg(MessageTypeUtils::toString(messageType));
+            qWarning() << error;
+            emit communicationError(error);
+            return false;
+        } else {
+            readModifyWrite = false;
+        }
+    }
+    const QVariantMap fullState = groupParams;
+
+    // 增量模式：状态与设备已确认的完全相同时跳过本次发送，有变化时仍发送完整消息。
+    // 读-改-写自带补全，不经过增量编码，并使增量基线失效，之后的帧从关键帧开始
+    bool keyframe = false;
+    bool deltaMode = deltaEncoder_->isEnabled(messageType);
+    if (deltaMode && readModifyWrite) {
+        deltaEncoder_->invalidate(messageType);
+        deltaMode = false;
+    }
+    if (deltaMode) {
+        groupParams = deltaEncoder_->encode(messageType, groupParams, keyframe);
+        if (groupParams.isEmpty()) {
+            for (const QString& path : paths) {
+                emit parameterAcknowledged(path);
+            }
+            return true;
+        }
+    }
+
+    QByteArray data = messageSerializer_->serialize(messageType, groupParams, FunctionCode::REQUEST, true);
+    if (data.isEmpty()) {
+        QString error = QString("Failed to serialize message type: %1").arg(static_cast<int>(messageType));
+        qWarning() << error;
+        emit communicationError(error);
+        return false;
+    }
+
+    // 影子状态只由设备应答更新；应答到达前，后续读-改-写以本次发出的完整消息为基础
+    if (readModifyWrite) {
+        UnconfirmedWrite& write = unconfirmedWrites_[messageType];
+        write.parameters = fullState;
+        write.pending++;
+    }
+
+    // 经发送窗口的写入预先写入序号，设备确认后才推进增量基准、结束读-改-写并通知参数。
+    // 未要求确认时写入成功即确认，须在发送前登记
+    const bool acknowledged = sendsReliably(messageType);
+    quint32 sequence = 0;
+    if (acknowledged) {
+        sequence = connectionManager_->allocateSequence();
+        data = ProtocolPackager::appendSequence(data, sequence);
+
+        SentWrite write;
+        write.messageType = messageType;
+        write.paths = paths;
+        write.state = groupParams;
+        write.delta = deltaMode;
+        write.keyframe = keyframe;
+        write.readModifyWrite = readModifyWrite;
+        sentWrites_.insert(sequence, write);
+    }
+
+    bool success = transmit(messageType, data);
+    if (!success) {
+        if (acknowledged) {
+            finishWrite(sequence, false);
+        } else {
+            if (deltaMode) {
+                deltaEncoder_->invalidate(messageType);
+            }
+            if (readModifyWrite) {
+                releaseWrite(messageType);
+            }
+        }
+        QString error = QString("Failed to send message type: %1").arg(static_cast<int>(messageType));
+        qWarning() << error;
+        emit communicationError(error);
+        return false;
+    }
+
+    // 不经发送窗口的周期状态没有确认：写入成功即作为增量基准（由关键帧间隔重新同步）并通知参数，
+    // 读-改-写以最后一次发出的值为基础，直到连接状态变化
+    if (!acknowledged) {
+        if (deltaMode) {
+            deltaEncoder_->commit(messageType, groupParams, keyframe);
+        }
+        for (const QString& path : paths) {
+            emit parameterAcknowledged(path);
+        }
+    }
+    return true;
+}
+
+void ProtocolAdapterRefactored::finishWrite(quint32 sequence, bool confirmed) {
+    auto it = sentWrites_.find(sequence);
+    if (it == sentWrites_.end()) {
+        return;
+    }
+    const SentWrite write = it.value();
+    sentWrites_.erase(it);
+
+    if (write.delta) {
+        if (confirmed) {
+            deltaEncoder_->commit(write.messageType, write.state, write.keyframe);
+        } else {
+            deltaEncoder_->invalidate(write.messageType);
+        }
+    }
+
+    if (write.readModifyWrite) {
+        releaseWrite(write.messageType);
+    }
+
+    if (confirmed) {
+        for (const QString& path : write.paths) {
+            emit parameterAcknowledged(path);
+        }
+    }
+}
+
+bool ProtocolAdapterRefactored::isCachedStateUsable(MessageType messageType) const {
+    const qint64 age = shadowState_->ageMs(messageType);
+    return age >= 0 && (maxStateAgeMs_ <= 0 || age <= maxStateAgeMs_);
+}
+
+bool ProtocolAdapterRefactored::writeBase(MessageType messageType, QVariantMap& parameters) const {
+    auto write = unconfirmedWrites_.constFind(messageType);
+    if (write != unconfirmedWrites_.constEnd()) {
+        parameters = write->parameters;
+        return true;
+    }
+    return cachedParameters(messageType, parameters);
+}
+
+void ProtocolAdapterRefactored::releaseWrite(MessageType messageType) {
+    auto write = unconfirmedWrites_.find(messageType);
+    if (write != unconfirmedWrites_.end() && --write->pending <= 0) {
+        unconfirmedWrites_.erase(write);
+    }
+}
+
+bool ProtocolAdapterRefactored::cachedParameters(MessageType messageType, QVariantMap& parameters) const {
+    if (!isCachedStateUsable(messageType)) {
+        return false;
+    }
+
+    QByteArray payload;
+    if (!shadowState_->encode(messageType, payload)) {
+        return false;
+    }
+    return messageSerializer_->decodeParameters(messageType, payload, parameters);
+}
+
+void ProtocolAdapterRefactored::refreshThen(MessageType messageType, std::function<void(bool)> continuation) {
+    auto waiting = refreshWaiters_.find(messageType);
+    if (waiting != refreshWaiters_.end()) {
+        waiting->append(std::move(continuation));
+        return;
+    }
+    refreshWaiters_[messageType].append(std::move(continuation));
+
+    // RESPONSE先经解码路径更新影子状态，再完成请求
+    quint32 requestId = requestMessage(messageType, [this, messageType](const RequestResult& result) {
+        const QList<std::function<void(bool)>> waiters = refreshWaiters_.take(messageType);
+        for (const auto& waiter : waiters) {
+            waiter(result.success);
+        }
+    });
+
+    if (requestId == 0) {
+        const QList<std::function<void(bool)>> waiters = refreshWaiters_.take(messageType);
+        for (const auto& waiter : waiters) {
+            waiter(false);
+        }
+    }
+}
+
+bool ProtocolAdapterRefactored::flushCoalesced(MessageType messageType) {
+    return sendMessageParameters(messageType, QVariantMap());
+}
+
+QVariantMap ProtocolAdapterRefactored::takePendingUpdates(MessageType messageType) {
+    auto slot = coalescing_.find(messageType);
+    if (slot == coalescing_.end() || slot->pending.isEmpty()) {
+        return QVariantMap();
+    }
+
+    slot->timer->stop();
+    QVariantMap pending;
+    pending.swap(slot->pending);
+    return pending;
+}
+
+bool ProtocolAdapterRefactored::sendsReliably(MessageType messageType) const {
+    // 与调度器的通道划分一致：流式通道不经发送窗口
+    return OutboundScheduler::isReliable(outboundScheduler_->laneForMessageType(messageType));
+}
+
+bool ProtocolAdapterRefactored::transmit(MessageType messageType, const QByteArray& data) {
+    if (schedulingEnabled_ && outboundScheduler_) {
+        return outboundScheduler_->enqueue(messageType, data);
+    }
+
+    // 周期性状态流下一周期即被新值覆盖，直接发送，不占用发送窗口
+    if (!sendsReliably(messageType)) {
+        return connectionManager_->sendData(data);
+    }
+
+    // 经发送窗口发送，未收到设备RESPONSE时自动重传
+    return connectionManager_->sendReliable(data) != 0;
+}
+
 } // namespace Protocol
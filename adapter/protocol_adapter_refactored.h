@@ -7,13 +7,26 @@
 #include <QStringList>
 #include <QByteArray>
 #include <QString>
+#include <QList>
+#include <QHash>
+#include <QSet>
+#include <QQueue>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QVector>
+#include <functional>
 #include <memory>
 
 #include "protocol/transport/itransport.h"
 #include "protocol/core/message_types.h"
 #include "protocol/mapping/parameter_mapper.h"
 #include "protocol/serialization/message_serializer.h"
+#include "protocol/serialization/delta_encoder.h"
+#include "protocol/serialization/message_bus.h"
+#include "protocol/state/shadow_state_store.h"
+#include "protocol/state/time_series_store.h"
 #include "protocol/connection/connection_manager.h"
+#include "protocol/connection/outbound_scheduler.h"
 #include "protocol/version/version_manager.h"
 
 namespace Protocol {
@@ -48,6 +61,13 @@ public:
     // 发送单个参数更新
     bool sendParameterUpdate(const QString& parameterPath, const QVariant& value);
 
+    // 按参数ID发送单个参数更新（跳过路径哈希和调试输出，用于高频调用）。
+    // 消息处理器按路径取值，本次更新仍以驻留的路径为键构造一项参数映射，并非免分配路径
+    bool sendParameterUpdate(ParamId id, const QVariant& value);
+
+    // 解析参数路径为参数ID，不支持的参数返回INVALID_PARAM_ID
+    ParamId parameterId(const QString& parameterPath) const;
+
     // 发送参数组更新
     bool sendParameterGroup(const QStringList& paths, const QVariantMap& values);
 
@@ -57,6 +77,140 @@ public:
     // 从字节数组反序列化参数
     bool deserializeParameters(const QByteArray& data, QVariantMap& parameters);
 
+    /**
+     * @brief 异步请求接口
+     *
+     * 每个REQUEST获得本地请求ID，信封中携带请求序号。设备在RESPONSE中带回序号时按序号完成对应请求，
+     * 旧版设备不带回序号，同一ProtoID按发送顺序匹配。超时或连接断开时以失败完成。在途请求数达到上限时后续请求在本地排队，
+     * 因此多个请求可以在同一个往返窗口内流水线发送。
+     */
+
+    // 异步请求结果
+    struct RequestResult {
+        quint32 requestId = 0;
+        MessageType messageType = MessageType::ANC_SWITCH;
+        bool success = false;
+        QVariantMap parameters;             // RESPONSE解码出的参数
+        QString error;
+        int roundTripMs = 0;                // 从发送到收到RESPONSE的时间（毫秒）
+    };
+
+    // 请求完成回调，在适配器所在线程调用
+    using RequestCallback = std::function<void(const RequestResult&)>;
+
+    // 发送指定消息类型的REQUEST，返回请求ID，失败返回0（timeoutMs<=0使用默认超时）
+    quint32 sendRequest(MessageType messageType, const QVariantMap& parameters,
+                        RequestCallback callback = RequestCallback(), int timeoutMs = -1);
+
+    // 异步发送单个参数更新
+    quint32 sendParameterUpdateAsync(const QString& parameterPath, const QVariant& value,
+                                     RequestCallback callback = RequestCallback(), int timeoutMs = -1);
+
+    // 回读消息当前值（发送不带载荷字段的REQUEST，不会被设备当作写入）
+    quint32 requestMessage(MessageType messageType,
+                           RequestCallback callback = RequestCallback(), int timeoutMs = -1);
+
+    // 回读所有支持的消息类型，返回各请求ID
+    QList<quint32> requestAllMessages(RequestCallback callback = RequestCallback(), int timeoutMs = -1);
+
+    // 取消尚未完成的请求（回调不再调用）。已发出的请求仍占用在途名额直到应答或超时，
+    // 迟到的应答不会被记到之后发出的同类型请求上
+    bool cancelRequest(quint32 requestId);
+
+    // 最大在途请求数
+    void setMaxOutstandingRequests(int count);
+    int maxOutstandingRequests() const { return maxOutstandingRequests_; }
+
+    // 默认请求超时（毫秒）
+    void setRequestTimeout(int ms);
+    int requestTimeout() const { return requestTimeoutMs_; }
+
+    // 在途请求数与排队请求数
+    int outstandingRequestCount() const { return outstandingRequests_.size(); }
+    int queuedRequestCount() const { return queuedRequests_.size(); }
+
+    /**
+     * @brief 发送合并接口
+     *
+     * 为消息类型设置合并窗口后，sendParameterUpdate对该类型的更新先在窗口内缓冲，
+     * 同一字段后写覆盖先写，窗口结束时每种消息类型只发送一条消息。
+     * 控制类消息可用sendParameterUpdateImmediate绕过窗口立即发送。
+     */
+
+    // 设置消息类型的合并窗口（毫秒，如5~20），0表示关闭（默认）
+    void setCoalescingWindow(MessageType messageType, int ms);
+    int coalescingWindow(MessageType messageType) const;
+
+    // 立即发送单个参数（连同该类型已缓冲的更新）
+    bool sendParameterUpdateImmediate(const QString& parameterPath, const QVariant& value);
+
+    // 立即发送所有已缓冲的更新
+    bool flushPendingUpdates();
+
+    /**
+     * @brief 发送调度接口
+     *
+     * 启用后所有发送按消息类型进入OutboundScheduler的控制/流式/批量通道，
+     * 控制命令不会被批量标定数据阻塞。通道映射、优先级策略和限速通过outboundScheduler()配置。
+     */
+
+    // 启用/关闭发送调度（默认关闭，直接发送）
+    void setOutboundSchedulingEnabled(bool enabled);
+    bool isOutboundSchedulingEnabled() const { return schedulingEnabled_; }
+
+    /**
+     * @brief 增量发送接口
+     *
+     * 对高频周期消息（如VEHICLE_STATE、CHANNEL_AMPLITUDE）在状态与设备已确认的相同时跳过发送，
+     * 有变化时发送完整消息（设备把缺省字段当作零值），并按间隔发送关键帧，
+     * 作用于sendParameterUpdate和sendParameterGroup。经发送窗口的帧在设备确认后才推进基准。
+     */
+
+    // 启用/关闭指定消息类型的增量模式（默认关闭）
+    void setDeltaMode(MessageType messageType, bool enabled);
+    bool isDeltaModeEnabled(MessageType messageType) const;
+
+    // 关键帧间隔（毫秒）
+    void setKeyframeInterval(int ms);
+
+    /**
+     * @brief 读-改-写发送接口
+     *
+     * 处理器按零值初始化消息结构体，只给出部分字段时其余字段会以零值覆盖设备上的参数。
+     * 启用读-改-写后，发送以影子状态中该消息的最后已知值为基础，只替换本次给出的字段，
+     * 单字段修改无需先回读设备。影子状态只由设备应答更新；已发出但设备尚未应答的写入
+     * 作为后续读-改-写的基础，避免连续修改互相覆盖。读-改-写的消息总是完整发送，不做增量编码。
+     * 影子状态未知或超过有效期时按StalenessPolicy处理；连接状态变化时影子状态被清空。
+     */
+
+    // 影子状态不可用时的处理策略
+    enum class StalenessPolicy {
+        Reject,             // 拒绝发送并报告错误
+        RefreshFirst,       // 先回读设备当前值，收到RESPONSE后再发送（默认）
+        SendPartial         // 按原方式只发送给出的字段，其余字段为零值
+    };
+
+    // 启用/关闭指定消息类型的读-改-写（默认关闭）
+    void setReadModifyWrite(MessageType messageType, bool enabled);
+    bool isReadModifyWriteEnabled(MessageType messageType) const;
+
+    void setStalenessPolicy(StalenessPolicy policy);
+    StalenessPolicy stalenessPolicy() const { return stalenessPolicy_; }
+
+    // 影子状态有效期（毫秒），超过后视为过期，0表示不过期（默认）
+    void setMaxStateAge(int ms);
+    int maxStateAge() const { return maxStateAgeMs_; }
+
+    // 影子状态是否存在且未超过有效期
+    bool isCachedStateUsable(MessageType messageType) const;
+
+    // 从影子状态构建该消息类型的完整参数映射，影子状态不可用时返回false
+    bool cachedParameters(MessageType messageType, QVariantMap& parameters) const;
+
+    // 修改数组参数中的单个元素，其余元素取自合并缓冲或影子状态
+    // （消息中的其他字段仅在该类型启用读-改-写时补全）
+    bool sendParameterElementUpdate(const QString& parameterPath, int index, const QVariant& value);
+
     /**
      * @brief 协议信息接口
      */
@@ -112,10 +266,28 @@ public:
     // 获取版本管理器
     VersionManager* versionManager() const { return versionManager_.get(); }
 
+    // 获取发送调度器
+    OutboundScheduler* outboundScheduler() const { return outboundScheduler_.get(); }
+
+    // 获取增量编码器
+    DeltaEncoder* deltaEncoder() const { return deltaEncoder_.get(); }
+
+    // 获取设备参数影子状态（收到的每种消息的最后一次解码结果，可在任意线程无锁读取）
+    ShadowStateStore* shadowState() const { return shadowState_.get(); }
+
+    // 获取通道幅值和实时数据的时间序列（带min/max抽稀，曲线界面可在任意线程无锁读取）
+    TimeSeriesStore* timeSeries() const { return timeSeries_.get(); }
+
+    // 获取消息总线（按ProtoID订阅收到的消息，回调得到解码后的MSG_*结构体）
+    MessageBus* messageBus() const { return messageBus_.get(); }
+
 signals:
-    // 参数确认信号
+    // 参数确认信号：设备带回该写入的应答后发出；流式通道的周期状态没有应答，写入传输层后发出
     void parameterAcknowledged(const QString& path);
 
+    // 设备参数变化信号：每条内容变化的消息发出一次，只包含值实际变化的参数ID
+    void parametersChanged(MessageType messageType, const QList<ParamId>& ids);
+
     // 通信错误信号
     void communicationError(const QString& error);
 
@@ -131,10 +303,10 @@ signals:
     // 参数映射加载完成信号
     void mappingLoaded(bool success, const QString& errorMessage = QString());
 
-private slots:
-    // 处理连接管理器的数据接收
-    void handleConnectionDataReceived(const QByteArray& data);
+    // 异步请求完成信号
+    void requestCompleted(quint32 requestId, bool success, const QString& error);
 
+private slots:
     // 处理连接管理器的错误
     void handleConnectionError(const QString& error);
 
@@ -149,6 +321,15 @@ private slots:
     // 处理参数映射加载结果
     void handleMappingLoaded(bool success, const QString& errorMessage);
 
+    // 处理异步请求超时
+    void handleRequestTimeout();
+
+    // 可靠发送的帧被设备确认
+    void handleFrameAcknowledged(quint32 sequence, int protoId, int roundTripMs);
+
+    // 可靠发送的帧最终失败（超时、被替换或断线）
+    void handleFrameFailed(quint32 sequence, const QString& error);
+
 private:
     /**
      * @brief 初始化组件
@@ -173,27 +354,209 @@ private:
     MessageType getMessageTypeFromPath(const QString& parameterPath) const;
 
     /**
-     * @brief 处理接收到的协议数据
-     * @param data 接收的数据
+     * @brief 处理连接管理器解析出的一帧（帧回调，视图只在调用期间有效）
+     * @param frame 帧载荷：单条MsgRequestResponse或批量帧
+     */
+    void handleConnectionFrame(const ScatterSpan& frame);
+
+    /**
+     * @brief 就地处理一条消息
+     *
+     * 只有等待该类型应答的请求需要参数映射，其余消息直接解码到影子状态、时间序列和总线订阅者。
+     * @param envelope MsgRequestResponse数据（非该格式时按旧格式尝试解析）
+     */
+    void processEnvelope(const ScatterSpan& envelope);
+
+    /**
+     * @brief 是否有在途请求等待该类型的RESPONSE
      */
-    void processProtocolData(const QByteArray& data);
+    bool awaitsResponse(MessageType messageType) const;
+
+    /**
+     * @brief 处理影子状态的字段级变更集，转换为参数ID后发出parametersChanged
+     * @param changes 变更集
+     */
+    void handleStateChanged(const ShadowStateStore::ChangeSet& changes);
+
+    /**
+     * @brief 按当前参数映射重建（消息类型, 字段序号）到参数ID的路由表
+     */
+    void rebuildChangeRouting();
 
     /**
      * @brief 验证协议版本
      * @param data 接收的数据
      * @return 版本验证成功返回true
      */
-    bool validateProtocolVersion(const QByteArray& data);
+    bool validateProtocolVersion(const ScatterSpan& data);
+
+    /**
+     * @brief 发送已序列化的消息
+     *
+     * 启用调度时进入对应通道；否则流式通道的周期性状态直接发送，其余经ConnectionManager可靠发送。
+     * @return 发送或入队成功返回true
+     */
+    bool transmit(MessageType messageType, const QByteArray& data);
+
+    /**
+     * @brief 该类型是否经ConnectionManager发送窗口发送（设备确认后发出frameAcknowledged）
+     */
+    bool sendsReliably(MessageType messageType) const;
+
+    /**
+     * @brief 发送一种消息类型的参数（并入合并缓冲，应用增量模式）
+     * @return 成功返回true
+     */
+    bool sendMessageParameters(MessageType messageType, const QVariantMap& parameters);
+
+    /**
+     * @brief 读-改-写的基础值：设备尚未应答的最后一次写入，否则取影子状态
+     * @return 没有可用的基础值时返回false
+     */
+    bool writeBase(MessageType messageType, QVariantMap& parameters) const;
+
+    /**
+     * @brief 结束一次尚未应答的读-改-写（已确认或已失败）
+     */
+    void releaseWrite(MessageType messageType);
+
+    /**
+     * @brief 经发送窗口的写入已确认或最终失败
+     *
+     * 确认时推进增量基准并对每个参数发出parameterAcknowledged，失败时使增量基准失效。
+     */
+    void finishWrite(quint32 sequence, bool confirmed);
+
+    /**
+     * @brief 回读设备当前值后执行后续操作，同一类型的并发回读合并为一次请求
+     * @param continuation 回读完成时调用，参数为是否成功
+     */
+    void refreshThen(MessageType messageType, std::function<void(bool)> continuation);
+
+    /**
+     * @brief 发送该类型合并窗口中缓冲的更新
+     */
+    bool flushCoalesced(MessageType messageType);
+
+    /**
+     * @brief 取出并清空该类型缓冲的更新
+     */
+    QVariantMap takePendingUpdates(MessageType messageType);
+
+    /**
+     * @brief 合并窗口状态
+     */
+    struct CoalescingSlot {
+        int windowMs = 0;                   // 合并窗口（毫秒）
+        QVariantMap pending;                // 窗口内缓冲的更新（后写覆盖先写）
+        QTimer* timer = nullptr;            // 窗口定时器
+    };
+
+    /**
+     * @brief 异步请求状态
+     */
+    struct PendingRequest {
+        quint32 requestId = 0;
+        MessageType messageType = MessageType::ANC_SWITCH;
+        quint32 sequence = 0;               // 信封中的请求序号
+        QByteArray data;                    // 待发送的MsgRequestResponse数据（已带序号）
+        RequestCallback callback;
+        bool cancelled = false;             // 已取消，只等待吸收应答
+        int timeoutMs = 0;
+        qint64 sentAtMs = 0;
+        qint64 deadlineMs = 0;
+    };
+
+    /**
+     * @brief 分配请求ID并加入发送队列
+     */
+    quint32 enqueueRequest(MessageType messageType, const QByteArray& data,
+                           RequestCallback callback, int timeoutMs);
+
+    /**
+     * @brief 在在途上限内发送排队的请求
+     */
+    void dispatchQueuedRequests();
+
+    /**
+     * @brief 用收到的RESPONSE完成对应的请求
+     * @param sequence RESPONSE带回的请求序号，0表示未带回（按发送顺序匹配最早的同类型请求）
+     */
+    void completeRequest(MessageType messageType, quint32 sequence, const QVariantMap& parameters);
+
+    /**
+     * @brief 通知请求结果（请求须已从队列中移除，已取消的请求不通知）
+     */
+    void finishRequest(const PendingRequest& request, bool success, const QString& error,
+                       const QVariantMap& parameters = QVariantMap());
+
+    /**
+     * @brief 按最早截止时间重新启动请求超时定时器
+     */
+    void rearmRequestTimer();
+
+    /**
+     * @brief 以失败结束所有在途与排队请求
+     */
+    void failAllRequests(const QString& error);
 
 private:
     // 核心组件（使用智能指针管理生命周期）
     std::unique_ptr<ParameterMapper> parameterMapper_;
+    std::unique_ptr<ShadowStateStore> shadowState_;
+    std::unique_ptr<TimeSeriesStore> timeSeries_;
+    std::unique_ptr<MessageBus> messageBus_;
     std::unique_ptr<MessageSerializer> messageSerializer_;
     std::unique_ptr<ConnectionManager> connectionManager_;
     std::unique_ptr<VersionManager> versionManager_;
+    std::unique_ptr<DeltaEncoder> deltaEncoder_;
+    std::unique_ptr<OutboundScheduler> outboundScheduler_;
 
     // 状态信息
     bool initialized_ = false;
+    int frameSinkId_ = -1;                  // ConnectionManager帧回调ID
+
+    // 发送调度
+    bool schedulingEnabled_ = false;
+
+    // 发送合并
+    QHash<MessageType, CoalescingSlot> coalescing_;
+
+    // 变化通知：消息类型 -> 按字段序号的参数ID
+    QHash<MessageType, QVector<QList<ParamId>>> changeRouting_;
+
+    // 读-改-写
+    QSet<MessageType> readModifyWriteTypes_;
+    StalenessPolicy stalenessPolicy_ = StalenessPolicy::RefreshFirst;
+    int maxStateAgeMs_ = 0;
+    QHash<MessageType, QList<std::function<void(bool)>>> refreshWaiters_;   // 等待回读完成的操作
+
+    // 已发出、设备尚未应答的读-改-写
+    struct UnconfirmedWrite {
+        QVariantMap parameters;             // 最后一次发出的完整参数
+        int pending = 0;                    // 尚未应答的写入数
+    };
+    QHash<MessageType, UnconfirmedWrite> unconfirmedWrites_;
+
+    // 已发出、等待设备确认的写入（按帧序号）
+    struct SentWrite {
+        MessageType messageType = MessageType::ANC_SWITCH;
+        QStringList paths;                  // 本次写入给出的参数
+        QVariantMap state;                  // 发送的完整状态（增量基准）
+        bool delta = false;                 // 增量模式
+        bool keyframe = false;
+        bool readModifyWrite = false;
+    };
+    QHash<quint32, SentWrite> sentWrites_;
+
+    // 异步请求
+    QTimer* requestTimer_ = nullptr;                // 请求超时定时器
+    QElapsedTimer requestClock_;                    // 单调时钟
+    QList<PendingRequest> outstandingRequests_;     // 已发送等待RESPONSE的请求（按ID升序）
+    QQueue<PendingRequest> queuedRequests_;         // 超过在途上限时排队的请求
+    quint32 nextRequestId_ = 1;                     // 下一个请求ID
+    int maxOutstandingRequests_ = 8;                // 最大在途请求数
+    int requestTimeoutMs_ = DEFAULT_TIMEOUT_MS;     // 默认请求超时（毫秒）
 
     // 协议常量
     static const QString PROTOCOL_VERSION;
@@ -0,0 +1,456 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+ERNC消息专用编解码生成器
+
+从ERNC_praram.proto为每个MSG_*消息生成直线式的编码/解码函数（仅头文件），
+线格式与nanopb完全一致：
+  - 单值uint32/bool为0时不编码
+  - fixed_count数组始终以packed形式编码
+  - 解码接受packed和非packed数组，未知字段跳过，错误条件与pb_decode相同
+  - packed数组的varint由PackedVarint（serialization/varint_kernels.h）按CPU选择SIMD内核编解码
+
+用法: generate_ernc_codec.py <ERNC_praram.proto> <输出头文件>
+"""
+
+import os
+import re
+import sys
+
+MESSAGE_RE = re.compile(r'^\s*message\s+(\w+)\s*\{(.*?)^\s*\}', re.S | re.M)
+FIELD_RE = re.compile(r'^\s*(repeated\s+)?(\w+)\s+(\w+)\s*=\s*(\d+)\s*(\[[^\]]*\])?\s*;', re.M)
+MAX_COUNT_RE = re.compile(r'\(nanopb\)\.max_count\s*=\s*(\d+)')
+FIXED_COUNT_RE = re.compile(r'\(nanopb\)\.fixed_count\s*=\s*true')
+
+VARINT_MAX = 5          # uint32的varint最大长度
+WIRETYPE_VARINT = 0
+WIRETYPE_LENGTH = 2
+
+
+class Field:
+    def __init__(self, name, type_, tag, count):
+        self.name = name
+        self.type = type_
+        self.tag = tag
+        self.count = count          # 0表示单值字段
+
+    @property
+    def is_array(self):
+        return self.count > 0
+
+    def key_bytes(self, wire_type):
+        return varint_bytes((self.tag << 3) | wire_type)
+
+    def max_size(self):
+        """本编码器对该字段输出的最大字节数"""
+        if self.is_array:
+            payload = self.count * VARINT_MAX
+            return len(self.key_bytes(WIRETYPE_LENGTH)) + len(varint_bytes(payload)) + payload
+        value = 1 if self.type == 'bool' else VARINT_MAX
+        return len(self.key_bytes(WIRETYPE_VARINT)) + value
+
+
+def varint_bytes(value):
+    out = []
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return out
+
+
+def strip_comments(text):
+    return re.sub(r'//[^\n]*', '', text)
+
+
+def parse(proto_path):
+    with open(proto_path, encoding='utf-8') as f:
+        text = strip_comments(f.read())
+
+    messages = []
+    for match in MESSAGE_RE.finditer(text):
+        name, body = match.group(1), match.group(2)
+        if not name.startswith('MSG_'):
+            continue        # MsgRequestResponse封装（oneof子消息）仍由nanopb处理
+
+        fields = []
+        for line in body.split(';'):
+            if not line.strip():
+                continue
+            field = FIELD_RE.match(line + ';')
+            if not field:
+                raise SystemExit('%s: unsupported declaration in %s: %s' % (proto_path, name, line.strip()))
+            repeated, type_, field_name, tag, options = field.groups()
+            if type_ not in ('uint32', 'bool'):
+                raise SystemExit('%s: %s.%s has unsupported type %s' % (proto_path, name, field_name, type_))
+            count = 0
+            if repeated:
+                max_count = MAX_COUNT_RE.search(options or '')
+                if type_ != 'uint32' or not max_count or not FIXED_COUNT_RE.search(options or ''):
+                    raise SystemExit('%s: %s.%s must be a fixed_count uint32 array' % (proto_path, name, field_name))
+                count = int(max_count.group(1))
+            fields.append(Field(field_name, type_, int(tag), count))
+
+        if not fields:
+            raise SystemExit('%s: %s has no fields' % (proto_path, name))
+        messages.append((name, fields))
+
+    if not messages:
+        raise SystemExit('%s: no MSG_* messages found' % proto_path)
+    return messages
+
+
+def emit_key(lines, indent, key):
+    for b in key:
+        lines.append('%s*p++ = 0x%02X;' % (indent, b))
+
+
+def emit_message(name, fields):
+    max_size = sum(f.max_size() for f in fields)
+    has_array = any(f.is_array for f in fields)
+    lines = []
+    a = lines.append
+
+    a('// %s' % name)
+    a('template<>')
+    a('struct Codec<%s> {' % name)
+    a('    static constexpr size_t MAX_ENCODED_SIZE = %d;' % max_size)
+    a('')
+
+    # 编码长度
+    a('    static constexpr size_t encodedSize(const %s& m) {' % name)
+    a('        size_t size = 0;')
+    for f in fields:
+        if f.is_array:
+            a('        {')
+            a('            size_t packed = 0;')
+            a('            for (size_t i = 0; i < %d; ++i) {' % f.count)
+            a('                packed += detail::varintSize(m.%s[i]);' % f.name)
+            a('            }')
+            a('            size += %d + detail::varintSize(static_cast<uint32_t>(packed)) + packed;'
+              % len(f.key_bytes(WIRETYPE_LENGTH)))
+            a('        }')
+        elif f.type == 'bool':
+            a('        if (m.%s) {' % f.name)
+            a('            size += %d;' % (len(f.key_bytes(WIRETYPE_VARINT)) + 1))
+            a('        }')
+        else:
+            a('        if (m.%s) {' % f.name)
+            a('            size += %d + detail::varintSize(m.%s);' % (len(f.key_bytes(WIRETYPE_VARINT)), f.name))
+            a('        }')
+    a('        return size;')
+    a('    }')
+    a('')
+
+    # 编码
+    a('    // out至少MAX_ENCODED_SIZE字节，返回写入的字节数')
+    a('    static size_t encode(const %s& m, uint8_t* out) {' % name)
+    a('        uint8_t* p = out;')
+    for f in fields:
+        if f.is_array:
+            a('        {')
+            a('            const size_t packed = PackedVarint::encodedSize(m.%s, %d);' % (f.name, f.count))
+            emit_key(lines, '            ', f.key_bytes(WIRETYPE_LENGTH))
+            a('            p = detail::writeVarint(p, static_cast<uint32_t>(packed));')
+            a('            p += PackedVarint::encode(m.%s, %d, p);' % (f.name, f.count))
+            a('        }')
+        elif f.type == 'bool':
+            a('        if (m.%s) {' % f.name)
+            emit_key(lines, '            ', f.key_bytes(WIRETYPE_VARINT))
+            a('            *p++ = 0x01;')
+            a('        }')
+        else:
+            a('        if (m.%s) {' % f.name)
+            emit_key(lines, '            ', f.key_bytes(WIRETYPE_VARINT))
+            a('            p = detail::writeVarint(p, m.%s);' % f.name)
+            a('        }')
+    a('        return static_cast<size_t>(p - out);')
+    a('    }')
+    a('')
+
+    # 解码
+    a('    // 消息先清零；失败时m的内容不确定')
+    a('    static bool decode(const uint8_t* data, size_t size, %s& m) {' % name)
+    a('        std::memset(&m, 0, sizeof(m));')
+    a('        const uint8_t* p = data;')
+    a('        const uint8_t* const end = data + size;')
+    if has_array:
+        a('        detail::FixedCount fixed;')
+    a('        while (p != end) {')
+    a('            uint32_t key;')
+    a('            if (!detail::readVarint32(p, end, key)) {')
+    a('                return false;')
+    a('            }')
+    a('            const uint32_t wireType = key & 0x07;')
+    a('            switch (key >> 3) {')
+    a('            case 0:')
+    a('                return false;')
+    for index, f in enumerate(fields):
+        a('            case %d:' % f.tag)
+        if f.is_array:
+            a('                if (!fixed.begin(%d, %d) || !detail::readArray(p, end, wireType, m.%s, fixed)) {'
+              % (index, f.count, f.name))
+            a('                    return false;')
+            a('                }')
+        elif f.type == 'bool':
+            a('                if (wireType != 0 || !detail::readBool(p, end, m.%s)) {' % f.name)
+            a('                    return false;')
+            a('                }')
+        else:
+            a('                if (wireType != 0 || !detail::readUint32(p, end, m.%s)) {' % f.name)
+            a('                    return false;')
+            a('                }')
+        a('                break;')
+    a('            default:')
+    a('                if (!detail::skipField(p, end, wireType)) {')
+    a('                    return false;')
+    a('                }')
+    a('                break;')
+    a('            }')
+    a('        }')
+    a('        return %s;' % ('fixed.complete()' if has_array else 'true'))
+    a('    }')
+    a('};')
+    a('')
+    a('static_assert(Codec<%s>::MAX_ENCODED_SIZE <= %s_size,' % (name, name))
+    a('              "%s: encoder bound exceeds the nanopb bound");' % name)
+    a('')
+    return lines
+
+
+HEADER_PROLOGUE = r'''// 由 cmake/generate_ernc_codec.py 根据 %(proto)s 生成，请勿手工修改
+#ifndef ERNC_CODEC_H
+#define ERNC_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "serialization/varint_kernels.h"
+
+extern "C" {
+#include "messages/ERNC_praram.pb.h"
+}
+
+namespace Protocol {
+namespace ErncCodec {
+
+namespace detail {
+
+constexpr size_t varintSize(uint32_t value) {
+    return value < (1u << 7) ? 1 : value < (1u << 14) ? 2 : value < (1u << 21) ? 3 : value < (1u << 28) ? 4 : 5;
+}
+
+inline uint8_t* writeVarint(uint8_t* p, uint32_t value) {
+    while (value >= 0x80) {
+        *p++ = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    *p++ = static_cast<uint8_t>(value);
+    return p;
+}
+
+// 与pb_decode_varint32相同：超过32位的部分只允许是负数的符号扩展（用于标签、长度和bool）
+inline bool readVarint32(const uint8_t*& p, const uint8_t* end, uint32_t& value) {
+    if (p == end) {
+        return false;
+    }
+    uint8_t byte = *p++;
+    if (!(byte & 0x80)) {
+        value = byte;
+        return true;
+    }
+
+    uint32_t result = byte & 0x7F;
+    unsigned bitpos = 7;
+    do {
+        if (p == end) {
+            return false;
+        }
+        byte = *p++;
+        if (bitpos >= 32) {
+            const uint8_t signExtension = bitpos < 63 ? 0xFF : 0x01;
+            const bool valid = (byte & 0x7F) == 0x00 || ((result >> 31) != 0 && byte == signExtension);
+            if (bitpos >= 64 || !valid) {
+                return false;
+            }
+        } else if (bitpos == 28) {
+            if ((byte & 0x70) != 0 && (byte & 0x78) != 0x78) {
+                return false;
+            }
+            result |= static_cast<uint32_t>(byte & 0x0F) << bitpos;
+        } else {
+            result |= static_cast<uint32_t>(byte & 0x7F) << bitpos;
+        }
+        bitpos += 7;
+    } while (byte & 0x80);
+
+    value = result;
+    return true;
+}
+
+// 与nanopb解码uint32字段相同：按64位varint读取，超出32位时失败
+inline bool readUint32(const uint8_t*& p, const uint8_t* end, uint32_t& value) {
+    if (p != end && !(*p & 0x80)) {
+        value = *p++;
+        return true;
+    }
+
+    uint64_t result = 0;
+    unsigned bitpos = 0;
+    uint8_t byte;
+    do {
+        if (p == end) {
+            return false;
+        }
+        byte = *p++;
+        if (bitpos >= 63 && (byte & 0xFE) != 0) {
+            return false;
+        }
+        result |= static_cast<uint64_t>(byte & 0x7F) << bitpos;
+        bitpos += 7;
+    } while (byte & 0x80);
+
+    if (result > 0xFFFFFFFFu) {
+        return false;
+    }
+    value = static_cast<uint32_t>(result);
+    return true;
+}
+
+inline bool readBool(const uint8_t*& p, const uint8_t* end, bool& value) {
+    uint32_t raw;
+    if (!readVarint32(p, end, raw)) {
+        return false;
+    }
+    value = raw != 0;
+    return true;
+}
+
+inline bool readLength(const uint8_t*& p, const uint8_t* end, const uint8_t*& fieldEnd) {
+    uint32_t length;
+    if (!readVarint32(p, end, length) || length > static_cast<size_t>(end - p)) {
+        return false;
+    }
+    fieldEnd = p + length;
+    return true;
+}
+
+inline bool skipField(const uint8_t*& p, const uint8_t* end, uint32_t wireType) {
+    switch (wireType) {
+    case 0:
+        do {
+            if (p == end) {
+                return false;
+            }
+        } while (*p++ & 0x80);
+        return true;
+    case 1:
+        if (end - p < 8) {
+            return false;
+        }
+        p += 8;
+        return true;
+    case 2:
+        return readLength(p, end, p);
+    case 5:
+        if (end - p < 4) {
+            return false;
+        }
+        p += 4;
+        return true;
+    default:
+        return false;
+    }
+}
+
+// fixed_count数组的接收计数：数组可以分多段出现，但切换到其他数组或消息结束时必须收满
+struct FixedCount {
+    int field = -1;
+    uint32_t count = 0;
+    uint32_t total = 0;
+
+    bool begin(int index, uint32_t arraySize) {
+        if (field != index) {
+            if (field >= 0 && count != total) {
+                return false;
+            }
+            field = index;
+            count = 0;
+            total = arraySize;
+        }
+        return true;
+    }
+
+    bool complete() const {
+        return field < 0 || count == total;
+    }
+};
+
+template<size_t N>
+inline bool readArray(const uint8_t*& p, const uint8_t* end, uint32_t wireType,
+                      uint32_t (&values)[N], FixedCount& fixed) {
+    if (wireType == 2) {
+        const uint8_t* packedEnd;
+        if (!readLength(p, end, packedEnd)) {
+            return false;
+        }
+        size_t decoded = 0;
+        if (!PackedVarint::decode(p, packedEnd, values + fixed.count, N - fixed.count, decoded)) {
+            return false;
+        }
+        fixed.count += static_cast<uint32_t>(decoded);
+        return p == packedEnd;
+    }
+    if (wireType == 0 && fixed.count < N) {
+        return readUint32(p, end, values[fixed.count++]);
+    }
+    return false;
+}
+
+} // namespace detail
+
+/**
+ * @brief 消息编解码（按消息结构体特化）
+ *
+ * MAX_ENCODED_SIZE为本编码器输出的上界（所有值取最大时），不超过nanopb的MSG_X_size。
+ */
+template<typename T>
+struct Codec;
+
+'''
+
+HEADER_EPILOGUE = r'''} // namespace ErncCodec
+} // namespace Protocol
+
+#endif // ERNC_CODEC_H
+'''
+
+
+def main():
+    if len(sys.argv) != 3:
+        raise SystemExit('usage: generate_ernc_codec.py <proto> <output header>')
+    proto_path, output_path = sys.argv[1], sys.argv[2]
+
+    messages = parse(proto_path)
+    parts = [HEADER_PROLOGUE % {'proto': os.path.basename(proto_path)}]
+    for name, fields in messages:
+        parts.append('\n'.join(emit_message(name, fields)) + '\n')
+    parts.append(HEADER_EPILOGUE)
+    content = ''.join(parts)
+
+    # 内容不变时不改写，避免无谓的重新编译
+    if os.path.exists(output_path):
+        with open(output_path, encoding='utf-8') as f:
+            if f.read() == content:
+                return
+    os.makedirs(os.path.dirname(os.path.abspath(output_path)), exist_ok=True)
+    with open(output_path, 'w', encoding='utf-8') as f:
+        f.write(content)
+
+
+if __name__ == '__main__':
+    main()
@@ -1,15 +1,29 @@
 #include "connection_manager.h"
+#include "frame_codec.h"
+#include "protocol/serialization/protocol_packager.h"
 #include <QDebug>
+#include <QMetaMethod>
 #include <QMutexLocker>
+#include <QRandomGenerator>
 
 namespace Protocol {
 
+// 常量定义
+const int ConnectionManager::RATE_SAMPLE_INTERVAL_MS = 1000;
+
 ConnectionManager::ConnectionManager(QObject* parent)
     : QObject(parent)
     , retryTimer_(new QTimer(this))
+    , rateTimer_(new QTimer(this))
 {
     retryTimer_->setSingleShot(true);
     connect(retryTimer_, &QTimer::timeout, this, &ConnectionManager::handleRetryTimeout);
+    reliableClock_.start();
+
+    rateClock_.start();
+    rateTimer_->setTimerType(Qt::CoarseTimer);
+    connect(rateTimer_, &QTimer::timeout, this, &ConnectionManager::sampleRates);
+    rateTimer_->start(RATE_SAMPLE_INTERVAL_MS);
 
     qDebug() << "ConnectionManager initialized";
 }
@@ -26,6 +40,8 @@ void ConnectionManager::setTransport(ITransport* transport) {
 
     // 断开之前的传输层信号
     disconnectTransportSignals();
+    failAllReliable("Transport changed");
+    peerEchoesSequence_ = false;
 
     transport_ = transport;
 
@@ -63,84 +79,179 @@ bool ConnectionManager::sendData(const QByteArray& data) {
     if (!transport_) {
         QString error = "No transport available";
         qWarning() << error;
+        recordSendError(error);
         emit communicationError(error);
-
-        QMutexLocker locker(&statsMutex_);
-        stats_.sendErrorCount++;
-        stats_.lastError = error;
         return false;
     }
 
     if (!transport_->isOpen()) {
         QString error = "Transport not connected";
         qWarning() << error;
+        recordSendError(error);
         emit communicationError(error);
-
-        QMutexLocker locker(&statsMutex_);
-        stats_.sendErrorCount++;
-        stats_.lastError = error;
         return false;
     }
 
     if (data.isEmpty()) {
         QString error = "Cannot send empty data";
         qWarning() << error;
+        recordSendError(error);
         emit communicationError(error);
-
-        QMutexLocker locker(&statsMutex_);
-        stats_.sendErrorCount++;
-        stats_.lastError = error;
         return false;
     }
 
     // 构造带协议头尾的数据包
-    QByteArray packet;
-    packet.append(PACKET_HEADER);                    // 包头
-    packet.append(static_cast<uint8_t>(data.size())); // 数据长度
-    packet.append(data);                            // 数据内容
-    packet.append(PACKET_FOOTER);                   // 包尾
+    QByteArray packet = FrameCodec::encode(data);
+    if (packet.isEmpty()) {
+        QString error = QString("Payload too large: %1 bytes").arg(data.size());
+        qWarning() << error;
+        recordSendError(error);
+        emit communicationError(error);
+        return false;
+    }
 
     // 发送数据
     bool success = transport_->send(packet);
 
-    {
-        QMutexLocker locker(&statsMutex_);
-        if (success) {
-            stats_.bytesSent += packet.size();
-            qDebug() << "Data sent successfully:" << packet.size() << "bytes";
-        } else {
-            stats_.sendErrorCount++;
-            stats_.lastError = "Transport write failed";
-            qWarning() << "Failed to send data:" << packet.size() << "bytes";
-        }
+    if (success) {
+        sendCounters_.bytes.fetch_add(static_cast<quint64>(packet.size()), std::memory_order_relaxed);
+        sendCounters_.frames.fetch_add(1, std::memory_order_relaxed);
+        qDebug() << "Data sent successfully:" << packet.size() << "bytes";
+    } else {
+        recordSendError("Transport write failed");
+        qWarning() << "Failed to send data:" << packet.size() << "bytes";
     }
 
     emit dataSent(success, success ? packet.size() : 0);
     return success;
 }
 
+quint32 ConnectionManager::sendReliable(const QByteArray& data, int maxRetries) {
+    if (data.isEmpty()) {
+        qWarning() << "Cannot send empty data";
+        return 0;
+    }
+
+    if (!isConnected()) {
+        qWarning() << "Transport not connected, reliable frame rejected";
+        return 0;
+    }
+
+    ReliableFrame frame;
+    frame.data = data;
+    frame.maxRetries = qMax(0, maxRetries);
+
+    // 只有能识别出ProtoID的请求帧才等待RESPONSE确认
+    int protoId = 0;
+    FunctionCode functionCode = FunctionCode::REQUEST;
+    quint32 sequence = 0;
+    const bool request = !ProtocolPackager::isBatch(data)
+        && ProtocolPackager::peekEnvelope(data.constData(), data.size(), protoId, functionCode, &sequence)
+        && functionCode == FunctionCode::REQUEST;
+
+    // 携带载荷的请求为写入，只有最新的值有意义；读请求不携带载荷，不参与替换
+    MessageType messageType = MessageType::CHANNEL_NUMBER;
+    ScatterSpan payload;
+    if (request && ProtocolPackager::unpackEnvelope(ScatterSpan(data), messageType, functionCode, payload)) {
+        frame.writeProtoId = protoId;
+    }
+
+    frame.sequence = sequence != 0 ? sequence : allocateSequence();
+    if (ackRequired_ && request) {
+        frame.protoId = protoId;
+        if (sequence == 0) {
+            frame.data = ProtocolPackager::appendSequence(data, frame.sequence);
+        }
+    } else {
+        qDebug() << "Reliable frame" << frame.sequence << "is not a request, no ACK expected";
+    }
+
+    // 超长的帧重传也无法发出，入队前拒绝
+    if (frame.data.size() > FrameCodec::MAX_PAYLOAD_SIZE) {
+        QString error = QString("Payload too large: %1 bytes").arg(frame.data.size());
+        qWarning() << error;
+        recordSendError(error);
+        emit communicationError(error);
+        return 0;
+    }
+
+    // 排队中同ProtoID的旧写入尚未发送，直接由新写入替换（保持排队位置）
+    if (frame.writeProtoId >= 0) {
+        for (ReliableFrame& queued : pendingFrames_) {
+            if (queued.writeProtoId != frame.writeProtoId) {
+                continue;
+            }
+
+            const quint32 superseded = queued.sequence;
+            queued = frame;
+            qDebug() << "Reliable frame" << superseded << "superseded by" << frame.sequence;
+            emit frameFailed(superseded, "Superseded by a newer write");
+            return frame.sequence;
+        }
+    }
+
+    if (pendingFrames_.size() >= maxPendingFrames_) {
+        QString error = QString("Reliable send queue full (%1 frames)").arg(pendingFrames_.size());
+        qWarning() << error;
+        recordSendError(error);
+        emit communicationError(error);
+        return 0;
+    }
+
+    pendingFrames_.enqueue(frame);
+    pumpReliableQueue();
+    rearmRetryTimer();
+    return frame.sequence;
+}
+
 bool ConnectionManager::sendDataWithRetry(const QByteArray& data, int maxRetries) {
-    maxRetryCount_ = maxRetries;
-    currentRetryCount_ = 0;
+    return sendReliable(data, maxRetries) != 0;
+}
 
-    // 先尝试直接发送
-    if (sendData(data)) {
-        return true; // 发送成功，无需重试
+quint32 ConnectionManager::allocateSequence() {
+    const quint32 sequence = nextSequence_++;
+    if (nextSequence_ == 0) {
+        nextSequence_ = 1; // 0保留为无效序号
     }
+    return sequence;
+}
 
-    // 发送失败，添加到重试队列
-    {
-        QMutexLocker locker(&retryMutex_);
-        retryQueue_.enqueue(data);
+void ConnectionManager::setWindowSize(int frames) {
+    if (frames <= 0) {
+        qWarning() << "Invalid window size:" << frames;
+        return;
+    }
+
+    windowSize_ = frames;
+    pumpReliableQueue();
+    rearmRetryTimer();
+    qDebug() << "Send window size set to:" << windowSize_;
+}
+
+void ConnectionManager::setMaxPendingFrames(int frames) {
+    if (frames <= 0) {
+        qWarning() << "Invalid pending frame limit:" << frames;
+        return;
     }
 
-    // 启动重试定时器
-    if (!retryTimer_->isActive()) {
-        retryTimer_->start(retryIntervalMs_);
-        qDebug() << "Started retry timer for data sending";
+    maxPendingFrames_ = frames;
+    qDebug() << "Reliable send queue limit set to:" << maxPendingFrames_;
+}
+
+void ConnectionManager::setAckTimeout(int ms) {
+    if (ms <= 0) {
+        qWarning() << "Invalid ACK timeout:" << ms;
+        return;
     }
+    ackTimeoutMs_ = ms;
+}
 
-    return false; // 首次发送失败，等待重试结果
+void ConnectionManager::setMaxBackoff(int ms) {
+    if (ms <= 0) {
+        qWarning() << "Invalid max backoff:" << ms;
+        return;
+    }
+    maxBackoffMs_ = ms;
 }
 
 void ConnectionManager::setReceiveBufferSize(int size) {
@@ -165,49 +276,120 @@ void ConnectionManager::clearReceiveBuffer() {
     qDebug() << "Receive buffer cleared";
 }
 
+ConnectionManager::ConnectionStats ConnectionManager::getConnectionStats() const {
+    ConnectionStats stats;
+    stats.bytesSent = sendCounters_.bytes.load(std::memory_order_relaxed);
+    stats.framesSent = sendCounters_.frames.load(std::memory_order_relaxed);
+    stats.sendErrorCount = sendCounters_.errors.load(std::memory_order_relaxed);
+    stats.retryCount = sendCounters_.retries.load(std::memory_order_relaxed);
+    stats.bytesReceived = receiveCounters_.bytes.load(std::memory_order_relaxed);
+    stats.framesReceived = receiveCounters_.frames.load(std::memory_order_relaxed);
+    stats.receiveErrorCount = receiveCounters_.errors.load(std::memory_order_relaxed);
+    stats.sendBytesPerSec = sendBytesRate_.rate();
+    stats.receiveBytesPerSec = receiveBytesRate_.rate();
+    stats.sendFramesPerSec = sendFramesRate_.rate();
+    stats.receiveFramesPerSec = receiveFramesRate_.rate();
+
+    QMutexLocker locker(&errorMutex_);
+    stats.lastError = lastError_;
+    return stats;
+}
+
 void ConnectionManager::resetStats() {
-    QMutexLocker locker(&statsMutex_);
-    stats_ = ConnectionStats();
+    sendCounters_.bytes.store(0, std::memory_order_relaxed);
+    sendCounters_.frames.store(0, std::memory_order_relaxed);
+    sendCounters_.errors.store(0, std::memory_order_relaxed);
+    sendCounters_.retries.store(0, std::memory_order_relaxed);
+    receiveCounters_.bytes.store(0, std::memory_order_relaxed);
+    receiveCounters_.frames.store(0, std::memory_order_relaxed);
+    receiveCounters_.errors.store(0, std::memory_order_relaxed);
+
+    sendBytesRate_.reset();
+    receiveBytesRate_.reset();
+    sendFramesRate_.reset();
+    receiveFramesRate_.reset();
+
+    {
+        QMutexLocker locker(&errorMutex_);
+        lastError_.clear();
+    }
     qDebug() << "Connection statistics reset";
 }
 
+void ConnectionManager::sampleRates() {
+    const qint64 now = rateClock_.nsecsElapsed();
+    sendBytesRate_.update(sendCounters_.bytes.load(std::memory_order_relaxed), now);
+    sendFramesRate_.update(sendCounters_.frames.load(std::memory_order_relaxed), now);
+    receiveBytesRate_.update(receiveCounters_.bytes.load(std::memory_order_relaxed), now);
+    receiveFramesRate_.update(receiveCounters_.frames.load(std::memory_order_relaxed), now);
+}
+
+void ConnectionManager::recordSendError(const QString& error) {
+    sendCounters_.errors.fetch_add(1, std::memory_order_relaxed);
+    QMutexLocker locker(&errorMutex_);
+    lastError_ = error;
+}
+
+void ConnectionManager::recordReceiveError(const QString& error) {
+    receiveCounters_.errors.fetch_add(1, std::memory_order_relaxed);
+    QMutexLocker locker(&errorMutex_);
+    lastError_ = error;
+}
+
 void ConnectionManager::handleTransportDataReceived(const QByteArray& data) {
-    if (data.isEmpty()) {
+    processReceivedBytes(data.constData(), data.size());
+}
+
+void ConnectionManager::processReceivedBytes(const char* data, int size) {
+    if (size <= 0) {
         return;
     }
 
-    // 添加到接收缓冲区
-    receiveBuffer_.append(data);
+    receiveCounters_.bytes.fetch_add(static_cast<quint64>(size), std::memory_order_relaxed);
+
+    QByteArray pending;     // 残留中未消费的部分
+    int consumed = 0;       // 新数据中已消费的字节数
+
+    if (receiveBuffer_.isEmpty()) {
+        // 快速路径：直接在传输层缓冲区上解析
+        consumed = parseFrames(ScatterSpan(data, size));
+    } else {
+        // 上次残留不完整帧：残留和新数据作为两段就地解析，不再拼接
+        // （先换出残留，回调中重入时接收缓冲区为空）
+        pending.swap(receiveBuffer_);
+        int parsed = parseFrames(ScatterSpan(pending.constData(), pending.size(), data, size));
+        if (parsed < pending.size()) {
+            // 不完整的帧仍从残留中开始
+            pending.remove(0, parsed);
+        } else {
+            consumed = parsed - pending.size();
+            pending.clear();
+        }
+    }
+
+    const int remaining = pending.size() + size - consumed;
+    if (remaining == 0) {
+        return;
+    }
 
     // 检查缓冲区大小
-    if (receiveBuffer_.size() > maxBufferSize_) {
+    if (receiveBuffer_.size() + remaining > maxBufferSize_) {
         qWarning() << "Receive buffer overflow, clearing buffer";
         receiveBuffer_.clear();
 
-        QMutexLocker locker(&statsMutex_);
-        stats_.receiveErrorCount++;
-        stats_.lastError = "Receive buffer overflow";
+        recordReceiveError("Receive buffer overflow");
         emit communicationError("Receive buffer overflow");
         return;
     }
 
-    {
-        QMutexLocker locker(&statsMutex_);
-        stats_.bytesReceived += data.size();
-    }
-
-    // 处理缓冲区中的完整数据包
-    processReceiveBuffer();
+    receiveBuffer_.append(pending);
+    receiveBuffer_.append(data + consumed, size - consumed);
 }
 
 void ConnectionManager::handleTransportError(const QString& error) {
     qWarning() << "Transport error:" << error;
 
-    {
-        QMutexLocker locker(&statsMutex_);
-        stats_.lastError = error;
-        stats_.receiveErrorCount++;
-    }
+    recordReceiveError(error);
 
     emit communicationError(error);
 }
@@ -219,174 +401,267 @@ void ConnectionManager::handleTransportConnectionChanged(bool connected) {
         // 连接断开时清除缓冲区
         clearReceiveBuffer();
 
-        // 停止重试
-        retryTimer_->stop();
-        {
-            QMutexLocker locker(&retryMutex_);
-            retryQueue_.clear();
-        }
-        currentRetryCount_ = 0;
+        // 在途帧不会再得到确认
+        failAllReliable("Connection lost");
+
+        // 重连后可能是另一台设备
+        peerEchoesSequence_ = false;
     }
 
     emit connectionStatusChanged(connected);
 }
 
 void ConnectionManager::handleRetryTimeout() {
-    QByteArray dataToRetry;
+    const qint64 now = reliableClock_.elapsed();
 
-    {
-        QMutexLocker locker(&retryMutex_);
-        if (retryQueue_.isEmpty()) {
-            return; // 没有数据需要重试
+    // 先取出所有到期的帧，重传过程中发射的信号可能再次修改在途列表
+    QList<ReliableFrame> due;
+    for (int i = 0; i < inFlight_.size();) {
+        if (inFlight_[i].deadlineMs <= now) {
+            due.append(inFlight_.takeAt(i));
+        } else {
+            ++i;
         }
-        dataToRetry = retryQueue_.dequeue();
     }
 
-    currentRetryCount_++;
-    emit retryingSend(currentRetryCount_, maxRetryCount_);
+    for (ReliableFrame& frame : due) {
+        if (frame.attempts > frame.maxRetries) {
+            // 重试次数用完
+            QString error = QString("Send failed after %1 retries").arg(frame.maxRetries);
+            qWarning() << "Reliable frame" << frame.sequence << "failed:" << error;
 
-    qDebug() << "Retrying send, attempt:" << currentRetryCount_ << "/" << maxRetryCount_;
+            recordSendError(error);
 
-    if (sendData(dataToRetry)) {
-        // 重试成功
-        qInfo() << "Retry send successful on attempt:" << currentRetryCount_;
-        currentRetryCount_ = 0;
+            emit communicationError(error);
+            emit frameFailed(frame.sequence, error);
+            continue;
+        }
 
-        QMutexLocker locker(&statsMutex_);
-        stats_.retryCount++;
-        return;
+        sendCounters_.retries.fetch_add(1, std::memory_order_relaxed);
+
+        emit retryingSend(frame.attempts, frame.maxRetries);
+        qDebug() << "Retransmitting frame" << frame.sequence
+                 << "attempt:" << frame.attempts << "/" << frame.maxRetries;
+
+        if (transmitFrame(frame)) {
+            insertInFlight(frame);
+        }
     }
 
-    // 重试失败
-    if (currentRetryCount_ < maxRetryCount_) {
-        // 还有重试机会，重新加入队列
-        {
-            QMutexLocker locker(&retryMutex_);
-            retryQueue_.enqueue(dataToRetry);
+    pumpReliableQueue();
+    rearmRetryTimer();
+}
+
+void ConnectionManager::pumpReliableQueue() {
+    // 按入队顺序发送，跳过须等待同ProtoID在途帧的帧；
+    // 发送过程中发射的信号可能修改队列，每发出一帧都从头扫描
+    int index = 0;
+    while (inFlight_.size() < windowSize_ && index < pendingFrames_.size()) {
+        if (isBlockedByInFlight(pendingFrames_[index])) {
+            ++index;
+            continue;
         }
-        retryTimer_->start(retryIntervalMs_);
-    } else {
-        // 重试次数用完
-        qWarning() << "Send retry failed after" << maxRetryCount_ << "attempts";
-        currentRetryCount_ = 0;
 
-        QMutexLocker locker(&statsMutex_);
-        stats_.sendErrorCount++;
-        stats_.lastError = QString("Send failed after %1 retries").arg(maxRetryCount_);
+        ReliableFrame frame = pendingFrames_.takeAt(index);
+        if (transmitFrame(frame)) {
+            insertInFlight(frame);
+        }
+        index = 0;
+    }
+}
+
+bool ConnectionManager::isBlockedByInFlight(const ReliableFrame& frame) const {
+    if (frame.protoId < 0 || peerEchoesSequence_) {
+        return false;
+    }
 
-        emit communicationError(stats_.lastError);
+    for (const ReliableFrame& inFlight : inFlight_) {
+        if (inFlight.protoId == frame.protoId) {
+            return true;
+        }
     }
+    return false;
 }
 
-void ConnectionManager::connectTransportSignals() {
-    if (!transport_) {
-        return;
+bool ConnectionManager::transmitFrame(ReliableFrame& frame) {
+    ++frame.attempts;
+    bool sent = sendData(frame.data);
+
+    const qint64 now = reliableClock_.elapsed();
+    frame.sentAtMs = now;
+
+    if (sent && frame.protoId < 0) {
+        // 不等待确认的帧写入成功即完成
+        emit frameAcknowledged(frame.sequence, -1, 0);
+        return false;
     }
 
-    connect(transport_, &ITransport::dataReceived,
-            this, &ConnectionManager::handleTransportDataReceived);
-    connect(transport_, &ITransport::transportError,
-            this, &ConnectionManager::handleTransportError);
-    connect(transport_, &ITransport::connectionStatusChanged,
-            this, &ConnectionManager::handleTransportConnectionChanged);
+    // 等待确认，或写入失败后退避重传
+    frame.deadlineMs = now + backoffInterval(frame.attempts);
+    return true;
+}
 
-    qDebug() << "Transport signals connected";
+void ConnectionManager::insertInFlight(const ReliableFrame& frame) {
+    int index = inFlight_.size();
+    while (index > 0 && inFlight_[index - 1].sequence > frame.sequence) {
+        --index;
+    }
+    inFlight_.insert(index, frame);
 }
 
-void ConnectionManager::disconnectTransportSignals() {
-    if (!transport_) {
+void ConnectionManager::matchAcknowledgement(const ScatterSpan& data) {
+    if (inFlight_.isEmpty()) {
         return;
     }
 
-    disconnect(transport_, nullptr, this, nullptr);
-    qDebug() << "Transport signals disconnected";
+    // 批量帧中的每条应答分别确认
+    if (ProtocolPackager::isBatch(data)) {
+        ProtocolPackager::parseBatch(data, [this](const ScatterSpan& envelope) {
+            matchAcknowledgement(envelope);
+        });
+        return;
+    }
+
+    int protoId = 0;
+    FunctionCode functionCode = FunctionCode::REQUEST;
+    quint32 sequence = 0;
+    if (!ProtocolPackager::peekEnvelope(data, protoId, functionCode, &sequence)
+        || functionCode != FunctionCode::RESPONSE) {
+        return;
+    }
+
+    if (sequence != 0) {
+        peerEchoesSequence_ = true;
+    }
+
+    // 带回序号时精确匹配；旧版设备同一ProtoID只有一帧在途，按ProtoID匹配
+    for (int i = 0; i < inFlight_.size(); ++i) {
+        if (inFlight_[i].protoId != protoId
+            || (sequence != 0 && inFlight_[i].sequence != sequence)) {
+            continue;
+        }
+
+        ReliableFrame frame = inFlight_.takeAt(i);
+        int roundTripMs = static_cast<int>(reliableClock_.elapsed() - frame.sentAtMs);
+        qDebug() << "Frame" << frame.sequence << "acknowledged, RTT:" << roundTripMs << "ms";
+
+        emit frameAcknowledged(frame.sequence, protoId, roundTripMs);
+        pumpReliableQueue();
+        rearmRetryTimer();
+        return;
+    }
 }
 
-void ConnectionManager::processReceiveBuffer() {
-    auto packets = extractCompletePackets();
+int ConnectionManager::backoffInterval(int attempt) const {
+    qint64 interval = ackTimeoutMs_;
+    for (int i = 1; i < attempt && interval < maxBackoffMs_; ++i) {
+        interval *= 2;
+    }
+    interval = qMin<qint64>(interval, maxBackoffMs_);
 
-    for (const QByteArray& packet : packets) {
-        qDebug() << "Complete packet received:" << packet.size() << "bytes";
-        emit dataReceived(packet);
+    // ±25%随机抖动，避免多帧在同一时刻集中重传
+    int jitter = static_cast<int>(interval / 4);
+    if (jitter > 0) {
+        interval += QRandomGenerator::global()->bounded(-jitter, jitter + 1);
     }
+    return qMax(1, static_cast<int>(interval));
 }
 
-bool ConnectionManager::isPacketComplete(const QByteArray& data) const {
-    if (data.size() < MIN_PACKET_SIZE) {
-        return false; // 数据太短
+void ConnectionManager::rearmRetryTimer() {
+    if (inFlight_.isEmpty()) {
+        retryTimer_->stop();
+        return;
     }
 
-    // 检查包头
-    if (static_cast<uint8_t>(data[0]) != PACKET_HEADER) {
-        return false;
+    qint64 earliest = inFlight_.first().deadlineMs;
+    for (const ReliableFrame& frame : inFlight_) {
+        earliest = qMin(earliest, frame.deadlineMs);
     }
 
-    // 获取数据长度
-    uint8_t dataLength = static_cast<uint8_t>(data[1]);
-    int expectedPacketSize = 2 + dataLength + 1; // 头+长度+数据+尾
+    qint64 delay = qMax<qint64>(0, earliest - reliableClock_.elapsed());
+    retryTimer_->start(static_cast<int>(delay));
+}
 
-    if (data.size() < expectedPacketSize) {
-        return false; // 数据不完整
+void ConnectionManager::failAllReliable(const QString& error) {
+    retryTimer_->stop();
+
+    if (inFlight_.isEmpty() && pendingFrames_.isEmpty()) {
+        return;
     }
 
-    // 检查包尾
-    if (static_cast<uint8_t>(data[expectedPacketSize - 1]) != PACKET_FOOTER) {
-        return false;
+    QList<ReliableFrame> dropped;
+    dropped.swap(inFlight_);
+    while (!pendingFrames_.isEmpty()) {
+        dropped.append(pendingFrames_.dequeue());
     }
 
-    return true;
+    qWarning() << "Dropping" << dropped.size() << "reliable frames:" << error;
+    for (const ReliableFrame& frame : dropped) {
+        emit frameFailed(frame.sequence, error);
+    }
 }
 
-QList<QByteArray> ConnectionManager::extractCompletePackets() {
-    QList<QByteArray> packets;
+void ConnectionManager::connectTransportSignals() {
+    if (!transport_) {
+        return;
+    }
 
-    while (receiveBuffer_.size() >= MIN_PACKET_SIZE) {
-        // 查找包头
-        int headerIndex = receiveBuffer_.indexOf(PACKET_HEADER);
-        if (headerIndex == -1) {
-            // 没有找到包头，清除缓冲区
-            receiveBuffer_.clear();
-            break;
-        }
+    // 与传输层同线程时使用接收回调就地解析，跨线程时仍走排队信号
+    if (transport_->thread() == thread()) {
+        receiveSinkId_ = transport_->addReceiveSink([this](const ReceiveSpan& span) {
+            processReceivedBytes(span.data(), span.size());
+        });
+    } else {
+        connect(transport_, &ITransport::dataReceived,
+                this, &ConnectionManager::handleTransportDataReceived);
+    }
+    connect(transport_, &ITransport::transportError,
+            this, &ConnectionManager::handleTransportError);
+    connect(transport_, &ITransport::connectionStatusChanged,
+            this, &ConnectionManager::handleTransportConnectionChanged);
 
-        // 移除包头之前的无效数据
-        if (headerIndex > 0) {
-            receiveBuffer_.remove(0, headerIndex);
-            qWarning() << "Removed" << headerIndex << "bytes of invalid data";
-        }
+    qDebug() << "Transport signals connected";
+}
 
-        // 检查是否有足够的数据来解析包长度
-        if (receiveBuffer_.size() < 2) {
-            break; // 等待更多数据
-        }
+void ConnectionManager::disconnectTransportSignals() {
+    if (!transport_) {
+        return;
+    }
 
-        // 获取数据长度
-        uint8_t dataLength = static_cast<uint8_t>(receiveBuffer_[1]);
-        int expectedPacketSize = 2 + dataLength + 1; // 头+长度+数据+尾
+    if (receiveSinkId_ != 0) {
+        transport_->removeReceiveSink(receiveSinkId_);
+        receiveSinkId_ = 0;
+    }
 
-        // 检查是否有完整的数据包
-        if (receiveBuffer_.size() < expectedPacketSize) {
-            break; // 等待更多数据
-        }
+    disconnect(transport_, nullptr, this, nullptr);
+    qDebug() << "Transport signals disconnected";
+}
 
-        // 提取可能的数据包
-        QByteArray potentialPacket = receiveBuffer_.left(expectedPacketSize);
+int ConnectionManager::addFrameSink(FrameSink sink) {
+    return frameSinks_.add(std::move(sink));
+}
 
-        if (isPacketComplete(potentialPacket)) {
-            // 提取数据内容（去除包头、长度和包尾）
-            QByteArray packetData = potentialPacket.mid(2, dataLength);
-            packets.append(packetData);
+void ConnectionManager::removeFrameSink(int sinkId) {
+    frameSinks_.remove(sinkId);
+}
 
-            // 从缓冲区移除已处理的数据包
-            receiveBuffer_.remove(0, expectedPacketSize);
-        } else {
-            // 无效的数据包，移除包头并继续搜索
-            receiveBuffer_.remove(0, 1);
-            qWarning() << "Invalid packet format, removed 1 byte";
+int ConnectionManager::parseFrames(const ScatterSpan& data) {
+    return FrameCodec::parse(data, [this](const ScatterSpan& payload) {
+        receiveCounters_.frames.fetch_add(1, std::memory_order_relaxed);
+        // 先由帧回调处理应答内容（影子状态等），frameAcknowledged的接收方看到的是已更新的状态
+        deliverFrame(payload);
+        matchAcknowledgement(payload);
+
+        if (isSignalConnected(QMetaMethod::fromSignal(&ConnectionManager::dataReceived))) {
+            QByteArray packetData = payload.toByteArray();
+            qDebug() << "Complete packet received:" << packetData.size() << "bytes";
+            emit dataReceived(packetData);
         }
-    }
+    });
+}
 
-    return packets;
+void ConnectionManager::deliverFrame(const ScatterSpan& payload) {
+    frameSinks_.dispatch(payload);
 }
 
 } // namespace Protocol
@@ -6,8 +6,15 @@
 #include <QString>
 #include <QTimer>
 #include <QQueue>
+#include <QList>
 #include <QMutex>
+#include <QElapsedTimer>
 #include "protocol/transport/itransport.h"
+#include "protocol/transport/sink_list.h"
+#include "protocol/serialization/scatter_span.h"
+#include "rate_meter.h"
+#include <atomic>
+#include <functional>
 
 namespace Protocol {
 
@@ -55,14 +62,71 @@ public:
      */
     bool sendData(const QByteArray& data);
 
+    /**
+     * @brief 可靠发送（滑动窗口）
+     *
+     * 帧获得序号后进入发送窗口：窗口未满时立即发送，否则排队。
+     * 等待确认的REQUEST在信封中携带序号字段（已携带时沿用其序号），设备在RESPONSE中
+     * 带回序号时按序号精确确认；旧版设备不带回序号，只能按ProtoID确认，
+     * 此时同一ProtoID同一时刻只有一帧在途，避免应答被记到另一帧上。
+     * 超时后按指数退避（带随机抖动）重传，窗口内其余帧继续发送，不会被单个慢帧阻塞。
+     * 排队中尚未发送的同ProtoID写入请求被新写入替换（旧帧以frameFailed通知），
+     * 排队帧数达到上限时拒绝新帧；加上序号后超过单帧长度上限的数据直接拒绝，不进入窗口。
+     * 周期性状态流请直接用sendData()发送，不要占用窗口。
+     * 最终结果通过frameAcknowledged/frameFailed信号通知；无法识别ProtoID或未要求确认的帧
+     * 在传输层写入成功时即完成，信号可能在本函数返回前发射。
+     * 须在ConnectionManager所在线程调用。
+     * @param data 要发送的MsgRequestResponse数据
+     * @param maxRetries 最大重传次数
+     * @return 帧序号，数据无效、超长、队列已满或未连接时返回0
+     */
+    quint32 sendReliable(const QByteArray& data, int maxRetries = 3);
+
     /**
      * @brief 发送数据（带重试）
      * @param data 要发送的数据
      * @param maxRetries 最大重试次数
-     * @return 成功返回true，失败返回false
+     * @return 已进入发送窗口返回true，失败返回false
      */
     bool sendDataWithRetry(const QByteArray& data, int maxRetries = 3);
 
+    /**
+     * @brief 分配帧序号
+     *
+     * 调用方可先用ProtocolPackager::appendSequence()把序号写入信封再交给sendReliable()，
+     * 从而在发送前得知应答将带回的序号。
+     * @return 非0的帧序号
+     */
+    quint32 allocateSequence();
+
+    /**
+     * @brief 可靠发送配置接口
+     */
+
+    // 同时在途（已发送未确认）的最大帧数
+    void setWindowSize(int frames);
+    int windowSize() const { return windowSize_; }
+
+    // 首次确认超时（毫秒），后续重传按指数退避
+    void setAckTimeout(int ms);
+    int ackTimeout() const { return ackTimeoutMs_; }
+
+    // 退避间隔上限（毫秒）
+    void setMaxBackoff(int ms);
+    int maxBackoff() const { return maxBackoffMs_; }
+
+    // 窗口已满时最多排队的帧数
+    void setMaxPendingFrames(int frames);
+    int maxPendingFrames() const { return maxPendingFrames_; }
+
+    // 是否等待设备RESPONSE确认；关闭时传输层写入成功即视为完成
+    void setAckRequired(bool required) { ackRequired_ = required; }
+    bool ackRequired() const { return ackRequired_; }
+
+    // 在途帧数与排队帧数
+    int inFlightCount() const { return inFlight_.size(); }
+    int pendingReliableCount() const { return pendingFrames_.size(); }
+
     /**
      * @brief 设置接收缓冲区大小
      * @param size 缓冲区大小（字节）
@@ -81,18 +145,45 @@ public:
     void clearReceiveBuffer();
 
     /**
-     * @brief 获取连接统计信息
+     * @brief 帧接收回调
+     *
+     * 每解析出一帧，在接收线程上以借用的载荷视图直接调用，不构造QByteArray。
+     * 跨两次读取的帧不拼接，视图由接收缓冲区中的残留和新数据两段组成，
+     * 可直接交给ProtocolPackager::unpackEnvelope()和MessageCodec::decode()就地解码。
+     * 视图只在回调期间有效。dataReceived信号仅在有连接时才复制载荷。
+     */
+    using FrameSink = std::function<void(const ScatterSpan&)>;
+
+    // 注册帧回调，返回回调ID
+    int addFrameSink(FrameSink sink);
+
+    // 注销帧回调（可在回调内部调用）
+    void removeFrameSink(int sinkId);
+
+    /**
+     * @brief 连接统计信息快照
+     *
+     * 计数为64位累计值；速率为EWMA平滑后的每秒值，每秒采样一次。
      */
     struct ConnectionStats {
-        int bytesSent = 0;
-        int bytesReceived = 0;
-        int sendErrorCount = 0;
-        int receiveErrorCount = 0;
-        int retryCount = 0;
+        quint64 bytesSent = 0;
+        quint64 bytesReceived = 0;
+        quint64 framesSent = 0;
+        quint64 framesReceived = 0;
+        quint64 sendErrorCount = 0;
+        quint64 receiveErrorCount = 0;
+        quint64 retryCount = 0;
+        double sendBytesPerSec = 0.0;
+        double receiveBytesPerSec = 0.0;
+        double sendFramesPerSec = 0.0;
+        double receiveFramesPerSec = 0.0;
         QString lastError;
     };
 
-    ConnectionStats getConnectionStats() const { return stats_; }
+    /**
+     * @brief 获取连接统计信息快照（可在任意线程调用，不阻塞收发路径）
+     */
+    ConnectionStats getConnectionStats() const;
 
     /**
      * @brief 重置统计信息
@@ -132,6 +223,21 @@ signals:
      */
     void retryingSend(int attempt, int maxRetries);
 
+    /**
+     * @brief 可靠发送的帧已被确认（在帧回调处理该应答之后发射）
+     * @param sequence 帧序号
+     * @param protoId 帧的ProtoID（未要求确认时为-1）
+     * @param roundTripMs 从最后一次发送到确认的往返时间（毫秒）
+     */
+    void frameAcknowledged(quint32 sequence, int protoId, int roundTripMs);
+
+    /**
+     * @brief 可靠发送的帧最终失败
+     * @param sequence 帧序号
+     * @param error 错误信息
+     */
+    void frameFailed(quint32 sequence, const QString& error);
+
 private slots:
     /**
      * @brief 处理传输层数据接收
@@ -156,6 +262,11 @@ private slots:
      */
     void handleRetryTimeout();
 
+    /**
+     * @brief 速率采样定时器处理
+     */
+    void sampleRates();
+
 private:
     /**
      * @brief 连接传输层信号
@@ -168,44 +279,138 @@ private:
     void disconnectTransportSignals();
 
     /**
-     * @brief 处理接收缓冲区数据
+     * @brief 记录发送/接收错误
+     */
+    void recordSendError(const QString& error);
+    void recordReceiveError(const QString& error);
+
+    /**
+     * @brief 处理接收到的原始数据
+     *
+     * 直接在传输层缓冲区上解析；有上次残留时把残留和新数据作为两段解析，
+     * 只把不完整的尾部复制到接收缓冲区。
+     * @param data 数据指针
+     * @param size 数据长度
+     */
+    void processReceivedBytes(const char* data, int size);
+
+    /**
+     * @brief 就地解析数据帧，调用帧回调并发射dataReceived
+     * @param data 数据视图
+     * @return 已消费的字节数，剩余部分为不完整的帧
+     */
+    int parseFrames(const ScatterSpan& data);
+
+    /**
+     * @brief 分发一帧给帧回调
+     */
+    void deliverFrame(const ScatterSpan& payload);
+
+    /**
+     * @brief 可靠发送的帧状态
+     */
+    struct ReliableFrame {
+        quint32 sequence = 0;               // 本地序号
+        QByteArray data;                    // 待发送数据
+        int protoId = -1;                   // 用于匹配确认的ProtoID（-1表示不等待确认）
+        int writeProtoId = -1;              // 写入请求的ProtoID，排队时被同ProtoID新写入替换（-1表示不替换）
+        int attempts = 0;                   // 已发送次数
+        int maxRetries = 0;                 // 最大重传次数
+        qint64 sentAtMs = 0;                // 最后一次发送时间
+        qint64 deadlineMs = 0;              // 确认/重传截止时间
+    };
+
+    /**
+     * @brief 在窗口允许范围内发送排队的帧
+     */
+    void pumpReliableQueue();
+
+    /**
+     * @brief 发送（或重传）一帧
+     * @return 帧仍需跟踪返回true，已完成或失败返回false
      */
-    void processReceiveBuffer();
+    bool transmitFrame(ReliableFrame& frame);
 
     /**
-     * @brief 检查数据包完整性
-     * @param data 数据
-     * @return 完整返回true，不完整返回false
+     * @brief 按序号把帧插入在途列表
      */
-    bool isPacketComplete(const QByteArray& data) const;
+    void insertInFlight(const ReliableFrame& frame);
 
     /**
-     * @brief 提取完整的数据包
-     * @return 完整的数据包列表
+     * @brief 用收到的RESPONSE确认在途帧
+     *
+     * RESPONSE携带序号时只确认同序号的帧（重传引起的重复应答被忽略），
+     * 否则确认最早的同ProtoID在途帧。
      */
-    QList<QByteArray> extractCompletePackets();
+    void matchAcknowledgement(const ScatterSpan& data);
+
+    /**
+     * @brief 帧是否须等待同ProtoID的在途帧确认后才能发送
+     */
+    bool isBlockedByInFlight(const ReliableFrame& frame) const;
+
+    /**
+     * @brief 计算第attempt次发送后的退避间隔（带抖动）
+     */
+    int backoffInterval(int attempt) const;
+
+    /**
+     * @brief 按最早截止时间重新启动重传定时器
+     */
+    void rearmRetryTimer();
+
+    /**
+     * @brief 丢弃全部在途与排队的帧
+     */
+    void failAllReliable(const QString& error);
 
 private:
     ITransport* transport_ = nullptr;       // 传输层对象
+    int receiveSinkId_ = 0;                 // 传输层接收回调ID（0表示使用信号）
     QByteArray receiveBuffer_;              // 接收缓冲区
     int maxBufferSize_ = 4096;              // 最大缓冲区大小
+    SinkList<const ScatterSpan&> frameSinks_;   // 帧回调
+
+    // 可靠发送（滑动窗口）
+    QTimer* retryTimer_;                    // 重传定时器（按最早截止时间启动）
+    QElapsedTimer reliableClock_;           // 单调时钟
+    QList<ReliableFrame> inFlight_;         // 在途帧（按序号升序）
+    QQueue<ReliableFrame> pendingFrames_;   // 窗口已满时排队的帧
+    quint32 nextSequence_ = 1;              // 下一个帧序号
+    int windowSize_ = 8;                    // 发送窗口大小
+    int maxPendingFrames_ = 64;             // 排队帧数上限
+    int ackTimeoutMs_ = 200;                // 首次确认超时（毫秒）
+    int maxBackoffMs_ = 5000;               // 退避间隔上限（毫秒）
+    bool ackRequired_ = true;               // 是否等待RESPONSE确认
+    bool peerEchoesSequence_ = false;       // 对端是否在RESPONSE中带回序号
+
+    // 统计信息：发送与接收计数分处不同缓存行，避免收发线程互相伪共享
+    struct alignas(64) SendCounters {
+        std::atomic<quint64> bytes{0};
+        std::atomic<quint64> frames{0};
+        std::atomic<quint64> errors{0};
+        std::atomic<quint64> retries{0};
+    };
+    struct alignas(64) ReceiveCounters {
+        std::atomic<quint64> bytes{0};
+        std::atomic<quint64> frames{0};
+        std::atomic<quint64> errors{0};
+    };
+    SendCounters sendCounters_;
+    ReceiveCounters receiveCounters_;
+
+    QTimer* rateTimer_;                     // 速率采样定时器
+    QElapsedTimer rateClock_;               // 速率采样时钟
+    RateMeter sendBytesRate_;
+    RateMeter receiveBytesRate_;
+    RateMeter sendFramesRate_;
+    RateMeter receiveFramesRate_;
+
+    mutable QMutex errorMutex_;             // 仅保护lastError_（错误路径）
+    QString lastError_;                     // 最近一次错误
 
-    // 重试机制
-    QTimer* retryTimer_;                    // 重试定时器
-    QQueue<QByteArray> retryQueue_;         // 重试队列
-    QMutex retryMutex_;                     // 重试队列互斥锁
-    int currentRetryCount_ = 0;             // 当前重试次数
-    int maxRetryCount_ = 3;                 // 最大重试次数
-    int retryIntervalMs_ = 1000;            // 重试间隔（毫秒）
-
-    // 统计信息
-    mutable QMutex statsMutex_;             // 统计信息互斥锁
-    ConnectionStats stats_;                 // 连接统计
-
-    // 协议相关
-    static constexpr uint8_t PACKET_HEADER = 0xAA;  // 数据包头
-    static constexpr uint8_t PACKET_FOOTER = 0x55;  // 数据包尾
-    static constexpr int MIN_PACKET_SIZE = 3;        // 最小数据包大小（头+长度+尾）
+    // 常量
+    static const int RATE_SAMPLE_INTERVAL_MS;
 };
 
 } // namespace Protocol
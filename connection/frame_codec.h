@@ -0,0 +1,127 @@
+#ifndef FRAME_CODEC_H
+#define FRAME_CODEC_H
+
+#include <QByteArray>
+#include <QDebug>
+#include <cstdint>
+#include <cstring>
+#include "protocol/serialization/scatter_span.h"
+
+namespace Protocol {
+
+/**
+ * @brief 链路层帧编解码
+ *
+ * 帧格式：[0xAA][长度(1字节)][数据][0x55]
+ * ConnectionManager与IoReactor共用，解析直接在调用方缓冲区上进行。
+ */
+class FrameCodec {
+public:
+    static constexpr uint8_t FRAME_HEADER = 0xAA;   // 帧头
+    static constexpr uint8_t FRAME_FOOTER = 0x55;   // 帧尾
+    static constexpr int MIN_FRAME_SIZE = 3;        // 最小帧长度（头+长度+尾）
+    static constexpr int MAX_PAYLOAD_SIZE = 255;    // 单帧最大数据长度
+    static constexpr int FRAME_OVERHEAD = 3;        // 帧头尾开销
+
+    /**
+     * @brief 封装数据帧
+     * @param payload 数据内容
+     * @return 完整帧，数据超长时返回空
+     */
+    static QByteArray encode(const QByteArray& payload) {
+        if (payload.size() > MAX_PAYLOAD_SIZE) {
+            return QByteArray();
+        }
+
+        QByteArray frame;
+        frame.reserve(payload.size() + FRAME_OVERHEAD);
+        frame.append(static_cast<char>(FRAME_HEADER));
+        frame.append(static_cast<char>(payload.size()));
+        frame.append(payload);
+        frame.append(static_cast<char>(FRAME_FOOTER));
+        return frame;
+    }
+
+    /**
+     * @brief 就地解析数据帧
+     * @param data 数据指针
+     * @param size 数据长度
+     * @param onPayload 每解析出一帧调用一次，参数为(const char* payload, int length)
+     * @param droppedBytes 可选，累加被丢弃的无效字节数
+     * @return 已消费的字节数，剩余部分为不完整的帧
+     */
+    template<typename Callback>
+    static int parse(const char* data, int size, Callback&& onPayload, int* droppedBytes = nullptr) {
+        return parse(ScatterSpan(data, size), [&onPayload](const ScatterSpan& payload) {
+            onPayload(payload.first(), payload.size());
+        }, droppedBytes);
+    }
+
+    /**
+     * @brief 就地解析两段不连续的数据（如上次残留的半帧和新读到的数据）
+     *
+     * 跨两段的帧不拼接，回调得到的载荷视图同样可能由两段组成。
+     * @param data 数据视图
+     * @param onPayload 每解析出一帧调用一次，参数为(const ScatterSpan& payload)
+     * @param droppedBytes 可选，累加被丢弃的无效字节数
+     * @return 已消费的字节数，剩余部分为不完整的帧
+     */
+    template<typename Callback>
+    static int parse(const ScatterSpan& data, Callback&& onPayload, int* droppedBytes = nullptr) {
+        const int size = data.size();
+        int pos = 0;
+
+        while (size - pos >= MIN_FRAME_SIZE) {
+            // 查找帧头
+            int headerIndex = data.indexOf(static_cast<char>(FRAME_HEADER), pos);
+            if (headerIndex < 0) {
+                // 没有找到帧头，丢弃全部数据
+                if (droppedBytes) {
+                    *droppedBytes += size - pos;
+                }
+                return size;
+            }
+
+            // 跳过帧头之前的无效数据
+            if (headerIndex > pos) {
+                qWarning() << "Removed" << (headerIndex - pos) << "bytes of invalid data";
+                if (droppedBytes) {
+                    *droppedBytes += headerIndex - pos;
+                }
+                pos = headerIndex;
+            }
+
+            // 检查是否有足够的数据来解析长度
+            if (size - pos < 2) {
+                break; // 等待更多数据
+            }
+
+            uint8_t dataLength = static_cast<uint8_t>(data.at(pos + 1));
+            int expectedFrameSize = 2 + dataLength + 1; // 头+长度+数据+尾
+
+            // 检查是否有完整的帧
+            if (size - pos < expectedFrameSize) {
+                break; // 等待更多数据
+            }
+
+            if (static_cast<uint8_t>(data.at(pos + expectedFrameSize - 1)) == FRAME_FOOTER) {
+                ScatterSpan payload = data.mid(pos + 2, dataLength);
+                pos += expectedFrameSize;
+                onPayload(payload);
+            } else {
+                // 无效帧，跳过帧头继续搜索
+                pos += 1;
+                if (droppedBytes) {
+                    *droppedBytes += 1;
+                }
+                qWarning() << "Invalid packet format, removed 1 byte";
+            }
+        }
+
+        return pos;
+    }
+};
+
+} // namespace Protocol
+
+#endif // FRAME_CODEC_H
@@ -0,0 +1,616 @@
+#include "io_reactor.h"
+#include "frame_codec.h"
+#include <QDebug>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QQueue>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace Protocol {
+
+// 常量定义
+const int IoReactor::MAX_EVENTS_PER_WAIT = 64;
+const int IoReactor::READ_BUFFER_SIZE = 64 * 1024;
+const int IoReactor::DEFAULT_MAX_PENDING_BYTES = 64 * 1024;
+
+namespace {
+
+constexpr uint64_t WAKE_TOKEN = ~static_cast<uint64_t>(0);
+constexpr int MAX_CARRY_BYTES = 4 * (FrameCodec::MAX_PAYLOAD_SIZE + FrameCodec::FRAME_OVERHEAD);
+
+qint64 monotonicMs()
+{
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+speed_t baudRateToSpeed(int baudRate)
+{
+    switch (baudRate) {
+    case 9600:    return B9600;
+    case 19200:   return B19200;
+    case 38400:   return B38400;
+    case 57600:   return B57600;
+    case 115200:  return B115200;
+    case 230400:  return B230400;
+    case 460800:  return B460800;
+    case 921600:  return B921600;
+    case 1000000: return B1000000;
+    case 2000000: return B2000000;
+    default:      return B0;
+    }
+}
+
+QString errnoString()
+{
+    return QString::fromLocal8Bit(strerror(errno));
+}
+
+} // namespace
+
+/**
+ * @brief 反应器中的设备
+ *
+ * 接收状态只由所属epoll线程访问；发送队列由txMutex保护，可从任意线程写入。
+ */
+struct IoReactor::Device {
+    int id = 0;
+    int fd = -1;
+    QString name;
+    PacketHandler handler;
+    Worker* worker = nullptr;
+    std::atomic<bool> open{true};
+
+    // 接收（仅epoll线程）
+    QByteArray rxCarry;
+
+    // 发送
+    QMutex txMutex;
+    QByteArray txQueue;
+    int txOffset = 0;
+    bool writeArmed = false;
+    quint64 txEnqueuedBytes = 0;        // 累计入队字节数
+    QQueue<quint64> txFrameEnds;        // 队列中各帧的结束位置（按累计入队字节数），写完后计入packetsSent
+
+    // 统计
+    std::atomic<quint64> bytesReceived{0};
+    std::atomic<quint64> bytesSent{0};
+    std::atomic<quint64> packetsReceived{0};
+    std::atomic<quint64> packetsSent{0};
+    std::atomic<quint64> droppedBytes{0};
+    std::atomic<quint64> sendErrorCount{0};
+    std::atomic<qint64> lastActivityMs{0};
+
+    ~Device() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+};
+
+/**
+ * @brief epoll工作线程
+ */
+struct IoReactor::Worker {
+    int index = 0;
+    int epollFd = -1;
+    int wakeFd = -1;
+    std::thread thread;
+    std::atomic<int> deviceCount{0};
+    QByteArray readBuffer;
+
+    ~Worker() {
+        if (wakeFd >= 0) {
+            ::close(wakeFd);
+        }
+        if (epollFd >= 0) {
+            ::close(epollFd);
+        }
+    }
+};
+
+IoReactor::IoReactor(int threadCount, QObject* parent)
+    : QObject(parent)
+    , threadCount_(qMax(1, threadCount))
+    , running_(false)
+    , nextDeviceId_(1)
+    , maxPendingBytes_(DEFAULT_MAX_PENDING_BYTES)
+{
+    qDebug() << "IoReactor initialized with" << threadCount_ << "threads";
+}
+
+IoReactor::~IoReactor()
+{
+    stop();
+    qDebug() << "IoReactor destroyed";
+}
+
+bool IoReactor::start()
+{
+    if (isRunning()) {
+        return true;
+    }
+
+    workers_.clear();
+    for (int i = 0; i < threadCount_; ++i) {
+        std::unique_ptr<Worker> worker(new Worker());
+        worker->index = i;
+        worker->readBuffer.resize(READ_BUFFER_SIZE);
+        worker->epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+        worker->wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (worker->epollFd < 0 || worker->wakeFd < 0) {
+            qWarning() << "Failed to create reactor thread resources:" << errnoString();
+            workers_.clear();
+            return false;
+        }
+
+        struct epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.u64 = WAKE_TOKEN;
+        ::epoll_ctl(worker->epollFd, EPOLL_CTL_ADD, worker->wakeFd, &event);
+
+        workers_.push_back(std::move(worker));
+    }
+
+    running_.store(true, std::memory_order_release);
+    for (auto& worker : workers_) {
+        Worker* raw = worker.get();
+        worker->thread = std::thread([this, raw]() { workerLoop(raw); });
+    }
+
+    qInfo() << "IoReactor started with" << threadCount_ << "threads";
+    return true;
+}
+
+void IoReactor::stop()
+{
+    if (!running_.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    const uint64_t one = 1;
+    for (auto& worker : workers_) {
+        ssize_t ignored = ::write(worker->wakeFd, &one, sizeof(one));
+        Q_UNUSED(ignored);
+    }
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+
+    {
+        QWriteLocker locker(&devicesLock_);
+        for (auto& device : devices_) {
+            device->open.store(false, std::memory_order_release);
+        }
+        devices_.clear();
+        workers_.clear();
+    }
+
+    qInfo() << "IoReactor stopped";
+}
+
+int IoReactor::addSerialDevice(const QString& portName, int baudRate, PacketHandler handler)
+{
+    speed_t speed = baudRateToSpeed(baudRate);
+    if (speed == B0) {
+        qWarning() << "Unsupported baud rate:" << baudRate;
+        return -1;
+    }
+
+    QByteArray path = portName.toLocal8Bit();
+    int fd = ::open(path.constData(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        qWarning() << "Failed to open serial device" << portName << ":" << errnoString();
+        return -1;
+    }
+
+    // 8N1原始模式，与SerialTransport的默认配置一致
+    struct termios tio;
+    if (::tcgetattr(fd, &tio) < 0) {
+        qWarning() << "Failed to read serial attributes for" << portName << ":" << errnoString();
+        ::close(fd);
+        return -1;
+    }
+
+    ::cfmakeraw(&tio);
+    tio.c_cflag |= (CLOCAL | CREAD);
+    tio.c_cflag &= ~(CSTOPB | PARENB | CRTSCTS);
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    ::cfsetispeed(&tio, speed);
+    ::cfsetospeed(&tio, speed);
+
+    if (::tcsetattr(fd, TCSANOW, &tio) < 0) {
+        qWarning() << "Failed to configure serial device" << portName << ":" << errnoString();
+        ::close(fd);
+        return -1;
+    }
+    ::tcflush(fd, TCIOFLUSH);
+
+    int deviceId = registerDevice(fd, portName, std::move(handler));
+    if (deviceId > 0) {
+        qInfo() << "Serial device added:" << portName << "baud:" << baudRate << "id:" << deviceId;
+    }
+    return deviceId;
+}
+
+int IoReactor::adoptDevice(int fd, const QString& name, PacketHandler handler)
+{
+    if (fd < 0) {
+        return -1;
+    }
+
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+    int deviceId = registerDevice(fd, name, std::move(handler));
+    if (deviceId > 0) {
+        qInfo() << "Device adopted:" << name << "id:" << deviceId;
+    }
+    return deviceId;
+}
+
+bool IoReactor::removeDevice(int deviceId)
+{
+    std::shared_ptr<Device> device = findDevice(deviceId);
+    if (!device || !unregisterDevice(device)) {
+        return false;
+    }
+
+    if (device->open.exchange(false, std::memory_order_acq_rel)) {
+        ::epoll_ctl(device->worker->epollFd, EPOLL_CTL_DEL, device->fd, nullptr);
+    }
+
+    qInfo() << "Device removed:" << device->name << "id:" << deviceId;
+    return true;
+}
+
+bool IoReactor::sendPacket(int deviceId, const QByteArray& payload)
+{
+    std::shared_ptr<Device> device = findDevice(deviceId);
+    if (!device || !device->open.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    QByteArray frame = FrameCodec::encode(payload);
+    if (frame.isEmpty()) {
+        device->sendErrorCount.fetch_add(1, std::memory_order_relaxed);
+        emit deviceError(deviceId, QString("Payload too large: %1 bytes").arg(payload.size()));
+        return false;
+    }
+
+    QMutexLocker locker(&device->txMutex);
+
+    int pending = device->txQueue.size() - device->txOffset;
+    if (pending + frame.size() > maxPendingBytes_) {
+        device->sendErrorCount.fetch_add(1, std::memory_order_relaxed);
+        emit deviceError(deviceId, "Send queue full");
+        return false;
+    }
+
+    device->txQueue.append(frame);
+    device->txEnqueuedBytes += static_cast<quint64>(frame.size());
+    device->txFrameEnds.enqueue(device->txEnqueuedBytes);
+
+    // 队列原本为空时直接在调用线程写出，只有写不完才交给epoll线程
+    if (!device->writeArmed && !flushDevice(device.get())) {
+        QString error = QString("Write error: %1").arg(errnoString());
+        locker.unlock();
+        closeDevice(device, error);
+        return false;
+    }
+    return true;
+}
+
+IoReactor::DeviceStats IoReactor::deviceStats(int deviceId) const
+{
+    DeviceStats stats;
+    std::shared_ptr<Device> device = findDevice(deviceId);
+    if (!device) {
+        return stats;
+    }
+
+    stats.name = device->name;
+    stats.open = device->open.load(std::memory_order_acquire);
+    stats.bytesReceived = device->bytesReceived.load(std::memory_order_relaxed);
+    stats.bytesSent = device->bytesSent.load(std::memory_order_relaxed);
+    stats.packetsReceived = device->packetsReceived.load(std::memory_order_relaxed);
+    stats.packetsSent = device->packetsSent.load(std::memory_order_relaxed);
+    stats.droppedBytes = device->droppedBytes.load(std::memory_order_relaxed);
+    stats.sendErrorCount = device->sendErrorCount.load(std::memory_order_relaxed);
+    stats.lastActivityMs = device->lastActivityMs.load(std::memory_order_relaxed);
+    stats.threadIndex = device->worker ? device->worker->index : -1;
+    {
+        QMutexLocker locker(&device->txMutex);
+        stats.pendingSendBytes = device->txQueue.size() - device->txOffset;
+    }
+    return stats;
+}
+
+QList<int> IoReactor::deviceIds() const
+{
+    QReadLocker locker(&devicesLock_);
+    return devices_.keys();
+}
+
+int IoReactor::deviceCount() const
+{
+    QReadLocker locker(&devicesLock_);
+    return devices_.size();
+}
+
+int IoReactor::registerDevice(int fd, const QString& name, PacketHandler handler)
+{
+    // 持有写锁期间stop()不能清空workers_，停止后注册直接失败
+    QWriteLocker locker(&devicesLock_);
+    Worker* worker = isRunning() ? selectWorker() : nullptr;
+    if (!worker) {
+        qWarning() << "IoReactor is not running, cannot add device:" << name;
+        ::close(fd);
+        return -1;
+    }
+
+    std::shared_ptr<Device> device = std::make_shared<Device>();
+    device->id = nextDeviceId_.fetch_add(1, std::memory_order_relaxed);
+    device->fd = fd;
+    device->name = name;
+    device->handler = std::move(handler);
+    device->worker = worker;
+    devices_.insert(device->id, device);
+
+    struct epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | EPOLLRDHUP;
+    event.data.u64 = static_cast<uint64_t>(device->id);
+    if (::epoll_ctl(worker->epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        qWarning() << "Failed to register device" << name << "with epoll:" << errnoString();
+        devices_.remove(device->id);
+        return -1;
+    }
+
+    worker->deviceCount.fetch_add(1, std::memory_order_relaxed);
+    return device->id;
+}
+
+bool IoReactor::unregisterDevice(const std::shared_ptr<Device>& device)
+{
+    {
+        QWriteLocker locker(&devicesLock_);
+        auto it = devices_.find(device->id);
+        if (it == devices_.end() || it.value() != device) {
+            return false;
+        }
+        devices_.erase(it);
+    }
+
+    // 只有从表中移除设备的一方减少计数，removeDevice与closeDevice并发时也只减一次
+    device->worker->deviceCount.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+std::shared_ptr<IoReactor::Device> IoReactor::findDevice(int deviceId) const
+{
+    QReadLocker locker(&devicesLock_);
+    return devices_.value(deviceId);
+}
+
+IoReactor::Worker* IoReactor::selectWorker()
+{
+    // 调用方持有devicesLock_
+    if (workers_.empty()) {
+        return nullptr;
+    }
+
+    Worker* selected = workers_.front().get();
+    for (auto& worker : workers_) {
+        if (worker->deviceCount.load(std::memory_order_relaxed) <
+            selected->deviceCount.load(std::memory_order_relaxed)) {
+            selected = worker.get();
+        }
+    }
+    return selected;
+}
+
+void IoReactor::workerLoop(Worker* worker)
+{
+    std::vector<struct epoll_event> events(MAX_EVENTS_PER_WAIT);
+
+    while (running_.load(std::memory_order_acquire)) {
+        int count = ::epoll_wait(worker->epollFd, events.data(), MAX_EVENTS_PER_WAIT, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            qWarning() << "epoll_wait failed in reactor thread" << worker->index << ":" << errnoString();
+            break;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            if (events[i].data.u64 == WAKE_TOKEN) {
+                uint64_t counter = 0;
+                ssize_t ignored = ::read(worker->wakeFd, &counter, sizeof(counter));
+                Q_UNUSED(ignored);
+                continue;
+            }
+
+            std::shared_ptr<Device> device = findDevice(static_cast<int>(events[i].data.u64));
+            if (!device || !device->open.load(std::memory_order_acquire)) {
+                continue;
+            }
+
+            uint32_t flags = events[i].events;
+            if (flags & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+                handleReadable(worker, device);
+            }
+            if ((flags & EPOLLOUT) && device->open.load(std::memory_order_acquire)) {
+                handleWritable(device);
+            }
+        }
+    }
+}
+
+void IoReactor::handleReadable(Worker* worker, const std::shared_ptr<Device>& device)
+{
+    Device* dev = device.get();
+    auto deliver = [this, dev](const char* payload, int size) {
+        dev->packetsReceived.fetch_add(1, std::memory_order_relaxed);
+        if (dev->handler) {
+            dev->handler(dev->id, payload, size);
+        } else {
+            emit packetReceived(dev->id, QByteArray(payload, size));
+        }
+    };
+
+    for (;;) {
+        ssize_t n = ::read(dev->fd, worker->readBuffer.data(), static_cast<size_t>(worker->readBuffer.size()));
+        if (n > 0) {
+            dev->bytesReceived.fetch_add(static_cast<quint64>(n), std::memory_order_relaxed);
+            dev->lastActivityMs.store(monotonicMs(), std::memory_order_relaxed);
+
+            int dropped = 0;
+            const char* data = worker->readBuffer.constData();
+            int size = static_cast<int>(n);
+
+            if (dev->rxCarry.isEmpty()) {
+                // 快速路径：直接在线程读缓冲区上解析
+                int consumed = FrameCodec::parse(data, size, deliver, &dropped);
+                if (consumed < size) {
+                    dev->rxCarry.append(data + consumed, size - consumed);
+                }
+            } else {
+                dev->rxCarry.append(data, size);
+                int consumed = FrameCodec::parse(dev->rxCarry.constData(), dev->rxCarry.size(), deliver, &dropped);
+                dev->rxCarry.remove(0, consumed);
+            }
+
+            if (dev->rxCarry.size() > MAX_CARRY_BYTES) {
+                dropped += dev->rxCarry.size();
+                dev->rxCarry.clear();
+            }
+            if (dropped > 0) {
+                dev->droppedBytes.fetch_add(static_cast<quint64>(dropped), std::memory_order_relaxed);
+            }
+
+            if (!dev->open.load(std::memory_order_acquire)) {
+                return;  // 回调中移除了设备
+            }
+            continue;
+        }
+
+        if (n == 0) {
+            closeDevice(device, "Device closed by peer");
+            return;
+        }
+
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            closeDevice(device, QString("Read error: %1").arg(errnoString()));
+        }
+        return;
+    }
+}
+
+void IoReactor::handleWritable(const std::shared_ptr<Device>& device)
+{
+    QString error;
+    {
+        QMutexLocker locker(&device->txMutex);
+        if (!flushDevice(device.get())) {
+            error = QString("Write error: %1").arg(errnoString());
+        }
+    }
+
+    if (!error.isEmpty()) {
+        closeDevice(device, error);
+    }
+}
+
+bool IoReactor::flushDevice(Device* device)
+{
+    // 调用方持有txMutex
+    while (device->txOffset < device->txQueue.size()) {
+        ssize_t n = ::write(device->fd, device->txQueue.constData() + device->txOffset,
+                            static_cast<size_t>(device->txQueue.size() - device->txOffset));
+        if (n > 0) {
+            device->txOffset += static_cast<int>(n);
+            // bytesSent只在持有txMutex时增加，累计值与txFrameEnds可直接比较
+            const quint64 written = device->bytesSent.fetch_add(static_cast<quint64>(n), std::memory_order_relaxed)
+                                    + static_cast<quint64>(n);
+            while (!device->txFrameEnds.isEmpty() && device->txFrameEnds.head() <= written) {
+                device->txFrameEnds.dequeue();
+                device->packetsSent.fetch_add(1, std::memory_order_relaxed);
+            }
+            continue;
+        }
+
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            device->sendErrorCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        // 内核缓冲区已满，等待EPOLLOUT
+        if (!device->writeArmed) {
+            struct epoll_event event;
+            std::memset(&event, 0, sizeof(event));
+            event.events = EPOLLIN | EPOLLRDHUP | EPOLLOUT;
+            event.data.u64 = static_cast<uint64_t>(device->id);
+            ::epoll_ctl(device->worker->epollFd, EPOLL_CTL_MOD, device->fd, &event);
+            device->writeArmed = true;
+        }
+
+        // 已发送部分过半时压缩队列
+        if (device->txOffset > device->txQueue.size() / 2) {
+            device->txQueue.remove(0, device->txOffset);
+            device->txOffset = 0;
+        }
+        return true;
+    }
+
+    device->txQueue.clear();
+    device->txOffset = 0;
+
+    if (device->writeArmed) {
+        struct epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.u64 = static_cast<uint64_t>(device->id);
+        ::epoll_ctl(device->worker->epollFd, EPOLL_CTL_MOD, device->fd, &event);
+        device->writeArmed = false;
+    }
+    return true;
+}
+
+void IoReactor::closeDevice(const std::shared_ptr<Device>& device, const QString& reason)
+{
+    if (!device->open.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    ::epoll_ctl(device->worker->epollFd, EPOLL_CTL_DEL, device->fd, nullptr);
+
+    // 关闭的设备不再计入所在线程的负载；文件描述符在最后一个引用释放时关闭
+    unregisterDevice(device);
+
+    qWarning() << "Reactor device" << device->name << "closed:" << reason;
+    emit deviceError(device->id, reason);
+    emit deviceClosed(device->id);
+}
+
+} // namespace Protocol
@@ -0,0 +1,186 @@
+#ifndef IO_REACTOR_H
+#define IO_REACTOR_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QReadWriteLock>
+#include <QString>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace Protocol {
+
+/**
+ * @brief 多设备I/O反应器
+ *
+ * 在少量epoll线程上同时服务大量设备（如产线测试工位上的16~64个DSP），
+ * 替代每台设备一套SerialTransport + ConnectionManager的方式：
+ * - 设备按负载均衡分配到各epoll线程，线程内非阻塞读写
+ * - 帧解析在线程本地读缓冲区上就地进行，完整帧交给设备的处理回调
+ * - 发送线程安全，缓冲区满时由EPOLLOUT继续发送
+ * - 每台设备独立统计收发字节数、帧数和错误
+ *
+ * 仅支持Linux平台
+ */
+class IoReactor : public QObject {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 帧处理回调
+     *
+     * 在反应器线程上直接调用，payload仅在回调期间有效。
+     * @param deviceId 设备ID
+     * @param payload 帧数据（已去除帧头尾）
+     * @param size 数据长度
+     */
+    using PacketHandler = std::function<void(int deviceId, const char* payload, int size)>;
+
+    /**
+     * @brief 设备统计信息
+     */
+    struct DeviceStats {
+        QString name;
+        bool open = false;
+        quint64 bytesReceived = 0;
+        quint64 bytesSent = 0;
+        quint64 packetsReceived = 0;
+        quint64 packetsSent = 0;           // 已完整写出的帧数
+        quint64 droppedBytes = 0;
+        quint64 sendErrorCount = 0;
+        int pendingSendBytes = 0;
+        qint64 lastActivityMs = 0;      // 最近一次收到数据的时间（单调时钟，毫秒）
+        int threadIndex = -1;
+    };
+
+    explicit IoReactor(int threadCount = 1, QObject* parent = nullptr);
+    ~IoReactor() override;
+
+    /**
+     * @brief 启动反应器线程
+     * @return 成功返回true
+     */
+    bool start();
+
+    /**
+     * @brief 停止反应器线程并关闭所有设备
+     */
+    void stop();
+
+    bool isRunning() const { return running_.load(std::memory_order_acquire); }
+
+    int threadCount() const { return threadCount_; }
+
+    /**
+     * @brief 打开串口设备并加入反应器
+     * @param portName 串口设备路径，如/dev/ttyUSB0
+     * @param baudRate 波特率
+     * @param handler 帧处理回调，为空时通过packetReceived信号投递
+     * @return 设备ID，失败返回-1
+     */
+    int addSerialDevice(const QString& portName, int baudRate, PacketHandler handler = nullptr);
+
+    /**
+     * @brief 接管已打开的文件描述符（socket、pty等）
+     * @param fd 文件描述符，反应器获得所有权
+     * @param name 设备名称
+     * @param handler 帧处理回调，为空时通过packetReceived信号投递
+     * @return 设备ID，失败返回-1
+     */
+    int adoptDevice(int fd, const QString& name, PacketHandler handler = nullptr);
+
+    /**
+     * @brief 移除并关闭设备
+     *
+     * 返回时设备不再产生新事件，但正在执行的回调可能仍会完成。
+     * 因对端断开或读写错误已关闭（发出deviceClosed）的设备已自动移除。
+     * @param deviceId 设备ID
+     * @return 设备存在返回true
+     */
+    bool removeDevice(int deviceId);
+
+    /**
+     * @brief 发送数据帧（线程安全）
+     * @param deviceId 设备ID
+     * @param payload 帧数据，自动封装帧头尾
+     * @return 成功写入或入队返回true
+     */
+    bool sendPacket(int deviceId, const QByteArray& payload);
+
+    /**
+     * @brief 获取设备统计信息
+     */
+    DeviceStats deviceStats(int deviceId) const;
+
+    /**
+     * @brief 获取所有设备ID
+     */
+    QList<int> deviceIds() const;
+
+    int deviceCount() const;
+
+    /**
+     * @brief 设置单台设备的发送队列上限（字节）
+     */
+    void setMaxPendingBytes(int bytes) { maxPendingBytes_ = bytes; }
+    int maxPendingBytes() const { return maxPendingBytes_; }
+
+signals:
+    /**
+     * @brief 接收到完整帧（设备未设置处理回调时发射）
+     */
+    void packetReceived(int deviceId, const QByteArray& payload);
+
+    /**
+     * @brief 设备错误
+     */
+    void deviceError(int deviceId, const QString& error);
+
+    /**
+     * @brief 设备已关闭（对端断开或读写错误），发射时设备已从反应器移除
+     */
+    void deviceClosed(int deviceId);
+
+private:
+    struct Device;
+    struct Worker;
+
+    /**
+     * @brief 私有方法
+     */
+    int registerDevice(int fd, const QString& name, PacketHandler handler);
+    bool unregisterDevice(const std::shared_ptr<Device>& device);
+    std::shared_ptr<Device> findDevice(int deviceId) const;
+    Worker* selectWorker();
+    void workerLoop(Worker* worker);
+    void handleReadable(Worker* worker, const std::shared_ptr<Device>& device);
+    void handleWritable(const std::shared_ptr<Device>& device);
+    bool flushDevice(Device* device);
+    void closeDevice(const std::shared_ptr<Device>& device, const QString& reason);
+
+    /**
+     * @brief 成员变量
+     */
+    int threadCount_;
+    std::atomic<bool> running_;
+    std::vector<std::unique_ptr<Worker>> workers_;      // 运行期间只在devicesLock_下读取，stop()持写锁清空
+
+    mutable QReadWriteLock devicesLock_;
+    QHash<int, std::shared_ptr<Device>> devices_;
+    std::atomic<int> nextDeviceId_;
+    int maxPendingBytes_;
+
+    // 常量
+    static const int MAX_EVENTS_PER_WAIT;
+    static const int READ_BUFFER_SIZE;
+    static const int DEFAULT_MAX_PENDING_BYTES;
+};
+
+} // namespace Protocol
+
+#endif // IO_REACTOR_H
@@ -0,0 +1,511 @@
+#include "outbound_scheduler.h"
+#include "connection_manager.h"
+#include "frame_codec.h"
+#include "protocol/serialization/protocol_packager.h"
+#include <QDebug>
+#include <QMetaObject>
+#include <QThread>
+#include <cmath>
+
+namespace Protocol {
+
+// 常量定义
+const int OutboundScheduler::DEFAULT_LANE_CAPACITY = 1024;
+
+// ---------------------------------------------------------------------------
+// MpscQueue
+
+OutboundScheduler::MpscQueue::MpscQueue()
+    : head_(&stub_)
+    , tail_(&stub_)
+{
+}
+
+OutboundScheduler::MpscQueue::~MpscQueue()
+{
+    while (Node* node = pop()) {
+        delete node;
+    }
+}
+
+void OutboundScheduler::MpscQueue::push(Node* node)
+{
+    node->next.store(nullptr, std::memory_order_relaxed);
+    Node* previous = head_.exchange(node, std::memory_order_acq_rel);
+    previous->next.store(node, std::memory_order_release);
+}
+
+OutboundScheduler::Node* OutboundScheduler::MpscQueue::pop()
+{
+    Node* tail = tail_;
+    Node* next = tail->next.load(std::memory_order_acquire);
+
+    if (tail == &stub_) {
+        if (!next) {
+            return nullptr;
+        }
+        tail_ = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+
+    if (next) {
+        tail_ = next;
+        return tail;
+    }
+
+    // 生产者已交换head但尚未链接next，稍后再取
+    if (tail != head_.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+
+    push(&stub_);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next) {
+        tail_ = next;
+        return tail;
+    }
+    return nullptr;
+}
+
+// ---------------------------------------------------------------------------
+// TokenBucket
+
+void OutboundScheduler::TokenBucket::refill(double seconds)
+{
+    if (unlimited()) {
+        return;
+    }
+    tokens = qMin(burst, tokens + rate * seconds);
+}
+
+void OutboundScheduler::TokenBucket::consume(int bytes)
+{
+    if (!unlimited()) {
+        tokens -= bytes;
+    }
+}
+
+qint64 OutboundScheduler::TokenBucket::waitNs(int bytes) const
+{
+    if (unlimited() || tokens >= bytes) {
+        return 0;
+    }
+    return static_cast<qint64>(std::ceil((bytes - tokens) / rate * 1e9));
+}
+
+void OutboundScheduler::TokenBucket::configure(int bytesPerSec, int burstBytes)
+{
+    rate = qMax(0, bytesPerSec);
+    if (unlimited()) {
+        burst = 0.0;
+        tokens = 0.0;
+        return;
+    }
+
+    // 默认容量为100ms的流量，且至少能容纳一个最大帧
+    const int maxFrame = FrameCodec::MAX_PAYLOAD_SIZE + FrameCodec::FRAME_OVERHEAD;
+    int capacity = burstBytes > 0 ? burstBytes : bytesPerSec / 10;
+    burst = qMax(capacity, maxFrame);
+    tokens = burst;
+}
+
+// ---------------------------------------------------------------------------
+// OutboundScheduler
+
+OutboundScheduler::OutboundScheduler(ConnectionManager* connectionManager, QObject* parent)
+    : QObject(parent)
+    , connectionManager_(connectionManager)
+    , policy_(Policy::Strict)
+    , pacingTimer_(new QTimer(this))
+    , lastRefillNs_(0)
+    , drainScheduled_(false)
+    , dispatching_(false)
+    , batchingEnabled_(false)
+{
+    for (LaneState& lane : lanes_) {
+        lane.capacity.store(DEFAULT_LANE_CAPACITY, std::memory_order_relaxed);
+    }
+
+    // 默认通道映射：开关/模式类为控制，周期状态为流式，其余为批量
+    laneMap_.insert(MessageType::ANC_SWITCH, Lane::Control);
+    laneMap_.insert(MessageType::CHECK_MOD, Lane::Control);
+    laneMap_.insert(MessageType::CHANNEL_SWITCH, Lane::Control);
+    laneMap_.insert(MessageType::TRAN_FUNC_FLAG, Lane::Control);
+    laneMap_.insert(MessageType::ORDER_FLAG, Lane::Control);
+    laneMap_.insert(MessageType::VEHICLE_STATE, Lane::Streaming);
+    laneMap_.insert(MessageType::CHANNEL_AMPLITUDE, Lane::Streaming);
+    laneMap_.insert(MessageType::GRAPH_DATA, Lane::Streaming);
+
+    pacingTimer_->setSingleShot(true);
+    pacingTimer_->setTimerType(Qt::PreciseTimer);
+    connect(pacingTimer_, &QTimer::timeout, this, &OutboundScheduler::drain);
+
+    // 发送窗口腾出位置后继续调度可靠通道
+    // （调度过程中发出的确认由dispatch循环自己处理）
+    if (connectionManager_) {
+        auto resume = [this]() {
+            if (!dispatching_) {
+                scheduleDrain();
+            }
+        };
+        connect(connectionManager_, &ConnectionManager::frameAcknowledged, this, resume);
+        connect(connectionManager_, &ConnectionManager::frameFailed, this, resume);
+    }
+
+    clock_.start();
+}
+
+OutboundScheduler::~OutboundScheduler()
+{
+    clear();
+}
+
+bool OutboundScheduler::enqueue(Lane lane, const QByteArray& data)
+{
+    if (data.isEmpty()) {
+        return false;
+    }
+
+    LaneState& state = lanes_[index(lane)];
+    if (state.count.fetch_add(1, std::memory_order_acq_rel) >= state.capacity.load(std::memory_order_relaxed)) {
+        state.count.fetch_sub(1, std::memory_order_acq_rel);
+        state.overflowed.fetch_add(1, std::memory_order_relaxed);
+        qWarning() << "Outbound lane" << index(lane) << "full, frame dropped";
+        emit laneOverflow(lane);
+        return false;
+    }
+
+    Node* node = new Node;
+    node->data = data;
+    node->enqueuedNs = clock_.nsecsElapsed();
+    state.incoming.push(node);
+
+    scheduleDrain();
+    return true;
+}
+
+bool OutboundScheduler::enqueue(MessageType messageType, const QByteArray& data)
+{
+    return enqueue(laneForMessageType(messageType), data);
+}
+
+void OutboundScheduler::setBatchingEnabled(bool enabled)
+{
+    if (batchingEnabled_ == enabled) {
+        return;
+    }
+
+    batchingEnabled_ = enabled;
+    qInfo() << "Outbound batching" << (enabled ? "enabled" : "disabled");
+}
+
+void OutboundScheduler::setPolicy(Policy policy)
+{
+    policy_ = policy;
+    scheduleDrain();
+}
+
+void OutboundScheduler::setLaneWeight(Lane lane, int weight)
+{
+    if (weight <= 0) {
+        qWarning() << "Invalid lane weight:" << weight;
+        return;
+    }
+    lanes_[index(lane)].weight = weight;
+}
+
+void OutboundScheduler::setLaneRate(Lane lane, int bytesPerSec, int burstBytes)
+{
+    lanes_[index(lane)].bucket.configure(bytesPerSec, burstBytes);
+    scheduleDrain();
+}
+
+void OutboundScheduler::setLinkRate(int bytesPerSec, int burstBytes)
+{
+    linkBucket_.configure(bytesPerSec, burstBytes);
+    scheduleDrain();
+}
+
+void OutboundScheduler::configureForBaudRate(int baudRate)
+{
+    if (baudRate <= 0) {
+        qWarning() << "Invalid baud rate:" << baudRate;
+        return;
+    }
+
+    // 8N1每字节10位；链路桶只留一个最大帧的突发，保持驱动缓冲区浅
+    const int linkRate = baudRate / 10;
+    const int maxFrame = FrameCodec::MAX_PAYLOAD_SIZE + FrameCodec::FRAME_OVERHEAD;
+    setLinkRate(linkRate, maxFrame);
+    setLaneRate(Lane::Control, 0);
+    setLaneRate(Lane::Streaming, linkRate / 2);
+    setLaneRate(Lane::Bulk, linkRate * 7 / 10);
+
+    qInfo() << "Outbound scheduler configured for" << baudRate << "baud, link rate:" << linkRate << "bytes/s";
+}
+
+void OutboundScheduler::setLaneCapacity(Lane lane, int frames)
+{
+    if (frames <= 0) {
+        qWarning() << "Invalid lane capacity:" << frames;
+        return;
+    }
+    lanes_[index(lane)].capacity.store(frames, std::memory_order_relaxed);
+}
+
+void OutboundScheduler::setLaneForMessageType(MessageType messageType, Lane lane)
+{
+    laneMap_.insert(messageType, lane);
+}
+
+OutboundScheduler::Lane OutboundScheduler::laneForMessageType(MessageType messageType) const
+{
+    return laneMap_.value(messageType, Lane::Bulk);
+}
+
+void OutboundScheduler::clear()
+{
+    pacingTimer_->stop();
+
+    for (LaneState& lane : lanes_) {
+        int dropped = 0;
+        while (Node* node = lane.incoming.pop()) {
+            delete node;
+            ++dropped;
+        }
+        while (!lane.ready.isEmpty()) {
+            delete lane.ready.dequeue();
+            ++dropped;
+        }
+        lane.count.fetch_sub(dropped, std::memory_order_acq_rel);
+        lane.stats.framesDropped.fetch_add(static_cast<quint64>(dropped), std::memory_order_relaxed);
+    }
+}
+
+int OutboundScheduler::queuedFrames(Lane lane) const
+{
+    return lanes_[index(lane)].count.load(std::memory_order_acquire);
+}
+
+OutboundScheduler::LaneStats OutboundScheduler::laneStats(Lane lane) const
+{
+    const LaneState& state = lanes_[index(lane)];
+    LaneStats stats;
+    stats.framesSent = state.stats.framesSent.load(std::memory_order_relaxed);
+    stats.bytesSent = state.stats.bytesSent.load(std::memory_order_relaxed);
+    stats.framesDropped = state.stats.framesDropped.load(std::memory_order_relaxed)
+                          + state.overflowed.load(std::memory_order_relaxed);
+    stats.messagesBatched = state.stats.messagesBatched.load(std::memory_order_relaxed);
+    stats.queuedFrames = state.count.load(std::memory_order_acquire);
+    stats.lastQueueDelayUs = state.stats.lastQueueDelayUs.load(std::memory_order_relaxed);
+    stats.maxQueueDelayUs = state.stats.maxQueueDelayUs.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void OutboundScheduler::resetStats()
+{
+    for (LaneState& lane : lanes_) {
+        lane.stats.framesSent.store(0, std::memory_order_relaxed);
+        lane.stats.bytesSent.store(0, std::memory_order_relaxed);
+        lane.stats.framesDropped.store(0, std::memory_order_relaxed);
+        lane.stats.messagesBatched.store(0, std::memory_order_relaxed);
+        lane.stats.lastQueueDelayUs.store(0, std::memory_order_relaxed);
+        lane.stats.maxQueueDelayUs.store(0, std::memory_order_relaxed);
+        lane.overflowed.store(0, std::memory_order_relaxed);
+    }
+}
+
+void OutboundScheduler::drain()
+{
+    drainScheduled_.store(false, std::memory_order_release);
+
+    // 找出当前积压通道中最小的虚拟时间，新变为积压的通道从这里起步，不能积攒空闲期的额度
+    double minVirtualTime = -1.0;
+    for (const LaneState& lane : lanes_) {
+        if (!lane.ready.isEmpty() && (minVirtualTime < 0.0 || lane.virtualTime < minVirtualTime)) {
+            minVirtualTime = lane.virtualTime;
+        }
+    }
+
+    for (LaneState& lane : lanes_) {
+        bool wasIdle = lane.ready.isEmpty();
+        while (Node* node = lane.incoming.pop()) {
+            lane.ready.enqueue(node);
+        }
+        if (wasIdle && !lane.ready.isEmpty() && minVirtualTime > lane.virtualTime) {
+            lane.virtualTime = minVirtualTime;
+        }
+    }
+
+    dispatch();
+}
+
+void OutboundScheduler::scheduleDrain()
+{
+    if (drainScheduled_.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    // 调度器线程上直接处理，其他线程投递到调度器线程
+    if (QThread::currentThread() == thread() && !dispatching_) {
+        drain();
+    } else {
+        QMetaObject::invokeMethod(this, "drain", Qt::QueuedConnection);
+    }
+}
+
+int OutboundScheduler::frameSize(const Node* node)
+{
+    return node->data.size() + FrameCodec::FRAME_OVERHEAD;
+}
+
+void OutboundScheduler::refillBuckets()
+{
+    const qint64 now = clock_.nsecsElapsed();
+    const double seconds = static_cast<double>(now - lastRefillNs_) / 1e9;
+    lastRefillNs_ = now;
+
+    linkBucket_.refill(seconds);
+    for (LaneState& lane : lanes_) {
+        lane.bucket.refill(seconds);
+    }
+}
+
+bool OutboundScheduler::windowOpen() const
+{
+    // 帧留在通道中排队，而不是堆进ConnectionManager的发送队列，优先级和限速才有意义
+    return connectionManager_->pendingReliableCount() == 0
+           && connectionManager_->inFlightCount() < connectionManager_->windowSize();
+}
+
+int OutboundScheduler::pickLane() const
+{
+    int chosen = -1;
+    const bool reliableAllowed = windowOpen();
+
+    for (int i = 0; i < LANE_COUNT; ++i) {
+        const LaneState& lane = lanes_[i];
+        if (lane.ready.isEmpty() || !lane.bucket.allows(frameSize(lane.ready.head()))
+            || (isReliable(static_cast<Lane>(i)) && !reliableAllowed)) {
+            continue;
+        }
+
+        if (policy_ == Policy::Strict) {
+            chosen = i;
+            break;
+        }
+
+        if (chosen < 0 || lane.virtualTime < lanes_[chosen].virtualTime) {
+            chosen = i;
+        }
+    }
+
+    // 链路令牌不足时整体等待，低优先级通道也不能插队
+    if (chosen >= 0 && !linkBucket_.allows(frameSize(lanes_[chosen].ready.head()))) {
+        return -1;
+    }
+    return chosen;
+}
+
+int OutboundScheduler::collectBatch(LaneState& lane, QByteArray& data)
+{
+    if (lane.ready.isEmpty()) {
+        return 0;
+    }
+
+    // 从已出队的第一条开始，依次并入后续消息，直到超过帧长或令牌不足
+    QList<QByteArray> envelopes;
+    envelopes.append(data);
+    int payloadSize = ProtocolPackager::BATCH_HEADER_SIZE + ProtocolPackager::batchEntrySize(data.size());
+
+    while (!lane.ready.isEmpty()) {
+        const Node* next = lane.ready.head();
+        const int batchSize = payloadSize + ProtocolPackager::batchEntrySize(next->data.size());
+        const int wireSize = batchSize + FrameCodec::FRAME_OVERHEAD;
+        if (batchSize > FrameCodec::MAX_PAYLOAD_SIZE || !lane.bucket.allows(wireSize)
+            || !linkBucket_.allows(wireSize)) {
+            break;
+        }
+
+        envelopes.append(next->data);
+        payloadSize = batchSize;
+        delete lane.ready.dequeue();
+        lane.count.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    if (envelopes.size() == 1) {
+        return 0;
+    }
+
+    data = ProtocolPackager::packageBatch(envelopes);
+    return envelopes.size() - 1;
+}
+
+void OutboundScheduler::dispatch()
+{
+    if (dispatching_ || !connectionManager_) {
+        return;
+    }
+    dispatching_ = true;
+    pacingTimer_->stop();
+
+    refillBuckets();
+
+    for (int i = pickLane(); i >= 0; i = pickLane()) {
+        LaneState& lane = lanes_[i];
+        const bool reliable = isReliable(static_cast<Lane>(i));
+        Node* node = lane.ready.dequeue();
+        QByteArray data = node->data;
+        const int messages = batchingEnabled_ && !reliable ? collectBatch(lane, data) + 1 : 1;
+        const int size = data.size() + FrameCodec::FRAME_OVERHEAD;
+
+        lane.bucket.consume(size);
+        linkBucket_.consume(size);
+        lane.virtualTime += static_cast<double>(size) / lane.weight;
+
+        const qint64 delayUs = (clock_.nsecsElapsed() - node->enqueuedNs) / 1000;
+        lane.stats.lastQueueDelayUs.store(delayUs, std::memory_order_relaxed);
+        if (delayUs > lane.stats.maxQueueDelayUs.load(std::memory_order_relaxed)) {
+            lane.stats.maxQueueDelayUs.store(delayUs, std::memory_order_relaxed);
+        }
+
+        const bool sent = reliable ? connectionManager_->sendReliable(data) != 0
+                                   : connectionManager_->sendData(data);
+        if (sent) {
+            lane.stats.framesSent.fetch_add(1, std::memory_order_relaxed);
+            lane.stats.bytesSent.fetch_add(static_cast<quint64>(size), std::memory_order_relaxed);
+            if (messages > 1) {
+                lane.stats.messagesBatched.fetch_add(static_cast<quint64>(messages), std::memory_order_relaxed);
+            }
+        } else {
+            lane.stats.framesDropped.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        lane.count.fetch_sub(1, std::memory_order_acq_rel);
+        delete node;
+    }
+
+    // 仍有积压：等到最早可发送的时刻；等待发送窗口的通道由确认信号唤醒
+    const bool reliableAllowed = windowOpen();
+    qint64 waitNs = -1;
+    for (int i = 0; i < LANE_COUNT; ++i) {
+        const LaneState& lane = lanes_[i];
+        if (lane.ready.isEmpty() || (isReliable(static_cast<Lane>(i)) && !reliableAllowed)) {
+            continue;
+        }
+        int size = frameSize(lane.ready.head());
+        qint64 laneWait = qMax(lane.bucket.waitNs(size), linkBucket_.waitNs(size));
+        if (waitNs < 0 || laneWait < waitNs) {
+            waitNs = laneWait;
+        }
+    }
+
+    if (waitNs >= 0) {
+        pacingTimer_->start(static_cast<int>(qMax<qint64>(1, (waitNs + 999999) / 1000000)));
+    }
+
+    dispatching_ = false;
+}
+
+} // namespace Protocol
@@ -0,0 +1,242 @@
+#ifndef OUTBOUND_SCHEDULER_H
+#define OUTBOUND_SCHEDULER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QQueue>
+#include <QTimer>
+#include <atomic>
+#include "protocol/core/message_types.h"
+
+namespace Protocol {
+
+class ConnectionManager;
+
+/**
+ * @brief 多通道优先级发送调度器
+ *
+ * 位于ConnectionManager之前，把发送流量分到控制、流式和批量三个通道：
+ * - 严格优先级或按权重分享链路，控制帧不会排在批量标定数据之后
+ * - 每个通道可设令牌桶限速，另有一个按波特率设定的链路令牌桶，
+ *   保证写入传输层的数据不超过链路实际排空速度，避免在驱动缓冲区中堆积
+ * - 入队为无锁多生产者单消费者队列，任意线程均可调用enqueue
+ * - 控制和批量通道经ConnectionManager::sendReliable()进入发送窗口，按帧确认和重传；
+ *   窗口已满时留在通道中排队，确认到达后继续调度。流式通道的周期状态直接sendData()发送
+ * - 启用批量发送后，流式通道中已排队的多条消息合并为一个批量帧（不超过单帧长度上限），
+ *   分摊帧头尾开销；只合并已在排队的消息，不为凑批而等待。可靠通道逐帧确认，不合并
+ *
+ * 调度器必须与ConnectionManager位于同一线程。
+ */
+class OutboundScheduler : public QObject {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 发送通道
+     */
+    enum class Lane {
+        Control = 0,        // 控制命令（开关、模式切换），延迟敏感
+        Streaming = 1,      // 周期性状态（车辆状态、通道幅值）
+        Bulk = 2            // 批量标定数据（阶次参数、阈值等）
+    };
+    static constexpr int LANE_COUNT = 3;
+
+    /**
+     * @brief 通道是否经发送窗口可靠发送（流式通道的周期状态下一周期即被覆盖，不重传）
+     */
+    static bool isReliable(Lane lane) { return lane != Lane::Streaming; }
+
+    /**
+     * @brief 通道调度策略
+     */
+    enum class Policy {
+        Strict,             // 严格优先级：控制 > 流式 > 批量
+        Weighted            // 按权重分享链路带宽
+    };
+
+    /**
+     * @brief 通道统计信息（快照）
+     */
+    struct LaneStats {
+        quint64 framesSent = 0;
+        quint64 bytesSent = 0;
+        quint64 framesDropped = 0;      // 队列满或发送失败丢弃的帧
+        quint64 messagesBatched = 0;    // 合并进批量帧发送的消息数
+        int queuedFrames = 0;
+        qint64 lastQueueDelayUs = 0;    // 最近一帧的排队时间（微秒）
+        qint64 maxQueueDelayUs = 0;     // 最大排队时间（微秒）
+    };
+
+    explicit OutboundScheduler(ConnectionManager* connectionManager, QObject* parent = nullptr);
+    ~OutboundScheduler() override;
+
+    /**
+     * @brief 入队待发送数据（线程安全）
+     * @param lane 发送通道
+     * @param data 未封帧的数据
+     * @return 入队成功返回true，队列已满返回false
+     */
+    bool enqueue(Lane lane, const QByteArray& data);
+
+    /**
+     * @brief 按消息类型选择通道入队（线程安全）
+     */
+    bool enqueue(MessageType messageType, const QByteArray& data);
+
+    /**
+     * @brief 调度配置接口（须在调度器所在线程调用）
+     */
+
+    void setPolicy(Policy policy);
+    Policy policy() const { return policy_; }
+
+    // Weighted策略下的通道权重
+    void setLaneWeight(Lane lane, int weight);
+    int laneWeight(Lane lane) const { return lanes_[index(lane)].weight; }
+
+    // 通道限速（字节/秒，0表示不限速）与突发容量（字节）
+    void setLaneRate(Lane lane, int bytesPerSec, int burstBytes = 0);
+
+    // 链路总速率（字节/秒，0表示不限速）
+    void setLinkRate(int bytesPerSec, int burstBytes = 0);
+
+    /**
+     * @brief 按串口波特率配置链路和通道速率
+     *
+     * 链路速率为 baud/10 字节每秒（8N1）；流式通道最多占用一半，批量通道最多占用七成，
+     * 控制通道只受链路速率限制。
+     */
+    void configureForBaudRate(int baudRate);
+
+    // 通道队列容量（帧数）
+    void setLaneCapacity(Lane lane, int frames);
+
+    /**
+     * @brief 批量发送
+     *
+     * 只能在对端支持批量帧（ProtocolPackager::CAPABILITY_BATCH）时启用，默认关闭。
+     * 只作用于不经发送窗口的通道。
+     */
+    void setBatchingEnabled(bool enabled);
+    bool isBatchingEnabled() const { return batchingEnabled_; }
+
+    // 消息类型到通道的映射（未设置时使用默认映射）
+    void setLaneForMessageType(MessageType messageType, Lane lane);
+    Lane laneForMessageType(MessageType messageType) const;
+
+    /**
+     * @brief 丢弃所有排队的数据
+     */
+    void clear();
+
+    int queuedFrames(Lane lane) const;
+    LaneStats laneStats(Lane lane) const;
+    void resetStats();
+
+signals:
+    /**
+     * @brief 通道队列已满，数据被丢弃
+     */
+    void laneOverflow(Lane lane);
+
+private slots:
+    /**
+     * @brief 取出各通道入队的数据并调度发送
+     */
+    void drain();
+
+private:
+    /**
+     * @brief 无锁多生产者单消费者队列（Vyukov侵入式队列）
+     */
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        QByteArray data;
+        qint64 enqueuedNs = 0;
+    };
+
+    class MpscQueue {
+    public:
+        MpscQueue();
+        ~MpscQueue();
+        void push(Node* node);          // 任意线程
+        Node* pop();                    // 仅消费者线程，返回的节点由调用方释放
+
+    private:
+        std::atomic<Node*> head_;
+        Node* tail_;
+        Node stub_;
+    };
+
+    /**
+     * @brief 令牌桶
+     */
+    struct TokenBucket {
+        double rate = 0.0;              // 字节/秒，0表示不限速
+        double burst = 0.0;             // 桶容量（字节）
+        double tokens = 0.0;
+
+        bool unlimited() const { return rate <= 0.0; }
+        void refill(double seconds);
+        bool allows(int bytes) const { return unlimited() || tokens >= bytes; }
+        void consume(int bytes);
+        qint64 waitNs(int bytes) const;
+        void configure(int bytesPerSec, int burstBytes);
+    };
+
+    /**
+     * @brief 通道计数器（调度线程写入，laneStats()可在任意线程读取）
+     */
+    struct LaneCounters {
+        std::atomic<quint64> framesSent{0};
+        std::atomic<quint64> bytesSent{0};
+        std::atomic<quint64> framesDropped{0};
+        std::atomic<quint64> messagesBatched{0};
+        std::atomic<qint64> lastQueueDelayUs{0};
+        std::atomic<qint64> maxQueueDelayUs{0};
+    };
+
+    struct LaneState {
+        MpscQueue incoming;                     // 生产者入队
+        QQueue<Node*> ready;                    // 消费者线程本地队列
+        std::atomic<int> count{0};              // incoming + ready中的帧数
+        std::atomic<quint64> overflowed{0};     // 队列满被拒绝的帧数（生产者线程计数）
+        std::atomic<int> capacity{0};
+        int weight = 1;
+        double virtualTime = 0.0;               // Weighted策略的虚拟完成时间
+        TokenBucket bucket;
+        LaneCounters stats;
+    };
+
+    static int index(Lane lane) { return static_cast<int>(lane); }
+    static int frameSize(const Node* node);
+
+    void scheduleDrain();
+    void refillBuckets();
+    bool windowOpen() const;
+    int pickLane() const;
+    int collectBatch(LaneState& lane, QByteArray& data);
+    void dispatch();
+
+    ConnectionManager* connectionManager_;
+    LaneState lanes_[LANE_COUNT];
+    TokenBucket linkBucket_;
+    Policy policy_;
+    QHash<MessageType, Lane> laneMap_;
+
+    QTimer* pacingTimer_;                       // 令牌不足时等待补充
+    QElapsedTimer clock_;
+    qint64 lastRefillNs_;
+    std::atomic<bool> drainScheduled_;
+    bool dispatching_;
+    bool batchingEnabled_;
+
+    // 常量
+    static const int DEFAULT_LANE_CAPACITY;
+};
+
+} // namespace Protocol
+
+#endif // OUTBOUND_SCHEDULER_H
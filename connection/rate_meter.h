@@ -0,0 +1,75 @@
+#ifndef RATE_METER_H
+#define RATE_METER_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <cmath>
+
+namespace Protocol {
+
+/**
+ * @brief 指数加权滑动平均（EWMA）速率计
+ *
+ * 由单个采样线程按任意间隔喂入累计计数，计算每秒速率；
+ * 非均匀采样间隔按 alpha = 1 - exp(-dt/tau) 折算，读取可在任意线程进行。
+ */
+class RateMeter {
+public:
+    /**
+     * @brief 构造函数
+     * @param timeConstantSec 平滑时间常数（秒），越大越平滑
+     */
+    explicit RateMeter(double timeConstantSec = 5.0)
+        : timeConstantSec_(timeConstantSec > 0.0 ? timeConstantSec : 5.0)
+    {
+    }
+
+    /**
+     * @brief 用累计计数更新速率
+     * @param total 当前累计计数
+     * @param nowNs 单调时钟（纳秒）
+     */
+    void update(quint64 total, qint64 nowNs)
+    {
+        if (lastNs_ < 0 || total < lastTotal_) {
+            // 首次采样或计数被重置
+            lastTotal_ = total;
+            lastNs_ = nowNs;
+            return;
+        }
+
+        qint64 elapsedNs = nowNs - lastNs_;
+        if (elapsedNs <= 0) {
+            return;
+        }
+
+        double dt = static_cast<double>(elapsedNs) / 1e9;
+        double instant = static_cast<double>(total - lastTotal_) / dt;
+        double alpha = 1.0 - std::exp(-dt / timeConstantSec_);
+        double current = rate_.load(std::memory_order_relaxed);
+        rate_.store(current + alpha * (instant - current), std::memory_order_relaxed);
+
+        lastTotal_ = total;
+        lastNs_ = nowNs;
+    }
+
+    /**
+     * @brief 当前速率（每秒）
+     */
+    double rate() const { return rate_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 清零速率（可在任意线程调用，累计计数归零后采样基准自动重建）
+     */
+    void reset() { rate_.store(0.0, std::memory_order_relaxed); }
+
+private:
+    double timeConstantSec_;
+    quint64 lastTotal_ = 0;
+    qint64 lastNs_ = -1;
+    std::atomic<double> rate_{0.0};
+};
+
+} // namespace Protocol
+
+#endif // RATE_METER_H
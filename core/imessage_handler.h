@@ -21,7 +21,7 @@ public:
     /**
      * @brief 序列化参数到字节数组
      * @param parameters 参数映射
-     * @return 序列化后的字节数组，失败返回空数组
+     * @return 序列化后的字节数组，全部字段为默认值时为空（非null）数组，失败返回null数组（QByteArray()）
      */
     virtual QByteArray serialize(const QVariantMap& parameters) = 0;
 
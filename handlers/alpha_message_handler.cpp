@@ -1,4 +1,5 @@
 #include "alpha_message_handler.h"
+#include "../serialization/message_codec.h"
 #include <QDebug>
 
 namespace Protocol {
@@ -30,34 +31,21 @@ QByteArray AlphaMessageHandler::serialize(const QVariantMap& parameters) {
     }
 
     // 序列化消息
-    uint8_t buffer[MAX_BUFFER_SIZE];
-    pb_ostream_t stream = pb_ostream_from_buffer(buffer, sizeof(buffer));
-
-    if (!pb_encode(&stream, MSG_AlphaParams_fields, &msg)) {
-        qWarning() << "Failed to encode Alpha message:" << PB_GET_ERROR(&stream);
+    QByteArray result;
+    if (!MessageCodec::encode(msg, result)) {
+        qWarning() << "Failed to encode Alpha message";
         return QByteArray();
     }
 
-    QByteArray result(reinterpret_cast<char*>(buffer), stream.bytes_written);
     qDebug() << "Alpha message serialized:" << result.size() << "bytes, alpha:" << alphaValue;
 
     return result;
 }
 
 bool AlphaMessageHandler::deserialize(const QByteArray& data, QVariantMap& parameters) {
-    if (data.isEmpty()) {
-        qWarning() << "Empty data for Alpha message deserialization";
-        return false;
-    }
-
     MSG_AlphaParams msg = MSG_AlphaParams_init_zero;
-    pb_istream_t stream = pb_istream_from_buffer(
-        reinterpret_cast<const uint8_t*>(data.constData()),
-        data.size()
-    );
-
-    if (!pb_decode(&stream, MSG_AlphaParams_fields, &msg)) {
-        qWarning() << "Failed to decode Alpha message:" << PB_GET_ERROR(&stream);
+    if (!MessageCodec::decode(data, msg)) {
+        qWarning() << "Failed to decode Alpha message";
         return false;
     }
 
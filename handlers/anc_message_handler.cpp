@@ -1,4 +1,5 @@
 #include "anc_message_handler.h"
+#include "../serialization/message_codec.h"
 #include <QDebug>
 
 namespace Protocol {
@@ -58,21 +59,14 @@ QByteArray AncMessageHandler::serialize(const QVariantMap& parameters) {
     }
 
     // 序列化消息
-    uint8_t buffer[MAX_BUFFER_SIZE];
-    pb_ostream_t stream = pb_ostream_from_buffer(buffer, sizeof(buffer));
-    qDebug() << "Protobuf stream initialized, buffer size:" << MAX_BUFFER_SIZE;
-
     qDebug() << "Starting protobuf encoding...";
-    if (!pb_encode(&stream, MSG_AncSwitch_fields, &msg)) {
-        qWarning() << "Failed to encode ANC message:" << PB_GET_ERROR(&stream);
-        qDebug() << "Stream bytes written before failure:" << stream.bytes_written;
+    QByteArray result;
+    if (!MessageCodec::encode(msg, result)) {
+        qWarning() << "Failed to encode ANC message";
         qDebug() << "=== AncMessageHandler::serialize END (encoding failed) ===";
         return QByteArray();
     }
-    qDebug() << "Protobuf encoding successful, bytes written:" << stream.bytes_written;
-
-    QByteArray result(reinterpret_cast<char*>(buffer), stream.bytes_written);
-    qDebug() << "Created QByteArray with size:" << result.size();
+    qDebug() << "Protobuf encoding successful, bytes written:" << result.size();
     qDebug() << "Result data (hex):" << result.toHex();
     qDebug() << "ANC message serialized:" << result.size() << "bytes, ANC state:"
              << (parameters.contains("anc.enabled") ?
@@ -89,19 +83,9 @@ QByteArray AncMessageHandler::serialize(const QVariantMap& parameters) {
 }
 
 bool AncMessageHandler::deserialize(const QByteArray& data, QVariantMap& parameters) {
-    if (data.isEmpty()) {
-        qWarning() << "Empty data for ANC message deserialization";
-        return false;
-    }
-
     MSG_AncSwitch msg = MSG_AncSwitch_init_zero;
-    pb_istream_t stream = pb_istream_from_buffer(
-        reinterpret_cast<const uint8_t*>(data.constData()),
-        data.size()
-    );
-
-    if (!pb_decode(&stream, MSG_AncSwitch_fields, &msg)) {
-        qWarning() << "Failed to decode ANC message:" << PB_GET_ERROR(&stream);
+    if (!MessageCodec::decode(data, msg)) {
+        qWarning() << "Failed to decode ANC message";
         return false;
     }
 
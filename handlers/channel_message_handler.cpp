@@ -1,4 +1,5 @@
 #include "channel_message_handler.h"
+#include "../serialization/message_codec.h"
 #include <QLoggingCategory>
 #include <QVariantList>
 
@@ -137,19 +138,12 @@ QByteArray ChannelMessageHandler::serializeChannelNumber(const QVariantMap& para
     }
 
     // 序列化消息
-    uint8_t buffer[MAX_BUFFER_SIZE];
-    pb_ostream_t stream = pb_ostream_from_buffer(buffer, sizeof(buffer));
-
-    bool status = pb_encode(&stream, MSG_ChannelNumber_fields, &channelNumber);
-    if (!status) {
-        qCWarning(channelHandler) << "Failed to encode channel number message:"
-                                  << PB_GET_ERROR(&stream);
+    QByteArray result;
+    if (!MessageCodec::encode(channelNumber, result)) {
+        qCWarning(channelHandler) << "Failed to encode channel number message";
         return QByteArray();
     }
 
-    QByteArray result(reinterpret_cast<const char*>(buffer),
-                      static_cast<int>(stream.bytes_written));
-
     qCDebug(channelHandler) << "Serialized channel number message, size:" << result.size();
     return result;
 }
@@ -171,19 +165,12 @@ QByteArray ChannelMessageHandler::serializeChannelAmplitude(const QVariantMap& p
     }
 
     // 序列化消息
-    uint8_t buffer[MAX_BUFFER_SIZE];
-    pb_ostream_t stream = pb_ostream_from_buffer(buffer, sizeof(buffer));
-
-    bool status = pb_encode(&stream, MSG_ChannelAmplitude_fields, &channelAmplitude);
-    if (!status) {
-        qCWarning(channelHandler) << "Failed to encode channel amplitude message:"
-                                  << PB_GET_ERROR(&stream);
+    QByteArray result;
+    if (!MessageCodec::encode(channelAmplitude, result)) {
+        qCWarning(channelHandler) << "Failed to encode channel amplitude message";
         return QByteArray();
     }
 
-    QByteArray result(reinterpret_cast<const char*>(buffer),
-                      static_cast<int>(stream.bytes_written));
-
     qCDebug(channelHandler) << "Serialized channel amplitude message, size:" << result.size();
     return result;
 }
@@ -209,19 +196,12 @@ QByteArray ChannelMessageHandler::serializeChannelSwitch(const QVariantMap& para
     }
 
     // 序列化消息
-    uint8_t buffer[MAX_BUFFER_SIZE];
-    pb_ostream_t stream = pb_ostream_from_buffer(buffer, sizeof(buffer));
-
-    bool status = pb_encode(&stream, MSG_ChannelSwitch_fields, &channelSwitch);
-    if (!status) {
-        qCWarning(channelHandler) << "Failed to encode channel switch message:"
-                                  << PB_GET_ERROR(&stream);
+    QByteArray result;
+    if (!MessageCodec::encode(channelSwitch, result)) {
+        qCWarning(channelHandler) << "Failed to encode channel switch message";
         return QByteArray();
     }
 
-    QByteArray result(reinterpret_cast<const char*>(buffer),
-                      static_cast<int>(stream.bytes_written));
-
     qCDebug(channelHandler) << "Serialized channel switch message, size:" << result.size();
     return result;
 }
@@ -229,15 +209,8 @@ QByteArray ChannelMessageHandler::serializeChannelSwitch(const QVariantMap& para
 bool ChannelMessageHandler::deserializeChannelNumber(const QByteArray& data, QVariantMap& parameters)
 {
     MSG_ChannelNumber channelNumber = MSG_ChannelNumber_init_zero;
-    pb_istream_t stream = pb_istream_from_buffer(
-        reinterpret_cast<const uint8_t*>(data.constData()),
-        static_cast<size_t>(data.size())
-    );
-
-    bool status = pb_decode(&stream, MSG_ChannelNumber_fields, &channelNumber);
-    if (!status) {
-        qCWarning(channelHandler) << "Failed to decode channel number message:"
-                                  << PB_GET_ERROR(&stream);
+    if (!MessageCodec::decode(data, channelNumber)) {
+        qCWarning(channelHandler) << "Failed to decode channel number message";
         return false;
     }
 
@@ -252,15 +225,8 @@ bool ChannelMessageHandler::deserializeChannelNumber(const QByteArray& data, QVa
 bool ChannelMessageHandler::deserializeChannelAmplitude(const QByteArray& data, QVariantMap& parameters)
 {
     MSG_ChannelAmplitude channelAmplitude = MSG_ChannelAmplitude_init_zero;
-    pb_istream_t stream = pb_istream_from_buffer(
-        reinterpret_cast<const uint8_t*>(data.constData()),
-        static_cast<size_t>(data.size())
-    );
-
-    bool status = pb_decode(&stream, MSG_ChannelAmplitude_fields, &channelAmplitude);
-    if (!status) {
-        qCWarning(channelHandler) << "Failed to decode channel amplitude message:"
-                                  << PB_GET_ERROR(&stream);
+    if (!MessageCodec::decode(data, channelAmplitude)) {
+        qCWarning(channelHandler) << "Failed to decode channel amplitude message";
         return false;
     }
 
@@ -280,15 +246,8 @@ bool ChannelMessageHandler::deserializeChannelAmplitude(const QByteArray& data,
 bool ChannelMessageHandler::deserializeChannelSwitch(const QByteArray& data, QVariantMap& parameters)
 {
     MSG_ChannelSwitch channelSwitch = MSG_ChannelSwitch_init_zero;
-    pb_istream_t stream = pb_istream_from_buffer(
-        reinterpret_cast<const uint8_t*>(data.constData()),
-        static_cast<size_t>(data.size())
-    );
-
-    bool status = pb_decode(&stream, MSG_ChannelSwitch_fields, &channelSwitch);
-    if (!status) {
-        qCWarning(channelHandler) << "Failed to decode channel switch message:"
-                                  << PB_GET_ERROR(&stream);
+    if (!MessageCodec::decode(data, channelSwitch)) {
+        qCWarning(channelHandler) << "Failed to decode channel switch message";
         return false;
     }
 
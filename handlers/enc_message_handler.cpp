@@ -1,4 +1,5 @@
 #include "enc_message_handler.h"
+#include "../serialization/message_codec.h"
 #include <QDebug>
 
 namespace Protocol {
@@ -16,34 +17,21 @@ QByteArray EncMessageHandler::serialize(const QVariantMap& parameters) {
     msg.enc_off = !encEnabled; // 设置ENC_OFF字段（true=关闭，false=开启）
 
     // 序列化消息
-    uint8_t buffer[MAX_BUFFER_SIZE];
-    pb_ostream_t stream = pb_ostream_from_buffer(buffer, sizeof(buffer));
-
-    if (!pb_encode(&stream, MSG_AncSwitch_fields, &msg)) {
-        qWarning() << "Failed to encode ENC message:" << PB_GET_ERROR(&stream);
+    QByteArray result;
+    if (!MessageCodec::encode(msg, result)) {
+        qWarning() << "Failed to encode ENC message";
         return QByteArray();
     }
 
-    QByteArray result(reinterpret_cast<char*>(buffer), stream.bytes_written);
     qDebug() << "ENC message serialized:" << result.size() << "bytes, ENC enabled:" << encEnabled;
 
     return result;
 }
 
 bool EncMessageHandler::deserialize(const QByteArray& data, QVariantMap& parameters) {
-    if (data.isEmpty()) {
-        qWarning() << "Empty data for ENC message deserialization";
-        return false;
-    }
-
     MSG_AncSwitch msg = MSG_AncSwitch_init_zero;
-    pb_istream_t stream = pb_istream_from_buffer(
-        reinterpret_cast<const uint8_t*>(data.constData()),
-        data.size()
-    );
-
-    if (!pb_decode(&stream, MSG_AncSwitch_fields, &msg)) {
-        qWarning() << "Failed to decode ENC message:" << PB_GET_ERROR(&stream);
+    if (!MessageCodec::decode(data, msg)) {
+        qWarning() << "Failed to decode ENC message";
         return false;
     }
 
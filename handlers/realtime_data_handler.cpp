@@ -1,140 +1,249 @@
 #include "realtime_data_handler.h"
 #include "messages/ERNC_praram.pb.h"
 #include <QDebug>
-#include <QDataStream>
-#include <QBuffer>
+#include <QVariantList>
+#include <QtEndian>
+#include <cstring>
 
 namespace Protocol {
 
+namespace {
+
+// 线格式：[channel_count][sample_rate][data_format][条数]（各uint32）
+//        + 每通道[id(uint32)][amplitude(double)][frequency(double)] + [timestamp(uint64)]
+constexpr int HEADER_SIZE = 16;
+constexpr int CHANNEL_RECORD_SIZE = 20;
+constexpr int TIMESTAMP_SIZE = 8;
+
+// 与QDataStream一致：剩余字节不足时读出0并消费剩余数据
+template<typename T>
+T readLittleEndian(const uchar*& p, const uchar* end)
+{
+    if (end - p < static_cast<ptrdiff_t>(sizeof(T))) {
+        p = end;
+        return 0;
+    }
+    T value = qFromLittleEndian<T>(p);
+    p += sizeof(T);
+    return value;
+}
+
+// QDataStream默认按双精度传输float
+float readFloat(const uchar*& p, const uchar* end)
+{
+    quint64 bits = readLittleEndian<quint64>(p, end);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return static_cast<float>(value);
+}
+
+template<typename T>
+void writeLittleEndian(uchar*& p, T value)
+{
+    qToLittleEndian(value, p);
+    p += sizeof(T);
+}
+
+void writeFloat(uchar*& p, float value)
+{
+    double widened = value;
+    quint64 bits;
+    std::memcpy(&bits, &widened, sizeof(bits));
+    writeLittleEndian(p, bits);
+}
+
+} // namespace
+
 QByteArray RealtimeDataHandler::serialize(const QVariantMap& parameters) {
     if (!validateParameters(parameters)) {
         qWarning() << "RealtimeDataHandler: Invalid parameters for serialization";
         return QByteArray();
     }
 
-    QByteArray result;
-    QBuffer buffer(&result);
-    buffer.open(QIODevice::WriteOnly);
-    QDataStream stream(&buffer);
-    stream.setByteOrder(QDataStream::LittleEndian);
-
-    // 序列化实时数据参数
-    if (parameters.contains("channel_count")) {
-        int channelCount = parameters["channel_count"].toInt();
-        stream << static_cast<quint32>(channelCount);
+    RealtimeFrame frame;
+    if (!fromParameters(parameters, frame)) {
+        qWarning() << "RealtimeDataHandler: Invalid parameters for serialization";
+        return QByteArray();
     }
 
-    if (parameters.contains("sample_rate")) {
-        int sampleRate = parameters["sample_rate"].toInt();
-        stream << static_cast<quint32>(sampleRate);
+    return encode(frame);
+}
+
+bool RealtimeDataHandler::deserialize(const QByteArray& data, QVariantMap& parameters) {
+    RealtimeFrame frame;
+    if (!decode(data, frame)) {
+        return false;
     }
 
-    if (parameters.contains("data_format")) {
-        int dataFormat = parameters["data_format"].toInt();
-        stream << static_cast<quint32>(dataFormat);
+    toParameters(frame, parameters);
+    return true;
+}
+
+bool RealtimeDataHandler::decode(const char* data, int size, RealtimeFrame& frame) {
+    if (!data || size <= 0 || size > MAX_BUFFER_SIZE) {
+        qWarning() << "RealtimeDataHandler: Invalid data size for deserialization";
+        return false;
     }
 
-    // 序列化通道数据
-    if (parameters.contains("channel_data")) {
-        QVariantList channelData = parameters["channel_data"].toList();
-        stream << static_cast<quint32>(channelData.size());
-
-        for (const auto& data : channelData) {
-            QVariantMap channelInfo = data.toMap();
-            if (channelInfo.contains("channel_id")) {
-                stream << static_cast<quint32>(channelInfo["channel_id"].toInt());
-            }
-            if (channelInfo.contains("amplitude")) {
-                stream << channelInfo["amplitude"].toFloat();
-            }
-            if (channelInfo.contains("frequency")) {
-                stream << channelInfo["frequency"].toFloat();
-            }
+    const uchar* p = reinterpret_cast<const uchar*>(data);
+    const uchar* const end = p + size;
+
+    // 基本参数和通道数据条数，读取前已到末尾视为格式错误
+    quint32* const header[] = { &frame.channelCount, &frame.sampleRate, &frame.dataFormat };
+    for (quint32* field : header) {
+        if (p == end) {
+            return false;
         }
+        *field = readLittleEndian<quint32>(p, end);
     }
 
-    // 序列化时间戳
-    if (parameters.contains("timestamp")) {
-        quint64 timestamp = parameters["timestamp"].toULongLong();
-        stream << timestamp;
+    if (p == end) {
+        return false;
     }
+    quint32 dataCount = readLittleEndian<quint32>(p, end);
 
-    buffer.close();
-    return result;
+    if (dataCount > MAX_CHANNELS) {
+        qWarning() << "RealtimeDataHandler: Too many channels:" << dataCount;
+        return false;
+    }
+
+    // 通道数据
+    frame.count = 0;
+    while (frame.count < static_cast<int>(dataCount) && p != end) {
+        const int i = frame.count++;
+        frame.id[i] = readLittleEndian<quint32>(p, end);
+        frame.amplitude[i] = readFloat(p, end);
+        frame.frequency[i] = readFloat(p, end);
+    }
+
+    // 时间戳（可选）
+    frame.hasTimestamp = p != end;
+    frame.timestamp = frame.hasTimestamp ? readLittleEndian<quint64>(p, end) : 0;
+
+    return validate(frame);
 }
 
-bool RealtimeDataHandler::deserialize(const QByteArray& data, QVariantMap& parameters) {
-    if (data.isEmpty() || data.size() > MAX_BUFFER_SIZE) {
+bool RealtimeDataHandler::decode(const ScatterSpan& data, RealtimeFrame& frame) {
+    if (data.isContiguous()) {
+        return decode(data.first(), data.size(), frame);
+    }
+
+    if (data.size() > MAX_BUFFER_SIZE) {
         qWarning() << "RealtimeDataHandler: Invalid data size for deserialization";
         return false;
     }
 
-    QBuffer buffer(const_cast<QByteArray*>(&data));
-    buffer.open(QIODevice::ReadOnly);
-    QDataStream stream(&buffer);
-    stream.setByteOrder(QDataStream::LittleEndian);
+    char buffer[MAX_BUFFER_SIZE];
+    data.copyTo(0, data.size(), buffer);
+    return decode(buffer, data.size(), frame);
+}
+
+QByteArray RealtimeDataHandler::encode(const RealtimeFrame& frame) {
+    if (frame.count < 0 || frame.count > MAX_CHANNELS) {
+        qWarning() << "RealtimeDataHandler: Too many channels:" << frame.count;
+        return QByteArray();
+    }
+
+    QByteArray result(HEADER_SIZE + frame.count * CHANNEL_RECORD_SIZE + (frame.hasTimestamp ? TIMESTAMP_SIZE : 0), '\0');
+    uchar* p = reinterpret_cast<uchar*>(result.data());
+
+    writeLittleEndian(p, frame.channelCount);
+    writeLittleEndian(p, frame.sampleRate);
+    writeLittleEndian(p, frame.dataFormat);
+    writeLittleEndian(p, static_cast<quint32>(frame.count));
+
+    for (int i = 0; i < frame.count; ++i) {
+        writeLittleEndian(p, frame.id[i]);
+        writeFloat(p, frame.amplitude[i]);
+        writeFloat(p, frame.frequency[i]);
+    }
+
+    if (frame.hasTimestamp) {
+        writeLittleEndian(p, frame.timestamp);
+    }
+
+    return result;
+}
 
-    try {
-        // 反序列化基本参数
-        quint32 channelCount = 0;
-        if (stream.atEnd()) return false;
-        stream >> channelCount;
-        parameters["channel_count"] = static_cast<int>(channelCount);
+bool RealtimeDataHandler::validate(const RealtimeFrame& frame) {
+    if (frame.channelCount > MAX_CHANNELS) {
+        return false;
+    }
 
-        quint32 sampleRate = 0;
-        if (stream.atEnd()) return false;
-        stream >> sampleRate;
-        parameters["sample_rate"] = static_cast<int>(sampleRate);
+    if (frame.sampleRate == 0 || frame.sampleRate > 48000) {
+        return false;
+    }
 
-        quint32 dataFormat = 0;
-        if (stream.atEnd()) return false;
-        stream >> dataFormat;
-        parameters["data_format"] = static_cast<int>(dataFormat);
+    if (frame.dataFormat > 3) {
+        return false;
+    }
 
-        // 反序列化通道数据
-        quint32 dataCount = 0;
-        if (stream.atEnd()) return false;
-        stream >> dataCount;
+    if (frame.count < 0 || frame.count > MAX_CHANNELS) {
+        return false;
+    }
 
-        if (dataCount > MAX_CHANNELS) {
-            qWarning() << "RealtimeDataHandler: Too many channels:" << dataCount;
+    for (int i = 0; i < frame.count; ++i) {
+        if (frame.id[i] >= MAX_CHANNELS) {
             return false;
         }
+        if (frame.amplitude[i] < -100.0f || frame.amplitude[i] > 100.0f) {
+            return false;
+        }
+    }
 
-        QVariantList channelDataList;
-        for (quint32 i = 0; i < dataCount && !stream.atEnd(); ++i) {
-            QVariantMap channelInfo;
-
-            quint32 channelId = 0;
-            stream >> channelId;
-            channelInfo["channel_id"] = static_cast<int>(channelId);
+    return true;
+}
 
-            float amplitude = 0.0f;
-            stream >> amplitude;
-            channelInfo["amplitude"] = amplitude;
+void RealtimeDataHandler::toParameters(const RealtimeFrame& frame, QVariantMap& parameters) {
+    parameters["channel_count"] = static_cast<int>(frame.channelCount);
+    parameters["sample_rate"] = static_cast<int>(frame.sampleRate);
+    parameters["data_format"] = static_cast<int>(frame.dataFormat);
+
+    QVariantList channelDataList;
+    channelDataList.reserve(frame.count);
+    for (int i = 0; i < frame.count; ++i) {
+        QVariantMap channelInfo;
+        channelInfo["channel_id"] = static_cast<int>(frame.id[i]);
+        channelInfo["amplitude"] = frame.amplitude[i];
+        channelInfo["frequency"] = frame.frequency[i];
+        channelDataList.append(channelInfo);
+    }
+    parameters["channel_data"] = channelDataList;
 
-            float frequency = 0.0f;
-            stream >> frequency;
-            channelInfo["frequency"] = frequency;
+    if (frame.hasTimestamp) {
+        parameters["timestamp"] = frame.timestamp;
+    }
+}
 
-            channelDataList.append(channelInfo);
-        }
-        parameters["channel_data"] = channelDataList;
+bool RealtimeDataHandler::fromParameters(const QVariantMap& parameters, RealtimeFrame& frame) {
+    if (!parameters.contains("channel_count") ||
+        !parameters.contains("sample_rate") ||
+        !parameters.contains("data_format")) {
+        return false;
+    }
 
-        // 反序列化时间戳
-        if (!stream.atEnd()) {
-            quint64 timestamp = 0;
-            stream >> timestamp;
-            parameters["timestamp"] = timestamp;
-        }
+    frame.channelCount = static_cast<quint32>(parameters["channel_count"].toInt());
+    frame.sampleRate = static_cast<quint32>(parameters["sample_rate"].toInt());
+    frame.dataFormat = static_cast<quint32>(parameters["data_format"].toInt());
 
-    } catch (...) {
-        qWarning() << "RealtimeDataHandler: Exception during deserialization";
+    // 缺省的频率按0编码
+    const QVariantList channelData = parameters.value("channel_data").toList();
+    if (channelData.size() > MAX_CHANNELS) {
         return false;
     }
 
-    buffer.close();
-    return validateParameters(parameters);
+    frame.count = 0;
+    for (const auto& data : channelData) {
+        const QVariantMap channelInfo = data.toMap();
+        const int i = frame.count++;
+        frame.id[i] = static_cast<quint32>(channelInfo.value("channel_id").toInt());
+        frame.amplitude[i] = channelInfo.value("amplitude").toFloat();
+        frame.frequency[i] = channelInfo.value("frequency").toFloat();
+    }
+
+    frame.hasTimestamp = parameters.contains("timestamp");
+    frame.timestamp = frame.hasTimestamp ? parameters["timestamp"].toULongLong() : 0;
+    return true;
 }
 
 bool RealtimeDataHandler::validateParameters(const QVariantMap& parameters) const {
@@ -3,16 +3,42 @@
 
 #include "core/imessage_handler.h"
 #include "core/message_types.h"
+#include "serialization/scatter_span.h"
 #include <QVariantMap>
 #include <QByteArray>
 
 namespace Protocol {
 
+/**
+ * @brief 一帧实时数据（列式存储）
+ *
+ * 各通道的id、幅值、频率分别存放在连续数组中，前count项有效，
+ * 解码和编码不经过QVariant，也不分配堆内存。
+ */
+struct RealtimeFrame {
+    static constexpr int MAX_CHANNELS = 32;
+
+    quint32 channelCount = 0;
+    quint32 sampleRate = 0;
+    quint32 dataFormat = 0;
+
+    int count = 0;                          // 通道数据条数
+    quint32 id[MAX_CHANNELS];
+    float amplitude[MAX_CHANNELS];
+    float frequency[MAX_CHANNELS];
+
+    bool hasTimestamp = false;
+    quint64 timestamp = 0;
+};
+
 /**
  * @brief 实时数据处理器
  *
  * 处理实时数据流消息，包括通道数据、幅值数据等
- * 支持CHECK_MOD消息类型(ProtoID: 150)
+ * 支持GRAPH_DATA消息类型(ProtoID: 156)，载荷在MsgRequestResponse的graph_data字段中传输
+ * （见ProtocolPackager::GRAPH_DATA_FIELD），只在协商CAPABILITY_GRAPH_DATA后收发。CHECK_MOD只负责启停数据流，载荷为MSG_CheckMod。
+ *
+ * 接收路径按decode()解码为RealtimeFrame，QVariantMap接口只为需要参数映射的调用方保留。
  */
 class RealtimeDataHandler : public IMessageHandler {
 public:
@@ -21,13 +47,38 @@ public:
 
     QByteArray serialize(const QVariantMap& parameters) override;
     bool deserialize(const QByteArray& data, QVariantMap& parameters) override;
-    MessageType getMessageType() const override { return MessageType::CHECK_MOD; }
+    MessageType getMessageType() const override { return MessageType::GRAPH_DATA; }
     bool validateParameters(const QVariantMap& parameters) const override;
     QString getDescription() const override { return "Realtime data stream message handler"; }
 
+    /**
+     * @brief 类型化解码/编码（实时采集热路径）
+     *
+     * 线格式与QVariantMap接口相同（QDataStream小端格式，浮点按64位double传输），
+     * 直接按小端读写，QVariantMap形式只在需要时通过toParameters()生成。
+     */
+    static bool decode(const char* data, int size, RealtimeFrame& frame);
+
+    static bool decode(const QByteArray& data, RealtimeFrame& frame) {
+        return decode(data.constData(), data.size(), frame);
+    }
+
+    // 直接在接收缓冲区上解码，跨两段的载荷先复制到栈上（不超过MAX_BUFFER_SIZE）
+    static bool decode(const ScatterSpan& data, RealtimeFrame& frame);
+
+    static QByteArray encode(const RealtimeFrame& frame);
+
+    static bool validate(const RealtimeFrame& frame);
+
+    /**
+     * @brief 列式帧与参数表之间的转换
+     */
+    static void toParameters(const RealtimeFrame& frame, QVariantMap& parameters);
+    static bool fromParameters(const QVariantMap& parameters, RealtimeFrame& frame);
+
 private:
     static constexpr int MAX_BUFFER_SIZE = 512;
-    static constexpr int MAX_CHANNELS = 32;
+    static constexpr int MAX_CHANNELS = RealtimeFrame::MAX_CHANNELS;
 
     bool validateChannelData(const QVariantMap& parameters) const;
     bool validateAmplitudeData(const QVariantMap& parameters) const;
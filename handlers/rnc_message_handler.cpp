@@ -1,4 +1,5 @@
 #include "rnc_message_handler.h"
+#include "../serialization/message_codec.h"
 #include <QDebug>
 
 namespace Protocol {
@@ -16,34 +17,21 @@ QByteArray RncMessageHandler::serialize(const QVariantMap& parameters) {
     msg.rnc_off = !rncEnabled; // 设置RNC_OFF字段（true=关闭，false=开启）
 
     // 序列化消息
-    uint8_t buffer[MAX_BUFFER_SIZE];
-    pb_ostream_t stream = pb_ostream_from_buffer(buffer, sizeof(buffer));
-
-    if (!pb_encode(&stream, MSG_AncSwitch_fields, &msg)) {
-        qWarning() << "Failed to encode RNC message:" << PB_GET_ERROR(&stream);
+    QByteArray result;
+    if (!MessageCodec::encode(msg, result)) {
+        qWarning() << "Failed to encode RNC message";
         return QByteArray();
     }
 
-    QByteArray result(reinterpret_cast<char*>(buffer), stream.bytes_written);
     qDebug() << "RNC message serialized:" << result.size() << "bytes, RNC enabled:" << rncEnabled;
 
     return result;
 }
 
 bool RncMessageHandler::deserialize(const QByteArray& data, QVariantMap& parameters) {
-    if (data.isEmpty()) {
-        qWarning() << "Empty data for RNC message deserialization";
-        return false;
-    }
-
     MSG_AncSwitch msg = MSG_AncSwitch_init_zero;
-    pb_istream_t stream = pb_istream_from_buffer(
-        reinterpret_cast<const uint8_t*>(data.constData()),
-        data.size()
-    );
-
-    if (!pb_decode(&stream, MSG_AncSwitch_fields, &msg)) {
-        qWarning() << "Failed to decode RNC message:" << PB_GET_ERROR(&stream);
+    if (!MessageCodec::decode(data, msg)) {
+        qWarning() << "Failed to decode RNC message";
         return false;
     }
 
@@ -1,4 +1,5 @@
 #include "vehicle_message_handler.h"
+#include "../serialization/message_codec.h"
 #include <QLoggingCategory>
 #include <QVariantList>
 
@@ -181,7 +182,6 @@ QByteArray VehicleMessageHandler::serialize(const QVariantMap& parameters)
 
     // 序列化消息
     qCDebug(vehicleHandler) << "--- Starting Protobuf Serialization ---";
-    qCDebug(vehicleHandler) << "Buffer size:" << MAX_BUFFER_SIZE;
 
     // 打印最终的vehicleState结构内容
     qCDebug(vehicleHandler) << "Final VehicleState structure:";
@@ -199,21 +199,13 @@ QByteArray VehicleMessageHandler::serialize(const QVariantMap& parameters)
     qCDebug(vehicleHandler) << "  window[4]:" << finalWindowList.join(",");
     qCDebug(vehicleHandler) << "  media[8]: not processed (not in parameter mapping)";
 
-    uint8_t buffer[MAX_BUFFER_SIZE];
-    pb_ostream_t stream = pb_ostream_from_buffer(buffer, sizeof(buffer));
-
-    bool status = pb_encode(&stream, MSG_VehicleState_fields, &vehicleState);
-    if (!status) {
-        qCWarning(vehicleHandler) << "Failed to encode vehicle state message:"
-                                  << PB_GET_ERROR(&stream);
+    QByteArray result;
+    if (!MessageCodec::encode(vehicleState, result)) {
+        qCWarning(vehicleHandler) << "Failed to encode vehicle state message";
         return QByteArray();
     }
 
-    QByteArray result(reinterpret_cast<const char*>(buffer),
-                      static_cast<int>(stream.bytes_written));
-
     qCDebug(vehicleHandler) << "Protobuf encoding successful!";
-    qCDebug(vehicleHandler) << "Bytes written:" << stream.bytes_written;
     qCDebug(vehicleHandler) << "Result size:" << result.size();
 
     // 打印序列化后的十六进制数据
@@ -250,22 +242,10 @@ QByteArray VehicleMessageHandler::serialize(const QVariantMap& parameters)
 
 bool VehicleMessageHandler::deserialize(const QByteArray& data, QVariantMap& parameters)
 {
-    if (data.isEmpty()) {
-        qCWarning(vehicleHandler) << "Empty data received";
-        return false;
-    }
-
     // 解码车辆状态消息
     MSG_VehicleState vehicleState = MSG_VehicleState_init_zero;
-    pb_istream_t stream = pb_istream_from_buffer(
-        reinterpret_cast<const uint8_t*>(data.constData()),
-        static_cast<size_t>(data.size())
-    );
-
-    bool status = pb_decode(&stream, MSG_VehicleState_fields, &vehicleState);
-    if (!status) {
-        qCWarning(vehicleHandler) << "Failed to decode vehicle state message:"
-                                  << PB_GET_ERROR(&stream);
+    if (!MessageCodec::decode(data, vehicleState)) {
+        qCWarning(vehicleHandler) << "Failed to decode vehicle state message";
         return false;
     }
 
@@ -3,6 +3,7 @@
 #include <QJsonArray>
 #include <QFile>
 #include <QDebug>
+#include <algorithm>
 
 namespace Protocol {
 
@@ -79,6 +80,7 @@ bool ParameterMapper::loadMappingFromJson(const QJsonObject& jsonObject) {
     }
 
     initialized_ = true;
+    rebuildIndex();
     qInfo() << "Parameter mapping loaded successfully:" << mappings_.size() << "parameters";
     return true;
 }
@@ -97,7 +99,37 @@ ParameterInfo ParameterMapper::getParameterInfo(const QString& parameterPath) co
 }
 
 bool ParameterMapper::isParameterSupported(const QString& parameterPath) const {
-    return mappings_.contains(parameterPath);
+    return parameterId(parameterPath) != INVALID_PARAM_ID;
+}
+
+ParamId ParameterMapper::parameterId(const QString& parameterPath) const {
+    if (phfSlots_.isEmpty()) {
+        return fallbackIndex_.value(parameterPath, INVALID_PARAM_ID);
+    }
+
+    const quint32 bucket = hashPath(parameterPath, 0) % static_cast<quint32>(phfSeeds_.size());
+    const quint32 slot = hashPath(parameterPath, phfSeeds_[bucket]) % static_cast<quint32>(phfSlots_.size());
+    const ParamId id = phfSlots_[slot];
+
+    // 完美哈希只对已知路径无冲突，未知路径需要比较确认
+    return coldInfo_[id].logicalPath == parameterPath ? id : INVALID_PARAM_ID;
+}
+
+ParameterInfo ParameterMapper::getParameterInfo(ParamId id) const {
+    const ParameterInfo* info = findParameterInfo(id);
+    if (!info) {
+        return ParameterInfo();
+    }
+
+    if (info->deprecated) {
+        emit const_cast<ParameterMapper*>(this)->deprecatedParameterUsed(info->logicalPath, info->replacedBy);
+    }
+    return *info;
+}
+
+QString ParameterMapper::parameterPath(ParamId id) const {
+    const ParameterInfo* info = findParameterInfo(id);
+    return info ? info->logicalPath : QString();
 }
 
 QStringList ParameterMapper::getSupportedParameters() const {
@@ -127,6 +159,7 @@ QString ParameterMapper::getReplacementParameter(const QString& parameterPath) c
 void ParameterMapper::clear() {
     mappings_.clear();
     initialized_ = false;
+    rebuildIndex();
 }
 
 int ParameterMapper::mappingCount() const {
@@ -185,6 +218,7 @@ void ParameterMapper::initializeDefaultMappings() {
     mappings_["processing.alpha"] = alphaInfo;
 
     initialized_ = true;
+    rebuildIndex();
     qDebug() << "Default parameter mappings initialized:" << mappings_.size() << "parameters";
 }
 
@@ -229,4 +263,139 @@ ParameterInfo ParameterMapper::parseParameterFromJson(const QString& parameterPa
     return info;
 }
 
+void ParameterMapper::rebuildIndex() {
+    coldInfo_.clear();
+    hotInfo_.clear();
+    phfSeeds_.clear();
+    phfSlots_.clear();
+    fallbackIndex_.clear();
+
+    if (mappings_.isEmpty()) {
+        return;
+    }
+
+    if (mappings_.size() >= INVALID_PARAM_ID) {
+        qWarning() << "Too many parameters for ParamId:" << mappings_.size();
+        return;
+    }
+
+    // 按路径排序分配ID，相同映射配置得到相同的ID
+    QStringList paths = mappings_.keys();
+    std::sort(paths.begin(), paths.end());
+
+    coldInfo_.reserve(paths.size());
+    hotInfo_.reserve(paths.size());
+    for (const QString& path : paths) {
+        const ParameterInfo& info = mappings_[path];
+        ParameterHotInfo hot;
+        hot.protoId = static_cast<quint16>(MessageTypeUtils::toProtoID(info.messageType));
+        hot.fieldType = fieldTypeFromString(info.fieldType);
+        hot.flags = info.deprecated ? ParameterHotInfo::FLAG_DEPRECATED : 0;
+
+        coldInfo_.append(info);
+        hotInfo_.append(hot);
+    }
+
+    // 一级桶数量从n开始，极少数情况下失败时换桶数重试
+    for (int bucketCount = coldInfo_.size(); bucketCount <= coldInfo_.size() * 4; bucketCount *= 2) {
+        if (buildPerfectHash(bucketCount)) {
+            qDebug() << "Parameter index rebuilt:" << coldInfo_.size() << "ids,"
+                     << bucketCount << "buckets";
+            return;
+        }
+    }
+
+    qWarning() << "Failed to build perfect hash, falling back to hash table index";
+    phfSeeds_.clear();
+    phfSlots_.clear();
+    for (int id = 0; id < coldInfo_.size(); ++id) {
+        fallbackIndex_.insert(coldInfo_[id].logicalPath, static_cast<ParamId>(id));
+    }
+}
+
+bool ParameterMapper::buildPerfectHash(int bucketCount) {
+    static const quint32 MAX_SEED_ATTEMPTS = 1u << 16;
+
+    const int keyCount = coldInfo_.size();
+    QVector<QVector<int>> buckets(bucketCount);
+    for (int id = 0; id < keyCount; ++id) {
+        quint32 bucket = hashPath(coldInfo_[id].logicalPath, 0) % static_cast<quint32>(bucketCount);
+        buckets[static_cast<int>(bucket)].append(id);
+    }
+
+    // 先安置大桶，越往后空闲槽位越少，小桶越容易找到种子
+    QVector<int> order(bucketCount);
+    for (int i = 0; i < bucketCount; ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&buckets](int a, int b) {
+        return buckets[a].size() > buckets[b].size();
+    });
+
+    QVector<quint32> seeds(bucketCount, 0);
+    QVector<ParamId> slotTable(keyCount, INVALID_PARAM_ID);
+    QVector<quint32> positions;
+
+    for (int bucketIndex : order) {
+        const QVector<int>& keys = buckets[bucketIndex];
+        if (keys.isEmpty()) {
+            break;
+        }
+
+        bool placed = false;
+        for (quint32 seed = 1; seed < MAX_SEED_ATTEMPTS && !placed; ++seed) {
+            positions.clear();
+            placed = true;
+            for (int id : keys) {
+                quint32 slot = hashPath(coldInfo_[id].logicalPath, seed) % static_cast<quint32>(keyCount);
+                if (slotTable[static_cast<int>(slot)] != INVALID_PARAM_ID || positions.contains(slot)) {
+                    placed = false;
+                    break;
+                }
+                positions.append(slot);
+            }
+
+            if (placed) {
+                seeds[bucketIndex] = seed;
+                for (int i = 0; i < keys.size(); ++i) {
+                    slotTable[static_cast<int>(positions[i])] = static_cast<ParamId>(keys[i]);
+                }
+            }
+        }
+
+        if (!placed) {
+            return false;
+        }
+    }
+
+    phfSeeds_ = seeds;
+    phfSlots_ = slotTable;
+    return true;
+}
+
+quint32 ParameterMapper::hashPath(const QString& path, quint32 seed) {
+    // FNV-1a + 混合，种子参与初始值
+    quint32 hash = 2166136261u ^ (seed * 0x9E3779B9u);
+    const QChar* data = path.constData();
+    for (int i = 0; i < path.size(); ++i) {
+        hash ^= data[i].unicode();
+        hash *= 16777619u;
+    }
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6Bu;
+    hash ^= hash >> 13;
+    return hash;
+}
+
+ParameterFieldType ParameterMapper::fieldTypeFromString(const QString& fieldType) {
+    if (fieldType == "bool") return ParameterFieldType::Bool;
+    if (fieldType == "int32") return ParameterFieldType::Int32;
+    if (fieldType == "uint32") return ParameterFieldType::UInt32;
+    if (fieldType == "float") return ParameterFieldType::Float;
+    if (fieldType == "double") return ParameterFieldType::Double;
+    if (fieldType == "string") return ParameterFieldType::String;
+    if (fieldType == "bytes") return ParameterFieldType::Bytes;
+    return ParameterFieldType::Unknown;
+}
+
 } // namespace Protocol
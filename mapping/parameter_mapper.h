@@ -6,6 +6,7 @@
 #include <QVariant>
 #include <QStringList>
 #include <QHash>
+#include <QVector>
 #include <QJsonObject>
 #include "../core/message_types.h"
 
@@ -27,6 +28,45 @@ struct ParameterInfo {
     bool isValid() const { return !logicalPath.isEmpty() && !protobufPath.isEmpty(); }
 };
 
+/**
+ * @brief 参数ID
+ *
+ * 映射加载时把参数路径驻留为从0开始的连续整数，重新加载映射后ID失效。
+ */
+using ParamId = quint16;
+constexpr ParamId INVALID_PARAM_ID = 0xFFFF;
+
+/**
+ * @brief 参数字段类型编码
+ */
+enum class ParameterFieldType : quint8 {
+    Unknown = 0,
+    Bool,
+    Int32,
+    UInt32,
+    Float,
+    Double,
+    String,
+    Bytes
+};
+
+/**
+ * @brief 参数热路径信息（4字节）
+ *
+ * 发送路径只需要消息类型和字段类型，其余描述信息见ParameterInfo。
+ */
+struct ParameterHotInfo {
+    quint16 protoId = 0xFFFF;                               // 消息类型的ProtoID
+    ParameterFieldType fieldType = ParameterFieldType::Unknown;
+    quint8 flags = 0;                                       // FLAG_*
+
+    static constexpr quint8 FLAG_DEPRECATED = 0x01;
+
+    MessageType messageType() const { return static_cast<MessageType>(protoId); }
+    bool isValid() const { return protoId != 0xFFFF; }
+    bool isDeprecated() const { return (flags & FLAG_DEPRECATED) != 0; }
+};
+
 /**
  * @brief 参数映射器
  *
@@ -61,6 +101,35 @@ public:
      */
     ParameterInfo getParameterInfo(const QString& parameterPath) const;
 
+    /**
+     * @brief 参数ID接口
+     *
+     * 路径到ID的解析使用加载映射时构建的最小完美哈希（一次字符串哈希加一次比较），
+     * 按ID查询为数组下标访问，不涉及字符串操作。
+     */
+
+    // 解析参数路径，不存在返回INVALID_PARAM_ID
+    ParamId parameterId(const QString& parameterPath) const;
+
+    // 参数热路径信息
+    ParameterHotInfo hotInfo(ParamId id) const {
+        return id < hotInfo_.size() ? hotInfo_[id] : ParameterHotInfo();
+    }
+
+    // 完整参数信息（不拷贝），ID无效返回nullptr
+    const ParameterInfo* findParameterInfo(ParamId id) const {
+        return id < coldInfo_.size() ? &coldInfo_[id] : nullptr;
+    }
+
+    // 获取参数信息（按ID）
+    ParameterInfo getParameterInfo(ParamId id) const;
+
+    // 参数ID对应的路径
+    QString parameterPath(ParamId id) const;
+
+    // 已分配的参数ID数量
+    int parameterIdCount() const { return coldInfo_.size(); }
+
     /**
      * @brief 检查参数是否支持
      * @param parameterPath 参数路径
@@ -142,9 +211,38 @@ private:
      */
     ParameterInfo parseParameterFromJson(const QString& parameterPath, const QJsonObject& jsonParam) const;
 
+    /**
+     * @brief 重建参数ID、热/冷信息表和完美哈希
+     */
+    void rebuildIndex();
+
+    /**
+     * @brief 构建最小完美哈希（hash-and-displace）
+     * @param bucketCount 一级桶数量
+     * @return 成功返回true
+     */
+    bool buildPerfectHash(int bucketCount);
+
+    /**
+     * @brief 带种子的路径哈希
+     */
+    static quint32 hashPath(const QString& path, quint32 seed);
+
+    /**
+     * @brief 字段类型字符串转编码
+     */
+    static ParameterFieldType fieldTypeFromString(const QString& fieldType);
+
 private:
     QHash<QString, ParameterInfo> mappings_;  // 参数路径到信息的映射
     bool initialized_ = false;                // 是否已初始化
+
+    // 参数ID索引（下标即ParamId）
+    QVector<ParameterInfo> coldInfo_;         // 完整参数信息
+    QVector<ParameterHotInfo> hotInfo_;       // 热路径信息
+    QVector<quint32> phfSeeds_;               // 每个一级桶的二级哈希种子
+    QVector<ParamId> phfSlots_;               // 槽位到参数ID
+    QHash<QString, ParamId> fallbackIndex_;   // 完美哈希构建失败时的后备索引
 };
 
 } // namespace Protocol
@@ -203,6 +203,7 @@ typedef struct _MsgRequestResponse {
         MSG_FreqDivision msg_freq_division;
         MSG_Thresholds msg_thresholds;
     } payload;
+    pb_callback_t graph_data;
 } MsgRequestResponse;
 
 
@@ -258,7 +259,7 @@ extern "C" {
 #define MSG_AlphaParams_init_default             {0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
 #define MSG_FreqDivision_init_default            {0, 0, 0, 0, 0}
 #define MSG_Thresholds_init_default              {0, 0, 0}
-#define MsgRequestResponse_init_default          {_ProtoID_MIN, _FunCode_MIN, 0, {MSG_ChannelNumber_init_default}}
+#define MsgRequestResponse_init_default          {_ProtoID_MIN, _FunCode_MIN, 0, {MSG_ChannelNumber_init_default}, {{NULL}, NULL}}
 #define MSG_ChannelNumber_init_zero              {0, 0, 0}
 #define MSG_ChannelAmplitude_init_zero           {{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}, 0}
 #define MSG_ChannelSwitch_init_zero              {{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}, {0, 0, 0, 0, 0, 0, 0, 0}}
@@ -276,7 +277,7 @@ extern "C" {
 #define MSG_AlphaParams_init_zero                {0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
 #define MSG_FreqDivision_init_zero               {0, 0, 0, 0, 0}
 #define MSG_Thresholds_init_zero                 {0, 0, 0}
-#define MsgRequestResponse_init_zero             {_ProtoID_MIN, _FunCode_MIN, 0, {MSG_ChannelNumber_init_zero}}
+#define MsgRequestResponse_init_zero             {_ProtoID_MIN, _FunCode_MIN, 0, {MSG_ChannelNumber_init_zero}, {{NULL}, NULL}}
 
 /* Field tags (for use in manual encoding/decoding) */
 #define MSG_ChannelNumber_ReferNum_tag           1
@@ -365,6 +366,7 @@ extern "C" {
 #define MsgRequestResponse_msg_alpha_params_tag  17
 #define MsgRequestResponse_msg_freq_division_tag 18
 #define MsgRequestResponse_msg_thresholds_tag    19
+#define MsgRequestResponse_graph_data_tag        22
 
 /* Struct field encoding specification for nanopb */
 #define MSG_ChannelNumber_FIELDLIST(X, a) \
@@ -521,8 +523,9 @@ X(a, STATIC,   ONEOF,    MESSAGE,  (payload,msg_order4_params,payload.msg_order4
 X(a, STATIC,   ONEOF,    MESSAGE,  (payload,msg_order6_params,payload.msg_order6_params),  16) \
 X(a, STATIC,   ONEOF,    MESSAGE,  (payload,msg_alpha_params,payload.msg_alpha_params),  17) \
 X(a, STATIC,   ONEOF,    MESSAGE,  (payload,msg_freq_division,payload.msg_freq_division),  18) \
-X(a, STATIC,   ONEOF,    MESSAGE,  (payload,msg_thresholds,payload.msg_thresholds),  19)
-#define MsgRequestResponse_CALLBACK NULL
+X(a, STATIC,   ONEOF,    MESSAGE,  (payload,msg_thresholds,payload.msg_thresholds),  19) \
+X(a, CALLBACK, SINGULAR, BYTES,    graph_data,       22)
+#define MsgRequestResponse_CALLBACK pb_default_field_callback
 #define MsgRequestResponse_DEFAULT NULL
 #define MsgRequestResponse_payload_msg_channel_number_MSGTYPE MSG_ChannelNumber
 #define MsgRequestResponse_payload_msg_channel_amplitude_MSGTYPE MSG_ChannelAmplitude
@@ -582,7 +585,8 @@ extern const pb_msgdesc_t MsgRequestResponse_msg;
 #define MsgRequestResponse_fields &MsgRequestResponse_msg
 
 /* Maximum encoded size of messages (where known) */
-#define ERNC_PRARAM_PB_H_MAX_SIZE                MsgRequestResponse_size
+/* MsgRequestResponse_size depends on runtime parameters */
+#define ERNC_PRARAM_PB_H_MAX_SIZE                MSG_Order2Params_size
 #define MSG_AlphaParams_size                     60
 #define MSG_AncSwitch_size                       6
 #define MSG_ChannelAmplitude_size                84
@@ -600,7 +604,6 @@ extern const pb_msgdesc_t MsgRequestResponse_msg;
 #define MSG_TranFuncFlag_size                    2
 #define MSG_TranFuncState_size                   6
 #define MSG_VehicleState_size                    132
-#define MsgRequestResponse_size                  309
 
 #ifdef __cplusplus
 } /* extern "C" */
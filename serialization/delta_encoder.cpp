@@ -0,0 +1,86 @@
+#include "delta_encoder.h"
+#include <QDebug>
+
+namespace Protocol {
+
+// 常量定义
+const int DeltaEncoder::DEFAULT_KEYFRAME_INTERVAL_MS = 1000;
+
+DeltaEncoder::DeltaEncoder()
+    : keyframeIntervalMs_(DEFAULT_KEYFRAME_INTERVAL_MS)
+{
+    clock_.start();
+}
+
+void DeltaEncoder::setEnabled(MessageType messageType, bool enabled) {
+    if (enabled) {
+        enabledTypes_.insert(messageType);
+    } else {
+        enabledTypes_.remove(messageType);
+        baselines_.remove(messageType);
+    }
+
+    qDebug() << "Delta mode" << (enabled ? "enabled" : "disabled")
+             << "for message type:" << MessageTypeUtils::toString(messageType);
+}
+
+void DeltaEncoder::setKeyframeInterval(int ms) {
+    if (ms <= 0) {
+        qWarning() << "Invalid keyframe interval:" << ms;
+        return;
+    }
+    keyframeIntervalMs_ = ms;
+}
+
+QVariantMap DeltaEncoder::encode(MessageType messageType, const QVariantMap& state, bool& keyframe) {
+    Baseline& baseline = baselines_[messageType];
+    const qint64 now = clock_.elapsed();
+
+    // 调用方可能只给出部分字段，以最后一次发送的状态补全
+    QVariantMap merged = baseline.latest;
+    for (auto it = state.constBegin(); it != state.constEnd(); ++it) {
+        merged.insert(it.key(), it.value());
+    }
+
+    keyframe = !baseline.valid
+               || baseline.lastKeyframeMs < 0
+               || now - baseline.lastKeyframeMs >= keyframeIntervalMs_;
+
+    // 有未确认的发送时设备状态可能随时变为latest，不能按已确认状态跳过
+    if (!keyframe && merged == baseline.confirmed && baseline.latest == baseline.confirmed) {
+        stats_.suppressedFrames++;
+        return QVariantMap();
+    }
+
+    // 设备不合并缺省字段，总是发送完整状态
+    baseline.latest = merged;
+    return merged;
+}
+
+void DeltaEncoder::commit(MessageType messageType, const QVariantMap& sent, bool keyframe) {
+    Baseline& baseline = baselines_[messageType];
+    baseline.confirmed = sent;
+    baseline.valid = true;
+
+    if (keyframe) {
+        baseline.lastKeyframeMs = clock_.elapsed();
+        stats_.keyframes++;
+    } else {
+        stats_.changedFrames++;
+    }
+}
+
+void DeltaEncoder::invalidate(MessageType messageType) {
+    auto it = baselines_.find(messageType);
+    if (it != baselines_.end()) {
+        it->valid = false;
+    }
+}
+
+void DeltaEncoder::invalidateAll() {
+    for (auto it = baselines_.begin(); it != baselines_.end(); ++it) {
+        it->valid = false;
+    }
+}
+
+} // namespace Protocol
@@ -0,0 +1,94 @@
+#ifndef DELTA_ENCODER_H
+#define DELTA_ENCODER_H
+
+#include <QHash>
+#include <QSet>
+#include <QVariantMap>
+#include <QElapsedTimer>
+#include "../core/message_types.h"
+
+namespace Protocol {
+
+/**
+ * @brief 增量发送编码器
+ *
+ * 为高频周期消息（VehicleState、ChannelAmplitude等）保存每种消息类型设备已确认的状态，
+ * 状态与已确认的完全相同且没有未确认的发送时跳过本次发送。
+ * 设备把消息中未携带的字段按零值处理，不会与已有状态合并，因此只要有变化就发送完整消息，
+ * 不省略未变化的字段。调用方给出的部分字段以最后一次发送的状态补全。
+ * 按固定间隔发送关键帧（即使没有变化）用于重新同步；基准只在设备确认后推进，
+ * 发送失败、超时或断线后基准失效，下一帧强制为关键帧。
+ */
+class DeltaEncoder {
+public:
+    DeltaEncoder();
+    ~DeltaEncoder() = default;
+
+    /**
+     * @brief 启用或关闭指定消息类型的增量模式
+     */
+    void setEnabled(MessageType messageType, bool enabled);
+    bool isEnabled(MessageType messageType) const { return enabledTypes_.contains(messageType); }
+
+    /**
+     * @brief 关键帧间隔（毫秒）
+     */
+    void setKeyframeInterval(int ms);
+    int keyframeInterval() const { return keyframeIntervalMs_; }
+
+    /**
+     * @brief 计算本次需要发送的参数
+     * @param messageType 消息类型
+     * @param state 调用方提供的当前状态（可以只包含部分字段）
+     * @param keyframe 输出：本次是否为关键帧
+     * @return 需要发送的完整状态；与设备已确认的状态相同时返回空映射，调用方可跳过本次发送
+     */
+    QVariantMap encode(MessageType messageType, const QVariantMap& state, bool& keyframe);
+
+    /**
+     * @brief 设备确认后推进基准状态
+     * @param messageType 消息类型
+     * @param sent 被确认的帧发送的完整状态
+     * @param keyframe 是否为关键帧
+     */
+    void commit(MessageType messageType, const QVariantMap& sent, bool keyframe);
+
+    /**
+     * @brief 丢弃基准状态（发送失败、超时或断线），下一帧强制为关键帧
+     */
+    void invalidate(MessageType messageType);
+    void invalidateAll();
+
+    /**
+     * @brief 统计信息
+     */
+    struct Statistics {
+        quint64 keyframes = 0;          // 已确认的关键帧数
+        quint64 changedFrames = 0;      // 已确认的变化帧数
+        quint64 suppressedFrames = 0;   // 无变化而跳过的帧数
+    };
+
+    Statistics getStatistics() const { return stats_; }
+    void resetStatistics() { stats_ = Statistics(); }
+
+private:
+    struct Baseline {
+        QVariantMap latest;             // 最后一次交给发送的完整状态（补全部分字段用）
+        QVariantMap confirmed;          // 设备已确认的完整状态
+        qint64 lastKeyframeMs = -1;     // 最后一次确认的关键帧时间
+        bool valid = false;             // confirmed是否可信
+    };
+
+    QSet<MessageType> enabledTypes_;
+    QHash<MessageType, Baseline> baselines_;
+    QElapsedTimer clock_;
+    int keyframeIntervalMs_;
+    Statistics stats_;
+
+    // 常量
+    static const int DEFAULT_KEYFRAME_INTERVAL_MS;
+};
+
+} // namespace Protocol
+
+#endif // DELTA_ENCODER_H
@@ -0,0 +1,251 @@
+#include "message_bus.h"
+#include "protocol/state/shadow_state_store.h"
+#include <QDebug>
+
+namespace Protocol {
+
+namespace {
+
+quint8 functionCodeBit(FunctionCode functionCode)
+{
+    return static_cast<quint8>(1u << static_cast<int>(functionCode));
+}
+
+} // namespace
+
+MessageBus::MessageBus(QObject* parent)
+    : QObject(parent)
+    , dispatching_(0)
+    , nextId_(1)
+    , published_(0)
+    , delivered_(0)
+    , decodeErrors_(0)
+{
+    for (int i = 0; i < PROTO_ID_COUNT; ++i) {
+        lists_[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+MessageBus::~MessageBus() {
+    QMutexLocker locker(&mutex_);
+    for (int i = 0; i < PROTO_ID_COUNT; ++i) {
+        delete lists_[i].exchange(nullptr);
+    }
+    qDeleteAll(retired_);
+    retired_.clear();
+}
+
+MessageBus::SubscriptionId MessageBus::addSubscriber(MessageType messageType, size_t messageSize, QObject* context,
+                                                     Delivery delivery, FunctionFilter filter, Invoker invoker) {
+    const int protoId = static_cast<int>(messageType);
+    if (protoId < 0 || protoId >= PROTO_ID_COUNT || ShadowStateStore::messageSize(messageType) != messageSize) {
+        qWarning() << "Cannot subscribe to unsupported message type:" << MessageTypeUtils::toString(messageType);
+        return INVALID_SUBSCRIPTION;
+    }
+
+    if (delivery == Delivery::Queued && !context) {
+        qWarning() << "Queued subscription requires a context object";
+        return INVALID_SUBSCRIPTION;
+    }
+
+    QMutexLocker locker(&mutex_);
+
+    Subscriber subscriber;
+    subscriber.id = nextId_++;
+    subscriber.context = context;
+    subscriber.delivery = delivery;
+    subscriber.functionCodes = static_cast<quint8>(filter);
+    subscriber.invoke = std::move(invoker);
+
+    // 复制当前列表并追加，原子替换后旧列表只读直到释放
+    const SubscriberList* current = lists_[protoId].load(std::memory_order_acquire);
+    SubscriberList* list = current ? new SubscriberList(*current) : new SubscriberList();
+    list->subscribers.append(subscriber);
+    list->functionCodes |= subscriber.functionCodes;
+    replaceList(protoId, list);
+
+    if (context && !contextConnections_.contains(context)) {
+        contextConnections_.insert(context, connect(context, &QObject::destroyed, this, [this, context]() {
+            unsubscribeAll(context);
+        }, Qt::DirectConnection));
+    }
+
+    qDebug() << "Message bus subscription" << subscriber.id << "for" << MessageTypeUtils::toString(messageType)
+             << (delivery == Delivery::Queued ? "(queued)" : "(direct)");
+    return subscriber.id;
+}
+
+bool MessageBus::unsubscribe(SubscriptionId id) {
+    if (id == INVALID_SUBSCRIPTION) {
+        return false;
+    }
+
+    QMutexLocker locker(&mutex_);
+    return removeSubscribers([id](const Subscriber& subscriber) {
+        return subscriber.id == id;
+    });
+}
+
+void MessageBus::unsubscribeAll(QObject* context) {
+    if (!context) {
+        return;
+    }
+
+    QMutexLocker locker(&mutex_);
+    removeSubscribers([context](const Subscriber& subscriber) {
+        return subscriber.context == context;
+    });
+
+    auto it = contextConnections_.find(context);
+    if (it != contextConnections_.end()) {
+        disconnect(it.value());
+        contextConnections_.erase(it);
+    }
+}
+
+bool MessageBus::removeSubscribers(const std::function<bool(const Subscriber&)>& predicate) {
+    bool removed = false;
+    for (int protoId = 0; protoId < PROTO_ID_COUNT; ++protoId) {
+        const SubscriberList* current = lists_[protoId].load(std::memory_order_acquire);
+        if (!current) {
+            continue;
+        }
+
+        bool matched = false;
+        for (const Subscriber& subscriber : current->subscribers) {
+            if (predicate(subscriber)) {
+                matched = true;
+                break;
+            }
+        }
+        if (!matched) {
+            continue;
+        }
+
+        SubscriberList* list = new SubscriberList();
+        for (const Subscriber& subscriber : current->subscribers) {
+            if (!predicate(subscriber)) {
+                list->subscribers.append(subscriber);
+                list->functionCodes |= subscriber.functionCodes;
+            }
+        }
+        if (list->subscribers.isEmpty()) {
+            delete list;
+            list = nullptr;
+        }
+        replaceList(protoId, list);
+        removed = true;
+    }
+    return removed;
+}
+
+void MessageBus::replaceList(int protoId, SubscriberList* list) {
+    const SubscriberList* previous = lists_[protoId].exchange(list, std::memory_order_seq_cst);
+    if (previous) {
+        retired_.append(previous);
+    }
+    reclaimRetired();
+}
+
+void MessageBus::reclaimRetired() {
+    // 替换之后没有进行中的分发，则不再有读取方持有旧列表
+    if (!retired_.isEmpty() && dispatching_.load(std::memory_order_seq_cst) == 0) {
+        qDeleteAll(retired_);
+        retired_.clear();
+    }
+}
+
+bool MessageBus::hasSubscribers(MessageType messageType) const {
+    const int protoId = static_cast<int>(messageType);
+    return protoId >= 0 && protoId < PROTO_ID_COUNT
+           && lists_[protoId].load(std::memory_order_acquire) != nullptr;
+}
+
+int MessageBus::subscriberCount(MessageType messageType) const {
+    const int protoId = static_cast<int>(messageType);
+    if (protoId < 0 || protoId >= PROTO_ID_COUNT) {
+        return 0;
+    }
+
+    // 旧列表只在持有互斥锁时释放，这里持有互斥锁读取
+    QMutexLocker locker(&mutex_);
+    const SubscriberList* list = lists_[protoId].load(std::memory_order_acquire);
+    return list ? list->subscribers.size() : 0;
+}
+
+int MessageBus::publish(MessageType messageType, FunctionCode functionCode, const ScatterSpan& payload) {
+    const int protoId = static_cast<int>(messageType);
+    if (protoId < 0 || protoId >= PROTO_ID_COUNT) {
+        return 0;
+    }
+
+    const quint8 bit = functionCodeBit(functionCode);
+    dispatching_.fetch_add(1, std::memory_order_seq_cst);
+
+    int delivered = 0;
+    const SubscriberList* list = lists_[protoId].load(std::memory_order_seq_cst);
+    if (list && (list->functionCodes & bit)) {
+        // 只有存在匹配的订阅者时才解码，解码到清零的缓冲区
+        quint64 buffer[ShadowStateStore::MAX_MESSAGE_SIZE / sizeof(quint64)] = {};
+        if (MessageCodec::decode(messageType, payload, buffer, ShadowStateStore::messageSize(messageType))) {
+            delivered = dispatch(list, bit, buffer);
+        } else {
+            decodeErrors_.fetch_add(1, std::memory_order_relaxed);
+            qWarning() << "Message bus decode failed for" << MessageTypeUtils::toString(messageType);
+        }
+    }
+
+    dispatching_.fetch_sub(1, std::memory_order_seq_cst);
+    return delivered;
+}
+
+int MessageBus::publish(MessageType messageType, FunctionCode functionCode, const void* message, size_t size) {
+    const int protoId = static_cast<int>(messageType);
+    if (protoId < 0 || protoId >= PROTO_ID_COUNT || !message
+        || size != ShadowStateStore::messageSize(messageType)) {
+        return 0;
+    }
+
+    const quint8 bit = functionCodeBit(functionCode);
+    dispatching_.fetch_add(1, std::memory_order_seq_cst);
+
+    int delivered = 0;
+    const SubscriberList* list = lists_[protoId].load(std::memory_order_seq_cst);
+    if (list && (list->functionCodes & bit)) {
+        delivered = dispatch(list, bit, message);
+    }
+
+    dispatching_.fetch_sub(1, std::memory_order_seq_cst);
+    return delivered;
+}
+
+int MessageBus::dispatch(const SubscriberList* list, quint8 functionCode, const void* message) {
+    published_.fetch_add(1, std::memory_order_relaxed);
+
+    int delivered = 0;
+    for (const Subscriber& subscriber : list->subscribers) {
+        if (subscriber.functionCodes & functionCode) {
+            subscriber.invoke(message);
+            delivered++;
+        }
+    }
+
+    delivered_.fetch_add(static_cast<quint64>(delivered), std::memory_order_relaxed);
+    return delivered;
+}
+
+MessageBus::Statistics MessageBus::getStatistics() const {
+    Statistics stats;
+    stats.published = published_.load(std::memory_order_relaxed);
+    stats.delivered = delivered_.load(std::memory_order_relaxed);
+    stats.decodeErrors = decodeErrors_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void MessageBus::resetStatistics() {
+    published_.store(0, std::memory_order_relaxed);
+    delivered_.store(0, std::memory_order_relaxed);
+    decodeErrors_.store(0, std::memory_order_relaxed);
+}
+
+} // namespace Protocol
@@ -0,0 +1,188 @@
+#ifndef MESSAGE_BUS_H
+#define MESSAGE_BUS_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QMetaObject>
+#include <QMutex>
+#include <QVector>
+#include <atomic>
+#include <functional>
+#include <type_traits>
+#include "../core/message_types.h"
+#include "message_codec.h"
+
+namespace Protocol {
+
+/**
+ * @brief 按ProtoID订阅的消息总线
+ *
+ * 使用者按消息结构体类型（即ProtoID）订阅，可选只接收REQUEST或RESPONSE，
+ * 收到消息时得到解码后的const MSG_X&回调，不再经过QByteArray/QVariantMap信号由每个使用者自行过滤。
+ * 没有订阅者的消息不解码，开销只与实际订阅者的数量有关。
+ *
+ * 每个ProtoID的订阅者列表发布后只读，分发路径无锁：读取当前列表指针后依次回调；
+ * 订阅和取消订阅在互斥锁内复制出新列表再原子替换，旧列表在没有分发进行时释放。
+ *
+ * 投递方式：
+ * - Direct：在发布消息的线程中同步回调（默认，开销最小）
+ * - Queued：复制消息结构体，投递到context所在线程的事件循环中回调
+ *
+ * context对象销毁时自动取消其所有订阅。跨线程使用Direct投递时，
+ * 调用方需保证取消订阅之前回调中用到的对象仍然有效，否则应使用Queued投递。
+ */
+class MessageBus : public QObject {
+    Q_OBJECT
+
+public:
+    enum class Delivery {
+        Direct,
+        Queued
+    };
+
+    // 按功能码过滤
+    enum class FunctionFilter : quint8 {
+        Request = 0x01,
+        Response = 0x02,
+        Any = 0x03
+    };
+
+    using SubscriptionId = quint32;
+    static constexpr SubscriptionId INVALID_SUBSCRIPTION = 0;
+
+    explicit MessageBus(QObject* parent = nullptr);
+    ~MessageBus() override;
+
+    /**
+     * @brief 订阅一种消息
+     *
+     * 例如：bus->subscribe<MSG_VehicleState>(this, [](const MSG_VehicleState& state) { ... });
+     * @param context 上下文对象：Queued投递的目标线程，销毁时自动取消订阅；Direct投递时可为空
+     * @param callback 回调
+     * @param delivery 投递方式
+     * @param filter 功能码过滤
+     * @return 订阅ID，失败返回INVALID_SUBSCRIPTION
+     */
+    template<typename T>
+    SubscriptionId subscribe(QObject* context, std::function<void(const T&)> callback,
+                             Delivery delivery = Delivery::Direct,
+                             FunctionFilter filter = FunctionFilter::Any) {
+        static_assert(std::is_trivially_copyable<T>::value, "subscriptions are for nanopb message structs");
+        if (!callback) {
+            return INVALID_SUBSCRIPTION;
+        }
+
+        Invoker invoker;
+        if (delivery == Delivery::Queued) {
+            invoker = [context, callback](const void* message) {
+                T copy = *static_cast<const T*>(message);
+                QMetaObject::invokeMethod(context, [callback, copy]() {
+                    callback(copy);
+                }, Qt::QueuedConnection);
+            };
+        } else {
+            invoker = [callback](const void* message) {
+                callback(*static_cast<const T*>(message));
+            };
+        }
+        return addSubscriber(MessageTraits<T>::type, sizeof(T), context, delivery, filter, std::move(invoker));
+    }
+
+    /**
+     * @brief 取消订阅
+     * @return 订阅存在返回true
+     */
+    bool unsubscribe(SubscriptionId id);
+
+    /**
+     * @brief 取消context的所有订阅
+     */
+    void unsubscribeAll(QObject* context);
+
+    /**
+     * @brief 是否有订阅者（无锁）
+     */
+    bool hasSubscribers(MessageType messageType) const;
+
+    int subscriberCount(MessageType messageType) const;
+
+    /**
+     * @brief 发布一条消息（线程安全，无锁）
+     *
+     * 没有匹配的订阅者时直接返回，不解码载荷。
+     * @param messageType 消息类型
+     * @param functionCode 功能码
+     * @param payload oneof字段内的消息载荷（不含MsgRequestResponse封装）
+     * @return 投递给的订阅者数
+     */
+    int publish(MessageType messageType, FunctionCode functionCode, const QByteArray& payload) {
+        return publish(messageType, functionCode, ScatterSpan(payload));
+    }
+
+    /**
+     * @brief 发布借用接收缓冲区的载荷（线程安全，无锁）
+     *
+     * 载荷可以由两段组成（见ScatterSpan），直接在原缓冲区上解码，回调返回后不再访问。
+     */
+    int publish(MessageType messageType, FunctionCode functionCode, const ScatterSpan& payload);
+
+    /**
+     * @brief 发布已解码的消息结构体（线程安全，无锁）
+     */
+    int publish(MessageType messageType, FunctionCode functionCode, const void* message, size_t size);
+
+    /**
+     * @brief 统计信息
+     */
+    struct Statistics {
+        quint64 published = 0;          // 有订阅者的发布次数
+        quint64 delivered = 0;          // 回调（或投递）次数
+        quint64 decodeErrors = 0;       // 载荷解码失败次数
+    };
+
+    Statistics getStatistics() const;
+    void resetStatistics();
+
+private:
+    using Invoker = std::function<void(const void*)>;
+
+    struct Subscriber {
+        SubscriptionId id = INVALID_SUBSCRIPTION;
+        QObject* context = nullptr;
+        Delivery delivery = Delivery::Direct;
+        quint8 functionCodes = 0;       // FunctionFilter位
+        Invoker invoke;
+    };
+
+    // 发布后只读
+    struct SubscriberList {
+        QVector<Subscriber> subscribers;
+        quint8 functionCodes = 0;       // 所有订阅者的功能码并集
+    };
+
+    SubscriptionId addSubscriber(MessageType messageType, size_t messageSize, QObject* context,
+                                 Delivery delivery, FunctionFilter filter, Invoker invoker);
+    bool removeSubscribers(const std::function<bool(const Subscriber&)>& predicate);
+    void replaceList(int protoId, SubscriberList* list);
+    void reclaimRetired();
+    int dispatch(const SubscriberList* list, quint8 functionCode, const void* message);
+
+    static constexpr int PROTO_ID_COUNT = 256;
+
+    std::atomic<const SubscriberList*> lists_[PROTO_ID_COUNT];
+    std::atomic<int> dispatching_;              // 正在进行的分发数
+
+    mutable QMutex mutex_;                      // 保护以下成员
+    QVector<const SubscriberList*> retired_;    // 已替换、等待释放的列表
+    QHash<QObject*, QMetaObject::Connection> contextConnections_;
+    SubscriptionId nextId_;
+
+    std::atomic<quint64> published_;
+    std::atomic<quint64> delivered_;
+    std::atomic<quint64> decodeErrors_;
+};
+
+} // namespace Protocol
+
+#endif // MESSAGE_BUS_H
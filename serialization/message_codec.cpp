@@ -0,0 +1,499 @@
+#include "message_codec.h"
+#include "varint_kernels.h"
+#include "../state/shadow_state_store.h"
+#include <QDebug>
+
+#include <array>
+
+#ifdef PROTOCOL_HAS_ERNC_CODEC
+#include "serialization/ernc_codec.h"
+#endif
+
+extern "C" {
+#include "../nanopb/pb_common.h"
+#include "../nanopb/pb_decode.h"
+#include "../nanopb/pb_encode.h"
+}
+
+namespace Protocol {
+
+namespace {
+
+using EncodeFunction = size_t (*)(const void* message, uint8_t* out);
+using DecodeFunction = bool (*)(const uint8_t* data, size_t size, void* message);
+
+struct CodecEntry {
+    MessageType type;
+    size_t size;                    // 结构体大小
+    size_t maxEncodedSize;          // 编码长度上界
+    const pb_msgdesc_t* fields;
+    EncodeFunction encode;          // 为空时使用nanopb
+    DecodeFunction decode;
+};
+
+#ifdef PROTOCOL_HAS_ERNC_CODEC
+
+template<typename T>
+size_t encodeMessage(const void* message, uint8_t* out)
+{
+    return ErncCodec::Codec<T>::encode(*static_cast<const T*>(message), out);
+}
+
+template<typename T>
+bool decodeMessage(const uint8_t* data, size_t size, void* message)
+{
+    return ErncCodec::Codec<T>::decode(data, size, *static_cast<T*>(message));
+}
+
+#define CODEC_ENTRY(Struct) \
+    { MessageTraits<Struct>::type, sizeof(Struct), ErncCodec::Codec<Struct>::MAX_ENCODED_SIZE, \
+      Struct##_fields, &encodeMessage<Struct>, &decodeMessage<Struct> }
+
+#else
+
+#define CODEC_ENTRY(Struct) \
+    { MessageTraits<Struct>::type, sizeof(Struct), Struct##_size, Struct##_fields, nullptr, nullptr }
+
+#endif
+
+const CodecEntry CODECS[] = {
+    CODEC_ENTRY(MSG_ChannelNumber),
+    CODEC_ENTRY(MSG_ChannelAmplitude),
+    CODEC_ENTRY(MSG_ChannelSwitch),
+    CODEC_ENTRY(MSG_CheckMod),
+    CODEC_ENTRY(MSG_AncSwitch),
+    CODEC_ENTRY(MSG_VehicleState),
+    CODEC_ENTRY(MSG_TranFuncFlag),
+    CODEC_ENTRY(MSG_TranFuncState),
+    CODEC_ENTRY(MSG_FilterRanges),
+    CODEC_ENTRY(MSG_SystemRanges),
+    CODEC_ENTRY(MSG_OrderFlag),
+    CODEC_ENTRY(MSG_Order2Params),
+    CODEC_ENTRY(MSG_Order4Params),
+    CODEC_ENTRY(MSG_Order6Params),
+    CODEC_ENTRY(MSG_AlphaParams),
+    CODEC_ENTRY(MSG_FreqDivision),
+    CODEC_ENTRY(MSG_Thresholds),
+};
+
+#undef CODEC_ENTRY
+
+constexpr int PROTO_ID_COUNT = 256;
+constexpr int CODEC_COUNT = static_cast<int>(sizeof(CODECS) / sizeof(CODECS[0]));
+
+// 按ProtoID直接索引
+const CodecEntry* findCodec(MessageType messageType)
+{
+    static const std::array<const CodecEntry*, PROTO_ID_COUNT> index = [] {
+        std::array<const CodecEntry*, PROTO_ID_COUNT> table{};
+        for (const CodecEntry& entry : CODECS) {
+            table[static_cast<int>(entry.type)] = &entry;
+        }
+        return table;
+    }();
+
+    const int protoId = static_cast<int>(messageType);
+    return protoId >= 0 && protoId < PROTO_ID_COUNT ? index[protoId] : nullptr;
+}
+
+// 紧凑格式处理的数组字段号上限（ERNC消息的字段号都很小）
+constexpr int MAX_ARRAY_TAG = 31;
+
+// 各消息的fixed_count数组：字段号 -> 元素个数，0表示不是数组
+struct ArrayLayout {
+    quint32 arrayTags = 0;              // 数组字段号的位集合
+    quint16 counts[MAX_ARRAY_TAG + 1] = {};
+};
+
+const ArrayLayout* arrayLayout(const CodecEntry* codec)
+{
+    static const std::array<ArrayLayout, CODEC_COUNT> layouts = [] {
+        std::array<ArrayLayout, CODEC_COUNT> table{};
+        for (int i = 0; i < CODEC_COUNT; ++i) {
+            std::array<char, ShadowStateStore::MAX_MESSAGE_SIZE> probe{};
+            pb_field_iter_t iter;
+            if (!pb_field_iter_begin(&iter, CODECS[i].fields, probe.data())) {
+                continue;
+            }
+            do {
+                if (PB_HTYPE(iter.type) == PB_HTYPE_FIXARRAY && iter.tag <= MAX_ARRAY_TAG) {
+                    table[i].arrayTags |= 1u << iter.tag;
+                    table[i].counts[iter.tag] = static_cast<quint16>(iter.array_size);
+                }
+            } while (pb_field_iter_next(&iter));
+        }
+        return table;
+    }();
+    return &layouts[static_cast<size_t>(codec - CODECS)];
+}
+
+bool readVarint(const uint8_t*& p, const uint8_t* end, quint64& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        const uint8_t byte = *p++;
+        value |= static_cast<quint64>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void appendVarint(QByteArray& out, quint32 value)
+{
+    while (value >= 0x80) {
+        out.append(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.append(static_cast<char>(value));
+}
+
+void appendRaw(QByteArray& out, const uint8_t* begin, const uint8_t* end)
+{
+    out.append(reinterpret_cast<const char*>(begin), static_cast<int>(end - begin));
+}
+
+// 读取长度前缀，fieldEnd指向字段数据末尾
+bool readLength(const uint8_t*& p, const uint8_t* end, const uint8_t*& fieldEnd)
+{
+    quint64 length;
+    if (!readVarint(p, end, length) || length > static_cast<quint64>(end - p)) {
+        return false;
+    }
+    fieldEnd = p + length;
+    return true;
+}
+
+bool skipValue(const uint8_t*& p, const uint8_t* end, quint32 wireType)
+{
+    quint64 value;
+    switch (wireType) {
+    case 0:
+        return readVarint(p, end, value);
+    case 1:
+        if (end - p < 8) {
+            return false;
+        }
+        p += 8;
+        return true;
+    case 2:
+        return readLength(p, end, p);
+    case 5:
+        if (end - p < 4) {
+            return false;
+        }
+        p += 4;
+        return true;
+    default:
+        return false;
+    }
+}
+
+// pb_istream_t回调：从ScatterReader读取，buf为空表示跳过
+bool readScatter(pb_istream_t* stream, pb_byte_t* buf, size_t count)
+{
+    auto* reader = static_cast<ScatterReader*>(stream->state);
+    if (!buf) {
+        return reader->skip(static_cast<int>(count));
+    }
+    return reader->read(reinterpret_cast<char*>(buf), static_cast<int>(count));
+}
+
+} // namespace
+
+bool MessageCodec::isSpecialized() {
+#ifdef PROTOCOL_HAS_ERNC_CODEC
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool MessageCodec::supports(MessageType messageType) {
+    return findCodec(messageType) != nullptr;
+}
+
+size_t MessageCodec::maxEncodedSize(MessageType messageType) {
+    const CodecEntry* codec = findCodec(messageType);
+    return codec ? codec->maxEncodedSize : 0;
+}
+
+bool MessageCodec::encode(MessageType messageType, const void* message, size_t size, QByteArray& payload) {
+    const CodecEntry* codec = findCodec(messageType);
+    if (!codec || !message || size != codec->size) {
+        payload.clear();
+        return false;
+    }
+
+    payload.resize(static_cast<int>(codec->maxEncodedSize));
+    auto* out = reinterpret_cast<uint8_t*>(payload.data());
+
+    size_t written = 0;
+    if (codec->encode) {
+        written = codec->encode(message, out);
+    } else {
+        pb_ostream_t stream = pb_ostream_from_buffer(out, codec->maxEncodedSize);
+        if (!pb_encode(&stream, codec->fields, message)) {
+            qDebug() << "nanopb encode failed for" << MessageTypeUtils::toString(messageType)
+                     << ":" << PB_GET_ERROR(&stream);
+            payload.clear();
+            return false;
+        }
+        written = stream.bytes_written;
+    }
+
+    // 缩短不释放缓冲区，written为0时payload仍非null，调用方据此区分全默认值消息和编码失败
+    payload.resize(static_cast<int>(written));
+    return true;
+}
+
+bool MessageCodec::decode(MessageType messageType, const char* data, size_t dataSize, void* message, size_t size) {
+    const CodecEntry* codec = findCodec(messageType);
+    if (!codec || !message || size != codec->size || (!data && dataSize > 0)) {
+        return false;
+    }
+
+    const auto* in = reinterpret_cast<const uint8_t*>(data);
+    if (codec->decode) {
+        return codec->decode(in, dataSize, message);
+    }
+
+    pb_istream_t stream = pb_istream_from_buffer(in, dataSize);
+    if (!pb_decode(&stream, codec->fields, message)) {
+        qDebug() << "nanopb decode failed for" << MessageTypeUtils::toString(messageType)
+                 << ":" << PB_GET_ERROR(&stream);
+        return false;
+    }
+    return true;
+}
+
+bool MessageCodec::decode(MessageType messageType, const ScatterSpan& payload, void* message, size_t size) {
+    if (payload.isContiguous()) {
+        return decode(messageType, payload.first(), static_cast<size_t>(payload.size()), message, size);
+    }
+
+    const CodecEntry* codec = findCodec(messageType);
+    if (!codec || !message || size != codec->size) {
+        return false;
+    }
+
+    // 生成的解码函数只接受连续输入，跨段的载荷统一由nanopb按段读取
+    ScatterReader reader(payload);
+    pb_istream_t stream = {};
+    stream.callback = &readScatter;
+    stream.state = &reader;
+    stream.bytes_left = static_cast<size_t>(payload.size());
+    if (!pb_decode(&stream, codec->fields, message)) {
+        qDebug() << "nanopb decode failed for" << MessageTypeUtils::toString(messageType)
+                 << ":" << PB_GET_ERROR(&stream);
+        return false;
+    }
+    return true;
+}
+
+bool MessageCodec::compactArrays(MessageType messageType, const QByteArray& payload, QByteArray& compact) {
+    const CodecEntry* codec = findCodec(messageType);
+    if (!codec) {
+        compact = payload;
+        return true;
+    }
+
+    const ArrayLayout* layout = arrayLayout(codec);
+    const auto* p = reinterpret_cast<const uint8_t*>(payload.constData());
+    const uint8_t* const end = p + payload.size();
+
+    QByteArray out;
+    out.reserve(payload.size());
+    bool modified = false;
+
+    while (p < end) {
+        const uint8_t* fieldStart = p;
+        quint64 key;
+        if (!readVarint(p, end, key)) {
+            return false;
+        }
+        const quint32 wireType = static_cast<quint32>(key & 0x07);
+        const quint64 tag = key >> 3;
+
+        if (wireType == 2 && tag <= MAX_ARRAY_TAG && (layout->arrayTags & (1u << tag))) {
+            const uint8_t* keyEnd = p;
+            const uint8_t* packedEnd;
+            if (!readLength(p, end, packedEnd)) {
+                return false;
+            }
+
+            // 找到最后一个非零元素的末尾
+            const uint8_t* packedStart = p;
+            const uint8_t* keep = packedStart;
+            while (p < packedEnd) {
+                quint64 value;
+                if (!readVarint(p, packedEnd, value)) {
+                    return false;
+                }
+                if (value != 0) {
+                    keep = p;
+                }
+            }
+
+            if (keep == packedEnd) {
+                appendRaw(out, fieldStart, packedEnd);
+                continue;
+            }
+
+            modified = true;
+            if (keep != packedStart) {
+                appendRaw(out, fieldStart, keyEnd);
+                appendVarint(out, static_cast<quint32>(keep - packedStart));
+                appendRaw(out, packedStart, keep);
+            }
+            continue;
+        }
+
+        if (!skipValue(p, end, wireType)) {
+            return false;
+        }
+        appendRaw(out, fieldStart, p);
+    }
+
+    compact = modified ? out : payload;
+    return true;
+}
+
+bool MessageCodec::hasFixedArrays(MessageType messageType) {
+    const CodecEntry* codec = findCodec(messageType);
+    return codec && arrayLayout(codec)->arrayTags != 0;
+}
+
+bool MessageCodec::expandArrays(MessageType messageType, const QByteArray& payload, QByteArray& expanded) {
+    const CodecEntry* codec = findCodec(messageType);
+    if (!codec) {
+        expanded = payload;
+        return true;
+    }
+
+    const ArrayLayout* layout = arrayLayout(codec);
+    const auto* p = reinterpret_cast<const uint8_t*>(payload.constData());
+    const uint8_t* const end = p + payload.size();
+
+    QByteArray out;
+    quint32 seenTags = 0;
+    bool modified = false;
+
+    while (p < end) {
+        const uint8_t* fieldStart = p;
+        quint64 key;
+        if (!readVarint(p, end, key)) {
+            return false;
+        }
+        const quint32 wireType = static_cast<quint32>(key & 0x07);
+        const quint64 tag = key >> 3;
+        const bool isArray = tag <= MAX_ARRAY_TAG && (layout->arrayTags & (1u << tag));
+
+        if (isArray) {
+            seenTags |= 1u << tag;
+        }
+
+        if (isArray && wireType == 2) {
+            const uint8_t* keyEnd = p;
+            const uint8_t* packedEnd;
+            if (!readLength(p, end, packedEnd)) {
+                return false;
+            }
+
+            const uint8_t* packedStart = p;
+            size_t count = 0;
+            if (!PackedVarint::count(packedStart, static_cast<size_t>(packedEnd - packedStart), count)) {
+                return false;
+            }
+            p = packedEnd;
+
+            const quint32 arraySize = layout->counts[tag];
+            if (count > arraySize) {
+                return false;
+            }
+            if (count == arraySize) {
+                appendRaw(out, fieldStart, packedEnd);
+                continue;
+            }
+
+            // 补齐末尾省略的0（每个0占一个字节）
+            modified = true;
+            appendRaw(out, fieldStart, keyEnd);
+            appendVarint(out, static_cast<quint32>(static_cast<size_t>(packedEnd - packedStart) + arraySize - count));
+            appendRaw(out, packedStart, packedEnd);
+            out.append(QByteArray(static_cast<int>(arraySize - count), '\0'));
+            continue;
+        }
+
+        if (!skipValue(p, end, wireType)) {
+            return false;
+        }
+        appendRaw(out, fieldStart, p);
+    }
+
+    // 省略的全零数组
+    const quint32 missingTags = layout->arrayTags & ~seenTags;
+    if (missingTags) {
+        modified = true;
+        for (quint32 tag = 1; tag <= MAX_ARRAY_TAG; ++tag) {
+            if (missingTags & (1u << tag)) {
+                appendVarint(out, (tag << 3) | 2);
+                appendVarint(out, layout->counts[tag]);
+                out.append(QByteArray(static_cast<int>(layout->counts[tag]), '\0'));
+            }
+        }
+    }
+
+    expanded = modified ? out : payload;
+    return true;
+}
+
+bool MessageCodec::isStandardLayout(MessageType messageType, const char* data, int size) {
+    const CodecEntry* codec = findCodec(messageType);
+    if (!codec) {
+        return true;
+    }
+
+    const ArrayLayout* layout = arrayLayout(codec);
+    const auto* p = reinterpret_cast<const uint8_t*>(data);
+    const uint8_t* const end = p + size;
+    quint32 seenTags = 0;
+
+    while (p < end) {
+        quint64 key;
+        if (!readVarint(p, end, key)) {
+            return false;
+        }
+        const quint32 wireType = static_cast<quint32>(key & 0x07);
+        const quint64 tag = key >> 3;
+        const bool isArray = tag <= MAX_ARRAY_TAG && (layout->arrayTags & (1u << tag));
+
+        if (isArray) {
+            seenTags |= 1u << tag;
+        }
+
+        if (isArray && wireType == 2) {
+            const uint8_t* packedEnd;
+            if (!readLength(p, end, packedEnd)) {
+                return false;
+            }
+
+            size_t count = 0;
+            if (!PackedVarint::count(p, static_cast<size_t>(packedEnd - p), count)
+                || count != layout->counts[tag]) {
+                return false;
+            }
+            p = packedEnd;
+            continue;
+        }
+
+        if (!skipValue(p, end, wireType)) {
+            return false;
+        }
+    }
+
+    return (layout->arrayTags & ~seenTags) == 0;
+}
+
+} // namespace Protocol
@@ -0,0 +1,150 @@
+#ifndef MESSAGE_CODEC_H
+#define MESSAGE_CODEC_H
+
+#include <QByteArray>
+#include <cstddef>
+#include <type_traits>
+#include "../core/message_types.h"
+#include "scatter_span.h"
+
+extern "C" {
+#include "../nanopb/pb.h"
+#include "../messages/ERNC_praram.pb.h"
+}
+
+namespace Protocol {
+
+/**
+ * @brief nanopb消息结构体到消息类型的对应关系
+ */
+template<typename T>
+struct MessageTraits;
+
+#define PROTOCOL_MESSAGE_TRAITS(Struct, Type) \
+    template<> \
+    struct MessageTraits<Struct> { \
+        static constexpr MessageType type = MessageType::Type; \
+    };
+
+PROTOCOL_MESSAGE_TRAITS(MSG_ChannelNumber,    CHANNEL_NUMBER)
+PROTOCOL_MESSAGE_TRAITS(MSG_ChannelAmplitude, CHANNEL_AMPLITUDE)
+PROTOCOL_MESSAGE_TRAITS(MSG_ChannelSwitch,    CHANNEL_SWITCH)
+PROTOCOL_MESSAGE_TRAITS(MSG_CheckMod,         CHECK_MOD)
+PROTOCOL_MESSAGE_TRAITS(MSG_AncSwitch,        ANC_SWITCH)
+PROTOCOL_MESSAGE_TRAITS(MSG_VehicleState,     VEHICLE_STATE)
+PROTOCOL_MESSAGE_TRAITS(MSG_TranFuncFlag,     TRAN_FUNC_FLAG)
+PROTOCOL_MESSAGE_TRAITS(MSG_TranFuncState,    TRAN_FUNC_STATE)
+PROTOCOL_MESSAGE_TRAITS(MSG_FilterRanges,     FILTER_RANGES)
+PROTOCOL_MESSAGE_TRAITS(MSG_SystemRanges,     SYSTEM_RANGES)
+PROTOCOL_MESSAGE_TRAITS(MSG_OrderFlag,        ORDER_FLAG)
+PROTOCOL_MESSAGE_TRAITS(MSG_Order2Params,     ORDER2_PARAMS)
+PROTOCOL_MESSAGE_TRAITS(MSG_Order4Params,     ORDER4_PARAMS)
+PROTOCOL_MESSAGE_TRAITS(MSG_Order6Params,     ORDER6_PARAMS)
+PROTOCOL_MESSAGE_TRAITS(MSG_AlphaParams,      ALPHA_PARAMS)
+PROTOCOL_MESSAGE_TRAITS(MSG_FreqDivision,     FREQ_DIVISION)
+PROTOCOL_MESSAGE_TRAITS(MSG_Thresholds,       THRESHOLDS)
+
+#undef PROTOCOL_MESSAGE_TRAITS
+
+/**
+ * @brief ERNC消息载荷编解码
+ *
+ * 构建时由cmake/generate_ernc_codec.py根据ERNC_praram.proto为每种消息生成直线式的编码/解码函数，
+ * 字段标签和数组长度在编译期确定，不再经过nanopb的通用字段迭代器；线格式与nanopb完全一致。
+ * 没有Python3（PROTOCOL_GENERATE_ERNC_CODEC关闭）时退回pb_encode/pb_decode，接口不变。
+ *
+ * 载荷为oneof字段内的消息（不含MsgRequestResponse封装），封装仍由nanopb处理。
+ */
+class MessageCodec {
+public:
+    /**
+     * @brief 是否使用生成的专用编解码
+     */
+    static bool isSpecialized();
+
+    /**
+     * @brief 是否支持该消息类型
+     */
+    static bool supports(MessageType messageType);
+
+    /**
+     * @brief 编码结果的长度上界，不支持的类型返回0
+     */
+    static size_t maxEncodedSize(MessageType messageType);
+
+    /**
+     * @brief 编码消息结构体
+     * @param messageType 消息类型
+     * @param message 对应的MSG_*结构体
+     * @param size 结构体大小（用于校验）
+     * @param payload 输出的消息载荷，全部字段为默认值时为非null的空数组；失败时为null数组
+     * @return 成功返回true
+     */
+    static bool encode(MessageType messageType, const void* message, size_t size, QByteArray& payload);
+
+    /**
+     * @brief 解码消息载荷到结构体（先清零）
+     */
+    static bool decode(MessageType messageType, const char* data, size_t dataSize, void* message, size_t size);
+
+    static bool decode(MessageType messageType, const QByteArray& payload, void* message, size_t size) {
+        return decode(messageType, payload.constData(), static_cast<size_t>(payload.size()), message, size);
+    }
+
+    /**
+     * @brief 就地解码由两段组成的载荷（如接收环回绕处的帧）
+     *
+     * 连续的载荷与上面的重载相同；不连续时用按段读取的pb_istream_t交给nanopb解码，不拼接载荷。
+     * 载荷须为标准格式（紧凑格式先经expandArrays()还原）。
+     */
+    static bool decode(MessageType messageType, const ScatterSpan& payload, void* message, size_t size);
+
+    template<typename T>
+    static bool encode(const T& message, QByteArray& payload) {
+        static_assert(std::is_trivially_copyable<T>::value, "codec works on nanopb message structs");
+        return encode(MessageTraits<T>::type, &message, sizeof(T), payload);
+    }
+
+    template<typename T>
+    static bool decode(const QByteArray& payload, T& message) {
+        static_assert(std::is_trivially_copyable<T>::value, "codec works on nanopb message structs");
+        return decode(MessageTraits<T>::type, payload, &message, sizeof(T));
+    }
+
+    template<typename T>
+    static bool decode(const ScatterSpan& payload, T& message) {
+        static_assert(std::is_trivially_copyable<T>::value, "codec works on nanopb message structs");
+        return decode(MessageTraits<T>::type, payload, &message, sizeof(T));
+    }
+
+    /**
+     * @brief 消息是否含有fixed_count数组（只有这类消息存在紧凑格式）
+     */
+    static bool hasFixedArrays(MessageType messageType);
+
+    /**
+     * @brief v2数组紧凑格式
+     *
+     * 标准格式中fixed_count数组总是完整编码（packed），全零的数组也要占用标签、长度和每个元素一个字节。
+     * 紧凑格式去掉数组末尾的0，全零的数组整个省略，其他字段不变。nanopb解码器要求数组长度固定，
+     * 紧凑格式只能在双方协商支持（ProtocolPackager::CAPABILITY_COMPACT_ARRAYS）后使用。
+     *
+     * compactArrays()把标准格式转换为紧凑格式；expandArrays()补齐数组得到标准格式，
+     * 输入已是标准格式时原样返回。不支持的消息类型原样返回。
+     * @return 载荷格式错误返回false
+     */
+    static bool compactArrays(MessageType messageType, const QByteArray& payload, QByteArray& compact);
+    static bool expandArrays(MessageType messageType, const QByteArray& payload, QByteArray& expanded);
+
+    /**
+     * @brief 载荷是否已是标准格式（所有数组完整出现，expandArrays()会原样返回）
+     *
+     * 只扫描不输出，供接收路径判断能否跳过还原、直接就地解码。
+     * @return 需要还原或格式错误返回false
+     */
+    static bool isStandardLayout(MessageType messageType, const char* data, int size);
+};
+
+} // namespace Protocol
+
+#endif // MESSAGE_CODEC_H
@@ -4,6 +4,7 @@
 #include "../handlers/alpha_message_handler.h"
 #include "../handlers/vehicle_message_handler.h"
 #include "../handlers/channel_message_handler.h"
+#include "../handlers/realtime_data_handler.h"
 #include <QDebug>
 
 namespace Protocol {
@@ -76,12 +77,16 @@ void MessageFactory::initializeDefaultHandlers() {
     auto channelSwitchHandler = std::make_shared<ChannelMessageHandler>(ChannelMessageHandler::ChannelMessageSubType::CHANNEL_SWITCH);
     registerHandler(MessageType::CHANNEL_SWITCH, channelSwitchHandler);
 
+    // 注册实时数据处理器（GRAPH_DATA实时数据帧）
+    auto realtimeHandler = std::make_shared<RealtimeDataHandler>();
+    registerHandler(MessageType::GRAPH_DATA, realtimeHandler);
+
     // TODO: 可以根据需要添加更多处理器
     // - TRAN_FUNC_FLAG, TRAN_FUNC_STATE (传函标定)
     // - FILTER_RANGES, SYSTEM_RANGES (系统配置)
     // - ORDER_FLAG, ORDER2_PARAMS, ORDER4_PARAMS, ORDER6_PARAMS (ENC标定)
     // - FREQ_DIVISION, THRESHOLDS (RNC其他参数)
-    // - CHECK_MOD, GRAPH_DATA (数据流控制)
+    // - CHECK_MOD (数据流控制)
 
     qInfo() << "ERNC Protocol message handlers initialized:" << handlers_.size() << "handlers";
     qInfo() << "Supported message types:";
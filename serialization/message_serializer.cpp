@@ -1,5 +1,10 @@
 #include "message_serializer.h"
 #include "protocol_packager.h"
+#include "message_bus.h"
+#include "message_codec.h"
+#include "../handlers/realtime_data_handler.h"
+#include "../state/shadow_state_store.h"
+#include "../state/time_series_store.h"
 #include <QDebug>
 
 namespace Protocol {
@@ -8,6 +13,13 @@ MessageSerializer::MessageSerializer(QObject* parent)
     : QObject(parent)
     , messageFactory_(std::make_shared<MessageFactory>())
     , protocolPackager_(std::make_unique<ProtocolPackager>())
+    , shadowState_(nullptr)
+    , timeSeries_(nullptr)
+    , messageBus_(nullptr)
+    , localCapabilities_(ProtocolPackager::CAPABILITY_COMPACT_ARRAYS | ProtocolPackager::CAPABILITY_BATCH
+                         | ProtocolPackager::CAPABILITY_GRAPH_DATA)
+    , peerCapabilities_(0)
+    , negotiated_(false)
 {
     qDebug() << "MessageSerializer initialized";
 }
@@ -34,8 +46,9 @@ QByteArray MessageSerializer::serialize(MessageType messageType, const QVariantM
     }
 
     // 执行序列化
+    // 全部字段为默认值时编码为空，失败时返回null数组
     QByteArray result = handler->serialize(parameters);
-    bool success = !result.isEmpty();
+    bool success = !result.isNull();
 
     if (success) {
         qDebug() << "Message serialized successfully. Type:" << static_cast<int>(messageType)
@@ -52,14 +65,7 @@ QByteArray MessageSerializer::serialize(MessageType messageType, const QVariantM
 }
 
 bool MessageSerializer::deserialize(MessageType messageType, const QByteArray& data, QVariantMap& parameters) {
-    if (data.isEmpty()) {
-        QString error = "Cannot deserialize empty data";
-        qWarning() << error;
-        emit serializationError(messageType, error);
-        recordStatistics(messageType, "deserialize", false, 0);
-        return false;
-    }
-
+    // 空载荷表示全部字段为默认值，交给处理器解码
     auto handler = messageFactory_->getHandler(messageType);
     if (!handler) {
         QString error = QString("No handler found for message type: %1").arg(static_cast<int>(messageType));
@@ -87,6 +93,16 @@ bool MessageSerializer::deserialize(MessageType messageType, const QByteArray& d
     return success;
 }
 
+bool MessageSerializer::decodeParameters(MessageType messageType, const QByteArray& data, QVariantMap& parameters) const {
+    parameters.clear();
+    if (data.isEmpty()) {
+        return true;
+    }
+
+    auto handler = messageFactory_->getHandler(messageType);
+    return handler ? handler->deserialize(data, parameters) : false;
+}
+
 bool MessageSerializer::isMessageTypeSupported(MessageType messageType) const {
     return messageFactory_->isSupported(messageType);
 }
@@ -122,7 +138,7 @@ QByteArray MessageSerializer::serialize(MessageType messageType, const QVariantM
     // 首先使用原有方法序列化具体消息
     QByteArray payloadData = serialize(messageType, parameters);
 
-    if (payloadData.isEmpty()) {
+    if (payloadData.isNull()) {
         qWarning() << "Failed to serialize payload for message type:" << static_cast<int>(messageType);
         return QByteArray();
     }
@@ -132,8 +148,8 @@ QByteArray MessageSerializer::serialize(MessageType messageType, const QVariantM
         return payloadData;
     }
 
-    // 使用协议封装器包装成完整的MsgRequestResponse格式
-    QByteArray result = protocolPackager_->packageMessage(messageType, functionCode, payloadData);
+    // 包装成完整的MsgRequestResponse格式
+    QByteArray result = package(messageType, functionCode, payloadData);
 
     if (result.isEmpty()) {
         QString error = QString("Protocol packaging failed for message type: %1").arg(static_cast<int>(messageType));
@@ -160,30 +176,169 @@ bool MessageSerializer::deserialize(const QByteArray& data, MessageType& message
         return false;
     }
 
-    // 使用协议封装器解包MsgRequestResponse格式
-    QByteArray payloadData;
-    if (!protocolPackager_->unpackageMessage(data, messageType, functionCode, payloadData)) {
-        QString error = "Failed to unpackage MsgRequestResponse format";
-        qWarning() << error;
-        emit serializationError(messageType, error);
-        recordStatistics(messageType, "deserialize", false, data.size());
+    return receive(ScatterSpan(data), messageType, functionCode, &parameters);
+}
+
+bool MessageSerializer::receive(const ScatterSpan& envelope, MessageType& messageType, FunctionCode& functionCode,
+                                QVariantMap* parameters) {
+    ScatterSpan payload;
+    quint32 capabilities = 0;
+    if (!ProtocolPackager::unpackEnvelope(envelope, messageType, functionCode, payload, &capabilities)) {
+        qWarning() << "Failed to unpackage MsgRequestResponse format, size:" << envelope.size();
         return false;
     }
 
-    // 使用原有方法反序列化具体消息
-    bool success = deserialize(messageType, payloadData, parameters);
+    updateNegotiation(functionCode, capabilities);
+
+    // 只有双方协商了紧凑格式，对端才会发送v2载荷：只有含数组的消息需要还原为标准格式，
+    // 已是标准格式的连续载荷仍就地解码（环回绕处的载荷先拼接一次）
+    QByteArray expanded;
+    if ((negotiatedCapabilities() & ProtocolPackager::CAPABILITY_COMPACT_ARRAYS)
+        && MessageCodec::hasFixedArrays(messageType)
+        && !(payload.isContiguous()
+             && MessageCodec::isStandardLayout(messageType, payload.first(), payload.size()))) {
+        if (!MessageCodec::expandArrays(messageType, payload.toByteArray(), expanded)) {
+            QString error = "Malformed compact payload";
+            qWarning() << error << "for message type:" << static_cast<int>(messageType);
+            emit serializationError(messageType, error);
+            recordStatistics(messageType, "deserialize", false, envelope.size());
+            return false;
+        }
+        payload = ScatterSpan(expanded);
+    }
+
+    // 实时数据帧：列式解码一次，直接写入时间序列，参数映射只为需要它的调用方构造
+    if (messageType == MessageType::GRAPH_DATA) {
+        // 字段22只在协商了实时数据帧能力后才有定义
+        if (!(negotiatedCapabilities() & ProtocolPackager::CAPABILITY_GRAPH_DATA)) {
+            QString error = "Realtime data frame without negotiated capability";
+            qWarning() << error;
+            emit serializationError(messageType, error);
+            recordStatistics(messageType, "deserialize", false, envelope.size());
+            return false;
+        }
+        return receiveRealtime(payload, parameters, envelope.size());
+    }
+
+    // 参数映射只为需要它的调用方构造
+    bool success = true;
+    if (parameters) {
+        parameters->clear();
+        auto handler = messageFactory_->getHandler(messageType);
+        success = handler && handler->deserialize(payload.toByteArray(), *parameters);
+        if (!success) {
+            QString error = QString("Deserialization failed for message type: %1").arg(static_cast<int>(messageType));
+            qWarning() << error;
+            emit serializationError(messageType, error);
+        }
+    }
+
+    // 影子状态、时间序列和总线各自直接从载荷解码
+    if (shadowState_ && ShadowStateStore::isTracked(messageType)) {
+        shadowState_->update(messageType, payload);
+    }
+
+    if (timeSeries_) {
+        timeSeries_->record(messageType, payload, TimeSeriesStore::now());
+    }
+
+    if (messageBus_) {
+        messageBus_->publish(messageType, functionCode, payload);
+    }
 
     if (success) {
+        const int parameterCount = parameters ? parameters->size() : 0;
         qDebug() << "Message unpackaged and deserialized successfully. Type:" << static_cast<int>(messageType)
                  << "FunCode:" << static_cast<int>(functionCode)
-                 << "Parameters:" << parameters.size();
-        emit deserializationCompleted(messageType, true, parameters.size());
+                 << "Parameters:" << parameterCount;
+        emit deserializationCompleted(messageType, true, parameterCount);
     }
 
-    recordStatistics(messageType, "deserialize", success, data.size());
+    recordStatistics(messageType, "deserialize", success, envelope.size());
     return success;
 }
 
+bool MessageSerializer::receiveRealtime(const ScatterSpan& payload, QVariantMap* parameters, int dataSize) {
+    RealtimeFrame frame;
+    if (!RealtimeDataHandler::decode(payload, frame)) {
+        QString error = "Malformed realtime data frame";
+        qWarning() << error;
+        emit serializationError(MessageType::GRAPH_DATA, error);
+        recordStatistics(MessageType::GRAPH_DATA, "deserialize", false, dataSize);
+        return false;
+    }
+
+    if (timeSeries_) {
+        timeSeries_->append(frame, TimeSeriesStore::now());
+    }
+
+    if (parameters) {
+        parameters->clear();
+        RealtimeDataHandler::toParameters(frame, *parameters);
+        emit deserializationCompleted(MessageType::GRAPH_DATA, true, parameters->size());
+    }
+
+    recordStatistics(MessageType::GRAPH_DATA, "deserialize", true, dataSize);
+    return true;
+}
+
+QByteArray MessageSerializer::package(MessageType messageType, FunctionCode functionCode, const QByteArray& payload) {
+    if (messageType == MessageType::GRAPH_DATA
+        && !(negotiatedCapabilities() & ProtocolPackager::CAPABILITY_GRAPH_DATA)) {
+        QString error = "Realtime data frame without negotiated capability";
+        qWarning() << error;
+        emit serializationError(messageType, error);
+        return QByteArray();
+    }
+
+    QByteArray wirePayload = payload;
+    if ((negotiatedCapabilities() & ProtocolPackager::CAPABILITY_COMPACT_ARRAYS)
+        && !MessageCodec::compactArrays(messageType, payload, wirePayload)) {
+        // 无法转换时发送标准格式，对端同样能解析
+        wirePayload = payload;
+    }
+
+    return protocolPackager_->packageMessage(messageType, functionCode, wirePayload,
+                                             negotiated_ ? 0 : localCapabilities_);
+}
+
+QByteArray MessageSerializer::packageReadRequest(MessageType messageType) {
+    return protocolPackager_->packageReadRequest(messageType, negotiated_ ? 0 : localCapabilities_);
+}
+
+void MessageSerializer::setLocalCapabilities(quint32 capabilities) {
+    if (localCapabilities_ == capabilities) {
+        return;
+    }
+
+    localCapabilities_ = capabilities;
+    resetNegotiation();
+}
+
+void MessageSerializer::resetNegotiation() {
+    peerCapabilities_ = 0;
+    negotiated_ = false;
+}
+
+void MessageSerializer::updateNegotiation(FunctionCode functionCode, quint32 capabilities) {
+    if (capabilities != 0) {
+        if (negotiated_ && peerCapabilities_ == capabilities) {
+            return;
+        }
+        peerCapabilities_ = capabilities;
+    } else if (negotiated_ || functionCode != FunctionCode::RESPONSE || localCapabilities_ == 0) {
+        return;
+    } else {
+        // 对端应答了本端的通告却没有携带能力字段：旧版设备
+        peerCapabilities_ = 0;
+    }
+
+    negotiated_ = true;
+    qInfo() << "Capabilities negotiated. Local:" << localCapabilities_
+            << "Peer:" << peerCapabilities_ << "Common:" << negotiatedCapabilities();
+    emit capabilitiesNegotiated(negotiatedCapabilities());
+}
+
 void MessageSerializer::recordStatistics(MessageType messageType, const QString& operation, bool success, int dataSize) {
     auto& stats = statistics_[messageType];
 
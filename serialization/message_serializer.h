@@ -7,9 +7,14 @@
 #include <memory>
 #include "../core/message_types.h"
 #include "message_factory.h"
+#include "scatter_span.h"
 
 namespace Protocol {
 
+class ShadowStateStore;
+class TimeSeriesStore;
+class MessageBus;
+
 /**
  * @brief 消息序列化器
  *
@@ -27,7 +32,7 @@ public:
      * @brief 序列化参数到字节数组
      * @param messageType 消息类型
      * @param parameters 参数映射
-     * @return 序列化后的字节数组，失败返回空数组
+     * @return 序列化后的字节数组，全部字段为默认值时为空（非null）数组，失败返回null数组（QByteArray()）
      */
     QByteArray serialize(MessageType messageType, const QVariantMap& parameters);
 
@@ -50,6 +55,17 @@ public:
      */
     bool deserialize(MessageType messageType, const QByteArray& data, QVariantMap& parameters);
 
+    /**
+     * @brief 把消息载荷解码为参数映射，不触发信号和统计
+     *
+     * 用于内部状态转换（例如从影子状态构建读-改-写的完整参数），空载荷表示所有字段均为默认值。
+     * @param messageType 消息类型
+     * @param data 消息载荷
+     * @param parameters 输出参数映射
+     * @return 成功返回true，失败返回false
+     */
+    bool decodeParameters(MessageType messageType, const QByteArray& data, QVariantMap& parameters) const;
+
     /**
      * @brief 从完整的MsgRequestResponse格式反序列化参数
      * @param data MsgRequestResponse格式的字节数组
@@ -60,6 +76,22 @@ public:
      */
     bool deserialize(const QByteArray& data, MessageType& messageType, FunctionCode& functionCode, QVariantMap& parameters);
 
+    /**
+     * @brief 就地处理接收缓冲区中的一条MsgRequestResponse
+     *
+     * 直接在借用的视图上解包和解码：更新协商状态、影子状态和时间序列，并把载荷发布到消息总线，
+     * 不构造中间QByteArray。例外：已协商紧凑格式且含数组的消息，载荷确实省略了数组元素
+     * （或跨环回绕处）时先拷贝还原为标准格式；参数映射只在需要时构造，处理器的反序列化接口
+     * 以QByteArray为输入，此时另拷贝一次载荷。
+     * @param envelope MsgRequestResponse数据，可以由两段组成，调用返回后不再访问
+     * @param messageType 输出：解析出的消息类型
+     * @param functionCode 输出：解析出的功能码
+     * @param parameters 输出（可选）：参数映射，为空时不经过参数处理器
+     * @return 解包成功且（需要时）参数解码成功返回true
+     */
+    bool receive(const ScatterSpan& envelope, MessageType& messageType, FunctionCode& functionCode,
+                 QVariantMap* parameters = nullptr);
+
     /**
      * @brief 检查是否支持某种消息类型
      * @param messageType 消息类型
@@ -96,6 +128,67 @@ public:
      */
     bool registerCustomHandler(MessageType messageType, std::shared_ptr<IMessageHandler> handler);
 
+    /**
+     * @brief 设置影子状态存储
+     *
+     * 设置后，MsgRequestResponse格式的数据解码成功时同时更新影子状态。存储由调用方持有。
+     * @param store 影子状态存储，为空表示不更新
+     */
+    void setShadowStateStore(ShadowStateStore* store) { shadowState_ = store; }
+    ShadowStateStore* shadowStateStore() const { return shadowState_; }
+
+    /**
+     * @brief 设置时间序列存储
+     *
+     * 设置后，通道幅值和GRAPH_DATA实时数据帧解码成功时同时写入时间序列存储。存储由调用方持有，
+     * 只能在同一个线程中反序列化。
+     * @param store 时间序列存储，为空表示不写入
+     */
+    void setTimeSeriesStore(TimeSeriesStore* store) { timeSeries_ = store; }
+    TimeSeriesStore* timeSeriesStore() const { return timeSeries_; }
+
+    /**
+     * @brief 设置消息总线
+     *
+     * 设置后，MsgRequestResponse格式的数据解包成功时把消息载荷发布到总线，
+     * 由总线按ProtoID投递给订阅者（不依赖参数处理器是否支持该消息）。总线由调用方持有。
+     * @param bus 消息总线，为空表示不发布
+     */
+    void setMessageBus(MessageBus* bus) { messageBus_ = bus; }
+    MessageBus* messageBus() const { return messageBus_; }
+
+    /**
+     * @brief 把消息载荷封装为MsgRequestResponse格式
+     *
+     * 协商完成且双方都支持紧凑数组时先转换为v2紧凑格式；协商完成前在封装中通告本端能力。
+     * @param messageType 消息类型
+     * @param functionCode 功能码
+     * @param payload 标准格式的消息载荷
+     * @return 完整的MsgRequestResponse字节数组，失败返回空数组
+     */
+    QByteArray package(MessageType messageType, FunctionCode functionCode, const QByteArray& payload);
+
+    /**
+     * @brief 封装回读请求（不带载荷字段的REQUEST，见ProtocolPackager::packageReadRequest()）
+     * @param messageType 要回读的消息类型
+     * @return 完整的MsgRequestResponse字节数组，失败返回空数组
+     */
+    QByteArray packageReadRequest(MessageType messageType);
+
+    /**
+     * @brief 能力协商
+     *
+     * 本端在协商完成前发送的每一帧都携带能力字段。收到带能力字段的帧即完成协商；
+     * 协商期间收到不带能力字段的应答，说明对端是旧版设备，按无能力完成协商。
+     * 连接重新建立时应调用resetNegotiation()。
+     */
+    void setLocalCapabilities(quint32 capabilities);
+    quint32 localCapabilities() const { return localCapabilities_; }
+    quint32 peerCapabilities() const { return peerCapabilities_; }
+    quint32 negotiatedCapabilities() const { return negotiated_ ? (localCapabilities_ & peerCapabilities_) : 0; }
+    bool isNegotiated() const { return negotiated_; }
+    void resetNegotiation();
+
 signals:
     /**
      * @brief 序列化完成信号
@@ -120,7 +213,28 @@ signals:
      */
     void serializationError(MessageType messageType, const QString& errorMessage);
 
+    /**
+     * @brief 能力协商完成信号
+     * @param capabilities 双方共同支持的能力位
+     */
+    void capabilitiesNegotiated(quint32 capabilities);
+
 private:
+    /**
+     * @brief 根据收到的帧更新协商状态
+     * @param functionCode 帧的功能码
+     * @param capabilities 帧携带的能力位，未携带时为0
+     */
+    void updateNegotiation(FunctionCode functionCode, quint32 capabilities);
+
+    /**
+     * @brief 处理GRAPH_DATA实时数据帧
+     *
+     * 按RealtimeDataHandler::decode()列式解码后写入时间序列，参数映射只在需要时由帧转换得到。
+     * @param dataSize 整条消息的大小（用于统计）
+     */
+    bool receiveRealtime(const ScatterSpan& payload, QVariantMap* parameters, int dataSize);
+
     /**
      * @brief 记录操作统计信息
      * @param messageType 消息类型
@@ -133,6 +247,14 @@ private:
 private:
     std::shared_ptr<MessageFactory> messageFactory_;
     std::unique_ptr<class ProtocolPackager> protocolPackager_;
+    ShadowStateStore* shadowState_;
+    TimeSeriesStore* timeSeries_;
+    MessageBus* messageBus_;
+
+    // 能力协商状态
+    quint32 localCapabilities_;
+    quint32 peerCapabilities_;
+    bool negotiated_;
 
     // 统计信息
     struct Statistics {
@@ -4,7 +4,50 @@
 
 namespace Protocol {
 
-QByteArray ProtocolPackager::packageMessage(MessageType messageType, FunctionCode functionCode, const QByteArray& payloadData) {
+// 常量定义
+const int ProtocolPackager::CAPABILITIES_FIELD = 20;
+const int ProtocolPackager::SEQUENCE_FIELD = 21;
+const int ProtocolPackager::GRAPH_DATA_FIELD = 22;
+
+namespace {
+
+void appendVarint(QByteArray& out, quint32 value) {
+    while (value >= 0x80) {
+        out.append(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.append(static_cast<char>(value));
+}
+
+// 消息类型对应的MsgRequestResponse载荷字段号（oneof字段或扩展字段），不支持的类型返回0
+int payloadFieldNumber(MessageType messageType) {
+    switch (messageType) {
+        case MessageType::CHANNEL_NUMBER:    return 3;   // msg_channel_number
+        case MessageType::CHANNEL_AMPLITUDE: return 4;   // msg_channel_amplitude
+        case MessageType::CHANNEL_SWITCH:    return 5;   // msg_channel_switch
+        case MessageType::CHECK_MOD:         return 6;   // msg_check_mod
+        case MessageType::ANC_SWITCH:        return 7;   // msg_anc_switch
+        case MessageType::VEHICLE_STATE:     return 8;   // msg_vehicle_state
+        case MessageType::TRAN_FUNC_FLAG:    return 9;   // msg_tran_func_flag
+        case MessageType::TRAN_FUNC_STATE:   return 10;  // msg_tran_func_state
+        case MessageType::FILTER_RANGES:     return 11;  // msg_filter_ranges
+        case MessageType::SYSTEM_RANGES:     return 12;  // msg_system_ranges
+        case MessageType::ORDER_FLAG:        return 13;  // msg_order_flag
+        case MessageType::ORDER2_PARAMS:     return 14;  // msg_order2_params
+        case MessageType::ORDER4_PARAMS:     return 15;  // msg_order4_params
+        case MessageType::ORDER6_PARAMS:     return 16;  // msg_order6_params
+        case MessageType::ALPHA_PARAMS:      return 17;  // msg_alpha_params
+        case MessageType::FREQ_DIVISION:     return 18;  // msg_freq_division
+        case MessageType::THRESHOLDS:        return 19;  // msg_thresholds
+        case MessageType::GRAPH_DATA:        return ProtocolPackager::GRAPH_DATA_FIELD;
+        default:                             return 0;
+    }
+}
+
+} // namespace
+
+QByteArray ProtocolPackager::packageMessage(MessageType messageType, FunctionCode functionCode, const QByteArray& payloadData,
+                                            quint32 capabilities) {
     QByteArray result;
 
     // 获取ProtoID
@@ -24,239 +67,246 @@ QByteArray ProtocolPackager::packageMessage(MessageType messageType, FunctionCod
     result.append(0x10);  // tag for field 2 (FunCode), wire type 0 (varint)
     result.append(encodeVarint(static_cast<quint32>(functionCode)));
 
-    // 根据消息类型确定具体的oneof字段标签
-    quint8 fieldTag;
-    switch (messageType) {
-        case MessageType::CHANNEL_NUMBER:
-            fieldTag = 0x1A;  // tag for field 3 (msg_channel_number)
-            break;
-        case MessageType::CHANNEL_AMPLITUDE:
-            fieldTag = 0x22;  // tag for field 4 (msg_channel_amplitude)
-            break;
-        case MessageType::CHANNEL_SWITCH:
-            fieldTag = 0x2A;  // tag for field 5 (msg_channel_switch)
-            break;
-        case MessageType::CHECK_MOD:
-            fieldTag = 0x32;  // tag for field 6 (msg_check_mod)
-            break;
-        case MessageType::ANC_SWITCH:
-            fieldTag = 0x3A;  // tag for field 7 (msg_anc_switch)
-            break;
-        case MessageType::VEHICLE_STATE:
-            fieldTag = 0x42;  // tag for field 8 (msg_vehicle_state)
-            break;
-        case MessageType::TRAN_FUNC_FLAG:
-            fieldTag = 0x4A;  // tag for field 9 (msg_tran_func_flag)
-            break;
-        case MessageType::TRAN_FUNC_STATE:
-            fieldTag = 0x52;  // tag for field 10 (msg_tran_func_state)
-            break;
-        case MessageType::FILTER_RANGES:
-            fieldTag = 0x5A;  // tag for field 11 (msg_filter_ranges)
-            break;
-        case MessageType::SYSTEM_RANGES:
-            fieldTag = 0x62;  // tag for field 12 (msg_system_ranges)
-            break;
-        case MessageType::ORDER_FLAG:
-            fieldTag = 0x6A;  // tag for field 13 (msg_order_flag)
-            break;
-        case MessageType::ORDER2_PARAMS:
-            fieldTag = 0x72;  // tag for field 14 (msg_order2_params)
-            break;
-        case MessageType::ORDER4_PARAMS:
-            fieldTag = 0x7A;  // tag for field 15 (msg_order4_params)
-            break;
-        case MessageType::ORDER6_PARAMS:
-            fieldTag = 0x82;  // tag for field 16 (msg_order6_params), need varint encoding
-            break;
-        case MessageType::ALPHA_PARAMS:
-            fieldTag = 0x8A;  // tag for field 17 (msg_alpha_params), need varint encoding
-            break;
-        case MessageType::FREQ_DIVISION:
-            fieldTag = 0x92;  // tag for field 18 (msg_freq_division), need varint encoding
-            break;
-        case MessageType::THRESHOLDS:
-            fieldTag = 0x9A;  // tag for field 19 (msg_thresholds), need varint encoding
-            break;
-        default:
-            qWarning() << "Unsupported message type for packaging:" << static_cast<int>(messageType);
-            return QByteArray();
-    }
-
-    // 对于字段号大于15的，需要使用varint编码tag
-    if (fieldTag >= 0x80) {
-        // 字段16-19需要特殊处理tag编码
-        switch (messageType) {
-            case MessageType::ORDER6_PARAMS:
-                result.append(0x82); result.append(0x01); // field 16, wire type 2
-                break;
-            case MessageType::ALPHA_PARAMS:
-                result.append(0x8A); result.append(0x01); // field 17, wire type 2
-                break;
-            case MessageType::FREQ_DIVISION:
-                result.append(0x92); result.append(0x01); // field 18, wire type 2
-                break;
-            case MessageType::THRESHOLDS:
-                result.append(0x9A); result.append(0x01); // field 19, wire type 2
-                break;
-            default:
-                break;
-        }
-    } else {
-        result.append(fieldTag);
+    // 根据消息类型确定具体的oneof字段（length-delimited）
+    const int payloadField = payloadFieldNumber(messageType);
+    if (payloadField == 0) {
+        qWarning() << "Unsupported message type for packaging:" << static_cast<int>(messageType);
+        return QByteArray();
     }
+    result.append(encodeVarint((static_cast<quint32>(payloadField) << 3) | 2));
 
     result.append(encodeLengthPrefixed(payloadData));
 
+    // 能力通告放在最后，旧版解码器跳过
+    if (capabilities != 0) {
+        result.append(encodeVarint(static_cast<quint32>(CAPABILITIES_FIELD) << 3));
+        result.append(encodeVarint(capabilities));
+    }
+
     qDebug() << "Packaged message size:" << result.size() << "bytes";
     qDebug() << "Packaged data:" << result.toHex(' ');
 
     return result;
 }
 
-bool ProtocolPackager::unpackageMessage(const QByteArray& data, MessageType& messageType, FunctionCode& functionCode, QByteArray& payloadData) {
+QByteArray ProtocolPackager::packageReadRequest(MessageType messageType, quint32 capabilities) {
+    if (payloadFieldNumber(messageType) == 0) {
+        qWarning() << "Unsupported message type for read request:" << static_cast<int>(messageType);
+        return QByteArray();
+    }
+
+    // 只有ProtoID和FunCode，不带oneof载荷字段（设备端which_payload为0）
+    QByteArray result;
+    result.append(0x08);
+    result.append(encodeVarint(static_cast<quint32>(MessageTypeUtils::toProtoID(messageType))));
+    result.append(0x10);
+    result.append(encodeVarint(static_cast<quint32>(FunctionCode::REQUEST)));
+
+    if (capabilities != 0) {
+        result.append(encodeVarint(static_cast<quint32>(CAPABILITIES_FIELD) << 3));
+        result.append(encodeVarint(capabilities));
+    }
+    return result;
+}
+
+bool ProtocolPackager::unpackageMessage(const QByteArray& data, MessageType& messageType, FunctionCode& functionCode, QByteArray& payloadData,
+                                        quint32* capabilities) {
     if (data.isEmpty()) {
         qWarning() << "Cannot unpackage empty data";
+        if (capabilities) {
+            *capabilities = 0;
+        }
+        return false;
+    }
+
+    ScatterSpan payload;
+    if (!unpackEnvelope(ScatterSpan(data), messageType, functionCode, payload, capabilities)) {
+        qWarning() << "Malformed MsgRequestResponse, size:" << data.size();
         return false;
     }
 
-    int offset = 0;
+    payloadData = payload.toByteArray();
+
+    qDebug() << "Unpackaged message - ProtoID:" << MessageTypeUtils::toProtoID(messageType)
+             << "Type:" << static_cast<int>(messageType)
+             << "FunCode:" << static_cast<int>(functionCode)
+             << "Payload size:" << payloadData.size();
+
+    return true;
+}
+
+bool ProtocolPackager::unpackEnvelope(const ScatterSpan& data, MessageType& messageType, FunctionCode& functionCode,
+                                      ScatterSpan& payload, quint32* capabilities, quint32* sequence) {
+    if (capabilities) {
+        *capabilities = 0;
+    }
+    if (sequence) {
+        *sequence = 0;
+    }
+
+    ScatterReader reader(data);
     quint32 protoID = 0;
     quint32 funCode = 0;
     bool foundProtoID = false;
     bool foundFunCode = false;
     bool foundPayload = false;
 
-    while (offset < data.size()) {
-        // 读取tag
+    while (!reader.atEnd()) {
         quint32 tag;
-        if (!decodeVarint(data, offset, tag)) {
-            qWarning() << "Failed to decode tag at offset" << offset;
+        if (!reader.readVarint(tag)) {
             return false;
         }
 
-        int fieldNumber = tag >> 3;
-        int wireType = tag & 0x07;
+        const int fieldNumber = static_cast<int>(tag >> 3);
+        const int wireType = static_cast<int>(tag & 0x07);
 
-        switch (fieldNumber) {
-        case 1: // ProtoID
-            if (wireType != 0) { // varint
-                qWarning() << "Invalid wire type for ProtoID field";
+        if (wireType == 0) {
+            quint32 value;
+            if (!reader.readVarint(value)) {
                 return false;
             }
-            if (!decodeVarint(data, offset, protoID)) {
-                qWarning() << "Failed to decode ProtoID";
+            if (fieldNumber == 1) {
+                protoID = value;
+                foundProtoID = true;
+            } else if (fieldNumber == 2) {
+                funCode = value;
+                foundFunCode = true;
+            } else if (fieldNumber == CAPABILITIES_FIELD) {
+                if (capabilities) {
+                    *capabilities = value;
+                }
+            } else if (fieldNumber == SEQUENCE_FIELD) {
+                if (sequence) {
+                    *sequence = value;
+                }
+            } else if ((fieldNumber >= 3 && fieldNumber <= 19) || fieldNumber == GRAPH_DATA_FIELD) {
                 return false;
             }
-            foundProtoID = true;
-            break;
-
-        case 2: // FunCode
-            if (wireType != 0) { // varint
-                qWarning() << "Invalid wire type for FunCode field";
+        } else if (wireType == 2) {
+            // 字段3~19为oneof载荷（msg_channel_number ... msg_thresholds），字段22为实时数据帧
+            quint32 length;
+            ScatterSpan field;
+            if (fieldNumber == 1 || fieldNumber == 2 || fieldNumber == CAPABILITIES_FIELD
+                || fieldNumber == SEQUENCE_FIELD
+                || !reader.readVarint(length) || length > static_cast<quint32>(reader.remaining())
+                || !reader.take(static_cast<int>(length), field)) {
                 return false;
             }
-            if (!decodeVarint(data, offset, funCode)) {
-                qWarning() << "Failed to decode FunCode";
-                return false;
+            if ((fieldNumber >= 3 && fieldNumber <= 19) || fieldNumber == GRAPH_DATA_FIELD) {
+                payload = field;
+                foundPayload = true;
             }
-            foundFunCode = true;
-            break;
-
-        case 3:  // msg_channel_number
-        case 4:  // msg_channel_amplitude
-        case 5:  // msg_channel_switch
-        case 6:  // msg_check_mod
-        case 7:  // msg_anc_switch
-        case 8:  // msg_vehicle_state
-        case 9:  // msg_tran_func_flag
-        case 10: // msg_tran_func_state
-        case 11: // msg_filter_ranges
-        case 12: // msg_system_ranges
-        case 13: // msg_order_flag
-        case 14: // msg_order2_params
-        case 15: // msg_order4_params
-        case 16: // msg_order6_params
-        case 17: // msg_alpha_params
-        case 18: // msg_freq_division
-        case 19: // msg_thresholds
-            if (wireType != 2) { // length-delimited
-                qWarning() << "Invalid wire type for payload field" << fieldNumber;
-                return false;
-            }
-            if (!decodeLengthPrefixed(data, offset, payloadData)) {
-                qWarning() << "Failed to decode payload for field" << fieldNumber;
-                return false;
-            }
-            foundPayload = true;
-            break;
-
-        default:
-            // 跳过未知字段
-            qWarning() << "Skipping unknown field" << fieldNumber;
-            if (wireType == 0) { // varint
-                quint32 dummy;
-                if (!decodeVarint(data, offset, dummy)) return false;
-            } else if (wireType == 2) { // length-delimited
-                QByteArray dummy;
-                if (!decodeLengthPrefixed(data, offset, dummy)) return false;
-            } else {
-                qWarning() << "Unsupported wire type" << wireType;
-                return false;
-            }
-            break;
+        } else {
+            return false;
         }
     }
 
     if (!foundProtoID || !foundFunCode || !foundPayload) {
-        qWarning() << "Missing required fields - ProtoID:" << foundProtoID
-                   << "FunCode:" << foundFunCode << "Payload:" << foundPayload;
         return false;
     }
 
     // 转换ProtoID到MessageType
     messageType = MessageTypeUtils::fromProtoID(static_cast<int>(protoID));
     functionCode = static_cast<FunctionCode>(funCode);
+    return true;
+}
 
-    qDebug() << "Unpackaged message - ProtoID:" << protoID
-             << "Type:" << static_cast<int>(messageType)
-             << "FunCode:" << funCode
-             << "Payload size:" << payloadData.size();
+bool ProtocolPackager::peekEnvelope(const ScatterSpan& data, int& protoID, FunctionCode& functionCode,
+                                    quint32* sequence) {
+    ScatterReader reader(data);
+    quint32 proto = 0;
+    quint32 funCode = 0;
+    quint32 seq = 0;
+
+    while (!reader.atEnd()) {
+        quint32 tag;
+        if (!reader.readVarint(tag)) {
+            return false;
+        }
+
+        int fieldNumber = static_cast<int>(tag >> 3);
+        int wireType = static_cast<int>(tag & 0x07);
+
+        if (wireType == 0) {
+            quint32 value;
+            if (!reader.readVarint(value)) {
+                return false;
+            }
+            if (fieldNumber == 1) {
+                proto = value;
+            } else if (fieldNumber == 2) {
+                funCode = value;
+            } else if (fieldNumber == SEQUENCE_FIELD) {
+                seq = value;
+            }
+        } else if (wireType == 2) {
+            quint32 length;
+            if (!reader.readVarint(length) || length > static_cast<quint32>(reader.remaining())) {
+                return false;
+            }
+            reader.skip(static_cast<int>(length));
+        } else {
+            return false;
+        }
+    }
 
+    protoID = static_cast<int>(proto);
+    functionCode = static_cast<FunctionCode>(funCode);
+    if (sequence) {
+        *sequence = seq;
+    }
     return true;
 }
 
-QByteArray ProtocolPackager::encodeVarint(quint32 value) {
-    QByteArray result;
-    while (value >= 0x80) {
-        result.append(static_cast<char>((value & 0x7F) | 0x80));
-        value >>= 7;
-    }
-    result.append(static_cast<char>(value & 0x7F));
+QByteArray ProtocolPackager::appendSequence(const QByteArray& envelope, quint32 sequence) {
+    // protobuf字段顺序任意，追加在末尾即可，不必重新编码整个信封
+    QByteArray result = envelope;
+    appendVarint(result, static_cast<quint32>(SEQUENCE_FIELD) << 3);
+    appendVarint(result, sequence);
     return result;
 }
 
-bool ProtocolPackager::decodeVarint(const QByteArray& data, int& offset, quint32& value) {
-    value = 0;
-    int shift = 0;
-
-    while (offset < data.size()) {
-        quint8 byte = static_cast<quint8>(data[offset++]);
-        value |= static_cast<quint32>(byte & 0x7F) << shift;
+int ProtocolPackager::batchEntrySize(int envelopeSize) {
+    int prefix = 1;
+    for (quint32 value = static_cast<quint32>(envelopeSize); value >= 0x80; value >>= 7) {
+        prefix++;
+    }
+    return prefix + envelopeSize;
+}
 
-        if ((byte & 0x80) == 0) {
-            return true; // 最后一个字节
+QByteArray ProtocolPackager::packageBatch(const QList<QByteArray>& envelopes) {
+    int total = BATCH_HEADER_SIZE;
+    for (const QByteArray& envelope : envelopes) {
+        if (envelope.isEmpty() || isBatch(envelope)) {
+            qWarning() << "Invalid message in batch";
+            return QByteArray();
         }
+        total += batchEntrySize(envelope.size());
+    }
 
-        shift += 7;
-        if (shift >= 32) {
-            qWarning() << "Varint too long";
-            return false;
+    QByteArray result;
+    result.reserve(total);
+    result.append(static_cast<char>(BATCH_MARKER));
+    for (const QByteArray& envelope : envelopes) {
+        quint32 length = static_cast<quint32>(envelope.size());
+        while (length >= 0x80) {
+            result.append(static_cast<char>((length & 0x7F) | 0x80));
+            length >>= 7;
         }
+        result.append(static_cast<char>(length));
+        result.append(envelope);
     }
+    return result;
+}
 
-    qWarning() << "Incomplete varint";
-    return false;
+QByteArray ProtocolPackager::encodeVarint(quint32 value) {
+    QByteArray result;
+    while (value >= 0x80) {
+        result.append(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    result.append(static_cast<char>(value & 0x7F));
+    return result;
 }
 
 QByteArray ProtocolPackager::encodeLengthPrefixed(const QByteArray& data) {
@@ -266,20 +316,4 @@ QByteArray ProtocolPackager::encodeLengthPrefixed(const QByteArray& data) {
     return result;
 }
 
-bool ProtocolPackager::decodeLengthPrefixed(const QByteArray& data, int& offset, QByteArray& result) {
-    quint32 length;
-    if (!decodeVarint(data, offset, length)) {
-        return false;
-    }
-
-    if (offset + static_cast<int>(length) > data.size()) {
-        qWarning() << "Length-prefixed data exceeds buffer size";
-        return false;
-    }
-
-    result = data.mid(offset, static_cast<int>(length));
-    offset += static_cast<int>(length);
-    return true;
-}
-
 } // namespace Protocol
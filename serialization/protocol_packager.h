@@ -2,7 +2,9 @@
 #define PROTOCOL_PACKAGER_H
 
 #include <QByteArray>
+#include <QList>
 #include "../core/message_types.h"
+#include "scatter_span.h"
 
 namespace Protocol {
 
@@ -11,9 +13,40 @@ namespace Protocol {
  *
  * 负责将具体消息数据封装成完整的MsgRequestResponse格式
  * 包含ProtoID、FunCode和payload字段
+ *
+ * 扩展字段20（varint）携带发送方支持的能力位，用于连接时的能力协商；
+ * 扩展字段21（varint）携带请求序号，支持的设备在RESPONSE中原样带回，用于匹配应答。
+ * 字段22（graph_data，length-delimited）携带GRAPH_DATA实时数据帧（格式见RealtimeDataHandler），
+ * 定义在ERNC_praram.proto的MsgRequestResponse中（oneof之外），只在协商CAPABILITY_GRAPH_DATA后使用。
+ * 旧版设备（nanopb）按未知字段跳过，不影响兼容性。
+ *
+ * 批量帧（协商CAPABILITY_BATCH后使用）在一个链路帧内携带多条MsgRequestResponse：
+ * [BATCH_MARKER][长度(varint)][MsgRequestResponse][长度][MsgRequestResponse]...
+ * 标记字节0x00在protobuf中是无效的字段键，不会与单条消息混淆。
  */
 class ProtocolPackager {
 public:
+    /**
+     * @brief 能力位
+     */
+    enum Capability : quint32 {
+        CAPABILITY_COMPACT_ARRAYS = 0x01,   // v2数组紧凑格式，见MessageCodec::compactArrays()
+        CAPABILITY_BATCH = 0x02,            // 批量帧
+        CAPABILITY_GRAPH_DATA = 0x04        // GRAPH_DATA实时数据帧（字段22）
+    };
+
+    // 能力通告字段的字段号
+    static const int CAPABILITIES_FIELD;
+
+    // 请求序号字段的字段号
+    static const int SEQUENCE_FIELD;
+
+    // GRAPH_DATA实时数据载荷字段的字段号
+    static const int GRAPH_DATA_FIELD;
+
+    static constexpr quint8 BATCH_MARKER = 0x00;    // 批量帧标记
+    static constexpr int BATCH_HEADER_SIZE = 1;     // 批量帧头开销
+
     ProtocolPackager() = default;
     ~ProtocolPackager() = default;
 
@@ -22,9 +55,22 @@ public:
      * @param messageType 消息类型（用于确定ProtoID）
      * @param functionCode 功能码（REQUEST或RESPONSE）
      * @param payloadData 具体消息的序列化数据
+     * @param capabilities 要通告的能力位，0表示不携带能力字段
      * @return 完整的MsgRequestResponse字节数组
      */
-    QByteArray packageMessage(MessageType messageType, FunctionCode functionCode, const QByteArray& payloadData);
+    QByteArray packageMessage(MessageType messageType, FunctionCode functionCode, const QByteArray& payloadData,
+                              quint32 capabilities = 0);
+
+    /**
+     * @brief 封装回读请求
+     *
+     * 回读请求是不带oneof载荷字段的REQUEST。写请求总是携带载荷字段（全零消息也带标签和0长度），
+     * 设备据此区分回读和写入，回读不会把设备上的值清零。
+     * @param messageType 要回读的消息类型
+     * @param capabilities 要通告的能力位，0表示不携带能力字段
+     * @return MsgRequestResponse数据，不支持的消息类型返回空数组
+     */
+    QByteArray packageReadRequest(MessageType messageType, quint32 capabilities = 0);
 
     /**
      * @brief 从MsgRequestResponse格式中解包消息
@@ -32,9 +78,127 @@ public:
      * @param messageType 输出：解析出的消息类型
      * @param functionCode 输出：解析出的功能码
      * @param payloadData 输出：具体消息数据
+     * @param capabilities 输出（可选）：对端通告的能力位，未携带时为0
      * @return 成功返回true，失败返回false
      */
-    bool unpackageMessage(const QByteArray& data, MessageType& messageType, FunctionCode& functionCode, QByteArray& payloadData);
+    bool unpackageMessage(const QByteArray& data, MessageType& messageType, FunctionCode& functionCode, QByteArray& payloadData,
+                          quint32* capabilities = nullptr);
+
+    /**
+     * @brief 就地解包MsgRequestResponse
+     *
+     * 与unpackageMessage()接受相同的输入，但不拷贝载荷也不输出日志：
+     * 数据可以由两段组成（如接收环回绕处），输出的载荷是data的子视图，只在data有效期间可用。
+     * @param data MsgRequestResponse数据
+     * @param messageType 输出：消息类型
+     * @param functionCode 输出：功能码
+     * @param payload 输出：具体消息数据的视图
+     * @param capabilities 输出（可选）：对端通告的能力位，未携带时为0
+     * @param sequence 输出（可选）：请求序号，未携带时为0
+     * @return 成功返回true，失败返回false
+     */
+    static bool unpackEnvelope(const ScatterSpan& data, MessageType& messageType, FunctionCode& functionCode,
+                               ScatterSpan& payload, quint32* capabilities = nullptr, quint32* sequence = nullptr);
+
+    /**
+     * @brief 快速读取MsgRequestResponse的ProtoID和FunCode
+     *
+     * 只扫描顶层字段、跳过payload，不拷贝数据也不输出日志，供收发热路径使用。
+     * 按proto3约定，缺省的字段取默认值0。
+     * @param data 完整的MsgRequestResponse数据
+     * @param protoID 输出：ProtoID
+     * @param functionCode 输出：功能码
+     * @param sequence 输出（可选）：请求序号，未携带时为0
+     * @return 格式正确返回true，失败返回false
+     */
+    static bool peekEnvelope(const ScatterSpan& data, int& protoID, FunctionCode& functionCode,
+                             quint32* sequence = nullptr);
+
+    static bool peekEnvelope(const char* data, int size, int& protoID, FunctionCode& functionCode,
+                             quint32* sequence = nullptr) {
+        return peekEnvelope(ScatterSpan(data, size), protoID, functionCode, sequence);
+    }
+
+    /**
+     * @brief 在MsgRequestResponse末尾追加请求序号字段
+     * @param envelope 不含序号字段的MsgRequestResponse数据
+     * @param sequence 请求序号，不能为0
+     * @return 追加后的数据
+     */
+    static QByteArray appendSequence(const QByteArray& envelope, quint32 sequence);
+
+    /**
+     * @brief 是否为批量帧
+     */
+    static bool isBatch(const char* data, int size) {
+        return size > 0 && static_cast<quint8>(data[0]) == BATCH_MARKER;
+    }
+
+    static bool isBatch(const QByteArray& data) {
+        return isBatch(data.constData(), data.size());
+    }
+
+    static bool isBatch(const ScatterSpan& data) {
+        return !data.isEmpty() && static_cast<quint8>(data.at(0)) == BATCH_MARKER;
+    }
+
+    /**
+     * @brief 一条消息在批量帧中占用的字节数（长度前缀+消息）
+     */
+    static int batchEntrySize(int envelopeSize);
+
+    /**
+     * @brief 把多条MsgRequestResponse封装为批量帧
+     * @param envelopes 完整的MsgRequestResponse数据，不能为空或嵌套批量帧
+     * @return 批量帧数据，参数无效时返回空数组
+     */
+    static QByteArray packageBatch(const QList<QByteArray>& envelopes);
+
+    /**
+     * @brief 就地解析批量帧
+     *
+     * 先校验整个批量帧，格式正确才依次回调，不会只投递一部分。
+     * @param data 批量帧数据，可以由两段组成
+     * @param onEnvelope 每条消息调用一次，参数为(const ScatterSpan& envelope)
+     * @return 格式正确返回true
+     */
+    template<typename Callback>
+    static bool parseBatch(const ScatterSpan& data, Callback&& onEnvelope) {
+        if (!isBatch(data)) {
+            return false;
+        }
+
+        // 第一遍校验，第二遍投递
+        for (int pass = 0; pass < 2; ++pass) {
+            ScatterReader reader(data);
+            reader.skip(BATCH_HEADER_SIZE);
+            while (!reader.atEnd()) {
+                quint32 length = 0;
+                ScatterSpan envelope;
+                if (!reader.readVarint(length) || length == 0
+                    || length > static_cast<quint32>(reader.remaining())
+                    || reader.peek() == BATCH_MARKER
+                    || !reader.take(static_cast<int>(length), envelope)) {
+                    return false;
+                }
+                if (pass == 1) {
+                    onEnvelope(envelope);
+                }
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief 就地解析连续的批量帧
+     * @param onEnvelope 每条消息调用一次，参数为(const char* envelope, int length)
+     */
+    template<typename Callback>
+    static bool parseBatch(const char* data, int size, Callback&& onEnvelope) {
+        return parseBatch(ScatterSpan(data, size), [&onEnvelope](const ScatterSpan& envelope) {
+            onEnvelope(envelope.first(), envelope.size());
+        });
+    }
 
 private:
     /**
@@ -44,30 +208,12 @@ private:
      */
     QByteArray encodeVarint(quint32 value);
 
-    /**
-     * @brief 解码varint格式的整数
-     * @param data 数据
-     * @param offset 偏移量（会被更新）
-     * @param value 输出：解码的值
-     * @return 成功返回true，失败返回false
-     */
-    bool decodeVarint(const QByteArray& data, int& offset, quint32& value);
-
     /**
      * @brief 编码带长度前缀的字节数组（protobuf的bytes类型）
      * @param data 要编码的数据
      * @return 编码后的字节数组（长度+数据）
      */
     QByteArray encodeLengthPrefixed(const QByteArray& data);
-
-    /**
-     * @brief 解码带长度前缀的字节数组
-     * @param data 源数据
-     * @param offset 偏移量（会被更新）
-     * @param result 输出：解码的数据
-     * @return 成功返回true，失败返回false
-     */
-    bool decodeLengthPrefixed(const QByteArray& data, int& offset, QByteArray& result);
 };
 
 } // namespace Protocol
@@ -0,0 +1,185 @@
+#ifndef SCATTER_SPAN_H
+#define SCATTER_SPAN_H
+
+#include <QByteArray>
+#include <QtGlobal>
+#include <cstring>
+
+namespace Protocol {
+
+/**
+ * @brief 由两段内存组成的只读数据视图
+ *
+ * 接收环回绕处的帧、跨两次传输层读取的帧在内存中不连续，用(first, second)两段描述后
+ * 可以直接解析帧、信封和载荷，不必先拼接到QByteArray。
+ * 只借用调用方的缓冲区，不持有数据；连续数据的second为空。
+ */
+class ScatterSpan {
+public:
+    ScatterSpan() = default;
+
+    ScatterSpan(const char* data, int size)
+        : first_(data), firstSize_(size) {}
+
+    ScatterSpan(const char* first, int firstSize, const char* second, int secondSize)
+        : first_(first), firstSize_(firstSize), second_(second), secondSize_(secondSize) {
+        // 保证非空视图的first总是非空
+        if (firstSize_ == 0) {
+            first_ = second_;
+            firstSize_ = secondSize_;
+            second_ = nullptr;
+            secondSize_ = 0;
+        }
+    }
+
+    explicit ScatterSpan(const QByteArray& data)
+        : first_(data.constData()), firstSize_(data.size()) {}
+
+    const char* first() const { return first_; }
+    int firstSize() const { return firstSize_; }
+    const char* second() const { return second_; }
+    int secondSize() const { return secondSize_; }
+
+    int size() const { return firstSize_ + secondSize_; }
+    bool isEmpty() const { return size() == 0; }
+    bool isContiguous() const { return secondSize_ == 0; }
+
+    char at(int index) const {
+        return index < firstSize_ ? first_[index] : second_[index - firstSize_];
+    }
+
+    /**
+     * @brief 从from开始查找字节
+     * @return 找到返回下标，否则返回-1
+     */
+    int indexOf(char byte, int from = 0) const {
+        if (from < firstSize_) {
+            const void* found = std::memchr(first_ + from, static_cast<unsigned char>(byte),
+                                            static_cast<size_t>(firstSize_ - from));
+            if (found) {
+                return static_cast<int>(static_cast<const char*>(found) - first_);
+            }
+            from = firstSize_;
+        }
+        if (from < size()) {
+            const void* found = std::memchr(second_ + (from - firstSize_), static_cast<unsigned char>(byte),
+                                            static_cast<size_t>(size() - from));
+            if (found) {
+                return firstSize_ + static_cast<int>(static_cast<const char*>(found) - second_);
+            }
+        }
+        return -1;
+    }
+
+    /**
+     * @brief 子视图，范围完全落在一段内时结果是连续的
+     */
+    ScatterSpan mid(int offset, int length) const {
+        if (offset + length <= firstSize_) {
+            return ScatterSpan(first_ + offset, length);
+        }
+        if (offset >= firstSize_) {
+            return ScatterSpan(second_ + (offset - firstSize_), length);
+        }
+        const int head = firstSize_ - offset;
+        return ScatterSpan(first_ + offset, head, second_, length - head);
+    }
+
+    /**
+     * @brief 复制[offset, offset + length)到out
+     */
+    void copyTo(int offset, int length, char* out) const {
+        if (offset < firstSize_) {
+            const int head = qMin(length, firstSize_ - offset);
+            std::memcpy(out, first_ + offset, static_cast<size_t>(head));
+            out += head;
+            offset += head;
+            length -= head;
+        }
+        if (length > 0) {
+            std::memcpy(out, second_ + (offset - firstSize_), static_cast<size_t>(length));
+        }
+    }
+
+    // 复制为QByteArray（需要保留数据或交给只接受连续数据的接口时使用）
+    QByteArray toByteArray() const {
+        if (isContiguous()) {
+            return QByteArray(first_, firstSize_);
+        }
+        QByteArray result(size(), '\0');
+        copyTo(0, size(), result.data());
+        return result;
+    }
+
+private:
+    const char* first_ = nullptr;
+    int firstSize_ = 0;
+    const char* second_ = nullptr;
+    int secondSize_ = 0;
+};
+
+/**
+ * @brief ScatterSpan上的顺序读取游标（protobuf线格式）
+ */
+class ScatterReader {
+public:
+    explicit ScatterReader(const ScatterSpan& data)
+        : data_(data) {}
+
+    int position() const { return position_; }
+    int remaining() const { return data_.size() - position_; }
+    bool atEnd() const { return position_ >= data_.size(); }
+
+    // 下一个字节，不移动游标（调用方保证未到末尾）
+    quint8 peek() const { return static_cast<quint8>(data_.at(position_)); }
+
+    /**
+     * @brief 读取uint32 varint（最多5字节）
+     */
+    bool readVarint(quint32& value) {
+        value = 0;
+        for (int shift = 0; shift < 32 && position_ < data_.size(); shift += 7) {
+            quint8 byte = static_cast<quint8>(data_.at(position_++));
+            value |= static_cast<quint32>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool read(char* out, int length) {
+        if (length < 0 || length > remaining()) {
+            return false;
+        }
+        data_.copyTo(position_, length, out);
+        position_ += length;
+        return true;
+    }
+
+    // 取出接下来length字节的子视图并跳过
+    bool take(int length, ScatterSpan& span) {
+        if (length < 0 || length > remaining()) {
+            return false;
+        }
+        span = data_.mid(position_, length);
+        position_ += length;
+        return true;
+    }
+
+    bool skip(int length) {
+        if (length < 0 || length > remaining()) {
+            return false;
+        }
+        position_ += length;
+        return true;
+    }
+
+private:
+    ScatterSpan data_;
+    int position_ = 0;
+};
+
+} // namespace Protocol
+
+#endif // SCATTER_SPAN_H
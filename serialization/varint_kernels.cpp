@@ -0,0 +1,604 @@
+#include "varint_kernels.h"
+
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <initializer_list>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PROTOCOL_VARINT_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC/Clang按函数开启指令集，其余代码仍按基线编译；MSVC无需开关即可使用intrinsics
+#if defined(__GNUC__) || defined(__clang__)
+#define VARINT_TARGET(features) __attribute__((target(features)))
+#else
+#define VARINT_TARGET(features)
+#endif
+
+namespace Protocol {
+
+namespace {
+
+using EncodedSizeFunction = size_t (*)(const uint32_t* values, size_t count);
+using EncodeFunction = size_t (*)(const uint32_t* values, size_t count, uint8_t* out);
+using DecodeFunction = bool (*)(const uint8_t*& data, const uint8_t* end, uint32_t* values, size_t maxCount,
+                                size_t& decoded);
+using CountFunction = bool (*)(const uint8_t* data, size_t size, size_t& count);
+
+struct Kernels {
+    PackedVarint::Implementation implementation;
+    EncodedSizeFunction encodedSize;
+    EncodeFunction encode;
+    DecodeFunction decode;
+    CountFunction count;
+};
+
+// ---- 标量实现 ----
+
+inline size_t varintSize(uint32_t value)
+{
+    return value < (1u << 7) ? 1 : value < (1u << 14) ? 2 : value < (1u << 21) ? 3 : value < (1u << 28) ? 4 : 5;
+}
+
+inline uint8_t* writeVarint(uint8_t* p, uint32_t value)
+{
+    while (value >= 0x80) {
+        *p++ = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    *p++ = static_cast<uint8_t>(value);
+    return p;
+}
+
+// 与nanopb解码uint32字段相同：按64位varint读取，超出32位时失败
+inline bool readUint32(const uint8_t*& p, const uint8_t* end, uint32_t& value)
+{
+    if (p != end && !(*p & 0x80)) {
+        value = *p++;
+        return true;
+    }
+
+    uint64_t result = 0;
+    unsigned bitpos = 0;
+    uint8_t byte;
+    do {
+        if (p == end) {
+            return false;
+        }
+        byte = *p++;
+        if (bitpos >= 63 && (byte & 0xFE) != 0) {
+            return false;
+        }
+        result |= static_cast<uint64_t>(byte & 0x7F) << bitpos;
+        bitpos += 7;
+    } while (byte & 0x80);
+
+    if (result > 0xFFFFFFFFu) {
+        return false;
+    }
+    value = static_cast<uint32_t>(result);
+    return true;
+}
+
+inline int popcount32(uint32_t value)
+{
+    value = value - ((value >> 1) & 0x55555555u);
+    value = (value & 0x33333333u) + ((value >> 2) & 0x33333333u);
+    return static_cast<int>((((value + (value >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+}
+
+size_t encodedSizeScalar(const uint32_t* values, size_t count)
+{
+    size_t size = 0;
+    for (size_t i = 0; i < count; ++i) {
+        size += varintSize(values[i]);
+    }
+    return size;
+}
+
+size_t encodeScalar(const uint32_t* values, size_t count, uint8_t* out)
+{
+    uint8_t* p = out;
+    for (size_t i = 0; i < count; ++i) {
+        p = writeVarint(p, values[i]);
+    }
+    return static_cast<size_t>(p - out);
+}
+
+bool decodeScalar(const uint8_t*& data, const uint8_t* end, uint32_t* values, size_t maxCount, size_t& decoded)
+{
+    size_t n = 0;
+    while (data != end && n < maxCount) {
+        if (!readUint32(data, end, values[n])) {
+            decoded = n;
+            return false;
+        }
+        n++;
+    }
+    decoded = n;
+    return true;
+}
+
+bool countScalar(const uint8_t* data, size_t size, size_t& count)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < size; ++i) {
+        n += (data[i] & 0x80) ? 0 : 1;
+    }
+    count = n;
+    return size == 0 || !(data[size - 1] & 0x80);
+}
+
+#ifdef PROTOCOL_VARINT_X86
+
+// ---- 查找表 ----
+
+// 8字节窗口按续位掩码：窗口内开头连续的1~2字节varint个数、各自结束的偏移，
+// 以及把第i个varint的两个字节放到第i个16位通道的重排控制（0x80表示填0）
+struct DecodeEntry {
+    alignas(16) uint8_t shuffle[16];
+    uint8_t ends[8];        // 前i+1个varint之后的偏移
+    uint8_t count;
+    uint8_t consumed;
+};
+
+// 4个1~2字节的值按2字节值的掩码：把各32位通道的低1~2字节紧凑排列的重排控制和输出长度
+struct EncodeEntry {
+    alignas(16) uint8_t shuffle[16];
+    uint8_t length;
+};
+
+const DecodeEntry* decodeTable()
+{
+    static const std::array<DecodeEntry, 256> table = [] {
+        std::array<DecodeEntry, 256> entries{};
+        for (int mask = 0; mask < 256; ++mask) {
+            DecodeEntry& entry = entries[mask];
+            std::memset(entry.shuffle, 0x80, sizeof(entry.shuffle));
+
+            int pos = 0;
+            int count = 0;
+            while (pos < 8) {
+                if (!(mask & (1 << pos))) {
+                    entry.shuffle[2 * count] = static_cast<uint8_t>(pos);
+                    pos += 1;
+                } else if (pos + 1 < 8 && !(mask & (1 << (pos + 1)))) {
+                    entry.shuffle[2 * count] = static_cast<uint8_t>(pos);
+                    entry.shuffle[2 * count + 1] = static_cast<uint8_t>(pos + 1);
+                    pos += 2;
+                } else {
+                    break;  // 3字节以上，或跨出窗口
+                }
+                entry.ends[count] = static_cast<uint8_t>(pos);
+                count++;
+            }
+            entry.count = static_cast<uint8_t>(count);
+            entry.consumed = static_cast<uint8_t>(pos);
+        }
+        return entries;
+    }();
+    return table.data();
+}
+
+const EncodeEntry* encodeTable()
+{
+    static const std::array<EncodeEntry, 16> table = [] {
+        std::array<EncodeEntry, 16> entries{};
+        for (int mask = 0; mask < 16; ++mask) {
+            EncodeEntry& entry = entries[mask];
+            std::memset(entry.shuffle, 0x80, sizeof(entry.shuffle));
+
+            int pos = 0;
+            for (int lane = 0; lane < 4; ++lane) {
+                entry.shuffle[pos++] = static_cast<uint8_t>(lane * 4);
+                if (mask & (1 << lane)) {
+                    entry.shuffle[pos++] = static_cast<uint8_t>(lane * 4 + 1);
+                }
+            }
+            entry.length = static_cast<uint8_t>(pos);
+        }
+        return entries;
+    }();
+    return table.data();
+}
+
+// ---- SSE4.1 ----
+
+// 编码4个值，返回新的输出位置；超过2字节的值退回标量
+VARINT_TARGET("sse4.1")
+inline uint8_t* encodeGroupSse41(const uint32_t* values, uint8_t* p, const EncodeEntry* table)
+{
+    const __m128i max1 = _mm_set1_epi32(0x7F);
+    const __m128i max2 = _mm_set1_epi32(0x3FFF);
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+
+    // v <= t 等价于 max(v, t) == t（无符号比较）
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_max_epu32(v, max1), max1)) == 0xFFFF) {
+        const __m128i bytes = _mm_packus_epi16(_mm_packus_epi32(v, v), v);
+        const int32_t word = _mm_cvtsi128_si32(bytes);
+        std::memcpy(p, &word, 4);
+        return p + 4;
+    }
+
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_max_epu32(v, max2), max2)) != 0xFFFF) {
+        for (int i = 0; i < 4; ++i) {
+            p = writeVarint(p, values[i]);
+        }
+        return p;
+    }
+
+    // 每个32位通道组成[低7位|续位, 高7位]，再按长度紧凑排列
+    const __m128i twoByte = _mm_cmpgt_epi32(v, max1);
+    const __m128i low = _mm_or_si128(_mm_and_si128(v, max1), _mm_and_si128(twoByte, _mm_set1_epi32(0x80)));
+    const __m128i high = _mm_slli_epi32(_mm_srli_epi32(v, 7), 8);
+    const EncodeEntry& entry = table[_mm_movemask_ps(_mm_castsi128_ps(twoByte))];
+    const __m128i shuffle = _mm_load_si128(reinterpret_cast<const __m128i*>(entry.shuffle));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_shuffle_epi8(_mm_or_si128(low, high), shuffle));
+    return p + entry.length;
+}
+
+// 解码一个8字节窗口，最多写入room个值，返回解码的个数；0表示窗口开头是3字节以上的varint
+VARINT_TARGET("sse4.1")
+inline size_t decodeWindowSse41(const uint8_t*& p, uint32_t* out, size_t room, const DecodeEntry* table)
+{
+    const __m128i window = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+    const DecodeEntry& entry = table[_mm_movemask_epi8(window) & 0xFF];
+    if (entry.count == 0) {
+        return 0;
+    }
+
+    const __m128i shuffle = _mm_load_si128(reinterpret_cast<const __m128i*>(entry.shuffle));
+    const __m128i pairs = _mm_shuffle_epi8(window, shuffle);
+    const __m128i values = _mm_or_si128(_mm_and_si128(pairs, _mm_set1_epi16(0x007F)),
+                                        _mm_and_si128(_mm_srli_epi16(pairs, 1), _mm_set1_epi16(0x3F80)));
+    const __m128i low = _mm_cvtepu16_epi32(values);
+    const __m128i high = _mm_cvtepu16_epi32(_mm_srli_si128(values, 8));
+
+    if (room >= 8) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), low);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4), high);
+        p += entry.consumed;
+        return entry.count;
+    }
+
+    // 数组末尾：只取剩余的个数
+    alignas(16) uint32_t buffer[8];
+    _mm_store_si128(reinterpret_cast<__m128i*>(buffer), low);
+    _mm_store_si128(reinterpret_cast<__m128i*>(buffer + 4), high);
+    const size_t taken = entry.count < room ? entry.count : room;
+    std::memcpy(out, buffer, taken * sizeof(uint32_t));
+    p += entry.ends[taken - 1];
+    return taken;
+}
+
+// 按8字节窗口解码，直到剩余不足8字节或已解码maxCount个值
+VARINT_TARGET("sse4.1")
+inline bool decodeWindowsSse41(const uint8_t*& data, const uint8_t* end, uint32_t* values, size_t maxCount,
+                               size_t& n, const DecodeEntry* table)
+{
+    while (end - data >= 8 && n < maxCount) {
+        const size_t windowCount = decodeWindowSse41(data, values + n, maxCount - n, table);
+        if (windowCount == 0) {
+            if (!readUint32(data, end, values[n])) {
+                return false;
+            }
+            n++;
+        }
+        n += windowCount;
+    }
+    return true;
+}
+
+VARINT_TARGET("sse4.1")
+size_t encodedSizeSse41(const uint32_t* values, size_t count)
+{
+    const __m128i t1 = _mm_set1_epi32(0x7F);
+    const __m128i t2 = _mm_set1_epi32(0x3FFF);
+    const __m128i t3 = _mm_set1_epi32(0x1FFFFF);
+    const __m128i t4 = _mm_set1_epi32(0xFFFFFFF);
+
+    // 每个值按5字节计，每满足一个 v <= t 减1（比较结果为-1）
+    __m128i adjust = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+        adjust = _mm_add_epi32(adjust, _mm_cmpeq_epi32(_mm_max_epu32(v, t1), t1));
+        adjust = _mm_add_epi32(adjust, _mm_cmpeq_epi32(_mm_max_epu32(v, t2), t2));
+        adjust = _mm_add_epi32(adjust, _mm_cmpeq_epi32(_mm_max_epu32(v, t3), t3));
+        adjust = _mm_add_epi32(adjust, _mm_cmpeq_epi32(_mm_max_epu32(v, t4), t4));
+    }
+
+    int32_t lanes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), adjust);
+    const int64_t size = static_cast<int64_t>(i * PackedVarint::MAX_VARINT_SIZE)
+                         + lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    return static_cast<size_t>(size) + encodedSizeScalar(values + i, count - i);
+}
+
+VARINT_TARGET("sse4.1")
+size_t encodeSse41(const uint32_t* values, size_t count, uint8_t* out)
+{
+    const EncodeEntry* table = encodeTable();
+    uint8_t* p = out;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        p = encodeGroupSse41(values + i, p, table);
+    }
+    return static_cast<size_t>(p - out) + encodeScalar(values + i, count - i, p);
+}
+
+VARINT_TARGET("sse4.1")
+bool decodeSse41(const uint8_t*& data, const uint8_t* end, uint32_t* values, size_t maxCount, size_t& decoded)
+{
+    size_t n = 0;
+    if (!decodeWindowsSse41(data, end, values, maxCount, n, decodeTable())) {
+        decoded = n;
+        return false;
+    }
+
+    size_t tail = 0;
+    const bool ok = decodeScalar(data, end, values + n, maxCount - n, tail);
+    decoded = n + tail;
+    return ok;
+}
+
+VARINT_TARGET("sse4.1")
+bool countSse41(const uint8_t* data, size_t size, size_t& count)
+{
+    size_t n = 0;
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        n += 16 - static_cast<size_t>(popcount32(static_cast<uint32_t>(_mm_movemask_epi8(chunk))));
+    }
+
+    size_t tail = 0;
+    countScalar(data + i, size - i, tail);
+    count = n + tail;
+    return size == 0 || !(data[size - 1] & 0x80);
+}
+
+// ---- AVX2 ----
+// 不足一个AVX2块的部分用内联的SSE4.1辅助函数处理（同为VEX编码），不调用SSE4.1版本
+
+VARINT_TARGET("avx2")
+size_t encodedSizeAvx2(const uint32_t* values, size_t count)
+{
+    const __m256i t1 = _mm256_set1_epi32(0x7F);
+    const __m256i t2 = _mm256_set1_epi32(0x3FFF);
+    const __m256i t3 = _mm256_set1_epi32(0x1FFFFF);
+    const __m256i t4 = _mm256_set1_epi32(0xFFFFFFF);
+
+    __m256i adjust = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+        adjust = _mm256_add_epi32(adjust, _mm256_cmpeq_epi32(_mm256_max_epu32(v, t1), t1));
+        adjust = _mm256_add_epi32(adjust, _mm256_cmpeq_epi32(_mm256_max_epu32(v, t2), t2));
+        adjust = _mm256_add_epi32(adjust, _mm256_cmpeq_epi32(_mm256_max_epu32(v, t3), t3));
+        adjust = _mm256_add_epi32(adjust, _mm256_cmpeq_epi32(_mm256_max_epu32(v, t4), t4));
+    }
+
+    int32_t lanes[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), adjust);
+    int64_t size = static_cast<int64_t>(i * PackedVarint::MAX_VARINT_SIZE);
+    for (int32_t lane : lanes) {
+        size += lane;
+    }
+    return static_cast<size_t>(size) + encodedSizeScalar(values + i, count - i);
+}
+
+VARINT_TARGET("avx2")
+size_t encodeAvx2(const uint32_t* values, size_t count, uint8_t* out)
+{
+    const EncodeEntry* table = encodeTable();
+    const __m256i max1 = _mm256_set1_epi32(0x7F);
+    // 每个128位通道把4个32位值的最低字节集中到低4字节，再把两个通道的结果拼成8字节
+    const __m256i gather = _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                            0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m256i join = _mm256_setr_epi32(0, 4, 1, 1, 1, 1, 1, 1);
+
+    uint8_t* p = out;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(_mm256_max_epu32(v, max1), max1)) == -1) {
+            const __m256i bytes = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(v, gather), join);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm256_castsi256_si128(bytes));
+            p += 8;
+        } else {
+            p = encodeGroupSse41(values + i, p, table);
+            p = encodeGroupSse41(values + i + 4, p, table);
+        }
+    }
+    if (i + 4 <= count) {
+        p = encodeGroupSse41(values + i, p, table);
+        i += 4;
+    }
+    return static_cast<size_t>(p - out) + encodeScalar(values + i, count - i, p);
+}
+
+VARINT_TARGET("avx2")
+bool decodeAvx2(const uint8_t*& data, const uint8_t* end, uint32_t* values, size_t maxCount, size_t& decoded)
+{
+    const DecodeEntry* table = decodeTable();
+    size_t n = 0;
+
+    while (end - data >= 32 && maxCount - n >= 32) {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+        if (_mm256_movemask_epi8(chunk) != 0) {
+            // 含多字节值：按窗口解码这一段
+            const size_t windowCount = decodeWindowSse41(data, values + n, maxCount - n, table);
+            if (windowCount == 0 && !readUint32(data, end, values[n++])) {
+                decoded = n - 1;
+                return false;
+            }
+            n += windowCount;
+            continue;
+        }
+
+        // 32个单字节值
+        for (int k = 0; k < 4; ++k) {
+            const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(data + 8 * k));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(values + n + 8 * k), _mm256_cvtepu8_epi32(bytes));
+        }
+        data += 32;
+        n += 32;
+    }
+
+    if (!decodeWindowsSse41(data, end, values, maxCount, n, table)) {
+        decoded = n;
+        return false;
+    }
+
+    size_t tail = 0;
+    const bool ok = decodeScalar(data, end, values + n, maxCount - n, tail);
+    decoded = n + tail;
+    return ok;
+}
+
+VARINT_TARGET("avx2")
+bool countAvx2(const uint8_t* data, size_t size, size_t& count)
+{
+    size_t n = 0;
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        n += 32 - static_cast<size_t>(popcount32(static_cast<uint32_t>(_mm256_movemask_epi8(chunk))));
+    }
+
+    size_t tail = 0;
+    countScalar(data + i, size - i, tail);
+    count = n + tail;
+    return size == 0 || !(data[size - 1] & 0x80);
+}
+
+#endif // PROTOCOL_VARINT_X86
+
+// ---- 运行时选择 ----
+
+const Kernels KERNELS[] = {
+    { PackedVarint::Implementation::Scalar, &encodedSizeScalar, &encodeScalar, &decodeScalar, &countScalar },
+#ifdef PROTOCOL_VARINT_X86
+    { PackedVarint::Implementation::Sse41, &encodedSizeSse41, &encodeSse41, &decodeSse41, &countSse41 },
+    { PackedVarint::Implementation::Avx2, &encodedSizeAvx2, &encodeAvx2, &decodeAvx2, &countAvx2 },
+#endif
+};
+
+bool cpuSupports(PackedVarint::Implementation implementation)
+{
+    switch (implementation) {
+    case PackedVarint::Implementation::Scalar:
+        return true;
+#ifdef PROTOCOL_VARINT_X86
+#if defined(__GNUC__) || defined(__clang__)
+    case PackedVarint::Implementation::Sse41:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse4.1");
+    case PackedVarint::Implementation::Avx2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER)
+    case PackedVarint::Implementation::Sse41: {
+        int info[4];
+        __cpuid(info, 1);
+        return (info[2] & (1 << 19)) != 0;
+    }
+    case PackedVarint::Implementation::Avx2: {
+        int info[4];
+        __cpuid(info, 0);
+        const int maxLeaf = info[0];
+        __cpuid(info, 1);
+        const bool osSavesAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28))
+                                && (_xgetbv(0) & 0x6) == 0x6;
+        if (maxLeaf < 7 || !osSavesAvx) {
+            return false;
+        }
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    }
+#endif
+#endif
+    default:
+        return false;
+    }
+}
+
+const Kernels* findKernels(PackedVarint::Implementation implementation)
+{
+    for (const Kernels& kernels : KERNELS) {
+        if (kernels.implementation == implementation) {
+            return &kernels;
+        }
+    }
+    return nullptr;
+}
+
+std::atomic<const Kernels*>& activeKernels()
+{
+    static std::atomic<const Kernels*> active(findKernels(PackedVarint::bestImplementation()));
+    return active;
+}
+
+inline const Kernels* kernels()
+{
+    return activeKernels().load(std::memory_order_relaxed);
+}
+
+} // namespace
+
+PackedVarint::Implementation PackedVarint::implementation() {
+    return kernels()->implementation;
+}
+
+PackedVarint::Implementation PackedVarint::bestImplementation() {
+    for (Implementation candidate : { Implementation::Avx2, Implementation::Sse41 }) {
+        if (findKernels(candidate) && cpuSupports(candidate)) {
+            return candidate;
+        }
+    }
+    return Implementation::Scalar;
+}
+
+bool PackedVarint::setImplementation(Implementation implementation) {
+    const Kernels* selected = findKernels(implementation);
+    if (!selected || !cpuSupports(implementation)) {
+        return false;
+    }
+    activeKernels().store(selected, std::memory_order_relaxed);
+    return true;
+}
+
+const char* PackedVarint::implementationName(Implementation implementation) {
+    switch (implementation) {
+    case Implementation::Sse41:
+        return "SSE4.1";
+    case Implementation::Avx2:
+        return "AVX2";
+    default:
+        return "Scalar";
+    }
+}
+
+size_t PackedVarint::encodedSize(const uint32_t* values, size_t count) {
+    return kernels()->encodedSize(values, count);
+}
+
+size_t PackedVarint::encode(const uint32_t* values, size_t count, uint8_t* out) {
+    return kernels()->encode(values, count, out);
+}
+
+bool PackedVarint::decode(const uint8_t*& data, const uint8_t* end, uint32_t* values, size_t maxCount, size_t& decoded) {
+    return kernels()->decode(data, end, values, maxCount, decoded);
+}
+
+bool PackedVarint::count(const uint8_t* data, size_t size, size_t& count) {
+    return kernels()->count(data, size, count);
+}
+
+} // namespace Protocol
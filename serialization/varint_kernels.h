@@ -0,0 +1,81 @@
+#ifndef VARINT_KERNELS_H
+#define VARINT_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Protocol {
+
+/**
+ * @brief packed uint32数组的varint编解码内核
+ *
+ * 标定和量程消息的数组（阈值、幅值、步长、泄漏系数等）几乎都是1~2字节的varint。
+ * x86上首次使用时检测CPU并选择实现：
+ * - AVX2：32字节全部是单字节varint时一次展开32个值，编码时8个单字节值一组
+ * - SSE4.1：按8字节窗口的续位掩码查表，一次解码最多8个1~2字节的varint；编码时4个值一组
+ * - 其他CPU，以及3字节以上的值，使用标量实现
+ *
+ * 各实现的输出与逐个编解码完全相同，解码的错误条件与nanopb解码uint32字段一致。
+ * 不依赖Qt，供生成的ERNC编解码（ernc_codec.h）直接调用。
+ */
+class PackedVarint {
+public:
+    enum class Implementation {
+        Scalar,
+        Sse41,
+        Avx2
+    };
+
+    static constexpr size_t MAX_VARINT_SIZE = 5;    // uint32的varint最大长度
+
+    /**
+     * @brief 当前使用的实现
+     */
+    static Implementation implementation();
+
+    /**
+     * @brief 本机CPU支持的最快实现
+     */
+    static Implementation bestImplementation();
+
+    /**
+     * @brief 指定实现（用于对比和基准测试）
+     * @return CPU不支持该实现时返回false，当前实现不变
+     */
+    static bool setImplementation(Implementation implementation);
+
+    static const char* implementationName(Implementation implementation);
+
+    /**
+     * @brief count个值编码后的字节数
+     */
+    static size_t encodedSize(const uint32_t* values, size_t count);
+
+    /**
+     * @brief 编码count个值
+     * @param out 输出缓冲区，至少count * MAX_VARINT_SIZE字节（SIMD实现按块写入）
+     * @return 写入的字节数
+     */
+    static size_t encode(const uint32_t* values, size_t count, uint8_t* out);
+
+    /**
+     * @brief 解码packed数据，直到end或已解码maxCount个值
+     * @param data 输入，返回时指向第一个未解码的字节
+     * @param end 数据末尾
+     * @param values 输出，至少maxCount个
+     * @param maxCount 最多解码的值个数
+     * @param decoded 输出：解码的值个数
+     * @return varint不完整或值超出uint32时返回false
+     */
+    static bool decode(const uint8_t*& data, const uint8_t* end, uint32_t* values, size_t maxCount, size_t& decoded);
+
+    /**
+     * @brief packed数据中的varint个数（不校验取值）
+     * @return 最后一个varint不完整时返回false
+     */
+    static bool count(const uint8_t* data, size_t size, size_t& count);
+};
+
+} // namespace Protocol
+
+#endif // VARINT_KERNELS_H
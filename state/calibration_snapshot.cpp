@@ -0,0 +1,495 @@
+#include "calibration_snapshot.h"
+#include "shadow_state_store.h"
+#include "../serialization/message_serializer.h"
+#include "../serialization/message_codec.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QSaveFile>
+
+#include <array>
+#include <cstring>
+#include <vector>
+
+extern "C" {
+#include "../nanopb/pb_common.h"
+#include "../messages/ERNC_praram.pb.h"
+}
+
+namespace Protocol {
+
+using namespace CalibrationSnapshotFormat;
+
+namespace {
+
+constexpr char FILE_MAGIC[8] = {'E', 'R', 'N', 'C', 'S', 'N', 'P', '1'};
+
+inline quint32 alignSection(quint32 offset)
+{
+    return (offset + 7u) & ~7u;
+}
+
+// CRC32（IEEE 802.3，反射多项式0xEDB88320）
+std::array<quint32, 256> makeCrcTable()
+{
+    std::array<quint32, 256> table{};
+    for (quint32 i = 0; i < 256; ++i) {
+        quint32 crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1u) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+quint32 crc32(const char* data, size_t size, quint32 crc = 0)
+{
+    static const std::array<quint32, 256> table = makeCrcTable();
+    crc = ~crc;
+    const auto* bytes = reinterpret_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ bytes[i]) & 0xFFu] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+// 结构体布局指纹：逐字段累积标签、类型、偏移、元素大小和数组长度（FNV-1a）
+quint32 layoutHash(const pb_msgdesc_t* fields, size_t structSize)
+{
+    quint32 hash = 2166136261u;
+    auto mix = [&hash](quint32 value) {
+        for (int i = 0; i < 4; ++i) {
+            hash ^= (value >> (i * 8)) & 0xFFu;
+            hash *= 16777619u;
+        }
+    };
+
+    mix(static_cast<quint32>(structSize));
+
+    std::vector<char> probe(structSize);
+    pb_field_iter_t iter;
+    if (pb_field_iter_begin(&iter, fields, probe.data())) {
+        do {
+            mix(iter.tag);
+            mix(iter.type);
+            mix(static_cast<quint32>(static_cast<char*>(iter.pField) - probe.data()));
+            mix(iter.data_size);
+            mix(iter.array_size);
+        } while (pb_field_iter_next(&iter));
+    }
+    return hash;
+}
+
+struct ExpectedSection {
+    MessageType type;
+    quint16 protoId;
+    quint32 size;
+    quint32 layoutHash;
+    quint32 offset;
+};
+
+struct ExpectedLayout {
+    QList<ExpectedSection> sections;
+    quint32 headerSize;             // 文件头加节目录
+    quint32 fileSize;
+};
+
+const ExpectedLayout& expectedLayout()
+{
+    static const ExpectedLayout layout = [] {
+        ExpectedLayout result;
+        const QList<MessageType> types = ShadowStateStore::trackedTypes();
+        result.headerSize = static_cast<quint32>(sizeof(FileHeader) + types.size() * sizeof(SectionEntry));
+
+        quint32 offset = alignSection(result.headerSize);
+        for (MessageType type : types) {
+            ExpectedSection section;
+            section.type = type;
+            section.protoId = static_cast<quint16>(MessageTypeUtils::toProtoID(type));
+            section.size = static_cast<quint32>(ShadowStateStore::messageSize(type));
+            section.layoutHash = layoutHash(ShadowStateStore::messageFields(type), section.size);
+            section.offset = offset;
+            offset = alignSection(offset + section.size);
+            result.sections.append(section);
+        }
+        result.fileSize = offset;
+        return result;
+    }();
+    return layout;
+}
+
+} // namespace
+
+CalibrationSnapshot::CalibrationSnapshot()
+    : data_(nullptr)
+    , size_(0)
+{
+    initializeEmpty();
+}
+
+CalibrationSnapshot::~CalibrationSnapshot() {
+    unmap();
+}
+
+void CalibrationSnapshot::initializeEmpty() {
+    unmap();
+
+    const ExpectedLayout& layout = expectedLayout();
+    buffer_ = QByteArray(static_cast<int>(layout.fileSize), '\0');
+
+    auto* fileHeader = reinterpret_cast<FileHeader*>(buffer_.data());
+    std::memcpy(fileHeader->magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    fileHeader->version = FORMAT_VERSION;
+    fileHeader->headerSize = sizeof(FileHeader);
+    fileHeader->sectionCount = static_cast<uint32_t>(layout.sections.size());
+    fileHeader->fileSize = layout.fileSize;
+    fileHeader->createdMs = QDateTime::currentMSecsSinceEpoch();
+
+    auto* entries = reinterpret_cast<SectionEntry*>(buffer_.data() + sizeof(FileHeader));
+    for (int i = 0; i < layout.sections.size(); ++i) {
+        const ExpectedSection& section = layout.sections[i];
+        entries[i].protoId = section.protoId;
+        entries[i].flags = 0;
+        entries[i].layoutHash = section.layoutHash;
+        entries[i].offset = section.offset;
+        entries[i].size = section.size;
+        entries[i].crc = crc32(buffer_.constData() + section.offset, section.size);
+    }
+
+    data_ = buffer_.constData();
+    size_ = buffer_.size();
+    finalize();
+}
+
+void CalibrationSnapshot::unmap() {
+    if (file_) {
+        file_->close();
+        file_.reset();
+    }
+}
+
+void CalibrationSnapshot::detach() {
+    if (!file_) {
+        return;
+    }
+
+    // 映射内存只读，修改前复制到内存
+    buffer_ = QByteArray(data_, static_cast<int>(size_));
+    unmap();
+    data_ = buffer_.constData();
+    size_ = buffer_.size();
+}
+
+void CalibrationSnapshot::finalize() {
+    auto* fileHeader = reinterpret_cast<FileHeader*>(buffer_.data());
+    fileHeader->headerCrc = 0;
+    fileHeader->headerCrc = crc32(buffer_.constData(), expectedLayout().headerSize);
+    data_ = buffer_.constData();
+}
+
+const FileHeader* CalibrationSnapshot::header() const {
+    return reinterpret_cast<const FileHeader*>(data_);
+}
+
+const SectionEntry* CalibrationSnapshot::entry(int index) const {
+    return reinterpret_cast<const SectionEntry*>(data_ + sizeof(FileHeader)) + index;
+}
+
+int CalibrationSnapshot::sectionIndex(MessageType messageType) const {
+    const QList<ExpectedSection>& sections = expectedLayout().sections;
+    for (int i = 0; i < sections.size(); ++i) {
+        if (sections[i].type == messageType) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+size_t CalibrationSnapshot::sectionSize(MessageType messageType) const {
+    int index = sectionIndex(messageType);
+    return index >= 0 ? entry(index)->size : 0;
+}
+
+bool CalibrationSnapshot::capture(const ShadowStateStore& store, const QList<MessageType>& types) {
+    const QList<MessageType> wanted = types.isEmpty() ? ShadowStateStore::trackedTypes() : types;
+
+    clear();
+    int captured = 0;
+    std::vector<char> message;
+    for (MessageType messageType : wanted) {
+        const size_t size = ShadowStateStore::messageSize(messageType);
+        if (size == 0) {
+            continue;
+        }
+        message.assign(size, 0);
+        if (store.read(messageType, message.data(), size) && setMessage(messageType, message.data(), size)) {
+            captured++;
+        }
+    }
+
+    qDebug() << "Calibration snapshot captured" << captured << "of" << wanted.size() << "messages";
+    return captured > 0;
+}
+
+bool CalibrationSnapshot::setMessage(MessageType messageType, const void* message, size_t size) {
+    int index = sectionIndex(messageType);
+    if (index < 0 || !message || size != entry(index)->size) {
+        errorString_ = QString("Invalid snapshot section: %1").arg(MessageTypeUtils::toString(messageType));
+        qWarning() << errorString_;
+        return false;
+    }
+
+    // 经编码/解码规范化：填充字节清零、bool取0/1，内容相同的结构体得到相同的节数据
+    std::vector<char> canonical(size, 0);
+    QByteArray encoded;
+    if (!MessageCodec::encode(messageType, message, size, encoded)
+        || !MessageCodec::decode(messageType, encoded, canonical.data(), size)) {
+        errorString_ = QString("Cannot normalize snapshot section: %1").arg(MessageTypeUtils::toString(messageType));
+        qWarning() << errorString_;
+        return false;
+    }
+
+    detach();
+    auto* section = reinterpret_cast<SectionEntry*>(buffer_.data() + sizeof(FileHeader)) + index;
+    std::memcpy(buffer_.data() + section->offset, canonical.data(), size);
+    section->flags |= SECTION_PRESENT;
+    section->crc = crc32(buffer_.constData() + section->offset, section->size);
+    finalize();
+    return true;
+}
+
+void CalibrationSnapshot::removeMessage(MessageType messageType) {
+    int index = sectionIndex(messageType);
+    if (index < 0 || !contains(messageType)) {
+        return;
+    }
+
+    detach();
+    auto* section = reinterpret_cast<SectionEntry*>(buffer_.data() + sizeof(FileHeader)) + index;
+    std::memset(buffer_.data() + section->offset, 0, section->size);
+    section->flags &= static_cast<uint16_t>(~SECTION_PRESENT);
+    section->crc = crc32(buffer_.constData() + section->offset, section->size);
+    finalize();
+}
+
+void CalibrationSnapshot::clear() {
+    initializeEmpty();
+    errorString_.clear();
+}
+
+bool CalibrationSnapshot::contains(MessageType messageType) const {
+    int index = sectionIndex(messageType);
+    return index >= 0 && (entry(index)->flags & SECTION_PRESENT);
+}
+
+QList<MessageType> CalibrationSnapshot::messageTypes() const {
+    QList<MessageType> types;
+    for (const ExpectedSection& section : expectedLayout().sections) {
+        if (contains(section.type)) {
+            types.append(section.type);
+        }
+    }
+    return types;
+}
+
+qint64 CalibrationSnapshot::createdMs() const {
+    return header()->createdMs;
+}
+
+const void* CalibrationSnapshot::messageData(MessageType messageType) const {
+    int index = sectionIndex(messageType);
+    if (index < 0 || !(entry(index)->flags & SECTION_PRESENT)) {
+        return nullptr;
+    }
+    return data_ + entry(index)->offset;
+}
+
+bool CalibrationSnapshot::encodeMessage(MessageType messageType, QByteArray& payload) const {
+    const void* message = messageData(messageType);
+    if (!message) {
+        return false;
+    }
+
+    if (!MessageCodec::encode(messageType, message, sectionSize(messageType), payload)) {
+        qWarning() << "Snapshot encode failed for" << MessageTypeUtils::toString(messageType);
+        return false;
+    }
+    return true;
+}
+
+QHash<MessageType, QVariantMap> CalibrationSnapshot::toParameters(const MessageSerializer& serializer) const {
+    QHash<MessageType, QVariantMap> calibration;
+    for (MessageType messageType : messageTypes()) {
+        QByteArray payload;
+        QVariantMap parameters;
+        if (encodeMessage(messageType, payload) && serializer.decodeParameters(messageType, payload, parameters)) {
+            calibration.insert(messageType, parameters);
+        } else {
+            qWarning() << "Snapshot section has no parameter mapping:" << MessageTypeUtils::toString(messageType);
+        }
+    }
+    return calibration;
+}
+
+QList<MessageType> CalibrationSnapshot::diff(const CalibrationSnapshot& other) const {
+    QList<MessageType> changed;
+    const QList<ExpectedSection>& sections = expectedLayout().sections;
+    for (int i = 0; i < sections.size(); ++i) {
+        const SectionEntry* mine = entry(i);
+        const SectionEntry* theirs = other.entry(i);
+
+        // 布局固定，先比较CRC，相同时再逐字节确认
+        const bool minePresent = mine->flags & SECTION_PRESENT;
+        const bool theirsPresent = theirs->flags & SECTION_PRESENT;
+        if (minePresent != theirsPresent
+            || mine->crc != theirs->crc
+            || std::memcmp(data_ + mine->offset, other.data_ + theirs->offset, mine->size) != 0) {
+            changed.append(sections[i].type);
+        }
+    }
+    return changed;
+}
+
+QByteArray CalibrationSnapshot::toByteArray() const {
+    return QByteArray(data_, static_cast<int>(size_));
+}
+
+bool CalibrationSnapshot::save(const QString& path) const {
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Cannot open snapshot file for writing:" << path << file.errorString();
+        return false;
+    }
+
+    if (file.write(data_, size_) != size_ || !file.commit()) {
+        qWarning() << "Failed to write snapshot file:" << path << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool CalibrationSnapshot::load(const QString& path, bool verifyChecksums) {
+    auto file = std::make_unique<QFile>(path);
+    if (!file->open(QIODevice::ReadOnly)) {
+        errorString_ = QString("Cannot open snapshot file: %1").arg(file->errorString());
+        qWarning() << errorString_ << path;
+        return false;
+    }
+
+    const qint64 fileSize = file->size();
+    uchar* mapped = fileSize > 0 ? file->map(0, fileSize) : nullptr;
+    if (!mapped) {
+        errorString_ = QString("Cannot map snapshot file: %1").arg(file->errorString());
+        qWarning() << errorString_ << path;
+        return false;
+    }
+
+    // 校验通过前保留原内容，失败时快照保持不变
+    const char* previousData = data_;
+    const qint64 previousSize = size_;
+    data_ = reinterpret_cast<const char*>(mapped);
+    size_ = fileSize;
+
+    if (!validate(verifyChecksums)) {
+        qWarning() << "Invalid snapshot file:" << path << errorString_;
+        data_ = previousData;
+        size_ = previousSize;
+        return false;
+    }
+
+    unmap();
+    buffer_.clear();
+    file_ = std::move(file);
+    return true;
+}
+
+bool CalibrationSnapshot::loadFromData(const QByteArray& data, bool verifyChecksums) {
+    const char* previousData = data_;
+    const qint64 previousSize = size_;
+    data_ = data.constData();
+    size_ = data.size();
+
+    if (!validate(verifyChecksums)) {
+        qWarning() << "Invalid snapshot data:" << errorString_;
+        data_ = previousData;
+        size_ = previousSize;
+        return false;
+    }
+
+    unmap();
+    buffer_ = data;
+    data_ = buffer_.constData();
+    size_ = buffer_.size();
+    return true;
+}
+
+bool CalibrationSnapshot::verify() const {
+    for (int i = 0; i < expectedLayout().sections.size(); ++i) {
+        const SectionEntry* section = entry(i);
+        if (crc32(data_ + section->offset, section->size) != section->crc) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CalibrationSnapshot::validate(bool verifyChecksums) {
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    errorString_ = "Snapshot files are little-endian; big-endian hosts are not supported";
+    return false;
+#endif
+
+    const ExpectedLayout& layout = expectedLayout();
+    if (size_ < static_cast<qint64>(layout.headerSize)) {
+        errorString_ = "Truncated snapshot header";
+        return false;
+    }
+
+    const FileHeader* fileHeader = header();
+    if (std::memcmp(fileHeader->magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) {
+        errorString_ = "Bad snapshot magic";
+        return false;
+    }
+    if (fileHeader->version != FORMAT_VERSION || fileHeader->headerSize != sizeof(FileHeader)) {
+        errorString_ = QString("Unsupported snapshot version: %1").arg(fileHeader->version);
+        return false;
+    }
+    if (fileHeader->sectionCount != static_cast<uint32_t>(layout.sections.size())
+        || fileHeader->fileSize != layout.fileSize
+        || size_ != static_cast<qint64>(layout.fileSize)) {
+        errorString_ = "Snapshot layout does not match this build";
+        return false;
+    }
+
+    // 文件头CRC计算时headerCrc字段视为0
+    FileHeader headerCopy = *fileHeader;
+    headerCopy.headerCrc = 0;
+    quint32 crc = crc32(reinterpret_cast<const char*>(&headerCopy), sizeof(FileHeader));
+    crc = crc32(data_ + sizeof(FileHeader), layout.headerSize - sizeof(FileHeader), crc);
+    if (crc != fileHeader->headerCrc) {
+        errorString_ = "Snapshot header checksum mismatch";
+        return false;
+    }
+
+    for (int i = 0; i < layout.sections.size(); ++i) {
+        const ExpectedSection& expected = layout.sections[i];
+        const SectionEntry* section = entry(i);
+        if (section->protoId != expected.protoId
+            || section->offset != expected.offset
+            || section->size != expected.size
+            || section->layoutHash != expected.layoutHash) {
+            errorString_ = QString("Snapshot section layout mismatch: %1").arg(MessageTypeUtils::toString(expected.type));
+            return false;
+        }
+        if (verifyChecksums && crc32(data_ + section->offset, section->size) != section->crc) {
+            errorString_ = QString("Snapshot section checksum mismatch: %1").arg(MessageTypeUtils::toString(expected.type));
+            return false;
+        }
+    }
+
+    errorString_.clear();
+    return true;
+}
+
+} // namespace Protocol
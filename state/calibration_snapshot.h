@@ -0,0 +1,181 @@
+#ifndef CALIBRATION_SNAPSHOT_H
+#define CALIBRATION_SNAPSHOT_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QVariantMap>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include "../core/message_types.h"
+
+class QFile;
+
+namespace Protocol {
+
+class MessageSerializer;
+class ShadowStateStore;
+
+/**
+ * @brief 标定快照文件格式（小端）
+ *
+ *   [FileHeader][SectionEntry × sectionCount][节数据，每节按8字节对齐]...
+ *
+ * 每种ERNC消息占一节，节的顺序、偏移和大小只由消息结构体决定，所有快照文件布局相同，
+ * 比较两个文件只需逐节比较。节数据为nanopb结构体的内存布局，layoutHash记录字段的偏移、
+ * 类型和数组长度，加载时与当前编译的结构体比对，一致时可直接把映射内存当作结构体读取。
+ * 未包含的消息flags中不置PRESENT位，数据为全零。
+ */
+namespace CalibrationSnapshotFormat {
+
+constexpr uint32_t FORMAT_VERSION = 1;
+constexpr uint16_t SECTION_PRESENT = 0x0001;
+
+struct FileHeader {
+    char magic[8];              // "ERNCSNP1"
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t sectionCount;
+    uint32_t fileSize;
+    int64_t createdMs;          // 抓取时间（墙上时间毫秒）
+    uint32_t headerCrc;         // 文件头与节目录的CRC32（计算时本字段为0）
+    uint32_t reserved[3];
+};
+
+struct SectionEntry {
+    uint16_t protoId;
+    uint16_t flags;
+    uint32_t layoutHash;        // 结构体布局指纹
+    uint32_t offset;            // 节数据在文件中的偏移
+    uint32_t size;              // 节数据长度（结构体大小）
+    uint32_t crc;               // 节数据的CRC32
+    uint32_t reserved;
+};
+
+static_assert(sizeof(FileHeader) == 48, "snapshot file header must stay 48 bytes");
+static_assert(sizeof(SectionEntry) == 24, "snapshot section entry must stay 24 bytes");
+
+} // namespace CalibrationSnapshotFormat
+
+/**
+ * @brief 标定快照
+ *
+ * 覆盖所有ERNC消息结构体的定长二进制快照。load()以只读方式映射文件，只校验文件头和各节CRC，
+ * 不做任何解析；message<T>()直接返回指向映射内存的结构体指针。
+ * 修改映射加载的快照时先复制到内存。仅支持小端主机。
+ */
+class CalibrationSnapshot {
+public:
+    CalibrationSnapshot();
+    ~CalibrationSnapshot();
+
+    CalibrationSnapshot(const CalibrationSnapshot&) = delete;
+    CalibrationSnapshot& operator=(const CalibrationSnapshot&) = delete;
+
+    /**
+     * @brief 从影子状态抓取快照
+     * @param store 影子状态
+     * @param types 要抓取的消息类型，为空表示所有消息
+     * @return 至少抓取到一种消息返回true
+     */
+    bool capture(const ShadowStateStore& store, const QList<MessageType>& types = QList<MessageType>());
+
+    /**
+     * @brief 写入一种消息的结构体（经编码/解码规范化后保存）
+     */
+    bool setMessage(MessageType messageType, const void* message, size_t size);
+
+    template<typename T>
+    bool setMessage(MessageType messageType, const T& message) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot sections are nanopb message structs");
+        return setMessage(messageType, &message, sizeof(T));
+    }
+
+    /**
+     * @brief 移除一种消息
+     */
+    void removeMessage(MessageType messageType);
+
+    /**
+     * @brief 清空快照
+     */
+    void clear();
+
+    /**
+     * @brief 读取接口
+     */
+
+    bool contains(MessageType messageType) const;
+    QList<MessageType> messageTypes() const;
+    qint64 createdMs() const;
+
+    // 节数据指针，未包含时返回nullptr；映射加载时指向映射内存
+    const void* messageData(MessageType messageType) const;
+
+    template<typename T>
+    const T* message(MessageType messageType) const {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot sections are nanopb message structs");
+        return sectionSize(messageType) == sizeof(T) ? static_cast<const T*>(messageData(messageType)) : nullptr;
+    }
+
+    /**
+     * @brief 把一种消息重新编码为消息载荷
+     */
+    bool encodeMessage(MessageType messageType, QByteArray& payload) const;
+
+    /**
+     * @brief 转换为参数映射（用于批量上传）
+     * @param serializer 用于把消息载荷解码为参数的序列化器
+     */
+    QHash<MessageType, QVariantMap> toParameters(const MessageSerializer& serializer) const;
+
+    /**
+     * @brief 比较两个快照，返回内容或有无不同的消息类型
+     */
+    QList<MessageType> diff(const CalibrationSnapshot& other) const;
+
+    /**
+     * @brief 文件读写
+     */
+
+    // 原子写入文件
+    bool save(const QString& path) const;
+
+    // 只读映射文件，verifyChecksums为false时跳过节CRC校验（文件头始终校验）
+    bool load(const QString& path, bool verifyChecksums = true);
+
+    // 从内存数据加载（数据被复制）
+    bool loadFromData(const QByteArray& data, bool verifyChecksums = true);
+
+    QByteArray toByteArray() const;
+
+    // 重新校验所有节的CRC
+    bool verify() const;
+
+    bool isMapped() const { return file_ != nullptr; }
+    QString errorString() const { return errorString_; }
+
+private:
+    const CalibrationSnapshotFormat::FileHeader* header() const;
+    const CalibrationSnapshotFormat::SectionEntry* entry(int index) const;
+    int sectionIndex(MessageType messageType) const;
+    size_t sectionSize(MessageType messageType) const;
+
+    bool validate(bool verifyChecksums);
+    void initializeEmpty();
+    void detach();
+    void unmap();
+    void finalize();
+
+    const char* data_;              // 当前数据（映射内存或buffer_）
+    qint64 size_;
+    QByteArray buffer_;             // 内存中的快照
+    std::unique_ptr<QFile> file_;   // 映射加载时的文件
+    QString errorString_;
+};
+
+} // namespace Protocol
+
+#endif // CALIBRATION_SNAPSHOT_H
@@ -0,0 +1,461 @@
+#include "shadow_state_store.h"
+#include "../serialization/message_codec.h"
+#include <QDebug>
+#include <QThread>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+extern "C" {
+#include "../nanopb/pb_common.h"
+#include "../messages/ERNC_praram.pb.h"
+}
+
+namespace Protocol {
+
+namespace {
+
+// 字段名表，由nanopb生成的FIELDLIST展开，顺序与字段描述一致
+#define SHADOW_FIELD_NAME(a, allocation, label, type, name, tag) #name,
+
+const char* const CHANNEL_NUMBER_FIELDS[]    = { MSG_ChannelNumber_FIELDLIST(SHADOW_FIELD_NAME, 0) };
+const char* const CHANNEL_AMPLITUDE_FIELDS[] = { MSG_ChannelAmplitude_FIELDLIST(SHADOW_FIELD_NAME, 0) };
+const char* const CHANNEL_SWITCH_FIELDS[]    = { MSG_ChannelSwitch_FIELDLIST(SHADOW_FIELD_NAME, 0) };
+const char* const CHECK_MOD_FIELDS[]         = { MSG_CheckMod_FIELDLIST(SHADOW_FIELD_NAME, 0) };
+const char* const ANC_SWITCH_FIELDS[]        = { MSG_AncSwitch_FIELDLIST(SHADOW_FIELD_NAME, 0) };
+const char* const VEHICLE_STATE_FIELDS[]     = { MSG_VehicleState_FIELDLIST(SHADOW_FIELD_NAME, 0) };
+const char* const TRAN_FUNC_FLAG_FIELDS[]    = { MSG_TranFuncFlag_FIELDLIST(SHADOW_FIELD_NAME, 0) };
+const char* const TRAN_FUNC_STATE_FIELDS[]   = { MSG_TranFuncState_FIELDLIST(SHADOW_FIELD_NAME, 0) };
+const char* const FILTER_RANGES_FIELDS[]     = { MSG_FilterRanges_FIELDLIST(SHADOW_FIELD_NAME, 0) };
+const char* const SYSTEM_RANGES_FIELDS[]     = { MSG_SystemRanges_FIELDLIST(SHADOW_FIELD_NAME, 0) };
+const char* const ORDER_FLAG_FIELDS[]        = { MSG_OrderFlag_FIELDLIST(SHADOW_FIELD_NAME, 0) };
+const char* const ORDER2_PARAMS_FIELDS[]     = { MSG_Order2Params_FIELDLIST(SHADOW_FIELD_NAME, 0) };
+const char* const ORDER4_PARAMS_FIELDS[]     = { MSG_Order4Params_FIELDLIST(SHADOW_FIELD_NAME, 0) };
+const char* const ORDER6_PARAMS_FIELDS[]     = { MSG_Order6Params_FIELDLIST(SHADOW_FIELD_NAME, 0) };
+const char* const ALPHA_PARAMS_FIELDS[]      = { MSG_AlphaParams_FIELDLIST(SHADOW_FIELD_NAME, 0) };
+const char* const FREQ_DIVISION_FIELDS[]     = { MSG_FreqDivision_FIELDLIST(SHADOW_FIELD_NAME, 0) };
+const char* const THRESHOLDS_FIELDS[]        = { MSG_Thresholds_FIELDLIST(SHADOW_FIELD_NAME, 0) };
+
+#undef SHADOW_FIELD_NAME
+
+#define SHADOW_FIELD_NAMES(names) names, static_cast<int>(sizeof(names) / sizeof(names[0]))
+
+struct MessageLayout {
+    MessageType type;
+    const pb_msgdesc_t* fields;
+    size_t size;
+    const char* const* fieldNames;
+    int fieldCount;
+};
+
+const MessageLayout MESSAGE_LAYOUTS[] = {
+    { MessageType::CHANNEL_NUMBER,    MSG_ChannelNumber_fields,    sizeof(MSG_ChannelNumber),    SHADOW_FIELD_NAMES(CHANNEL_NUMBER_FIELDS) },
+    { MessageType::CHANNEL_AMPLITUDE, MSG_ChannelAmplitude_fields, sizeof(MSG_ChannelAmplitude), SHADOW_FIELD_NAMES(CHANNEL_AMPLITUDE_FIELDS) },
+    { MessageType::CHANNEL_SWITCH,    MSG_ChannelSwitch_fields,    sizeof(MSG_ChannelSwitch),    SHADOW_FIELD_NAMES(CHANNEL_SWITCH_FIELDS) },
+    { MessageType::CHECK_MOD,         MSG_CheckMod_fields,         sizeof(MSG_CheckMod),         SHADOW_FIELD_NAMES(CHECK_MOD_FIELDS) },
+    { MessageType::ANC_SWITCH,        MSG_AncSwitch_fields,        sizeof(MSG_AncSwitch),        SHADOW_FIELD_NAMES(ANC_SWITCH_FIELDS) },
+    { MessageType::VEHICLE_STATE,     MSG_VehicleState_fields,     sizeof(MSG_VehicleState),     SHADOW_FIELD_NAMES(VEHICLE_STATE_FIELDS) },
+    { MessageType::TRAN_FUNC_FLAG,    MSG_TranFuncFlag_fields,     sizeof(MSG_TranFuncFlag),     SHADOW_FIELD_NAMES(TRAN_FUNC_FLAG_FIELDS) },
+    { MessageType::TRAN_FUNC_STATE,   MSG_TranFuncState_fields,    sizeof(MSG_TranFuncState),    SHADOW_FIELD_NAMES(TRAN_FUNC_STATE_FIELDS) },
+    { MessageType::FILTER_RANGES,     MSG_FilterRanges_fields,     sizeof(MSG_FilterRanges),     SHADOW_FIELD_NAMES(FILTER_RANGES_FIELDS) },
+    { MessageType::SYSTEM_RANGES,     MSG_SystemRanges_fields,     sizeof(MSG_SystemRanges),     SHADOW_FIELD_NAMES(SYSTEM_RANGES_FIELDS) },
+    { MessageType::ORDER_FLAG,        MSG_OrderFlag_fields,        sizeof(MSG_OrderFlag),        SHADOW_FIELD_NAMES(ORDER_FLAG_FIELDS) },
+    { MessageType::ORDER2_PARAMS,     MSG_Order2Params_fields,     sizeof(MSG_Order2Params),     SHADOW_FIELD_NAMES(ORDER2_PARAMS_FIELDS) },
+    { MessageType::ORDER4_PARAMS,     MSG_Order4Params_fields,     sizeof(MSG_Order4Params),     SHADOW_FIELD_NAMES(ORDER4_PARAMS_FIELDS) },
+    { MessageType::ORDER6_PARAMS,     MSG_Order6Params_fields,     sizeof(MSG_Order6Params),     SHADOW_FIELD_NAMES(ORDER6_PARAMS_FIELDS) },
+    { MessageType::ALPHA_PARAMS,      MSG_AlphaParams_fields,      sizeof(MSG_AlphaParams),      SHADOW_FIELD_NAMES(ALPHA_PARAMS_FIELDS) },
+    { MessageType::FREQ_DIVISION,     MSG_FreqDivision_fields,     sizeof(MSG_FreqDivision),     SHADOW_FIELD_NAMES(FREQ_DIVISION_FIELDS) },
+    { MessageType::THRESHOLDS,        MSG_Thresholds_fields,       sizeof(MSG_Thresholds),       SHADOW_FIELD_NAMES(THRESHOLDS_FIELDS) },
+};
+
+#undef SHADOW_FIELD_NAMES
+
+// 变更集用64位掩码表示字段
+constexpr int MAX_FIELDS = 64;
+
+constexpr int LAYOUT_COUNT = static_cast<int>(sizeof(MESSAGE_LAYOUTS) / sizeof(MESSAGE_LAYOUTS[0]));
+
+// 最大的消息结构体所占的64位字数，读写时在栈上开辟缓冲区
+constexpr size_t LARGEST_MESSAGE_SIZE = std::max({
+    sizeof(MSG_ChannelNumber), sizeof(MSG_ChannelAmplitude), sizeof(MSG_ChannelSwitch),
+    sizeof(MSG_CheckMod), sizeof(MSG_AncSwitch), sizeof(MSG_VehicleState),
+    sizeof(MSG_TranFuncFlag), sizeof(MSG_TranFuncState), sizeof(MSG_FilterRanges),
+    sizeof(MSG_SystemRanges), sizeof(MSG_OrderFlag), sizeof(MSG_Order2Params),
+    sizeof(MSG_Order4Params), sizeof(MSG_Order6Params), sizeof(MSG_AlphaParams),
+    sizeof(MSG_FreqDivision), sizeof(MSG_Thresholds)
+});
+constexpr int MAX_WORDS = static_cast<int>((LARGEST_MESSAGE_SIZE + sizeof(quint64) - 1) / sizeof(quint64));
+
+qint64 monotonicNs()
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+int layoutIndex(MessageType messageType)
+{
+    for (int i = 0; i < LAYOUT_COUNT; ++i) {
+        if (MESSAGE_LAYOUTS[i].type == messageType) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+} // namespace
+
+ShadowStateStore::ShadowStateStore()
+    : globalVersion_(0)
+    , updates_(0)
+    , unchangedUpdates_(0)
+    , decodeErrors_(0)
+    , readRetries_(0)
+{
+    static_assert(SLOT_COUNT == LAYOUT_COUNT, "one shadow slot per message layout");
+    static_assert(LARGEST_MESSAGE_SIZE <= MAX_MESSAGE_SIZE, "MAX_MESSAGE_SIZE must cover every message struct");
+
+    for (int i = 0; i < SLOT_COUNT; ++i) {
+        Slot& slot = entries_[i];
+        slot.fields = MESSAGE_LAYOUTS[i].fields;
+        slot.size = MESSAGE_LAYOUTS[i].size;
+        slot.wordCount = static_cast<int>((slot.size + sizeof(quint64) - 1) / sizeof(quint64));
+        slot.words.reset(new std::atomic<quint64>[slot.wordCount]);
+        for (int w = 0; w < slot.wordCount; ++w) {
+            slot.words[w].store(0, std::memory_order_relaxed);
+        }
+
+        // 记录每个字段在结构体中的位置，用于字段级比较
+        quint64 probe[MAX_WORDS] = {};
+        slot.fieldCount = std::min(MESSAGE_LAYOUTS[i].fieldCount, MAX_FIELDS);
+        slot.spans.reset(new FieldSpan[slot.fieldCount]);
+        pb_field_iter_t iter;
+        int field = 0;
+        if (pb_field_iter_begin(&iter, slot.fields, probe)) {
+            do {
+                if (field >= slot.fieldCount) {
+                    break;
+                }
+                const size_t offset = static_cast<const char*>(iter.pField) - reinterpret_cast<const char*>(probe);
+                const size_t arraySize = iter.array_size > 0 ? iter.array_size : 1;
+                slot.spans[field].offset = static_cast<quint16>(offset);
+                slot.spans[field].size = static_cast<quint16>(iter.data_size * arraySize);
+                field++;
+            } while (pb_field_iter_next(&iter));
+        }
+        if (field != MESSAGE_LAYOUTS[i].fieldCount) {
+            qWarning() << "Shadow state field table mismatch for" << MessageTypeUtils::toString(MESSAGE_LAYOUTS[i].type);
+        }
+    }
+}
+
+ShadowStateStore::~ShadowStateStore() = default;
+
+bool ShadowStateStore::isTracked(MessageType messageType) {
+    return layoutIndex(messageType) >= 0;
+}
+
+size_t ShadowStateStore::messageSize(MessageType messageType) {
+    int index = layoutIndex(messageType);
+    return index >= 0 ? MESSAGE_LAYOUTS[index].size : 0;
+}
+
+const pb_msgdesc_t* ShadowStateStore::messageFields(MessageType messageType) {
+    int index = layoutIndex(messageType);
+    return index >= 0 ? MESSAGE_LAYOUTS[index].fields : nullptr;
+}
+
+QList<MessageType> ShadowStateStore::trackedTypes() {
+    QList<MessageType> types;
+    types.reserve(LAYOUT_COUNT);
+    for (const MessageLayout& layout : MESSAGE_LAYOUTS) {
+        types.append(layout.type);
+    }
+    return types;
+}
+
+int ShadowStateStore::fieldCount(MessageType messageType) {
+    int index = layoutIndex(messageType);
+    return index >= 0 ? std::min(MESSAGE_LAYOUTS[index].fieldCount, MAX_FIELDS) : 0;
+}
+
+int ShadowStateStore::fieldIndex(MessageType messageType, const QString& fieldName) {
+    int index = layoutIndex(messageType);
+    if (index < 0) {
+        return -1;
+    }
+
+    const MessageLayout& layout = MESSAGE_LAYOUTS[index];
+    const QByteArray name = fieldName.toLatin1();
+    for (int i = 0; i < layout.fieldCount && i < MAX_FIELDS; ++i) {
+        if (name == layout.fieldNames[i]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+QString ShadowStateStore::fieldName(MessageType messageType, int fieldIndex) {
+    int index = layoutIndex(messageType);
+    if (index < 0 || fieldIndex < 0 || fieldIndex >= fieldCount(messageType)) {
+        return QString();
+    }
+    return QString::fromLatin1(MESSAGE_LAYOUTS[index].fieldNames[fieldIndex]);
+}
+
+void ShadowStateStore::setChangeListener(ChangeListener listener) {
+    changeListener_ = std::move(listener);
+}
+
+ShadowStateStore::Slot* ShadowStateStore::slotFor(MessageType messageType) {
+    int index = layoutIndex(messageType);
+    return index >= 0 ? &entries_[index] : nullptr;
+}
+
+const ShadowStateStore::Slot* ShadowStateStore::slotFor(MessageType messageType) const {
+    int index = layoutIndex(messageType);
+    return index >= 0 ? &entries_[index] : nullptr;
+}
+
+bool ShadowStateStore::update(MessageType messageType, const ScatterSpan& payload, ChangeSet* changes) {
+    Slot* slot = slotFor(messageType);
+    if (!slot) {
+        return false;
+    }
+
+    // 解码到清零的缓冲区，结构体填充字节保持为0，便于逐字比较
+    quint64 buffer[MAX_WORDS] = {};
+    if (!MessageCodec::decode(messageType, payload, buffer, slot->size)) {
+        decodeErrors_.fetch_add(1, std::memory_order_relaxed);
+        qWarning() << "Shadow state decode failed for" << MessageTypeUtils::toString(messageType);
+        return false;
+    }
+
+    publish(*slot, buffer, changes);
+    return true;
+}
+
+bool ShadowStateStore::store(MessageType messageType, const void* message, size_t size, ChangeSet* changes) {
+    Slot* slot = slotFor(messageType);
+    if (!slot || !message || size != slot->size) {
+        qWarning() << "Shadow state store rejected for" << MessageTypeUtils::toString(messageType)
+                   << "size:" << size;
+        return false;
+    }
+
+    quint64 buffer[MAX_WORDS] = {};
+    std::memcpy(buffer, message, size);
+    publish(*slot, buffer, changes);
+    return true;
+}
+
+quint64 ShadowStateStore::beginWrite(Slot& slot) {
+    // 写入方之间通过把序号置为奇数互斥
+    quint64 sequence = slot.sequence.load(std::memory_order_relaxed);
+    for (;;) {
+        if (sequence & 1u) {
+            QThread::yieldCurrentThread();
+            sequence = slot.sequence.load(std::memory_order_relaxed);
+            continue;
+        }
+        if (slot.sequence.compare_exchange_weak(sequence, sequence + 1,
+                                                std::memory_order_acquire,
+                                                std::memory_order_relaxed)) {
+            break;
+        }
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    return sequence;
+}
+
+void ShadowStateStore::endWrite(Slot& slot, quint64 sequence) {
+    slot.sequence.store(sequence, std::memory_order_release);
+}
+
+bool ShadowStateStore::publish(Slot& slot, const quint64* words, ChangeSet* changes) {
+    updates_.fetch_add(1, std::memory_order_relaxed);
+
+    ChangeSet changeSet;
+    changeSet.messageType = MESSAGE_LAYOUTS[&slot - entries_].type;
+
+    const quint64 sequence = beginWrite(slot);
+    slot.refreshedNs.store(monotonicNs(), std::memory_order_relaxed);
+
+    // 写入方独占期间逐字比较当前内容，未变化时不递增版本号；同时保留旧内容用于字段级比较
+    quint64 previous[MAX_WORDS];
+    changeSet.initial = slot.version.load(std::memory_order_relaxed) == 0;
+    bool changed = changeSet.initial;
+    for (int w = 0; w < slot.wordCount; ++w) {
+        previous[w] = slot.words[w].load(std::memory_order_relaxed);
+        changed = changed || previous[w] != words[w];
+    }
+
+    if (!changed) {
+        // 内容未变，恢复原序号，并发读取方无需重试
+        endWrite(slot, sequence);
+        unchangedUpdates_.fetch_add(1, std::memory_order_relaxed);
+        if (changes) {
+            *changes = changeSet;
+        }
+        return false;
+    }
+
+    for (int w = 0; w < slot.wordCount; ++w) {
+        slot.words[w].store(words[w], std::memory_order_relaxed);
+    }
+    changeSet.version = globalVersion_.fetch_add(1, std::memory_order_acq_rel) + 1;
+    slot.version.store(changeSet.version, std::memory_order_relaxed);
+
+    endWrite(slot, sequence + 2);
+
+    // 释放消息槽后再逐字段比较，不延长读取方的等待
+    if (changeSet.initial) {
+        changeSet.fieldMask = slot.fieldCount >= MAX_FIELDS ? ~quint64(0) : (quint64(1) << slot.fieldCount) - 1;
+    } else {
+        const char* before = reinterpret_cast<const char*>(previous);
+        const char* after = reinterpret_cast<const char*>(words);
+        for (int i = 0; i < slot.fieldCount; ++i) {
+            const FieldSpan& span = slot.spans[i];
+            if (std::memcmp(before + span.offset, after + span.offset, span.size) != 0) {
+                changeSet.fieldMask |= quint64(1) << i;
+            }
+        }
+    }
+
+    if (changes) {
+        *changes = changeSet;
+    }
+    if (changeListener_) {
+        changeListener_(changeSet);
+    }
+    return true;
+}
+
+bool ShadowStateStore::read(MessageType messageType, void* out, size_t size, quint64* version) const {
+    const Slot* slot = slotFor(messageType);
+    if (!slot || !out || size != slot->size) {
+        qWarning() << "Shadow state read rejected for" << MessageTypeUtils::toString(messageType)
+                   << "size:" << size;
+        return false;
+    }
+
+    quint64 buffer[MAX_WORDS];
+    quint64 snapshotVersion = 0;
+    for (;;) {
+        const quint64 before = slot->sequence.load(std::memory_order_acquire);
+        if (before & 1u) {
+            readRetries_.fetch_add(1, std::memory_order_relaxed);
+            QThread::yieldCurrentThread();
+            continue;
+        }
+
+        snapshotVersion = slot->version.load(std::memory_order_relaxed);
+        for (int w = 0; w < slot->wordCount; ++w) {
+            buffer[w] = slot->words[w].load(std::memory_order_relaxed);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot->sequence.load(std::memory_order_relaxed) == before) {
+            break;
+        }
+        readRetries_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (snapshotVersion == 0) {
+        return false;
+    }
+
+    std::memcpy(out, buffer, size);
+    if (version) {
+        *version = snapshotVersion;
+    }
+    return true;
+}
+
+bool ShadowStateStore::encode(MessageType messageType, QByteArray& payload, quint64* version) const {
+    const Slot* slot = slotFor(messageType);
+    if (!slot) {
+        return false;
+    }
+
+    quint64 buffer[MAX_WORDS];
+    if (!read(messageType, buffer, slot->size, version)) {
+        return false;
+    }
+
+    if (!MessageCodec::encode(messageType, buffer, slot->size, payload)) {
+        qWarning() << "Shadow state encode failed for" << MessageTypeUtils::toString(messageType);
+        return false;
+    }
+    return true;
+}
+
+qint64 ShadowStateStore::ageMs(MessageType messageType) const {
+    const Slot* slot = slotFor(messageType);
+    if (!slot || slot->version.load(std::memory_order_acquire) == 0) {
+        return -1;
+    }
+
+    const qint64 refreshedNs = slot->refreshedNs.load(std::memory_order_relaxed);
+    return refreshedNs < 0 ? -1 : (monotonicNs() - refreshedNs) / 1000000;
+}
+
+quint64 ShadowStateStore::version(MessageType messageType) const {
+    const Slot* slot = slotFor(messageType);
+    return slot ? slot->version.load(std::memory_order_acquire) : 0;
+}
+
+bool ShadowStateStore::hasChangedSince(MessageType messageType, quint64 version) const {
+    return this->version(messageType) > version;
+}
+
+bool ShadowStateStore::hasAnyChangedSince(quint64 globalVersion) const {
+    return globalVersion_.load(std::memory_order_acquire) > globalVersion;
+}
+
+QList<MessageType> ShadowStateStore::changedSince(quint64 globalVersion) const {
+    QList<MessageType> changed;
+    if (!hasAnyChangedSince(globalVersion)) {
+        return changed;
+    }
+
+    for (int i = 0; i < SLOT_COUNT; ++i) {
+        if (entries_[i].version.load(std::memory_order_acquire) > globalVersion) {
+            changed.append(MESSAGE_LAYOUTS[i].type);
+        }
+    }
+    return changed;
+}
+
+void ShadowStateStore::clear() {
+    for (int i = 0; i < SLOT_COUNT; ++i) {
+        Slot& slot = entries_[i];
+        const quint64 sequence = beginWrite(slot);
+        for (int w = 0; w < slot.wordCount; ++w) {
+            slot.words[w].store(0, std::memory_order_relaxed);
+        }
+        slot.version.store(0, std::memory_order_relaxed);
+        slot.refreshedNs.store(-1, std::memory_order_relaxed);
+        endWrite(slot, sequence + 2);
+    }
+
+    qDebug() << "Shadow state cleared";
+}
+
+ShadowStateStore::Statistics ShadowStateStore::getStatistics() const {
+    Statistics stats;
+    stats.updates = updates_.load(std::memory_order_relaxed);
+    stats.unchangedUpdates = unchangedUpdates_.load(std::memory_order_relaxed);
+    stats.decodeErrors = decodeErrors_.load(std::memory_order_relaxed);
+    stats.readRetries = readRetries_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void ShadowStateStore::resetStatistics() {
+    updates_.store(0, std::memory_order_relaxed);
+    unchangedUpdates_.store(0, std::memory_order_relaxed);
+    decodeErrors_.store(0, std::memory_order_relaxed);
+    readRetries_.store(0, std::memory_order_relaxed);
+}
+
+} // namespace Protocol
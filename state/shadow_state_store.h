@@ -0,0 +1,243 @@
+#ifndef SHADOW_STATE_STORE_H
+#define SHADOW_STATE_STORE_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include "../core/message_types.h"
+#include "../serialization/scatter_span.h"
+
+extern "C" {
+#include "../nanopb/pb.h"
+}
+
+namespace Protocol {
+
+/**
+ * @brief 设备参数影子状态
+ *
+ * 保存每种MSG_*消息最后一次从设备收到的解码结果（nanopb结构体原样保存），由解码路径更新；
+ * 读-改-写发送成功后，发出的完整消息也会写回，使影子状态与设备保持一致。
+ * 每个消息槽由序列锁（seqlock）保护：写入方独占写入，读取方无锁读取，
+ * 遇到并发写入时重试，读到的总是某一次完整写入的快照。
+ *
+ * 每个消息槽带版本号，只有内容实际变化时才递增；版本号取自全局递增计数，
+ * 读取方保存一次globalVersion()，之后即可用hasAnyChangedSince()/changedSince()廉价判断是否有变化。
+ *
+ * 写入时先逐字比较新旧结构体，内容变化时再逐字段比较，得到字段级的变更集（ChangeSet），
+ * 通过变更监听器每条消息通知一次；内容未变化的写入不产生任何通知。
+ */
+class ShadowStateStore {
+public:
+    ShadowStateStore();
+    ~ShadowStateStore();
+
+    ShadowStateStore(const ShadowStateStore&) = delete;
+    ShadowStateStore& operator=(const ShadowStateStore&) = delete;
+
+    /**
+     * @brief 一次写入的字段级变更集
+     *
+     * 字段序号为字段在nanopb描述中的顺序（即.proto中的声明顺序），每种消息不超过64个字段。
+     */
+    struct ChangeSet {
+        MessageType messageType = MessageType::ANC_SWITCH;
+        quint64 version = 0;        // 写入后的版本号
+        quint64 fieldMask = 0;      // 第i位置位表示第i个字段变化
+        bool initial = false;       // 首次收到该消息，所有字段都视为变化
+
+        bool isEmpty() const { return fieldMask == 0; }
+        bool contains(int fieldIndex) const {
+            return fieldIndex >= 0 && fieldIndex < 64 && (fieldMask & (quint64(1) << fieldIndex)) != 0;
+        }
+    };
+
+    // 变更监听器，在写入线程中调用
+    using ChangeListener = std::function<void(const ChangeSet&)>;
+
+    /**
+     * @brief 是否保存该消息类型的影子状态
+     */
+    static bool isTracked(MessageType messageType);
+
+    /**
+     * @brief 消息类型对应的nanopb结构体大小，不支持的类型返回0
+     */
+    static size_t messageSize(MessageType messageType);
+
+    /**
+     * @brief 消息类型对应的nanopb字段描述，不支持的类型返回nullptr
+     */
+    static const pb_msgdesc_t* messageFields(MessageType messageType);
+
+    /**
+     * @brief 所有保存影子状态的消息类型（顺序固定）
+     */
+    static QList<MessageType> trackedTypes();
+
+    // 消息结构体大小的上限，可用于在栈上开辟解码缓冲区
+    static constexpr size_t MAX_MESSAGE_SIZE = 256;
+
+    /**
+     * @brief 字段信息
+     */
+
+    // 消息的字段数，不支持的类型返回0
+    static int fieldCount(MessageType messageType);
+
+    // 按字段名（.proto中的名称）查找字段序号，不存在返回-1
+    static int fieldIndex(MessageType messageType, const QString& fieldName);
+
+    // 字段序号对应的字段名，序号无效返回空字符串
+    static QString fieldName(MessageType messageType, int fieldIndex);
+
+    /**
+     * @brief 设置变更监听器
+     *
+     * 只有内容实际变化的写入才会调用，每次写入调用一次。监听器在写入方释放消息槽之后调用，
+     * 可以在其中读取影子状态。应在开始接收数据前设置，运行期间更换监听器不是线程安全的。
+     */
+    void setChangeListener(ChangeListener listener);
+
+    /**
+     * @brief 解码消息载荷并更新影子状态（线程安全）
+     * @param messageType 消息类型
+     * @param payload oneof字段内的消息载荷（不含MsgRequestResponse封装）
+     * @param changes 输出：本次写入的变更集（内容未变化时为空），可为空
+     * @return 解码成功返回true（内容未变化也返回true）
+     */
+    bool update(MessageType messageType, const QByteArray& payload, ChangeSet* changes = nullptr) {
+        return update(messageType, ScatterSpan(payload), changes);
+    }
+
+    /**
+     * @brief 直接在接收缓冲区上解码并更新影子状态（线程安全）
+     *
+     * 载荷可以由两段组成（见ScatterSpan），调用返回后不再访问。
+     */
+    bool update(MessageType messageType, const ScatterSpan& payload, ChangeSet* changes = nullptr);
+
+    /**
+     * @brief 直接写入已解码的结构体（线程安全）
+     * @param messageType 消息类型
+     * @param message 结构体指针
+     * @param size 结构体大小，必须与messageSize()一致
+     * @param changes 输出：本次写入的变更集（内容未变化时为空），可为空
+     * @return 成功返回true
+     */
+    bool store(MessageType messageType, const void* message, size_t size, ChangeSet* changes = nullptr);
+
+    /**
+     * @brief 无锁读取影子状态（线程安全）
+     * @param messageType 消息类型
+     * @param out 输出缓冲区
+     * @param size 缓冲区大小，必须与messageSize()一致
+     * @param version 输出：快照对应的版本号，可为空
+     * @return 已收到过该消息返回true
+     */
+    bool read(MessageType messageType, void* out, size_t size, quint64* version = nullptr) const;
+
+    /**
+     * @brief 读取影子状态到对应的MSG_*结构体
+     */
+    template<typename T>
+    bool snapshot(MessageType messageType, T& out, quint64* version = nullptr) const {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot requires a nanopb message struct");
+        return read(messageType, &out, sizeof(T), version);
+    }
+
+    /**
+     * @brief 把影子状态重新编码为消息载荷（线程安全）
+     * @param messageType 消息类型
+     * @param payload 输出：消息载荷，全部为默认值时为空
+     * @param version 输出：快照对应的版本号，可为空
+     * @return 已收到过该消息且编码成功返回true
+     */
+    bool encode(MessageType messageType, QByteArray& payload, quint64* version = nullptr) const;
+
+    /**
+     * @brief 距最后一次写入的时间（毫秒），内容未变化的写入也会刷新；从未收到过返回-1
+     */
+    qint64 ageMs(MessageType messageType) const;
+
+    /**
+     * @brief 消息的当前版本号，从未收到过返回0
+     */
+    quint64 version(MessageType messageType) const;
+
+    /**
+     * @brief 全局版本号，等于所有消息版本号中的最大值
+     */
+    quint64 globalVersion() const { return globalVersion_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief 变化检测
+     */
+    bool hasChangedSince(MessageType messageType, quint64 version) const;
+    bool hasAnyChangedSince(quint64 globalVersion) const;
+    QList<MessageType> changedSince(quint64 globalVersion) const;
+
+    /**
+     * @brief 丢弃所有影子状态（例如断线后设备状态未知）
+     */
+    void clear();
+
+    /**
+     * @brief 统计信息
+     */
+    struct Statistics {
+        quint64 updates = 0;            // 写入次数
+        quint64 unchangedUpdates = 0;   // 内容未变化的写入次数
+        quint64 decodeErrors = 0;       // 载荷解码失败次数
+        quint64 readRetries = 0;        // 读取因并发写入而重试的次数
+    };
+
+    Statistics getStatistics() const;
+    void resetStatistics();
+
+private:
+    // 字段在结构体中的位置
+    struct FieldSpan {
+        quint16 offset = 0;
+        quint16 size = 0;
+    };
+
+    struct alignas(64) Slot {
+        std::atomic<quint64> sequence{0};       // 奇数表示正在写入
+        std::atomic<quint64> version{0};        // 0表示从未收到
+        std::atomic<qint64> refreshedNs{-1};    // 最后一次写入的单调时钟
+        std::unique_ptr<std::atomic<quint64>[]> words;
+        int wordCount = 0;
+        size_t size = 0;
+        const pb_msgdesc_t* fields = nullptr;
+        std::unique_ptr<FieldSpan[]> spans;     // 按字段序号
+        int fieldCount = 0;
+    };
+
+    Slot* slotFor(MessageType messageType);
+    const Slot* slotFor(MessageType messageType) const;
+
+    bool publish(Slot& slot, const quint64* words, ChangeSet* changes);
+
+    quint64 beginWrite(Slot& slot);
+    void endWrite(Slot& slot, quint64 sequence);
+
+    static constexpr int SLOT_COUNT = 17;
+
+    Slot entries_[SLOT_COUNT];
+    std::atomic<quint64> globalVersion_;
+    ChangeListener changeListener_;
+
+    std::atomic<quint64> updates_;
+    std::atomic<quint64> unchangedUpdates_;
+    std::atomic<quint64> decodeErrors_;
+    mutable std::atomic<quint64> readRetries_;
+};
+
+} // namespace Protocol
+
+#endif // SHADOW_STATE_STORE_H
@@ -0,0 +1,354 @@
+#include "time_series_store.h"
+#include "../serialization/message_codec.h"
+#include <QDebug>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+namespace Protocol {
+
+namespace {
+
+constexpr int MIN_CAPACITY = 64;
+constexpr int MAX_CAPACITY = 1 << 24;
+constexpr int MAX_LEVELS = 12;
+
+// 读取时跳过环中最旧的1/16：这部分即将被覆盖，避免读取期间被写入方追上
+constexpr quint64 READ_GUARD_DIVISOR = 16;
+
+} // namespace
+
+/**
+ * @brief 单个级别的环形缓冲区（列式）
+ */
+struct TimeSeriesStore::Ring {
+    std::unique_ptr<std::atomic<qint64>[]> timestamps;
+    std::unique_ptr<std::atomic<float>[]> minimum;      // 原始采样层为采样值
+    std::unique_ptr<std::atomic<float>[]> maximum;      // 原始采样层为空
+    quint64 capacity = 0;
+    quint64 mask = 0;
+    std::atomic<quint64> head{0};                       // 已发布的条数
+    std::atomic<quint64> reserved{0};                   // 已开始写入的条数，先于数据更新
+
+    // 读取方可安全读取的最旧序号
+    quint64 firstReadable(quint64 published) const {
+        const quint64 window = capacity - capacity / READ_GUARD_DIVISOR;
+        return published > window ? published - window : 0;
+    }
+
+    qint64 timestampAt(quint64 index) const {
+        return timestamps[index & mask].load(std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @brief 一个通道的全部级别
+ */
+struct TimeSeriesStore::Series {
+    // 正在累计的桶（写入方私有）
+    struct Pending {
+        qint64 timestampNs = 0;
+        float minimum = 0.0f;
+        float maximum = 0.0f;
+        int count = 0;
+    };
+
+    std::unique_ptr<Ring[]> rings;                      // [0]为原始采样，[l]为第l级
+    std::unique_ptr<Pending[]> pending;                 // [l]为第l级正在累计的桶
+    qint64 lastTimestampNs = std::numeric_limits<qint64>::min();
+};
+
+TimeSeriesStore::TimeSeriesStore(int capacity, int levels)
+    : capacity_(MIN_CAPACITY)
+    , levelCapacity_(0)
+    , levels_(qBound(0, levels, MAX_LEVELS))
+    , series_(new std::atomic<Series*>[CHANNEL_COUNT])
+{
+    while (capacity_ < capacity && capacity_ < MAX_CAPACITY) {
+        capacity_ *= 2;
+    }
+    levelCapacity_ = capacity_ / DECIMATION_FACTOR;
+
+    for (int i = 0; i < CHANNEL_COUNT; ++i) {
+        series_[i].store(nullptr, std::memory_order_relaxed);
+    }
+
+    qDebug() << "TimeSeriesStore initialized, capacity:" << capacity_ << "levels:" << levels_;
+}
+
+TimeSeriesStore::~TimeSeriesStore() {
+    for (int i = 0; i < CHANNEL_COUNT; ++i) {
+        delete series_[i].load(std::memory_order_relaxed);
+    }
+}
+
+qint64 TimeSeriesStore::now() {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+TimeSeriesStore::Series* TimeSeriesStore::seriesFor(int channel) {
+    if (channel < 0 || channel >= CHANNEL_COUNT) {
+        return nullptr;
+    }
+
+    // 只有写入方分配，读取方看到空指针时视为没有数据
+    Series* series = series_[channel].load(std::memory_order_relaxed);
+    if (series) {
+        return series;
+    }
+
+    series = new Series;
+    series->rings.reset(new Ring[levels_ + 1]);
+    series->pending.reset(new Series::Pending[levels_ + 1]);
+    for (int level = 0; level <= levels_; ++level) {
+        Ring& ring = series->rings[level];
+        ring.capacity = static_cast<quint64>(level == 0 ? capacity_ : levelCapacity_);
+        ring.mask = ring.capacity - 1;
+        ring.timestamps.reset(new std::atomic<qint64>[ring.capacity]());
+        ring.minimum.reset(new std::atomic<float>[ring.capacity]());
+        if (level > 0) {
+            ring.maximum.reset(new std::atomic<float>[ring.capacity]());
+        }
+    }
+
+    series_[channel].store(series, std::memory_order_release);
+    return series;
+}
+
+const TimeSeriesStore::Series* TimeSeriesStore::seriesFor(int channel) const {
+    if (channel < 0 || channel >= CHANNEL_COUNT) {
+        return nullptr;
+    }
+    return series_[channel].load(std::memory_order_acquire);
+}
+
+void TimeSeriesStore::append(int channel, float value, qint64 timestampNs) {
+    Series* series = seriesFor(channel);
+    if (!series) {
+        return;
+    }
+
+    timestampNs = std::max(timestampNs, series->lastTimestampNs);
+    series->lastTimestampNs = timestampNs;
+
+    push(series->rings[0], timestampNs, value, value);
+    accumulate(*series, 1, timestampNs, value, value);
+}
+
+void TimeSeriesStore::append(const MSG_ChannelAmplitude& amplitude, qint64 timestampNs) {
+    for (int i = 0; i < INPUT_AMPLITUDE_COUNT; ++i) {
+        append(INPUT_AMPLITUDE_CHANNEL + i, static_cast<float>(amplitude.InputAmplitude[i]), timestampNs);
+    }
+    append(OUTPUT_AMPLITUDE_CHANNEL, static_cast<float>(amplitude.OutputAmplitude), timestampNs);
+}
+
+void TimeSeriesStore::append(const RealtimeFrame& frame, qint64 timestampNs) {
+    for (int i = 0; i < frame.count; ++i) {
+        if (frame.id[i] < static_cast<quint32>(RealtimeFrame::MAX_CHANNELS)) {
+            append(REALTIME_CHANNEL + static_cast<int>(frame.id[i]), frame.amplitude[i], timestampNs);
+        }
+    }
+}
+
+bool TimeSeriesStore::record(MessageType messageType, const ScatterSpan& payload, qint64 timestampNs) {
+    switch (messageType) {
+    case MessageType::CHANNEL_AMPLITUDE: {
+        MSG_ChannelAmplitude amplitude;
+        if (!MessageCodec::decode(payload, amplitude)) {
+            return false;
+        }
+        append(amplitude, timestampNs);
+        return true;
+    }
+    case MessageType::GRAPH_DATA: {
+        RealtimeFrame frame;
+        if (!RealtimeDataHandler::decode(payload, frame)) {
+            return false;
+        }
+        append(frame, timestampNs);
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+void TimeSeriesStore::push(Ring& ring, qint64 timestampNs, float minimum, float maximum) {
+    const quint64 index = ring.head.load(std::memory_order_relaxed);
+
+    // 先登记再覆盖，读取方复制数据后据此丢弃可能被覆盖的部分
+    ring.reserved.store(index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const quint64 slot = index & ring.mask;
+    ring.timestamps[slot].store(timestampNs, std::memory_order_relaxed);
+    ring.minimum[slot].store(minimum, std::memory_order_relaxed);
+    if (ring.maximum) {
+        ring.maximum[slot].store(maximum, std::memory_order_relaxed);
+    }
+
+    ring.head.store(index + 1, std::memory_order_release);
+}
+
+void TimeSeriesStore::accumulate(Series& series, int level, qint64 timestampNs, float minimum, float maximum) {
+    for (; level <= levels_; ++level) {
+        Series::Pending& bucket = series.pending[level];
+        if (bucket.count == 0) {
+            bucket.timestampNs = timestampNs;
+            bucket.minimum = minimum;
+            bucket.maximum = maximum;
+        } else {
+            bucket.minimum = std::min(bucket.minimum, minimum);
+            bucket.maximum = std::max(bucket.maximum, maximum);
+        }
+
+        if (++bucket.count < DECIMATION_FACTOR) {
+            return;
+        }
+
+        // 桶已满：发布到本级，并作为一个采样累计到上一级
+        push(series.rings[level], bucket.timestampNs, bucket.minimum, bucket.maximum);
+        timestampNs = bucket.timestampNs;
+        minimum = bucket.minimum;
+        maximum = bucket.maximum;
+        bucket.count = 0;
+    }
+}
+
+quint64 TimeSeriesStore::sampleCount(int channel) const {
+    const Series* series = seriesFor(channel);
+    return series ? series->rings[0].head.load(std::memory_order_acquire) : 0;
+}
+
+bool TimeSeriesStore::latest(int channel, Point& point) const {
+    const Series* series = seriesFor(channel);
+    if (!series) {
+        return false;
+    }
+
+    const Ring& ring = series->rings[0];
+    const quint64 head = ring.head.load(std::memory_order_acquire);
+    if (head == 0) {
+        return false;
+    }
+
+    const quint64 slot = (head - 1) & ring.mask;
+    point.timestampNs = ring.timestamps[slot].load(std::memory_order_relaxed);
+    point.minimum = ring.minimum[slot].load(std::memory_order_relaxed);
+    point.maximum = point.minimum;
+
+    // 读取期间写入方绕环一周才会覆盖最新的采样
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return ring.reserved.load(std::memory_order_relaxed) < head + ring.capacity;
+}
+
+quint64 TimeSeriesStore::lowerBound(const Ring& ring, quint64 begin, quint64 end, qint64 timestampNs) {
+    while (begin < end) {
+        const quint64 middle = begin + (end - begin) / 2;
+        if (ring.timestampAt(middle) < timestampNs) {
+            begin = middle + 1;
+        } else {
+            end = middle;
+        }
+    }
+    return begin;
+}
+
+quint64 TimeSeriesStore::readRing(const Ring& ring, quint64 first, qint64 fromNs, qint64 toNs, QVector<Point>& points) {
+    const quint64 head = ring.head.load(std::memory_order_acquire);
+    const quint64 begin = lowerBound(ring, std::max(first, ring.firstReadable(head)), head, fromNs);
+    const quint64 end = toNs == std::numeric_limits<qint64>::max()
+        ? head : lowerBound(ring, begin, head, toNs + 1);
+
+    const int base = static_cast<int>(points.size());
+    for (quint64 index = begin; index < end; ++index) {
+        const quint64 slot = index & ring.mask;
+        Point point;
+        point.timestampNs = ring.timestamps[slot].load(std::memory_order_relaxed);
+        point.minimum = ring.minimum[slot].load(std::memory_order_relaxed);
+        point.maximum = ring.maximum ? ring.maximum[slot].load(std::memory_order_relaxed) : point.minimum;
+        points.append(point);
+    }
+
+    // 丢弃读取期间被覆盖的数据（只可能是最旧的一段），以及因此越出窗口的数据
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const quint64 reserved = ring.reserved.load(std::memory_order_relaxed);
+    const quint64 valid = reserved > ring.capacity ? reserved - ring.capacity : 0;
+
+    int drop = begin < valid ? static_cast<int>(std::min<quint64>(valid - begin, end - begin)) : 0;
+    while (base + drop < points.size() && points[base + drop].timestampNs < fromNs) {
+        ++drop;
+    }
+    if (drop > 0) {
+        points.remove(base, drop);
+    }
+    while (points.size() > base && points.last().timestampNs > toNs) {
+        points.removeLast();
+    }
+
+    return head;
+}
+
+int TimeSeriesStore::read(int channel, qint64 fromNs, qint64 toNs, int maxPoints, QVector<Point>& points, int* level) const {
+    points.clear();
+    if (level) {
+        *level = 0;
+    }
+
+    const Series* series = seriesFor(channel);
+    if (!series || maxPoints <= 0 || toNs < fromNs) {
+        return 0;
+    }
+
+    // 选择覆盖窗口起点、且窗口内点数不超过maxPoints的最细级别
+    int chosen = 0;
+    for (int l = 0; l <= levels_; ++l) {
+        const Ring& ring = series->rings[l];
+        const quint64 head = ring.head.load(std::memory_order_acquire);
+        if (head == 0) {
+            break;
+        }
+
+        chosen = l;
+        const quint64 oldest = ring.firstReadable(head);
+        const bool covers = oldest == 0 || ring.timestampAt(oldest) <= fromNs;
+        const quint64 begin = lowerBound(ring, oldest, head, fromNs);
+        const quint64 end = toNs == std::numeric_limits<qint64>::max()
+            ? head : lowerBound(ring, begin, head, toNs + 1);
+        if (covers && end - begin <= static_cast<quint64>(maxPoints)) {
+            break;
+        }
+    }
+
+    // 该级别尚未完成的最新部分由更细的级别补齐
+    points.reserve(maxPoints + DECIMATION_FACTOR * (chosen + 1));
+    quint64 published = readRing(series->rings[chosen], 0, fromNs, toNs, points);
+    for (int l = chosen - 1; l >= 0; --l) {
+        published = readRing(series->rings[l], published * DECIMATION_FACTOR, fromNs, toNs, points);
+    }
+
+    // 仍超过maxPoints时合并相邻的点
+    if (points.size() > maxPoints) {
+        const int group = static_cast<int>((points.size() + maxPoints - 1) / maxPoints);
+        int merged = 0;
+        for (int i = 0; i < points.size(); i += group) {
+            Point point = points[i];
+            const int last = std::min(i + group, static_cast<int>(points.size()));
+            for (int j = i + 1; j < last; ++j) {
+                point.minimum = std::min(point.minimum, points[j].minimum);
+                point.maximum = std::max(point.maximum, points[j].maximum);
+            }
+            points[merged++] = point;
+        }
+        points.resize(merged);
+    }
+
+    if (level) {
+        *level = chosen;
+    }
+    return static_cast<int>(points.size());
+}
+
+} // namespace Protocol
@@ -0,0 +1,155 @@
+#ifndef TIME_SERIES_STORE_H
+#define TIME_SERIES_STORE_H
+
+#include <QByteArray>
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include "../core/message_types.h"
+#include "../handlers/realtime_data_handler.h"
+#include "../serialization/scatter_span.h"
+
+extern "C" {
+#include "../messages/ERNC_praram.pb.h"
+}
+
+namespace Protocol {
+
+/**
+ * @brief 实时数据时间序列存储
+ *
+ * 为每个通道保存固定容量的环形缓冲区（时间戳、数值分列存放），供各个曲线界面共享，
+ * 不必各自保存副本再逐点扫描绘制。
+ *
+ * 写入方为单线程（解码线程），读取方任意线程、无锁且无需重试（wait-free）：
+ * 写入方在覆盖旧数据之前先登记，读取方复制数据后检查登记计数，丢弃读取期间被覆盖的最旧部分。
+ *
+ * 写入时按DECIMATION_FACTOR逐级累计min/max，得到多级抽稀金字塔：第l级每个桶覆盖
+ * DECIMATION_FACTOR^l个原始采样，各级容量相同（原始容量/DECIMATION_FACTOR），级别越高保留的时间越长。
+ * read()按窗口和点数选择最合适的级别，例如1000像素宽的10分钟窗口只读取约1000个桶，
+ * 再以更细的级别补齐最高级别尚未完成的最新部分。
+ *
+ * 通道编号：
+ * - INPUT_AMPLITUDE_CHANNEL起13个通道：MSG_ChannelAmplitude的InputAmplitude
+ * - OUTPUT_AMPLITUDE_CHANNEL：MSG_ChannelAmplitude的OutputAmplitude
+ * - REALTIME_CHANNEL起RealtimeFrame::MAX_CHANNELS个通道：GRAPH_DATA实时数据帧按通道id的幅值
+ *
+ * 通道的缓冲区在第一次写入时分配，未使用的通道不占用内存。
+ */
+class TimeSeriesStore {
+public:
+    static constexpr int INPUT_AMPLITUDE_CHANNEL = 0;
+    static constexpr int INPUT_AMPLITUDE_COUNT = 13;
+    static constexpr int OUTPUT_AMPLITUDE_CHANNEL = INPUT_AMPLITUDE_CHANNEL + INPUT_AMPLITUDE_COUNT;
+    static constexpr int REALTIME_CHANNEL = OUTPUT_AMPLITUDE_CHANNEL + 1;
+    static constexpr int CHANNEL_COUNT = REALTIME_CHANNEL + RealtimeFrame::MAX_CHANNELS;
+
+    static constexpr int DECIMATION_FACTOR = 4;     // 相邻级别的抽稀倍数
+    static constexpr int DEFAULT_CAPACITY = 16384;  // 每通道原始采样数
+    static constexpr int DEFAULT_LEVELS = 6;        // 抽稀级数
+
+    /**
+     * @brief 读取结果中的一个点
+     *
+     * 原始采样的minimum与maximum相同；抽稀桶的时间为桶内第一个采样的时间。
+     */
+    struct Point {
+        qint64 timestampNs = 0;
+        float minimum = 0.0f;
+        float maximum = 0.0f;
+    };
+
+    /**
+     * @param capacity 每通道原始采样容量，向上取整为2的幂（至少64）
+     * @param levels 抽稀级数，0表示只保存原始采样
+     */
+    explicit TimeSeriesStore(int capacity = DEFAULT_CAPACITY, int levels = DEFAULT_LEVELS);
+    ~TimeSeriesStore();
+
+    TimeSeriesStore(const TimeSeriesStore&) = delete;
+    TimeSeriesStore& operator=(const TimeSeriesStore&) = delete;
+
+    int capacity() const { return capacity_; }
+    int levelCount() const { return levels_; }
+
+    /**
+     * @brief 单调时钟（纳秒），与写入时默认使用的时间戳一致
+     */
+    static qint64 now();
+
+    /**
+     * @brief 写入接口（只能由同一个线程调用）
+     *
+     * 时间戳须单调不减，回退的时间戳按上一次的时间戳保存。
+     */
+
+    // 写入一个采样，通道无效时忽略
+    void append(int channel, float value, qint64 timestampNs);
+
+    // 写入一条MSG_ChannelAmplitude（14个通道）
+    void append(const MSG_ChannelAmplitude& amplitude, qint64 timestampNs);
+
+    // 写入一帧实时数据，按通道id写入幅值
+    void append(const RealtimeFrame& frame, qint64 timestampNs);
+
+    /**
+     * @brief 解码消息载荷并写入（CHANNEL_AMPLITUDE、GRAPH_DATA实时数据帧）
+     * @return 写入了数据返回true，其他消息类型或载荷无法解码返回false
+     */
+    bool record(MessageType messageType, const QByteArray& payload, qint64 timestampNs) {
+        return record(messageType, ScatterSpan(payload), timestampNs);
+    }
+
+    // 直接在接收缓冲区上解码并写入，载荷可以由两段组成（见ScatterSpan）
+    bool record(MessageType messageType, const ScatterSpan& payload, qint64 timestampNs);
+
+    /**
+     * @brief 读取接口（线程安全，无锁）
+     */
+
+    // 通道累计写入的采样数
+    quint64 sampleCount(int channel) const;
+
+    // 最新的采样
+    bool latest(int channel, Point& point) const;
+
+    /**
+     * @brief 读取时间窗口[fromNs, toNs]内的数据
+     *
+     * 选择覆盖窗口起点、且窗口内点数不超过maxPoints的最细级别；
+     * 最高级别仍超过maxPoints时再合并相邻的桶。
+     * @param channel 通道
+     * @param fromNs 窗口起点
+     * @param toNs 窗口终点
+     * @param maxPoints 最多返回的点数（通常为绘制区域的像素宽度）
+     * @param points 输出，按时间升序
+     * @param level 输出（可选）：使用的级别，0为原始采样
+     * @return 返回的点数
+     */
+    int read(int channel, qint64 fromNs, qint64 toNs, int maxPoints, QVector<Point>& points, int* level = nullptr) const;
+
+private:
+    struct Ring;
+    struct Series;
+
+    Series* seriesFor(int channel);
+    const Series* seriesFor(int channel) const;
+
+    void push(Ring& ring, qint64 timestampNs, float minimum, float maximum);
+    void accumulate(Series& series, int level, qint64 timestampNs, float minimum, float maximum);
+
+    // 环中[begin, end)之间第一个时间戳不小于timestampNs的位置
+    static quint64 lowerBound(const Ring& ring, quint64 begin, quint64 end, qint64 timestampNs);
+
+    // 读取环中时间戳在[fromNs, toNs]内、序号不小于first的数据，返回本次读取时的发布计数
+    static quint64 readRing(const Ring& ring, quint64 first, qint64 fromNs, qint64 toNs, QVector<Point>& points);
+
+    int capacity_;
+    int levelCapacity_;
+    int levels_;
+    std::unique_ptr<std::atomic<Series*>[]> series_;
+};
+
+} // namespace Protocol
+
+#endif // TIME_SERIES_STORE_H
@@ -0,0 +1,338 @@
+#include <QCoreApplication>
+#include <QVariantMap>
+#include "test_common.h"
+#include "loopback_transport.h"
+#include "../adapter/protocol_adapter_refactored.h"
+#include "../serialization/protocol_packager.h"
+
+/**
+ * @brief 异步请求测试
+ *
+ * 验证：
+ * 1. 回读请求不带载荷字段，与全零写入在链路上可以区分
+ * 2. 设备RESPONSE完成对应的在途请求
+ * 3. 连接断开时在途请求以失败完成
+ * 4. 读-改-写以设备应答和未应答的写入为基础，发送不改动影子状态，重连后影子状态清空
+ * 5. 已取消请求的迟到应答不会完成之后发出的同类型请求
+ * 6. 未请求的帧（包括跨两次读取的帧）直接解码到影子状态和总线订阅者
+ * 7. 写入只在设备带回同一序号的应答后确认，发送成功不发出parameterAcknowledged
+ */
+
+using namespace Protocol;
+
+namespace {
+
+// 构造设备应答（带回请求序号）
+QByteArray deviceResponse(MessageType messageType, const QVariantMap& parameters, quint32 sequence) {
+    MessageSerializer serializer;
+    ProtocolPackager packager;
+    QByteArray payload = serializer.serialize(messageType, parameters);
+    QByteArray envelope = packager.packageMessage(messageType, FunctionCode::RESPONSE, payload);
+    return sequence != 0 ? ProtocolPackager::appendSequence(envelope, sequence) : envelope;
+}
+
+// 解码发出的写请求
+QVariantMap sentParameters(const QByteArray& envelope) {
+    ProtocolPackager packager;
+    MessageSerializer serializer;
+    MessageType messageType;
+    FunctionCode functionCode;
+    QByteArray payload;
+    QVariantMap parameters;
+    if (packager.unpackageMessage(envelope, messageType, functionCode, payload)) {
+        serializer.deserialize(messageType, payload, parameters);
+    }
+    return parameters;
+}
+
+// 取出发出的请求序号
+QList<quint32> sentSequences(LoopbackTransport& transport) {
+    QList<quint32> sequences;
+    for (const QByteArray& envelope : transport.takeSentPayloads()) {
+        int protoId = 0;
+        FunctionCode functionCode;
+        quint32 sequence = 0;
+        ProtocolPackager::peekEnvelope(envelope.constData(), envelope.size(), protoId, functionCode, &sequence);
+        sequences.append(sequence);
+    }
+    return sequences;
+}
+
+// 发出回读请求并以给定状态应答
+void answerReadback(LoopbackTransport& transport, ProtocolAdapterRefactored& adapter,
+                    MessageType messageType, const QVariantMap& state) {
+    adapter.requestMessage(messageType);
+    const QList<QByteArray> sent = transport.takeSentPayloads();
+    TEST_CHECK(sent.size() == 1);
+    if (sent.isEmpty()) {
+        return;
+    }
+
+    int protoId = 0;
+    FunctionCode functionCode;
+    quint32 sequence = 0;
+    ProtocolPackager::peekEnvelope(sent.first().constData(), sent.first().size(), protoId, functionCode, &sequence);
+    transport.injectFrame(deviceResponse(messageType, state, sequence));
+}
+
+void testReadRequestEncoding() {
+    ProtocolPackager packager;
+    const QByteArray readRequest = packager.packageReadRequest(MessageType::ANC_SWITCH);
+    const QByteArray zeroWrite = packager.packageMessage(MessageType::ANC_SWITCH, FunctionCode::REQUEST, QByteArray());
+
+    TEST_CHECK(!readRequest.isEmpty());
+    TEST_CHECK(readRequest != zeroWrite);
+
+    // 写请求带载荷字段，回读请求没有
+    MessageType messageType;
+    FunctionCode functionCode;
+    ScatterSpan payload;
+    TEST_CHECK(ProtocolPackager::unpackEnvelope(ScatterSpan(zeroWrite), messageType, functionCode, payload));
+    TEST_CHECK(!ProtocolPackager::unpackEnvelope(ScatterSpan(readRequest), messageType, functionCode, payload));
+
+    int protoId = 0;
+    TEST_CHECK(ProtocolPackager::peekEnvelope(readRequest.constData(), readRequest.size(), protoId, functionCode));
+    TEST_CHECK(protoId == MessageTypeUtils::toProtoID(MessageType::ANC_SWITCH));
+    TEST_CHECK(functionCode == FunctionCode::REQUEST);
+}
+
+void testResponseCompletesRequest() {
+    LoopbackTransport transport;
+    transport.open();
+    ProtocolAdapterRefactored adapter(&transport);
+
+    bool completed = false;
+    ProtocolAdapterRefactored::RequestResult result;
+    quint32 requestId = adapter.requestMessage(MessageType::ANC_SWITCH,
+                                               [&](const ProtocolAdapterRefactored::RequestResult& r) {
+        completed = true;
+        result = r;
+    });
+    TEST_CHECK(requestId != 0);
+    TEST_CHECK(adapter.outstandingRequestCount() == 1);
+
+    const QList<QByteArray> sent = transport.takeSentPayloads();
+    TEST_CHECK(sent.size() == 1);
+    if (sent.isEmpty()) {
+        return;
+    }
+
+    int protoId = 0;
+    FunctionCode functionCode = FunctionCode::RESPONSE;
+    quint32 sequence = 0;
+    TEST_CHECK(ProtocolPackager::peekEnvelope(sent.first().constData(), sent.first().size(),
+                                              protoId, functionCode, &sequence));
+    TEST_CHECK(protoId == MessageTypeUtils::toProtoID(MessageType::ANC_SWITCH));
+    TEST_CHECK(functionCode == FunctionCode::REQUEST);
+    TEST_CHECK(sequence != 0);
+
+    QVariantMap state;
+    state["enc.enabled"] = false;
+    transport.injectFrame(deviceResponse(MessageType::ANC_SWITCH, state, sequence));
+
+    TEST_CHECK(completed);
+    TEST_CHECK(result.requestId == requestId);
+    TEST_CHECK(result.success);
+    TEST_CHECK(result.parameters.value("enc.enabled").toBool() == false);
+    TEST_CHECK(adapter.outstandingRequestCount() == 0);
+}
+
+void testDisconnectFailsRequests() {
+    LoopbackTransport transport;
+    transport.open();
+    ProtocolAdapterRefactored adapter(&transport);
+
+    bool completed = false;
+    bool success = true;
+    adapter.requestMessage(MessageType::ANC_SWITCH, [&](const ProtocolAdapterRefactored::RequestResult& r) {
+        completed = true;
+        success = r.success;
+    });
+    TEST_CHECK(adapter.outstandingRequestCount() == 1);
+
+    transport.close();
+
+    TEST_CHECK(completed);
+    TEST_CHECK(!success);
+    TEST_CHECK(adapter.outstandingRequestCount() == 0);
+}
+
+void testReadModifyWrite() {
+    LoopbackTransport transport;
+    transport.open();
+    ProtocolAdapterRefactored adapter(&transport);
+    adapter.setReadModifyWrite(MessageType::ANC_SWITCH, true);
+    adapter.setDeltaMode(MessageType::ANC_SWITCH, true);
+
+    QVariantMap state;
+    state["enc.enabled"] = false;
+    answerReadback(transport, adapter, MessageType::ANC_SWITCH, state);
+    TEST_CHECK(adapter.isCachedStateUsable(MessageType::ANC_SWITCH));
+
+    // 只给出ANC，其余字段取自设备应答，不做增量编码
+    TEST_CHECK(adapter.sendParameterUpdate("anc.enabled", false));
+    QList<QByteArray> sent = transport.takeSentPayloads();
+    TEST_CHECK(sent.size() == 1);
+    QVariantMap written = sent.isEmpty() ? QVariantMap() : sentParameters(sent.first());
+    TEST_CHECK(written.value("anc.enabled").toBool() == false);
+    TEST_CHECK(written.value("enc.enabled").toBool() == false);
+    TEST_CHECK(written.value("rnc.enabled").toBool() == true);
+
+    // 设备应答前的下一次修改以上一次写入为基础
+    TEST_CHECK(adapter.sendParameterUpdate("rnc.enabled", false));
+    sent = transport.takeSentPayloads();
+    TEST_CHECK(sent.size() == 1);
+    written = sent.isEmpty() ? QVariantMap() : sentParameters(sent.first());
+    TEST_CHECK(written.value("anc.enabled").toBool() == false);
+    TEST_CHECK(written.value("enc.enabled").toBool() == false);
+    TEST_CHECK(written.value("rnc.enabled").toBool() == false);
+
+    // 影子状态仍是设备上报的值
+    QVariantMap cached;
+    TEST_CHECK(adapter.cachedParameters(MessageType::ANC_SWITCH, cached));
+    TEST_CHECK(cached.value("anc.enabled").toBool() == true);
+
+    // 重连后可能是另一台设备
+    transport.close();
+    transport.open();
+    TEST_CHECK(!adapter.isCachedStateUsable(MessageType::ANC_SWITCH));
+}
+
+void testCancelledResponseAbsorbed() {
+    QVariantMap state;
+    state["enc.enabled"] = false;
+
+    // 旧版设备：应答不带序号，按发送顺序匹配
+    {
+        LoopbackTransport transport;
+        transport.open();
+        ProtocolAdapterRefactored adapter(&transport);
+
+        quint32 cancelled = adapter.requestMessage(MessageType::ANC_SWITCH);
+        TEST_CHECK(adapter.cancelRequest(cancelled));
+
+        bool completed = false;
+        adapter.requestMessage(MessageType::ANC_SWITCH, [&](const ProtocolAdapterRefactored::RequestResult&) {
+            completed = true;
+        });
+
+        transport.injectFrame(deviceResponse(MessageType::ANC_SWITCH, state, 0));
+        TEST_CHECK(!completed);
+        TEST_CHECK(adapter.outstandingRequestCount() == 1);
+
+        transport.injectFrame(deviceResponse(MessageType::ANC_SWITCH, state, 0));
+        TEST_CHECK(completed);
+        TEST_CHECK(adapter.outstandingRequestCount() == 0);
+    }
+
+    // 设备带回序号：按序号匹配，应答顺序无关
+    {
+        LoopbackTransport transport;
+        transport.open();
+        ProtocolAdapterRefactored adapter(&transport);
+        answerReadback(transport, adapter, MessageType::ANC_SWITCH, state);
+
+        quint32 cancelled = adapter.requestMessage(MessageType::ANC_SWITCH);
+        TEST_CHECK(adapter.cancelRequest(cancelled));
+
+        bool completed = false;
+        adapter.requestMessage(MessageType::ANC_SWITCH, [&](const ProtocolAdapterRefactored::RequestResult&) {
+            completed = true;
+        });
+
+        const QList<quint32> sequences = sentSequences(transport);
+        TEST_CHECK(sequences.size() == 2);
+        if (sequences.size() != 2) {
+            return;
+        }
+
+        transport.injectFrame(deviceResponse(MessageType::ANC_SWITCH, state, sequences[0]));
+        TEST_CHECK(!completed);
+
+        transport.injectFrame(deviceResponse(MessageType::ANC_SWITCH, state, sequences[1]));
+        TEST_CHECK(completed);
+        TEST_CHECK(adapter.outstandingRequestCount() == 0);
+    }
+}
+
+void testUnsolicitedFrameDecodedInPlace() {
+    LoopbackTransport transport;
+    transport.open();
+    ProtocolAdapterRefactored adapter(&transport);
+
+    int delivered = 0;
+    MSG_AncSwitch received = MSG_AncSwitch_init_zero;
+    adapter.messageBus()->subscribe<MSG_AncSwitch>(nullptr, [&](const MSG_AncSwitch& message) {
+        ++delivered;
+        received = message;
+    });
+
+    QVariantMap state;
+    state["enc.enabled"] = false;
+    transport.injectFrame(deviceResponse(MessageType::ANC_SWITCH, state, 0));
+
+    TEST_CHECK(delivered == 1);
+    TEST_CHECK(received.enc_off);
+    MSG_AncSwitch shadow = MSG_AncSwitch_init_zero;
+    TEST_CHECK(adapter.shadowState()->snapshot(MessageType::ANC_SWITCH, shadow));
+    TEST_CHECK(shadow.enc_off);
+    TEST_CHECK(!shadow.anc_off);
+
+    // 一帧分两次到达，载荷视图由残留和新数据两段组成
+    state["enc.enabled"] = true;
+    state["rnc.enabled"] = false;
+    const QByteArray frame = FrameCodec::encode(deviceResponse(MessageType::ANC_SWITCH, state, 0));
+    const int split = frame.size() - 3;
+    transport.inject(frame.left(split));
+    TEST_CHECK(delivered == 1);
+    transport.inject(frame.mid(split));
+
+    TEST_CHECK(delivered == 2);
+    TEST_CHECK(!received.enc_off);
+    TEST_CHECK(received.rnc_off);
+    TEST_CHECK(adapter.shadowState()->snapshot(MessageType::ANC_SWITCH, shadow));
+    TEST_CHECK(shadow.rnc_off);
+}
+
+void testWriteAcknowledgedBySequence() {
+    LoopbackTransport transport;
+    transport.open();
+    ProtocolAdapterRefactored adapter(&transport);
+
+    QStringList acknowledged;
+    QObject::connect(&adapter, &ProtocolAdapterRefactored::parameterAcknowledged, [&acknowledged](const QString& path) {
+        acknowledged.append(path);
+    });
+
+    TEST_CHECK(adapter.sendParameterUpdate("anc.enabled", false));
+    const QList<quint32> sequences = sentSequences(transport);
+    TEST_CHECK(sequences.size() == 1);
+    const quint32 sequence = sequences.isEmpty() ? 0 : sequences.first();
+    TEST_CHECK(sequence != 0);
+    TEST_CHECK(acknowledged.isEmpty());
+
+    // 同类型但序号不同的应答（例如其他请求的应答）不确认本次写入
+    QVariantMap state;
+    state["anc.enabled"] = false;
+    transport.injectFrame(deviceResponse(MessageType::ANC_SWITCH, state, sequence + 100));
+    TEST_CHECK(acknowledged.isEmpty());
+
+    transport.injectFrame(deviceResponse(MessageType::ANC_SWITCH, state, sequence));
+    TEST_CHECK(acknowledged == QStringList{ "anc.enabled" });
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+
+    testReadRequestEncoding();
+    testResponseCompletesRequest();
+    testDisconnectFailsRequests();
+    testReadModifyWrite();
+    testCancelledResponseAbsorbed();
+    testUnsolicitedFrameDecodedInPlace();
+    testWriteAcknowledgedBySequence();
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,106 @@
+#include <QCoreApplication>
+#include <QVariantMap>
+#include "test_common.h"
+#include "loopback_transport.h"
+#include "../adapter/protocol_adapter_refactored.h"
+#include "../connection/connection_manager.h"
+#include "../connection/outbound_scheduler.h"
+#include "../serialization/protocol_packager.h"
+
+/**
+ * @brief 批量帧测试
+ *
+ * 验证：
+ * 1. 调度器把流式通道中排队的消息合并为批量帧，parseBatch()按原顺序还原每条消息
+ * 2. 批量帧中的每条RESPONSE都完成对应的在途请求
+ */
+
+using namespace Protocol;
+
+namespace {
+
+QByteArray ancRequest(bool enabled) {
+    MessageSerializer serializer;
+    QVariantMap parameters;
+    parameters["anc.enabled"] = enabled;
+    return serializer.serialize(MessageType::ANC_SWITCH, parameters, FunctionCode::REQUEST, true);
+}
+
+void testSchedulerBatchRoundTrip() {
+    LoopbackTransport transport;
+    ConnectionManager connectionManager;
+    connectionManager.setTransport(&transport);
+    transport.open();
+
+    OutboundScheduler scheduler(&connectionManager);
+    scheduler.setBatchingEnabled(true);
+
+    // 一个最大帧耗尽链路令牌，之后入队的消息只能排队
+    scheduler.setLinkRate(100);
+    TEST_CHECK(scheduler.enqueue(OutboundScheduler::Lane::Control, QByteArray(FrameCodec::MAX_PAYLOAD_SIZE, 'x')));
+
+    const QList<QByteArray> envelopes = { ancRequest(true), ancRequest(false), ancRequest(true) };
+    for (const QByteArray& envelope : envelopes) {
+        TEST_CHECK(scheduler.enqueue(OutboundScheduler::Lane::Streaming, envelope));
+    }
+    TEST_CHECK(scheduler.queuedFrames(OutboundScheduler::Lane::Streaming) == envelopes.size());
+
+    // 取消限速后排队的消息合并为一帧发出
+    scheduler.setLinkRate(0);
+    TEST_CHECK(scheduler.queuedFrames(OutboundScheduler::Lane::Streaming) == 0);
+
+    const QList<QByteArray> sent = transport.takeSentPayloads();
+    TEST_CHECK(sent.size() == 2);
+    if (sent.size() != 2) {
+        return;
+    }
+    TEST_CHECK(!ProtocolPackager::isBatch(sent[0]));
+    TEST_CHECK(ProtocolPackager::isBatch(sent[1]));
+
+    QList<QByteArray> unpacked;
+    TEST_CHECK(ProtocolPackager::parseBatch(ScatterSpan(sent[1]), [&unpacked](const ScatterSpan& envelope) {
+        unpacked.append(envelope.toByteArray());
+    }));
+    TEST_CHECK(unpacked == envelopes);
+
+    const OutboundScheduler::LaneStats stats = scheduler.laneStats(OutboundScheduler::Lane::Streaming);
+    TEST_CHECK(stats.framesSent == 1);
+    TEST_CHECK(stats.messagesBatched == static_cast<quint64>(envelopes.size()));
+}
+
+void testBatchedResponses() {
+    LoopbackTransport transport;
+    transport.open();
+    ProtocolAdapterRefactored adapter(&transport);
+
+    int completed = 0;
+    auto callback = [&completed](const ProtocolAdapterRefactored::RequestResult& result) {
+        if (result.success) {
+            ++completed;
+        }
+    };
+    adapter.requestMessage(MessageType::ANC_SWITCH, callback);
+    adapter.requestMessage(MessageType::ANC_SWITCH, callback);
+    TEST_CHECK(adapter.outstandingRequestCount() == 2);
+
+    // 旧版设备的应答不带序号，按发送顺序匹配
+    MessageSerializer serializer;
+    QVariantMap state;
+    state["enc.enabled"] = false;
+    const QByteArray response = serializer.serialize(MessageType::ANC_SWITCH, state, FunctionCode::RESPONSE, true);
+    transport.injectFrame(ProtocolPackager::packageBatch({ response, response }));
+
+    TEST_CHECK(completed == 2);
+    TEST_CHECK(adapter.outstandingRequestCount() == 0);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+
+    testSchedulerBatchRoundTrip();
+    testBatchedResponses();
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,195 @@
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "test_common.h"
+#include "serialization/ernc_codec.h"
+#include "serialization/varint_kernels.h"
+
+extern "C" {
+#include "pb_common.h"
+#include "pb_decode.h"
+#include "pb_encode.h"
+}
+
+/**
+ * @brief 生成的ERNC编解码与nanopb的差分测试
+ *
+ * 对每种消息随机填充字段（包括0、单字节、多字节和uint32最大值），比较：
+ * 1. 编码结果与nanopb逐字节相同，encodedSize()与实际长度一致且不超过MAX_ENCODED_SIZE
+ * 2. 对编码结果做翻转字节、截断、随机标签、追加非packed字段等变形后，
+ *    解码的成败和解码出的结构体与nanopb相同
+ *
+ * 本机支持的每种varint内核实现各跑一遍。
+ */
+
+using namespace Protocol;
+using namespace Protocol::ErncCodec;
+
+namespace {
+
+const int ITERATIONS = 20000;
+const int MAX_REPORTED_MISMATCHES = 3;
+
+std::mt19937_64 rng(12345);
+
+// 随机uint32，偏向varint长度的边界
+uint32_t randomValue() {
+    switch (rng() % 5) {
+    case 0:
+        return 0;
+    case 1:
+        return static_cast<uint32_t>(rng() % 128);
+    case 2:
+        return static_cast<uint32_t>(rng() % 70000);
+    case 3:
+        return 0xFFFFFFFFu;
+    default:
+        return static_cast<uint32_t>(rng());
+    }
+}
+
+// 按nanopb字段描述随机填充消息（bool取0/1，其余为uint32）
+template <typename T>
+void fillRandom(const pb_msgdesc_t* fields, T& message) {
+    memset(&message, 0, sizeof(message));
+
+    pb_field_iter_t iter;
+    if (!pb_field_iter_begin(&iter, fields, &message)) {
+        return;
+    }
+    do {
+        const pb_size_t count = iter.array_size != 0 ? iter.array_size : 1;
+        for (pb_size_t i = 0; i < count; ++i) {
+            if (iter.data_size == 1) {
+                static_cast<uint8_t*>(iter.pData)[i] = static_cast<uint8_t>(rng() % 2);
+            } else {
+                static_cast<uint32_t*>(iter.pData)[i] = randomValue();
+            }
+        }
+    } while (pb_field_iter_next(&iter));
+}
+
+// 变形编码结果，覆盖解码的各类错误路径
+std::vector<uint8_t> mutate(const uint8_t* data, size_t size) {
+    std::vector<uint8_t> input(data, data + size);
+
+    switch (rng() % 4) {
+    case 1:
+        if (!input.empty()) {
+            input[rng() % input.size()] = static_cast<uint8_t>(rng());
+        }
+        break;
+    case 2:
+        if (!input.empty()) {
+            input.resize(rng() % input.size());
+        }
+        break;
+    case 3:
+        input.resize(rng() % 40);
+        for (uint8_t& byte : input) {
+            byte = rng() % 3 == 0 ? static_cast<uint8_t>(((rng() % 64) << 3) | (rng() % 8))
+                                  : static_cast<uint8_t>(rng());
+        }
+        break;
+    default:
+        break;
+    }
+
+    // 追加一个非packed的varint字段
+    if (rng() % 5 == 0) {
+        input.push_back(static_cast<uint8_t>(0x08 | ((rng() % 3) << 3)));
+        input.push_back(static_cast<uint8_t>(rng() % 200));
+    }
+    return input;
+}
+
+template <typename T>
+int compareWithNanopb(const pb_msgdesc_t* fields, const char* name) {
+    int mismatches = 0;
+
+    for (int iteration = 0; iteration < ITERATIONS; ++iteration) {
+        T message;
+        fillRandom(fields, message);
+
+        uint8_t expected[1024];
+        uint8_t actual[1024];
+        pb_ostream_t ostream = pb_ostream_from_buffer(expected, sizeof(expected));
+        if (!pb_encode(&ostream, fields, &message)) {
+            ++mismatches;
+            continue;
+        }
+
+        const size_t size = Codec<T>::encode(message, actual);
+        if (size != ostream.bytes_written || memcmp(expected, actual, size) != 0
+            || size != Codec<T>::encodedSize(message) || size > Codec<T>::MAX_ENCODED_SIZE) {
+            if (mismatches < MAX_REPORTED_MISMATCHES) {
+                printf("%s: encode mismatch\n", name);
+            }
+            ++mismatches;
+        }
+
+        const std::vector<uint8_t> input = mutate(expected, ostream.bytes_written);
+        T nanopbResult;
+        T codecResult;
+        memset(&nanopbResult, 0, sizeof(nanopbResult));
+        memset(&codecResult, 0, sizeof(codecResult));
+
+        pb_istream_t istream = pb_istream_from_buffer(input.data(), input.size());
+        const bool nanopbOk = pb_decode(&istream, fields, &nanopbResult);
+        const bool codecOk = Codec<T>::decode(input.data(), input.size(), codecResult);
+        if (nanopbOk != codecOk || (nanopbOk && memcmp(&nanopbResult, &codecResult, sizeof(T)) != 0)) {
+            if (mismatches < MAX_REPORTED_MISMATCHES) {
+                printf("%s: decode mismatch (nanopb %d, codec %d, %s)\n",
+                       name, nanopbOk, codecOk, PB_GET_ERROR(&istream));
+            }
+            ++mismatches;
+        }
+    }
+    return mismatches;
+}
+
+int compareAllMessages() {
+    int mismatches = 0;
+    mismatches += compareWithNanopb<MSG_ChannelNumber>(MSG_ChannelNumber_fields, "MSG_ChannelNumber");
+    mismatches += compareWithNanopb<MSG_ChannelAmplitude>(MSG_ChannelAmplitude_fields, "MSG_ChannelAmplitude");
+    mismatches += compareWithNanopb<MSG_ChannelSwitch>(MSG_ChannelSwitch_fields, "MSG_ChannelSwitch");
+    mismatches += compareWithNanopb<MSG_CheckMod>(MSG_CheckMod_fields, "MSG_CheckMod");
+    mismatches += compareWithNanopb<MSG_AncSwitch>(MSG_AncSwitch_fields, "MSG_AncSwitch");
+    mismatches += compareWithNanopb<MSG_VehicleState>(MSG_VehicleState_fields, "MSG_VehicleState");
+    mismatches += compareWithNanopb<MSG_TranFuncFlag>(MSG_TranFuncFlag_fields, "MSG_TranFuncFlag");
+    mismatches += compareWithNanopb<MSG_TranFuncState>(MSG_TranFuncState_fields, "MSG_TranFuncState");
+    mismatches += compareWithNanopb<MSG_FilterRanges>(MSG_FilterRanges_fields, "MSG_FilterRanges");
+    mismatches += compareWithNanopb<MSG_SystemRanges>(MSG_SystemRanges_fields, "MSG_SystemRanges");
+    mismatches += compareWithNanopb<MSG_OrderFlag>(MSG_OrderFlag_fields, "MSG_OrderFlag");
+    mismatches += compareWithNanopb<MSG_Order2Params>(MSG_Order2Params_fields, "MSG_Order2Params");
+    mismatches += compareWithNanopb<MSG_Order4Params>(MSG_Order4Params_fields, "MSG_Order4Params");
+    mismatches += compareWithNanopb<MSG_Order6Params>(MSG_Order6Params_fields, "MSG_Order6Params");
+    mismatches += compareWithNanopb<MSG_AlphaParams>(MSG_AlphaParams_fields, "MSG_AlphaParams");
+    mismatches += compareWithNanopb<MSG_FreqDivision>(MSG_FreqDivision_fields, "MSG_FreqDivision");
+    mismatches += compareWithNanopb<MSG_Thresholds>(MSG_Thresholds_fields, "MSG_Thresholds");
+    return mismatches;
+}
+
+} // namespace
+
+int main() {
+    const PackedVarint::Implementation implementations[] = {
+        PackedVarint::Implementation::Scalar,
+        PackedVarint::Implementation::Sse41,
+        PackedVarint::Implementation::Avx2
+    };
+
+    for (PackedVarint::Implementation implementation : implementations) {
+        if (!PackedVarint::setImplementation(implementation)) {
+            printf("%s: not supported, skipped\n", PackedVarint::implementationName(implementation));
+            continue;
+        }
+
+        const int mismatches = compareAllMessages();
+        printf("%s: %d mismatches\n", PackedVarint::implementationName(implementation), mismatches);
+        TEST_CHECK(mismatches == 0);
+    }
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,69 @@
+#ifndef LOOPBACK_TRANSPORT_H
+#define LOOPBACK_TRANSPORT_H
+
+#include <QList>
+#include "../transport/itransport.h"
+#include "../connection/frame_codec.h"
+
+/**
+ * @brief 测试用传输层
+ *
+ * 记录发出的数据，inject()模拟设备发来的数据；全部在调用线程同步完成。
+ */
+class LoopbackTransport : public ITransport
+{
+public:
+    explicit LoopbackTransport(QObject* parent = nullptr) : ITransport(parent) {}
+
+    bool open() override {
+        if (!open_) {
+            open_ = true;
+            emitConnectionStatusChanged(true);
+        }
+        return true;
+    }
+
+    void close() override {
+        if (open_) {
+            open_ = false;
+            emitConnectionStatusChanged(false);
+        }
+    }
+
+    bool isOpen() const override { return open_; }
+
+    bool send(const QByteArray& data) override {
+        if (!open_) {
+            return false;
+        }
+        sent_.append(data);
+        return true;
+    }
+
+    QString description() const override { return "Loopback"; }
+    QString transportType() const override { return "Loopback"; }
+
+    // 模拟收到数据
+    void inject(const QByteArray& data) { emitDataReceived(data); }
+
+    // 以链路帧封装后注入一条消息
+    void injectFrame(const QByteArray& payload) { inject(Protocol::FrameCodec::encode(payload)); }
+
+    // 取出已发送的链路帧载荷
+    QList<QByteArray> takeSentPayloads() {
+        QList<QByteArray> payloads;
+        for (const QByteArray& data : sent_) {
+            Protocol::FrameCodec::parse(data.constData(), data.size(), [&payloads](const char* payload, int length) {
+                payloads.append(QByteArray(payload, length));
+            });
+        }
+        sent_.clear();
+        return payloads;
+    }
+
+private:
+    bool open_ = false;
+    QList<QByteArray> sent_;
+};
+
+#endif // LOOPBACK_TRANSPORT_H
@@ -0,0 +1,186 @@
+#include <QCoreApplication>
+#include <QVariantMap>
+#include <cstdio>
+#include "test_common.h"
+#include "../serialization/message_codec.h"
+#include "../serialization/message_serializer.h"
+#include "../serialization/protocol_packager.h"
+#include "../handlers/realtime_data_handler.h"
+
+/**
+ * @brief 消息载荷编码测试
+ *
+ * 验证：
+ * 1. 全部字段为默认值的消息编码为空载荷，写入和应答都能正常收发
+ * 2. 全零写入与回读请求在链路上可以区分
+ * 3. 紧凑格式比标准格式短，并能还原为相同的标准格式；接收路径能识别无需还原的标准格式
+ * 4. GRAPH_DATA实时数据帧只在协商CAPABILITY_GRAPH_DATA后经字段22收发，跨两段的载荷按列式解码
+ */
+
+using namespace Protocol;
+
+namespace {
+
+void testAllDefaultMessage() {
+    MessageSerializer serializer;
+
+    // anc_off/enc_off/rnc_off全为false，三个字段都不编码
+    QVariantMap enabled;
+    enabled["anc.enabled"] = true;
+    enabled["enc.enabled"] = true;
+    enabled["rnc.enabled"] = true;
+
+    const QByteArray payload = serializer.serialize(MessageType::ANC_SWITCH, enabled);
+    TEST_CHECK(!payload.isNull());
+    TEST_CHECK(payload.isEmpty());
+
+    QVariantMap decoded;
+    TEST_CHECK(serializer.deserialize(MessageType::ANC_SWITCH, payload, decoded));
+    TEST_CHECK(decoded.value("anc.enabled").toBool());
+    TEST_CHECK(decoded.value("rnc.enabled").toBool());
+
+    // 设备应答全默认值的状态
+    const QByteArray response = serializer.serialize(MessageType::ANC_SWITCH, enabled, FunctionCode::RESPONSE, true);
+    TEST_CHECK(!response.isEmpty());
+
+    MessageType messageType = MessageType::ALPHA_PARAMS;
+    FunctionCode functionCode = FunctionCode::REQUEST;
+    decoded.clear();
+    TEST_CHECK(serializer.deserialize(response, messageType, functionCode, decoded));
+    TEST_CHECK(messageType == MessageType::ANC_SWITCH);
+    TEST_CHECK(functionCode == FunctionCode::RESPONSE);
+    TEST_CHECK(decoded.value("enc.enabled").toBool());
+}
+
+void testZeroWriteDistinctFromReadback() {
+    MessageSerializer serializer;
+
+    QVariantMap enabled;
+    enabled["anc.enabled"] = true;
+    enabled["enc.enabled"] = true;
+    enabled["rnc.enabled"] = true;
+
+    const QByteArray write = serializer.serialize(MessageType::ANC_SWITCH, enabled, FunctionCode::REQUEST, true);
+    const QByteArray readback = serializer.packageReadRequest(MessageType::ANC_SWITCH);
+    TEST_CHECK(!write.isEmpty());
+    TEST_CHECK(!readback.isEmpty());
+    TEST_CHECK(write != readback);
+
+    // 写入带零长度的载荷字段，回读请求没有载荷字段
+    MessageType messageType;
+    FunctionCode functionCode;
+    ScatterSpan payload;
+    TEST_CHECK(ProtocolPackager::unpackEnvelope(ScatterSpan(write), messageType, functionCode, payload));
+    TEST_CHECK(payload.size() == 0);
+    TEST_CHECK(!ProtocolPackager::unpackEnvelope(ScatterSpan(readback), messageType, functionCode, payload));
+}
+
+void testCompactSize() {
+    // 典型2阶参数：只有前几个转速点有值
+    MSG_Order2Params params = MSG_Order2Params_init_zero;
+    for (int i = 0; i < 3; ++i) {
+        params.tach_of_amp1[i] = 600 + i * 400;
+        params.amp1[i] = 1200 + i * 100;
+        params.step1[i] = 8;
+    }
+    params.err_wei1 = 5;
+    params.delta1 = 9;
+
+    QByteArray standard;
+    TEST_CHECK(MessageCodec::encode(params, standard));
+
+    QByteArray compact;
+    TEST_CHECK(MessageCodec::compactArrays(MessageType::ORDER2_PARAMS, standard, compact));
+    printf("ORDER2_PARAMS payload: standard %d bytes, compact %d bytes\n",
+           static_cast<int>(standard.size()), static_cast<int>(compact.size()));
+    TEST_CHECK(compact.size() < standard.size());
+
+    QByteArray expanded;
+    TEST_CHECK(MessageCodec::expandArrays(MessageType::ORDER2_PARAMS, compact, expanded));
+    TEST_CHECK(expanded == standard);
+
+    // 标准格式无需还原，紧凑格式需要
+    TEST_CHECK(MessageCodec::isStandardLayout(MessageType::ORDER2_PARAMS, standard.constData(), standard.size()));
+    TEST_CHECK(!MessageCodec::isStandardLayout(MessageType::ORDER2_PARAMS, compact.constData(), compact.size()));
+
+    // 全零数组整个省略
+    const MSG_Order2Params zero = MSG_Order2Params_init_zero;
+    TEST_CHECK(MessageCodec::encode(zero, standard));
+    TEST_CHECK(MessageCodec::compactArrays(MessageType::ORDER2_PARAMS, standard, compact));
+    TEST_CHECK(compact.isEmpty());
+    TEST_CHECK(MessageCodec::expandArrays(MessageType::ORDER2_PARAMS, compact, expanded));
+    TEST_CHECK(expanded == standard);
+}
+
+void testRealtimeFrameEnvelope() {
+    RealtimeFrame frame;
+    frame.channelCount = 3;
+    frame.sampleRate = 1000;
+    frame.count = 3;
+    for (int i = 0; i < frame.count; ++i) {
+        frame.id[i] = static_cast<quint32>(i * 5);
+        frame.amplitude[i] = 1.5f * (i + 1);
+        frame.frequency[i] = 100.0f * (i + 1);
+    }
+
+    QVariantMap parameters;
+    RealtimeDataHandler::toParameters(frame, parameters);
+
+    MessageSerializer serializer;
+    TEST_CHECK(serializer.isMessageTypeSupported(MessageType::GRAPH_DATA));
+
+    // 协商CAPABILITY_GRAPH_DATA之前既不发送也不接受字段22
+    MessageType messageType = MessageType::ANC_SWITCH;
+    FunctionCode functionCode = FunctionCode::REQUEST;
+    QVariantMap received;
+    TEST_CHECK(serializer.serialize(MessageType::GRAPH_DATA, parameters, FunctionCode::RESPONSE, true).isEmpty());
+    const QByteArray legacy = ProtocolPackager().packageMessage(MessageType::GRAPH_DATA, FunctionCode::RESPONSE,
+                                                                RealtimeDataHandler::encode(frame));
+    TEST_CHECK(!serializer.deserialize(legacy, messageType, functionCode, received));
+
+    // 对端通告该能力后双向可用
+    const QByteArray advertised = ProtocolPackager().packageMessage(MessageType::GRAPH_DATA, FunctionCode::RESPONSE,
+                                                                    RealtimeDataHandler::encode(frame),
+                                                                    ProtocolPackager::CAPABILITY_GRAPH_DATA);
+    TEST_CHECK(serializer.deserialize(advertised, messageType, functionCode, received));
+    TEST_CHECK(serializer.negotiatedCapabilities() == ProtocolPackager::CAPABILITY_GRAPH_DATA);
+
+    const QByteArray envelope = serializer.serialize(MessageType::GRAPH_DATA, parameters, FunctionCode::RESPONSE, true);
+    TEST_CHECK(!envelope.isEmpty());
+
+    ScatterSpan payload;
+    TEST_CHECK(ProtocolPackager::unpackEnvelope(ScatterSpan(envelope), messageType, functionCode, payload));
+    TEST_CHECK(messageType == MessageType::GRAPH_DATA);
+    TEST_CHECK(payload.toByteArray() == RealtimeDataHandler::encode(frame));
+
+    // 载荷分两段时解码结果相同
+    const QByteArray encoded = payload.toByteArray();
+    const int split = encoded.size() / 2;
+    RealtimeFrame decoded;
+    TEST_CHECK(RealtimeDataHandler::decode(ScatterSpan(encoded.constData(), split,
+                                                       encoded.constData() + split, encoded.size() - split), decoded));
+    TEST_CHECK(decoded.count == frame.count);
+    for (int i = 0; i < frame.count && i < decoded.count; ++i) {
+        TEST_CHECK(decoded.id[i] == frame.id[i]);
+        TEST_CHECK(decoded.amplitude[i] == frame.amplitude[i]);
+        TEST_CHECK(decoded.frequency[i] == frame.frequency[i]);
+    }
+
+    // 旧接口的参数映射由帧转换得到
+    received.clear();
+    TEST_CHECK(serializer.deserialize(envelope, messageType, functionCode, received));
+    TEST_CHECK(received.value("channel_data").toList().size() == frame.count);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+
+    testAllDefaultMessage();
+    testZeroWriteDistinctFromReadback();
+    testCompactSize();
+    testRealtimeFrameEnvelope();
+
+    return TEST_RESULT();
+}
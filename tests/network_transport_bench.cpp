@@ -0,0 +1,227 @@
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include "../transport/tcp_transport.h"
+#include "../transport/udp_transport.h"
+
+/**
+ * @brief TCP/UDP传输基准
+ *
+ * 本机回环上以一个回显线程模拟串口转以太网网桥，测量：
+ * 1. 单帧往返时延（中位数和99分位）
+ * 2. 保持固定在途帧数时的吞吐量
+ * 不作为CTest测试运行。
+ */
+
+namespace {
+
+const int PING_COUNT = 2000;
+const int PING_SIZE = 32;
+const int THROUGHPUT_FRAMES = 20000;
+const int THROUGHPUT_FRAME_SIZE = 64;
+const int THROUGHPUT_WINDOW = 32;
+const int WAIT_TIMEOUT_MS = 2000;
+
+/**
+ * @brief 回环回显服务（阻塞socket，独立线程）
+ */
+class EchoServer
+{
+public:
+    explicit EchoServer(int type) : type_(type) {}
+
+    ~EchoServer() { stop(); }
+
+    bool start() {
+        listenFd_ = ::socket(AF_INET, type_, 0);
+        if (listenFd_ < 0) {
+            return false;
+        }
+
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(address);
+        if (::bind(listenFd_, reinterpret_cast<sockaddr*>(&address), length) < 0
+            || ::getsockname(listenFd_, reinterpret_cast<sockaddr*>(&address), &length) < 0
+            || (type_ == SOCK_STREAM && ::listen(listenFd_, 1) < 0)) {
+            return false;
+        }
+        port_ = ntohs(address.sin_port);
+
+        // 定期醒来检查停止标志
+        timeval timeout = {0, 100000};
+        ::setsockopt(listenFd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        thread_ = std::thread([this]() { type_ == SOCK_STREAM ? serveStream() : serveDatagrams(); });
+        return true;
+    }
+
+    void stop() {
+        stop_ = true;
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        if (listenFd_ >= 0) {
+            ::close(listenFd_);
+            listenFd_ = -1;
+        }
+    }
+
+    quint16 port() const { return port_; }
+
+private:
+    void serveStream() {
+        int fd = -1;
+        while (!stop_ && fd < 0) {
+            fd = ::accept(listenFd_, nullptr, nullptr);
+        }
+        if (fd < 0) {
+            return;
+        }
+
+        timeval timeout = {0, 100000};
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        char buffer[65536];
+        while (!stop_) {
+            const ssize_t received = ::recv(fd, buffer, sizeof(buffer), 0);
+            if (received == 0) {
+                break;
+            }
+            for (ssize_t sent = 0; received > 0 && sent < received;) {
+                const ssize_t n = ::send(fd, buffer + sent, static_cast<size_t>(received - sent), MSG_NOSIGNAL);
+                if (n <= 0) {
+                    break;
+                }
+                sent += n;
+            }
+        }
+        ::close(fd);
+    }
+
+    void serveDatagrams() {
+        char buffer[65536];
+        while (!stop_) {
+            sockaddr_in peer = {};
+            socklen_t length = sizeof(peer);
+            const ssize_t received = ::recvfrom(listenFd_, buffer, sizeof(buffer), 0,
+                                                reinterpret_cast<sockaddr*>(&peer), &length);
+            if (received > 0) {
+                ::sendto(listenFd_, buffer, static_cast<size_t>(received), 0,
+                         reinterpret_cast<sockaddr*>(&peer), length);
+            }
+        }
+    }
+
+    int type_;
+    int listenFd_ = -1;
+    quint16 port_ = 0;
+    std::atomic<bool> stop_{false};
+    std::thread thread_;
+};
+
+// 处理事件直到条件满足或超时
+template <typename Condition>
+bool waitFor(Condition condition, int timeoutMs) {
+    QElapsedTimer timer;
+    timer.start();
+    while (!condition()) {
+        if (timer.elapsed() > timeoutMs) {
+            return false;
+        }
+        QCoreApplication::processEvents(QEventLoop::AllEvents);
+    }
+    return true;
+}
+
+void bench(const char* name, ITransport& transport) {
+    qint64 receivedBytes = 0;
+    transport.addReceiveSink([&receivedBytes](const ReceiveSpan& span) {
+        receivedBytes += span.size();
+    });
+
+    if (!transport.open() || !waitFor([&transport] { return transport.isOpen(); }, WAIT_TIMEOUT_MS)) {
+        printf("%s: failed to open\n", name);
+        return;
+    }
+
+    // 往返时延
+    const QByteArray ping(PING_SIZE, 'p');
+    std::vector<qint64> latencies;
+    latencies.reserve(PING_COUNT);
+    QElapsedTimer clock;
+    clock.start();
+    for (int i = 0; i < PING_COUNT; ++i) {
+        const qint64 expected = receivedBytes + PING_SIZE;
+        const qint64 start = clock.nsecsElapsed();
+        transport.send(ping);
+        if (!waitFor([&] { return receivedBytes >= expected; }, WAIT_TIMEOUT_MS)) {
+            printf("%s: ping %d lost\n", name, i);
+            break;
+        }
+        latencies.push_back(clock.nsecsElapsed() - start);
+    }
+
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        printf("%s round trip: p50 %.1f us, p99 %.1f us\n", name,
+               latencies[latencies.size() / 2] / 1000.0,
+               latencies[latencies.size() * 99 / 100] / 1000.0);
+    }
+
+    // 固定在途帧数的吞吐量
+    const QByteArray frame(THROUGHPUT_FRAME_SIZE, 'f');
+    const qint64 base = receivedBytes;
+    const qint64 total = static_cast<qint64>(THROUGHPUT_FRAMES) * THROUGHPUT_FRAME_SIZE;
+    qint64 sentBytes = 0;
+    const qint64 start = clock.nsecsElapsed();
+    while (receivedBytes - base < total) {
+        while (sentBytes < total && sentBytes - (receivedBytes - base) < THROUGHPUT_WINDOW * THROUGHPUT_FRAME_SIZE) {
+            transport.send(frame);
+            sentBytes += THROUGHPUT_FRAME_SIZE;
+        }
+        const qint64 before = receivedBytes;
+        if (!waitFor([&] { return receivedBytes > before; }, WAIT_TIMEOUT_MS)) {
+            break;
+        }
+    }
+    const double seconds = (clock.nsecsElapsed() - start) / 1e9;
+    const qint64 echoed = receivedBytes - base;
+    printf("%s throughput: %.0f frames/s, %.2f MB/s, %lld of %lld bytes echoed\n", name,
+           echoed / THROUGHPUT_FRAME_SIZE / seconds, echoed / seconds / 1e6,
+           static_cast<long long>(echoed), static_cast<long long>(total));
+
+    transport.close();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+
+    EchoServer tcpEcho(SOCK_STREAM);
+    if (tcpEcho.start()) {
+        TcpTransport tcp("127.0.0.1", tcpEcho.port());
+        tcp.setNoDelay(true);
+        bench("TCP", tcp);
+    }
+
+    EchoServer udpEcho(SOCK_DGRAM);
+    if (udpEcho.start()) {
+        UdpTransport udp("127.0.0.1", udpEcho.port());
+        bench("UDP", udp);
+    }
+
+    return 0;
+}
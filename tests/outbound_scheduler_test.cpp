@@ -0,0 +1,239 @@
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QVariantMap>
+#include <thread>
+#include <vector>
+#include "test_common.h"
+#include "loopback_transport.h"
+#include "../connection/connection_manager.h"
+#include "../connection/outbound_scheduler.h"
+#include "../serialization/message_serializer.h"
+#include "../serialization/protocol_packager.h"
+
+/**
+ * @brief 发送调度器测试
+ *
+ * 验证：
+ * 1. 严格优先级下控制帧越过排队的批量帧
+ * 2. 加权策略按权重分配积压通道的发送机会
+ * 3. 批量上传占满115200波特链路时，控制帧的排队时间不超过上限
+ * 4. 多个线程同时入队，帧不丢失
+ * 5. 可靠通道经发送窗口发送，窗口已满时留在通道中，确认后继续调度
+ */
+
+using namespace Protocol;
+
+namespace {
+
+const int FRAME_SIZE = 100;
+const int SERIAL_BAUD_RATE = 115200;
+const qint64 CONTROL_DELAY_BOUND_US = 50000;    // 一个最大帧在该链路上约22ms
+
+// 以首字节标识通道的测试帧
+QByteArray laneFrame(char tag) {
+    return QByteArray(FRAME_SIZE, tag);
+}
+
+// 一个最大帧耗尽链路令牌，之后入队的帧积压，setLinkRate(0)时一次调度
+void blockLink(OutboundScheduler& scheduler) {
+    scheduler.setLinkRate(100);
+    scheduler.enqueue(OutboundScheduler::Lane::Control, QByteArray(FrameCodec::MAX_PAYLOAD_SIZE, 'x'));
+}
+
+QByteArray sentTags(LoopbackTransport& transport) {
+    QByteArray tags;
+    for (const QByteArray& payload : transport.takeSentPayloads()) {
+        tags.append(payload.at(0));
+    }
+    return tags;
+}
+
+// 处理事件直到条件满足或超时
+template <typename Condition>
+bool waitFor(Condition condition, int timeoutMs) {
+    QElapsedTimer timer;
+    timer.start();
+    while (!condition()) {
+        if (timer.elapsed() > timeoutMs) {
+            return false;
+        }
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 5);
+    }
+    return true;
+}
+
+void processEventsFor(int ms) {
+    waitFor([] { return false; }, ms);
+}
+
+QByteArray ancMessage(FunctionCode functionCode) {
+    MessageSerializer serializer;
+    QVariantMap parameters;
+    parameters["anc.enabled"] = true;
+    return serializer.serialize(MessageType::ANC_SWITCH, parameters, functionCode, true);
+}
+
+void testStrictPriority() {
+    LoopbackTransport transport;
+    ConnectionManager connectionManager;
+    connectionManager.setTransport(&transport);
+    transport.open();
+    OutboundScheduler scheduler(&connectionManager);
+
+    blockLink(scheduler);
+    for (int i = 0; i < 5; ++i) {
+        scheduler.enqueue(OutboundScheduler::Lane::Bulk, laneFrame('b'));
+    }
+    scheduler.enqueue(OutboundScheduler::Lane::Streaming, laneFrame('s'));
+    scheduler.enqueue(OutboundScheduler::Lane::Control, laneFrame('c'));
+    scheduler.setLinkRate(0);
+
+    TEST_CHECK(sentTags(transport) == QByteArray("xcsbbbbb"));
+}
+
+void testWeightedShare() {
+    LoopbackTransport transport;
+    ConnectionManager connectionManager;
+    connectionManager.setTransport(&transport);
+    transport.open();
+    OutboundScheduler scheduler(&connectionManager);
+    scheduler.setPolicy(OutboundScheduler::Policy::Weighted);
+    scheduler.setLaneWeight(OutboundScheduler::Lane::Streaming, 3);
+    scheduler.setLaneWeight(OutboundScheduler::Lane::Bulk, 1);
+
+    blockLink(scheduler);
+    for (int i = 0; i < 20; ++i) {
+        scheduler.enqueue(OutboundScheduler::Lane::Streaming, laneFrame('s'));
+        scheduler.enqueue(OutboundScheduler::Lane::Bulk, laneFrame('b'));
+    }
+    scheduler.setLinkRate(0);
+
+    // 两个通道都积压时按3:1发送
+    const QByteArray tags = sentTags(transport);
+    TEST_CHECK(tags.size() == 41);
+    const QByteArray contended = tags.mid(1, 16);
+    TEST_CHECK(contended.count('s') == 12);
+    TEST_CHECK(contended.count('b') == 4);
+}
+
+void testControlLatencyUnderBulkLoad() {
+    LoopbackTransport transport;
+    ConnectionManager connectionManager;
+    connectionManager.setTransport(&transport);
+    transport.open();
+    OutboundScheduler scheduler(&connectionManager);
+    scheduler.configureForBaudRate(SERIAL_BAUD_RATE);
+    scheduler.setLaneRate(OutboundScheduler::Lane::Bulk, 0);    // 批量通道不限速，占满链路
+
+    // 约1秒的批量上传
+    const int bulkFrames = 80;
+    for (int i = 0; i < bulkFrames; ++i) {
+        TEST_CHECK(scheduler.enqueue(OutboundScheduler::Lane::Bulk, QByteArray(FrameCodec::MAX_PAYLOAD_SIZE, 'b')));
+    }
+
+    // 链路进入稳定的限速状态后发出控制帧
+    processEventsFor(100);
+    TEST_CHECK(scheduler.queuedFrames(OutboundScheduler::Lane::Bulk) > 0);
+
+    for (int i = 0; i < 3; ++i) {
+        scheduler.enqueue(OutboundScheduler::Lane::Control, laneFrame('c'));
+        TEST_CHECK(waitFor([&scheduler] {
+            return scheduler.queuedFrames(OutboundScheduler::Lane::Control) == 0;
+        }, 1000));
+
+        const OutboundScheduler::LaneStats stats = scheduler.laneStats(OutboundScheduler::Lane::Control);
+        qInfo() << "Control frame queue delay:" << stats.lastQueueDelayUs << "us";
+        TEST_CHECK(stats.lastQueueDelayUs < CONTROL_DELAY_BOUND_US);
+        processEventsFor(50);
+    }
+
+    // 批量上传仍在进行，控制帧没有等它发完
+    TEST_CHECK(scheduler.queuedFrames(OutboundScheduler::Lane::Bulk) > 0);
+    scheduler.clear();
+}
+
+void testConcurrentEnqueue() {
+    LoopbackTransport transport;
+    ConnectionManager connectionManager;
+    connectionManager.setTransport(&transport);
+    transport.open();
+    OutboundScheduler scheduler(&connectionManager);
+
+    const int threadCount = 4;
+    const int framesPerThread = 200;
+    scheduler.setLaneCapacity(OutboundScheduler::Lane::Bulk, threadCount * framesPerThread);
+
+    std::vector<std::thread> producers;
+    for (int t = 0; t < threadCount; ++t) {
+        producers.emplace_back([&scheduler, t] {
+            for (int i = 0; i < framesPerThread; ++i) {
+                scheduler.enqueue(OutboundScheduler::Lane::Bulk, laneFrame(static_cast<char>('a' + t)));
+            }
+        });
+    }
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+
+    TEST_CHECK(waitFor([&scheduler] {
+        return scheduler.queuedFrames(OutboundScheduler::Lane::Bulk) == 0;
+    }, 5000));
+
+    const QByteArray tags = sentTags(transport);
+    TEST_CHECK(tags.size() == threadCount * framesPerThread);
+    for (int t = 0; t < threadCount; ++t) {
+        TEST_CHECK(tags.count(static_cast<char>('a' + t)) == framesPerThread);
+    }
+
+    const OutboundScheduler::LaneStats stats = scheduler.laneStats(OutboundScheduler::Lane::Bulk);
+    TEST_CHECK(stats.framesDropped == 0);
+}
+
+void testReliableLaneWaitsForWindow() {
+    LoopbackTransport transport;
+    ConnectionManager connectionManager;
+    connectionManager.setTransport(&transport);
+    transport.open();
+    connectionManager.setWindowSize(1);
+    OutboundScheduler scheduler(&connectionManager);
+
+    for (int i = 0; i < 3; ++i) {
+        TEST_CHECK(scheduler.enqueue(OutboundScheduler::Lane::Bulk, ancMessage(FunctionCode::REQUEST)));
+    }
+
+    // 窗口只容纳一帧，其余留在通道中而不是堆进发送队列
+    TEST_CHECK(transport.takeSentPayloads().size() == 1);
+    TEST_CHECK(connectionManager.inFlightCount() == 1);
+    TEST_CHECK(connectionManager.pendingReliableCount() == 0);
+    TEST_CHECK(scheduler.queuedFrames(OutboundScheduler::Lane::Bulk) == 2);
+
+    // 流式通道不受发送窗口限制
+    scheduler.enqueue(OutboundScheduler::Lane::Streaming, laneFrame('s'));
+    TEST_CHECK(sentTags(transport) == QByteArray("s"));
+
+    // 第一帧（序号1）被确认后调度下一帧
+    transport.injectFrame(ProtocolPackager::appendSequence(ancMessage(FunctionCode::RESPONSE), 1));
+    TEST_CHECK(connectionManager.inFlightCount() == 1);
+    TEST_CHECK(scheduler.queuedFrames(OutboundScheduler::Lane::Bulk) == 1);
+    TEST_CHECK(transport.takeSentPayloads().size() == 1);
+
+    const OutboundScheduler::LaneStats stats = scheduler.laneStats(OutboundScheduler::Lane::Bulk);
+    TEST_CHECK(stats.framesSent == 2);
+    TEST_CHECK(stats.framesDropped == 0);
+    scheduler.clear();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+
+    testStrictPriority();
+    testWeightedShare();
+    testControlLatencyUnderBulkLoad();
+    testConcurrentEnqueue();
+    testReliableLaneWaitsForWindow();
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,165 @@
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QSocketNotifier>
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "../transport/shared_memory_transport.h"
+
+/**
+ * @brief 共享内存传输基准
+ *
+ * 与同样经Qt事件循环收发的Unix域套接字（SOCK_SEQPACKET）对比：
+ * 1. 单帧往返时延（中位数和99分位）
+ * 2. 保持固定在途帧数时的吞吐量
+ * 两端在同一进程中，订阅者/对端收到帧后原样回送。不作为CTest测试运行。
+ */
+
+namespace {
+
+const int PING_COUNT = 5000;
+const int PING_SIZE = 32;
+const int THROUGHPUT_FRAMES = 50000;
+const int THROUGHPUT_FRAME_SIZE = 64;
+const int THROUGHPUT_WINDOW = 32;
+const int WAIT_TIMEOUT_MS = 2000;
+
+// 处理事件直到条件满足或超时
+template <typename Condition>
+bool waitFor(Condition condition, int timeoutMs) {
+    QElapsedTimer timer;
+    timer.start();
+    while (!condition()) {
+        if (timer.elapsed() > timeoutMs) {
+            return false;
+        }
+        QCoreApplication::processEvents(QEventLoop::AllEvents);
+    }
+    return true;
+}
+
+void bench(const char* name, const std::function<bool(const QByteArray&)>& send, const qint64& receivedBytes) {
+    QElapsedTimer clock;
+    clock.start();
+
+    // 往返时延
+    const QByteArray ping(PING_SIZE, 'p');
+    std::vector<qint64> latencies;
+    latencies.reserve(PING_COUNT);
+    for (int i = 0; i < PING_COUNT; ++i) {
+        const qint64 expected = receivedBytes + PING_SIZE;
+        const qint64 start = clock.nsecsElapsed();
+        send(ping);
+        if (!waitFor([&] { return receivedBytes >= expected; }, WAIT_TIMEOUT_MS)) {
+            printf("%s: ping %d lost\n", name, i);
+            break;
+        }
+        latencies.push_back(clock.nsecsElapsed() - start);
+    }
+
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        printf("%-14s round trip: p50 %.1f us, p99 %.1f us\n", name,
+               latencies[latencies.size() / 2] / 1000.0,
+               latencies[latencies.size() * 99 / 100] / 1000.0);
+    }
+
+    // 固定在途帧数的吞吐量
+    const QByteArray frame(THROUGHPUT_FRAME_SIZE, 'f');
+    const qint64 base = receivedBytes;
+    const qint64 total = static_cast<qint64>(THROUGHPUT_FRAMES) * THROUGHPUT_FRAME_SIZE;
+    qint64 sentBytes = 0;
+    const qint64 start = clock.nsecsElapsed();
+    while (receivedBytes - base < total) {
+        while (sentBytes < total && sentBytes - (receivedBytes - base) < THROUGHPUT_WINDOW * THROUGHPUT_FRAME_SIZE) {
+            if (!send(frame)) {
+                break;
+            }
+            sentBytes += THROUGHPUT_FRAME_SIZE;
+        }
+        const qint64 before = receivedBytes;
+        if (!waitFor([&] { return receivedBytes > before; }, WAIT_TIMEOUT_MS)) {
+            break;
+        }
+    }
+    const double seconds = (clock.nsecsElapsed() - start) / 1e9;
+    const qint64 echoed = receivedBytes - base;
+    printf("%-14s throughput: %.0f frames/s, %.2f MB/s\n", name,
+           echoed / THROUGHPUT_FRAME_SIZE / seconds, echoed / seconds / 1e6);
+}
+
+void benchSharedMemory() {
+    const QString name = QString("ernc_bench_%1").arg(QCoreApplication::applicationPid());
+    SharedMemoryTransport owner(name, SharedMemoryTransport::Role::Owner);
+    SharedMemoryTransport subscriber(name, SharedMemoryTransport::Role::Subscriber);
+    if (!owner.open() || !subscriber.open()) {
+        printf("shared memory: failed to open\n");
+        return;
+    }
+
+    subscriber.addReceiveSink([&subscriber](const ReceiveSpan& span) {
+        subscriber.send(span.toByteArray());
+    });
+
+    qint64 receivedBytes = 0;
+    owner.addReceiveSink([&receivedBytes](const ReceiveSpan& span) {
+        receivedBytes += span.size();
+    });
+
+    bench("shared memory", [&owner](const QByteArray& data) { return owner.send(data); }, receivedBytes);
+
+    subscriber.close();
+    owner.close();
+}
+
+void benchUnixSocket() {
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds) < 0) {
+        printf("unix socket: socketpair failed\n");
+        return;
+    }
+
+    char buffer[4096];
+
+    // 对端回送
+    QSocketNotifier echoNotifier(fds[1], QSocketNotifier::Read);
+    QObject::connect(&echoNotifier, &QSocketNotifier::activated, [&]() {
+        const ssize_t received = ::recv(fds[1], buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (received > 0) {
+            ::send(fds[1], buffer, static_cast<size_t>(received), MSG_NOSIGNAL);
+        }
+    });
+
+    qint64 receivedBytes = 0;
+    QSocketNotifier replyNotifier(fds[0], QSocketNotifier::Read);
+    QObject::connect(&replyNotifier, &QSocketNotifier::activated, [&]() {
+        const ssize_t received = ::recv(fds[0], buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (received > 0) {
+            receivedBytes += received;
+        }
+    });
+
+    bench("unix socket", [&fds](const QByteArray& data) {
+        return ::send(fds[0], data.constData(), static_cast<size_t>(data.size()), MSG_NOSIGNAL) == data.size();
+    }, receivedBytes);
+
+    echoNotifier.setEnabled(false);
+    replyNotifier.setEnabled(false);
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+
+    benchSharedMemory();
+    benchUnixSocket();
+
+    return 0;
+}
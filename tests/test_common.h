@@ -0,0 +1,27 @@
+#ifndef TEST_COMMON_H
+#define TEST_COMMON_H
+
+#include <QDebug>
+
+/**
+ * @brief 测试辅助宏
+ *
+ * 测试程序不依赖测试框架：检查失败时输出位置并计数，main()按失败数返回退出码，由CTest判定结果。
+ */
+
+inline int& testFailureCount() {
+    static int failures = 0;
+    return failures;
+}
+
+#define TEST_CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            qCritical().nospace() << __FILE__ << ":" << __LINE__ << ": check failed: " << #condition; \
+            ++testFailureCount(); \
+        } \
+    } while (0)
+
+#define TEST_RESULT() (testFailureCount() == 0 ? 0 : 1)
+
+#endif // TEST_COMMON_H
@@ -0,0 +1,199 @@
+#include <QCoreApplication>
+#include <limits>
+#include "test_common.h"
+#include "loopback_transport.h"
+#include "../adapter/protocol_adapter_refactored.h"
+#include "../handlers/realtime_data_handler.h"
+#include "../serialization/message_codec.h"
+#include "../serialization/protocol_packager.h"
+#include "../state/time_series_store.h"
+
+/**
+ * @brief 时间序列存储测试
+ *
+ * 经适配器接收链路注入设备数据，验证：
+ * 1. MSG_ChannelAmplitude写入13个输入通道和1个输出通道
+ * 2. GRAPH_DATA实时数据帧（包括批量帧中的多帧）按通道id写入实时通道
+ * 3. CHECK_MOD（数据流启停）不产生采样
+ * 4. 抽稀读取：按窗口选择级别、桶的min/max、最新未完成桶由细级别补齐、绕环后丢弃被覆盖的数据
+ */
+
+using namespace Protocol;
+
+namespace {
+
+QByteArray amplitudeResponse(quint32 base) {
+    MSG_ChannelAmplitude amplitude = MSG_ChannelAmplitude_init_zero;
+    for (int i = 0; i < TimeSeriesStore::INPUT_AMPLITUDE_COUNT; ++i) {
+        amplitude.InputAmplitude[i] = base + static_cast<quint32>(i);
+    }
+    amplitude.OutputAmplitude = base + 100;
+
+    QByteArray payload;
+    MessageCodec::encode(amplitude, payload);
+    return ProtocolPackager().packageMessage(MessageType::CHANNEL_AMPLITUDE, FunctionCode::RESPONSE, payload);
+}
+
+QByteArray realtimeResponse(float amplitude) {
+    RealtimeFrame frame;
+    frame.channelCount = 2;
+    frame.sampleRate = 1000;
+    frame.count = 2;
+    frame.id[0] = 0;
+    frame.amplitude[0] = amplitude;
+    frame.frequency[0] = 50.0f;
+    frame.id[1] = 7;
+    frame.amplitude[1] = -amplitude;
+    frame.frequency[1] = 120.0f;
+
+    // 设备在实时数据帧中通告CAPABILITY_GRAPH_DATA
+    return ProtocolPackager().packageMessage(MessageType::GRAPH_DATA, FunctionCode::RESPONSE,
+                                             RealtimeDataHandler::encode(frame), ProtocolPackager::CAPABILITY_GRAPH_DATA);
+}
+
+// 偶数序号为正、奇数序号为负：每个桶的最小值是最后一个采样，最大值是倒数第二个
+float sampleValue(int i) {
+    return static_cast<float>(i % 2 == 0 ? i : -i);
+}
+
+constexpr qint64 SAMPLE_INTERVAL_NS = 1000;
+
+quint64 totalSamples(const TimeSeriesStore& store) {
+    quint64 total = 0;
+    for (int channel = 0; channel < TimeSeriesStore::CHANNEL_COUNT; ++channel) {
+        total += store.sampleCount(channel);
+    }
+    return total;
+}
+
+void testChannelAmplitude() {
+    LoopbackTransport transport;
+    transport.open();
+    ProtocolAdapterRefactored adapter(&transport);
+    const TimeSeriesStore& store = *adapter.timeSeries();
+
+    transport.injectFrame(amplitudeResponse(10));
+    transport.injectFrame(amplitudeResponse(20));
+
+    for (int i = 0; i < TimeSeriesStore::INPUT_AMPLITUDE_COUNT; ++i) {
+        TEST_CHECK(store.sampleCount(TimeSeriesStore::INPUT_AMPLITUDE_CHANNEL + i) == 2);
+    }
+    TEST_CHECK(store.sampleCount(TimeSeriesStore::OUTPUT_AMPLITUDE_CHANNEL) == 2);
+
+    TimeSeriesStore::Point point;
+    TEST_CHECK(store.latest(TimeSeriesStore::INPUT_AMPLITUDE_CHANNEL + 3, point));
+    TEST_CHECK(point.minimum == 23.0f);
+    TEST_CHECK(store.latest(TimeSeriesStore::OUTPUT_AMPLITUDE_CHANNEL, point));
+    TEST_CHECK(point.maximum == 120.0f);
+}
+
+void testRealtimeFrames() {
+    LoopbackTransport transport;
+    transport.open();
+    ProtocolAdapterRefactored adapter(&transport);
+    const TimeSeriesStore& store = *adapter.timeSeries();
+
+    transport.injectFrame(realtimeResponse(1.0f));
+    transport.injectFrame(ProtocolPackager::packageBatch({ realtimeResponse(2.0f), realtimeResponse(3.0f) }));
+
+    TEST_CHECK(store.sampleCount(TimeSeriesStore::REALTIME_CHANNEL) == 3);
+    TEST_CHECK(store.sampleCount(TimeSeriesStore::REALTIME_CHANNEL + 7) == 3);
+    TEST_CHECK(store.sampleCount(TimeSeriesStore::REALTIME_CHANNEL + 1) == 0);
+    TEST_CHECK(totalSamples(store) == 6);
+
+    TimeSeriesStore::Point point;
+    TEST_CHECK(store.latest(TimeSeriesStore::REALTIME_CHANNEL, point));
+    TEST_CHECK(point.minimum == 3.0f);
+    TEST_CHECK(store.latest(TimeSeriesStore::REALTIME_CHANNEL + 7, point));
+    TEST_CHECK(point.minimum == -3.0f);
+
+    QVector<TimeSeriesStore::Point> points;
+    TEST_CHECK(store.read(TimeSeriesStore::REALTIME_CHANNEL, 0, point.timestampNs, 100, points) == 3);
+}
+
+void testCheckModeNotRecorded() {
+    LoopbackTransport transport;
+    transport.open();
+    ProtocolAdapterRefactored adapter(&transport);
+
+    // 启动数据流的应答
+    MSG_CheckMod checkMod = MSG_CheckMod_init_zero;
+    checkMod.check_mod = 1;
+    QByteArray payload;
+    TEST_CHECK(MessageCodec::encode(checkMod, payload));
+    transport.injectFrame(ProtocolPackager().packageMessage(MessageType::CHECK_MOD, FunctionCode::RESPONSE, payload));
+
+    TEST_CHECK(totalSamples(*adapter.timeSeries()) == 0);
+}
+
+void testDecimatedRead() {
+    // 原始容量64，各级容量16；第1级每桶4个采样，第2级每桶16个采样
+    TimeSeriesStore store(64, 2);
+    TEST_CHECK(store.capacity() == 64);
+    TEST_CHECK(store.levelCount() == 2);
+
+    const int channel = TimeSeriesStore::REALTIME_CHANNEL;
+    int sample = 0;
+    for (; sample < 250; ++sample) {
+        store.append(channel, sampleValue(sample), sample * SAMPLE_INTERVAL_NS);
+    }
+
+    // 短窗口在原始采样内
+    QVector<TimeSeriesStore::Point> points;
+    int level = -1;
+    TEST_CHECK(store.read(channel, 200 * SAMPLE_INTERVAL_NS, 249 * SAMPLE_INTERVAL_NS, 100, points, &level) == 50);
+    TEST_CHECK(level == 0);
+    TEST_CHECK(points.first().minimum == points.first().maximum);
+
+    // 长窗口只有第2级覆盖起点：15个完整的第2级桶，第2级未完成的部分（采样240~249）
+    // 由第1级的两个桶（240~243、244~247）和两个原始采样（248、249）补齐
+    TEST_CHECK(store.read(channel, 0, std::numeric_limits<qint64>::max(), 20, points, &level) == 19);
+    TEST_CHECK(level == 2);
+    for (int i = 0; i < 15 && i < points.size(); ++i) {
+        TEST_CHECK(points[i].timestampNs == i * 16 * SAMPLE_INTERVAL_NS);
+        TEST_CHECK(points[i].minimum == sampleValue(i * 16 + 15));
+        TEST_CHECK(points[i].maximum == sampleValue(i * 16 + 14));
+    }
+    if (points.size() == 19) {
+        TEST_CHECK(points[15].timestampNs == 240 * SAMPLE_INTERVAL_NS);
+        TEST_CHECK(points[15].minimum == sampleValue(243));
+        TEST_CHECK(points[15].maximum == sampleValue(242));
+        TEST_CHECK(points[16].timestampNs == 244 * SAMPLE_INTERVAL_NS);
+        TEST_CHECK(points[16].minimum == sampleValue(247));
+        TEST_CHECK(points[16].maximum == sampleValue(246));
+        TEST_CHECK(points[17].timestampNs == 248 * SAMPLE_INTERVAL_NS);
+        TEST_CHECK(points[17].minimum == sampleValue(248) && points[17].maximum == sampleValue(248));
+        TEST_CHECK(points[18].timestampNs == 249 * SAMPLE_INTERVAL_NS);
+        TEST_CHECK(points[18].minimum == sampleValue(249) && points[18].maximum == sampleValue(249));
+    }
+
+    // 第2级绕环后（25个桶、容量16），被覆盖的最旧桶不再返回
+    for (; sample < 400; ++sample) {
+        store.append(channel, sampleValue(sample), sample * SAMPLE_INTERVAL_NS);
+    }
+    TEST_CHECK(store.sampleCount(channel) == 400);
+    TEST_CHECK(store.read(channel, 0, std::numeric_limits<qint64>::max(), 100, points, &level) == 15);
+    TEST_CHECK(level == 2);
+    if (!points.isEmpty()) {
+        TEST_CHECK(points.first().timestampNs == 160 * SAMPLE_INTERVAL_NS);
+        TEST_CHECK(points.first().minimum == sampleValue(175));
+        TEST_CHECK(points.last().timestampNs == 384 * SAMPLE_INTERVAL_NS);
+        TEST_CHECK(points.last().maximum == sampleValue(398));
+    }
+    for (int i = 1; i < points.size(); ++i) {
+        TEST_CHECK(points[i].timestampNs > points[i - 1].timestampNs);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+
+    testChannelAmplitude();
+    testRealtimeFrames();
+    testCheckModeNotRecorded();
+    testDecimatedRead();
+
+    return TEST_RESULT();
+}
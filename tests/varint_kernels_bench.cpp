@@ -0,0 +1,82 @@
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "serialization/varint_kernels.h"
+
+/**
+ * @brief packed varint内核基准
+ *
+ * 按标定和量程数组的典型取值（全单字节、1~2字节、混合长度）比较各实现的编解码耗时，
+ * 输出每个值的平均纳秒数。不作为CTest测试运行。
+ */
+
+using namespace Protocol;
+
+namespace {
+
+const size_t VALUE_COUNT = 64;
+const int ROUNDS = 200000;
+
+template <typename Function>
+double nanosecondsPerValue(Function function) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; ++round) {
+        function();
+    }
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / (static_cast<double>(ROUNDS) * VALUE_COUNT);
+}
+
+void bench(const char* name, const std::vector<uint32_t>& values) {
+    std::vector<uint8_t> encoded(VALUE_COUNT * PackedVarint::MAX_VARINT_SIZE);
+    std::vector<uint32_t> decoded(VALUE_COUNT);
+    const size_t size = PackedVarint::encode(values.data(), values.size(), encoded.data());
+    size_t sink = 0;
+
+    printf("%-10s %4zu bytes |", name, size);
+
+    const PackedVarint::Implementation implementations[] = {
+        PackedVarint::Implementation::Scalar,
+        PackedVarint::Implementation::Sse41,
+        PackedVarint::Implementation::Avx2
+    };
+    for (PackedVarint::Implementation implementation : implementations) {
+        if (!PackedVarint::setImplementation(implementation)) {
+            continue;
+        }
+
+        const double encode = nanosecondsPerValue([&] {
+            sink += PackedVarint::encode(values.data(), values.size(), encoded.data());
+        });
+        const double decode = nanosecondsPerValue([&] {
+            const uint8_t* data = encoded.data();
+            size_t count = 0;
+            PackedVarint::decode(data, encoded.data() + size, decoded.data(), VALUE_COUNT, count);
+            sink += decoded[count / 2];
+        });
+        printf(" %s enc %.2f dec %.2f ns |", PackedVarint::implementationName(implementation), encode, decode);
+    }
+
+    // 输出结果防止循环被优化掉
+    printf(" %zu\n", sink & 1);
+}
+
+} // namespace
+
+int main() {
+    std::mt19937 rng(3);
+    std::vector<uint32_t> oneByte(VALUE_COUNT);
+    std::vector<uint32_t> twoBytes(VALUE_COUNT);
+    std::vector<uint32_t> mixed(VALUE_COUNT);
+    for (size_t i = 0; i < VALUE_COUNT; ++i) {
+        oneByte[i] = rng() % 128;
+        twoBytes[i] = rng() % 16384;
+        mixed[i] = rng() % 8 == 0 ? rng() : rng() % 300;
+    }
+
+    bench("1 byte", oneByte);
+    bench("1-2 bytes", twoBytes);
+    bench("mixed", mixed);
+    return 0;
+}
@@ -0,0 +1,207 @@
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "test_common.h"
+#include "serialization/varint_kernels.h"
+
+/**
+ * @brief packed varint内核测试
+ *
+ * 对本机支持的每种实现，与逐字节的参考实现比较：
+ * 1. encodedSize()和encode()的结果，encode()不写出count * MAX_VARINT_SIZE之外的字节
+ * 2. 对翻转字节、插入续位字节、截断后的输入，decode()的成败、解码个数、停止位置和取值，
+ *    包括maxCount小于、等于和大于实际个数的情况
+ * 3. count()的结果
+ */
+
+using namespace Protocol;
+
+namespace {
+
+const int ITERATIONS = 300000;
+const size_t MAX_VALUES = 70;
+const uint8_t GUARD_BYTE = 0xCC;
+
+std::mt19937_64 rng(1);
+
+// 参考实现：逐字节解码一个uint32 varint，错误条件与nanopb一致
+bool referenceRead(const uint8_t*& data, const uint8_t* end, uint32_t& value) {
+    uint64_t result = 0;
+    unsigned shift = 0;
+    uint8_t byte = 0;
+    do {
+        if (data == end) {
+            return false;
+        }
+        byte = *data++;
+        if (shift >= 63 && (byte & 0xFE) != 0) {
+            return false;
+        }
+        result |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+
+    if (result > 0xFFFFFFFFu) {
+        return false;
+    }
+    value = static_cast<uint32_t>(result);
+    return true;
+}
+
+std::vector<uint8_t> referenceEncode(const std::vector<uint32_t>& values) {
+    std::vector<uint8_t> out;
+    for (uint32_t value : values) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+    return out;
+}
+
+// 随机取值：全单字节、1~2字节、偶尔5字节、大量零、任意长度
+std::vector<uint32_t> randomValues() {
+    std::vector<uint32_t> values(rng() % MAX_VALUES);
+    const int mode = static_cast<int>(rng() % 5);
+    for (uint32_t& value : values) {
+        switch (mode) {
+        case 0:
+            value = static_cast<uint32_t>(rng() % 128);
+            break;
+        case 1:
+            value = static_cast<uint32_t>(rng() % 16384);
+            break;
+        case 2:
+            value = rng() % 4 == 0 ? static_cast<uint32_t>(rng()) : static_cast<uint32_t>(rng() % 300);
+            break;
+        case 3:
+            value = rng() % 2 != 0 ? 0 : static_cast<uint32_t>(rng() % 200);
+            break;
+        default:
+            value = static_cast<uint32_t>(rng()) >> (rng() % 32);
+            break;
+        }
+    }
+    return values;
+}
+
+std::vector<uint8_t> corrupt(std::vector<uint8_t> input) {
+    switch (rng() % 4) {
+    case 1:
+        if (!input.empty()) {
+            input[rng() % input.size()] = static_cast<uint8_t>(rng());
+        }
+        break;
+    case 2:
+        // 插入续位字节，产生过长或超出uint32的varint
+        for (int i = static_cast<int>(rng() % 12); i > 0; --i) {
+            const size_t position = input.empty() ? 0 : rng() % input.size();
+            input.insert(input.begin() + position, static_cast<uint8_t>(0x80 | rng()));
+        }
+        break;
+    case 3:
+        input.resize(input.empty() ? 0 : rng() % input.size());
+        break;
+    default:
+        break;
+    }
+    return input;
+}
+
+void checkEncode(PackedVarint::Implementation implementation, const std::vector<uint32_t>& values,
+                 const std::vector<uint8_t>& expected) {
+    const size_t count = values.size();
+    TEST_CHECK(PackedVarint::encodedSize(values.data(), count) == expected.size());
+
+    // 实现允许按块写满count * MAX_VARINT_SIZE字节，之后的字节不能被改写
+    std::vector<uint8_t> out(count * PackedVarint::MAX_VARINT_SIZE + 16, GUARD_BYTE);
+    const size_t size = PackedVarint::encode(values.data(), count, out.data());
+    const bool matches = size == expected.size()
+        && (size == 0 || memcmp(out.data(), expected.data(), size) == 0);
+    if (!matches) {
+        printf("%s: encode mismatch (%zu values)\n", PackedVarint::implementationName(implementation), count);
+    }
+    TEST_CHECK(matches);
+
+    bool guardIntact = true;
+    for (size_t i = count * PackedVarint::MAX_VARINT_SIZE; i < out.size(); ++i) {
+        guardIntact = guardIntact && out[i] == GUARD_BYTE;
+    }
+    TEST_CHECK(guardIntact);
+}
+
+void checkDecode(PackedVarint::Implementation implementation, const std::vector<uint8_t>& input, size_t maxCount) {
+    const uint8_t* end = input.data() + input.size();
+
+    std::vector<uint32_t> expected(maxCount + 1);
+    const uint8_t* expectedStop = input.data();
+    size_t expectedCount = 0;
+    bool expectedOk = true;
+    while (expectedStop != end && expectedCount < maxCount) {
+        if (!referenceRead(expectedStop, end, expected[expectedCount])) {
+            expectedOk = false;
+            break;
+        }
+        ++expectedCount;
+    }
+
+    std::vector<uint32_t> actual(maxCount + 1);
+    const uint8_t* stop = input.data();
+    size_t decoded = 0;
+    const bool ok = PackedVarint::decode(stop, end, actual.data(), maxCount, decoded);
+
+    const bool matches = ok == expectedOk
+        && (!ok || (decoded == expectedCount && stop == expectedStop
+                    && memcmp(actual.data(), expected.data(), decoded * sizeof(uint32_t)) == 0));
+    if (!matches) {
+        printf("%s: decode mismatch (ok %d/%d, decoded %zu/%zu)\n",
+               PackedVarint::implementationName(implementation), ok, expectedOk, decoded, expectedCount);
+    }
+    TEST_CHECK(matches);
+}
+
+void checkCount(const std::vector<uint8_t>& input) {
+    size_t expected = 0;
+    for (uint8_t byte : input) {
+        expected += (byte & 0x80) == 0 ? 1 : 0;
+    }
+    const bool expectedOk = input.empty() || (input.back() & 0x80) == 0;
+
+    size_t count = 0;
+    const bool ok = PackedVarint::count(input.data(), input.size(), count);
+    TEST_CHECK(ok == expectedOk);
+    TEST_CHECK(count == expected);
+}
+
+} // namespace
+
+int main() {
+    const PackedVarint::Implementation implementations[] = {
+        PackedVarint::Implementation::Scalar,
+        PackedVarint::Implementation::Sse41,
+        PackedVarint::Implementation::Avx2
+    };
+
+    printf("best implementation: %s\n",
+           PackedVarint::implementationName(PackedVarint::bestImplementation()));
+
+    for (int iteration = 0; iteration < ITERATIONS && testFailureCount() < 10; ++iteration) {
+        const std::vector<uint32_t> values = randomValues();
+        const std::vector<uint8_t> encoded = referenceEncode(values);
+        const std::vector<uint8_t> input = corrupt(encoded);
+        const size_t maxCount = rng() % 3 == 0 ? rng() % (MAX_VALUES + 10) : values.size();
+
+        for (PackedVarint::Implementation implementation : implementations) {
+            if (!PackedVarint::setImplementation(implementation)) {
+                continue;
+            }
+            checkEncode(implementation, values, encoded);
+            checkDecode(implementation, input, maxCount);
+            checkCount(input);
+        }
+    }
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,100 @@
+#include "capturing_transport.h"
+#include <QDebug>
+
+CapturingTransport::CapturingTransport(ITransport* inner, QObject* parent)
+    : ITransport(parent)
+    , inner_(inner)
+    , receiveSinkId_(0)
+    , capturing_(false)
+{
+    if (!inner_) {
+        qWarning() << "CapturingTransport created without inner transport";
+        return;
+    }
+
+    // 接收方向：先落盘，再把同一块缓冲区原样转发给上层
+    receiveSinkId_ = inner_->addReceiveSink([this](const ReceiveSpan& span) {
+        if (capturing_.load(std::memory_order_acquire)) {
+            writer_.append(LinkCapture::Direction::Received, span.data(), span.size());
+        }
+        deliverReceived(span.data(), span.size(), span.owner());
+    });
+
+    connect(inner_.data(), &ITransport::connectionStatusChanged,
+            this, [this](bool connected) { emitConnectionStatusChanged(connected); });
+    connect(inner_.data(), &ITransport::transportError,
+            this, [this](const QString& error) { emitTransportError(error); });
+}
+
+CapturingTransport::~CapturingTransport()
+{
+    if (inner_ && receiveSinkId_ != 0) {
+        inner_->removeReceiveSink(receiveSinkId_);
+    }
+    stopCapture();
+}
+
+bool CapturingTransport::startCapture(const QString& path)
+{
+    if (isCapturing()) {
+        stopCapture();
+    }
+
+    if (!writer_.open(path)) {
+        qWarning() << "Failed to start link capture:" << writer_.lastErrorString();
+        emitTransportError(QString("Failed to start capture: %1").arg(writer_.lastErrorString()));
+        return false;
+    }
+
+    capturing_.store(true, std::memory_order_release);
+    return true;
+}
+
+void CapturingTransport::stopCapture()
+{
+    if (!capturing_.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+    writer_.close();
+}
+
+bool CapturingTransport::open()
+{
+    return inner_ && inner_->open();
+}
+
+void CapturingTransport::close()
+{
+    if (inner_) {
+        inner_->close();
+    }
+}
+
+bool CapturingTransport::isOpen() const
+{
+    return inner_ && inner_->isOpen();
+}
+
+bool CapturingTransport::send(const QByteArray& data)
+{
+    if (!inner_) {
+        emitTransportError("No inner transport");
+        return false;
+    }
+
+    if (capturing_.load(std::memory_order_acquire)) {
+        writer_.append(LinkCapture::Direction::Sent, data.constData(), data.size());
+    }
+    return inner_->send(data);
+}
+
+QString CapturingTransport::description() const
+{
+    QString innerDescription = inner_ ? inner_->description() : QString("none");
+    return QString("Capture: %1%2").arg(innerDescription, isCapturing() ? " [recording]" : "");
+}
+
+QString CapturingTransport::transportType() const
+{
+    return inner_ ? inner_->transportType() : QString("Capture");
+}
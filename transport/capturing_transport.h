@@ -0,0 +1,65 @@
+#ifndef CAPTURING_TRANSPORT_H
+#define CAPTURING_TRANSPORT_H
+
+#include "itransport.h"
+#include "link_capture.h"
+#include <QPointer>
+#include <atomic>
+
+/**
+ * @brief 抓包传输装饰器
+ *
+ * 包装任意ITransport，在传输层边界把收发两个方向的原始字节连同单调时间戳
+ * 写入抓包文件（见LinkCaptureWriter），其余行为与被包装的传输层完全一致。
+ * 抓包文件可由ReplayTransport按原始/缩放/最高速度回放。
+ */
+class CapturingTransport : public ITransport
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 构造函数
+     * @param inner 被包装的传输层，不获得所有权，须与本对象位于同一线程
+     */
+    explicit CapturingTransport(ITransport* inner, QObject* parent = nullptr);
+    ~CapturingTransport() override;
+
+    ITransport* innerTransport() const { return inner_.data(); }
+
+    /**
+     * @brief 抓包控制接口
+     */
+
+    // 开始抓包（覆盖已存在的文件）
+    bool startCapture(const QString& path);
+
+    // 停止抓包
+    void stopCapture();
+
+    bool isCapturing() const { return capturing_.load(std::memory_order_acquire); }
+
+    // 已记录的记录数和字节数
+    quint64 capturedRecords() const { return writer_.recordCount(); }
+    quint64 capturedBytes() const { return writer_.bytesWritten(); }
+
+    QString lastErrorString() const { return writer_.lastErrorString(); }
+
+    /**
+     * @brief ITransport接口实现
+     */
+    bool open() override;
+    void close() override;
+    bool isOpen() const override;
+    bool send(const QByteArray& data) override;
+    QString description() const override;
+    QString transportType() const override;
+
+private:
+    QPointer<ITransport> inner_;
+    int receiveSinkId_;
+    LinkCaptureWriter writer_;
+    std::atomic<bool> capturing_;
+};
+
+#endif // CAPTURING_TRANSPORT_H
@@ -4,6 +4,74 @@
 #include <QObject>
 #include <QByteArray>
 #include <QString>
+#include <QMetaMethod>
+#include <functional>
+#include "sink_list.h"
+
+/**
+ * @brief 接收数据租约
+ *
+ * 持有传输层读缓冲区的引用计数副本（QByteArray隐式共享）。传输层下次写入该缓冲区时
+ * 会自动分离，因此租约在接收回调返回后仍然有效且内容不变。
+ */
+class ReceiveLease
+{
+public:
+    ReceiveLease() = default;
+    ReceiveLease(const QByteArray& buffer, int offset, int length)
+        : buffer_(buffer), offset_(offset), length_(length) {}
+
+    const char* data() const { return buffer_.constData() + offset_; }
+    int size() const { return length_; }
+    bool isEmpty() const { return length_ == 0; }
+
+    // 转换为QByteArray（覆盖整个缓冲区时不复制）
+    QByteArray toByteArray() const {
+        if (offset_ == 0 && length_ == buffer_.size()) {
+            return buffer_;
+        }
+        return buffer_.mid(offset_, length_);
+    }
+
+private:
+    QByteArray buffer_;
+    int offset_ = 0;
+    int length_ = 0;
+};
+
+/**
+ * @brief 接收数据视图
+ *
+ * 借用传输层自身的读缓冲区，仅在接收回调执行期间有效；需要保留数据时调用lease()。
+ */
+class ReceiveSpan
+{
+public:
+    ReceiveSpan(const char* data, int size, const QByteArray* owner = nullptr)
+        : data_(data), size_(size), owner_(owner) {}
+
+    const char* data() const { return data_; }
+    int size() const { return size_; }
+    bool isEmpty() const { return size_ == 0; }
+
+    // 底层缓冲区（可能为nullptr），供装饰传输层原样转发
+    const QByteArray* owner() const { return owner_; }
+
+    // 获取租约；底层缓冲区不是QByteArray时（如共享内存）退化为复制
+    ReceiveLease lease() const {
+        if (owner_) {
+            return ReceiveLease(*owner_, static_cast<int>(data_ - owner_->constData()), size_);
+        }
+        return ReceiveLease(QByteArray(data_, size_), 0, size_);
+    }
+
+    QByteArray toByteArray() const { return lease().toByteArray(); }
+
+private:
+    const char* data_;
+    int size_;
+    const QByteArray* owner_;
+};
 
 /**
  * @brief 传输层抽象接口
@@ -12,6 +80,7 @@
  * - 串口通信 (SerialTransport)
  * - TCP通信 (TcpTransport)
  * - UDP通信 (UdpTransport)
+ * - 共享内存 (SharedMemoryTransport) - 同机进程间通信
  * - 模拟传输 (MockTransport) - 用于单元测试
  */
 class ITransport : public QObject
@@ -44,6 +113,30 @@ public:
     // 获取传输层类型
     virtual QString transportType() const = 0;
 
+    /**
+     * @brief 低层接收接口
+     *
+     * 回调在传输层I/O线程上直接调用，参数借用传输层读缓冲区，不经过Qt事件队列，
+     * 帧解析可以就地进行。注册/注销须在传输层所在线程进行。
+     * dataReceived信号作为兼容层保留，仅在有连接时才构造QByteArray。
+     */
+    using ReceiveSink = std::function<void(const ReceiveSpan&)>;
+
+    // 注册接收回调，返回回调ID（在回调内部注册时从下一次接收开始生效）
+    int addReceiveSink(ReceiveSink sink) {
+        return receiveSinks_.add(std::move(sink));
+    }
+
+    // 注销接收回调（可在回调内部调用，包括注销自身）
+    void removeReceiveSink(int sinkId) {
+        receiveSinks_.remove(sinkId);
+    }
+
+    // 是否存在接收回调
+    bool hasReceiveSinks() const {
+        return !receiveSinks_.isEmpty();
+    }
+
 signals:
     /**
      * @brief 传输层信号
@@ -69,9 +162,19 @@ protected:
      * @brief 受保护的辅助方法
      */
 
+    // 分发读缓冲区中的一段数据：先调用接收回调，再发射兼容信号（供子类调用）
+    void deliverReceived(const char* data, int size, const QByteArray* owner = nullptr) {
+        ReceiveSpan span(data, size, owner);
+        receiveSinks_.dispatch(span);
+
+        if (isSignalConnected(QMetaMethod::fromSignal(&ITransport::dataReceived))) {
+            emit dataReceived(span.toByteArray());
+        }
+    }
+
     // 发射数据接收信号（供子类调用）
     void emitDataReceived(const QByteArray& data) {
-        emit dataReceived(data);
+        deliverReceived(data.constData(), data.size(), &data);
     }
 
     // 发射连接状态变化信号
@@ -88,6 +191,9 @@ protected:
     void emitTransportError(const QString& error) {
         emit transportError(error);
     }
+
+private:
+    SinkList<const ReceiveSpan&> receiveSinks_;  // 接收回调
 };
 
 #endif // ITRANSPORT_H
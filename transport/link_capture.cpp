@@ -0,0 +1,450 @@
+#include "link_capture.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QMutexLocker>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace LinkCapture;
+
+// 常量定义
+const size_t LinkCaptureWriter::GROW_CHUNK_SIZE = 8 * 1024 * 1024;
+
+namespace {
+
+constexpr char FILE_MAGIC[8] = {'E', 'R', 'N', 'C', 'C', 'A', 'P', '1'};
+constexpr uint32_t FILE_VERSION = 1;
+constexpr quint64 INDEX_INTERVAL_NS = 1000000000ULL;   // 每秒一个索引点
+
+inline quint64 alignRecord(quint64 size)
+{
+    return (size + 7u) & ~static_cast<quint64>(7u);
+}
+
+qint64 monotonicNs()
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+QString errnoString()
+{
+    return QString::fromLocal8Bit(strerror(errno));
+}
+
+} // namespace
+
+// ================================
+// LinkCaptureWriter
+// ================================
+
+LinkCaptureWriter::LinkCaptureWriter()
+    : fd_(-1)
+    , indexFd_(-1)
+    , mapping_(nullptr)
+    , mappedSize_(0)
+    , writeOffset_(0)
+    , recordCount_(0)
+    , startNs_(0)
+    , lastIndexNs_(0)
+    , indexed_(false)
+{
+}
+
+LinkCaptureWriter::~LinkCaptureWriter()
+{
+    close();
+}
+
+bool LinkCaptureWriter::open(const QString& path)
+{
+    QMutexLocker locker(&mutex_);
+
+    if (fd_ >= 0) {
+        lastError_ = "Capture file already open";
+        return false;
+    }
+
+    QByteArray nativePath = path.toLocal8Bit();
+    fd_ = ::open(nativePath.constData(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        lastError_ = QString("Cannot create capture file: %1").arg(errnoString());
+        return false;
+    }
+
+    QByteArray indexPath = nativePath + ".idx";
+    indexFd_ = ::open(indexPath.constData(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (indexFd_ < 0) {
+        lastError_ = QString("Cannot create capture index: %1").arg(errnoString());
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    if (!growMapping(GROW_CHUNK_SIZE)) {
+        ::close(indexFd_);
+        ::close(fd_);
+        indexFd_ = -1;
+        fd_ = -1;
+        return false;
+    }
+
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+    header.version = FILE_VERSION;
+    header.headerSize = sizeof(FileHeader);
+    header.startWallClockMs = QDateTime::currentMSecsSinceEpoch();
+    std::memcpy(mapping_, &header, sizeof(header));
+
+    path_ = path;
+    writeOffset_ = sizeof(FileHeader);
+    recordCount_ = 0;
+    startNs_ = monotonicNs();
+    lastIndexNs_ = 0;
+    indexed_ = false;
+    lastError_.clear();
+
+    qInfo() << "Link capture started:" << path;
+    return true;
+}
+
+void LinkCaptureWriter::close()
+{
+    QMutexLocker locker(&mutex_);
+
+    if (fd_ < 0) {
+        return;
+    }
+
+    if (mapping_) {
+        ::munmap(mapping_, mappedSize_);
+        mapping_ = nullptr;
+        mappedSize_ = 0;
+    }
+
+    // 截掉预分配的尾部
+    if (::ftruncate(fd_, static_cast<off_t>(writeOffset_)) < 0) {
+        qWarning() << "Failed to truncate capture file:" << errnoString();
+    }
+
+    ::close(fd_);
+    ::close(indexFd_);
+    fd_ = -1;
+    indexFd_ = -1;
+
+    qInfo() << "Link capture stopped:" << path_ << "records:" << recordCount_ << "bytes:" << writeOffset_;
+}
+
+bool LinkCaptureWriter::append(Direction direction, const char* data, int size)
+{
+    if (size <= 0 || direction == Direction::End) {
+        return false;
+    }
+
+    const qint64 now = monotonicNs();
+    QMutexLocker locker(&mutex_);
+
+    if (fd_ < 0) {
+        return false;
+    }
+
+    const quint64 needed = sizeof(RecordHeader) + alignRecord(static_cast<quint64>(size));
+    if (writeOffset_ + needed + sizeof(RecordHeader) > mappedSize_ &&
+        !growMapping(static_cast<size_t>(writeOffset_ + needed + sizeof(RecordHeader)))) {
+        return false;
+    }
+
+    const quint64 timestampNs = static_cast<quint64>(qMax<qint64>(0, now - startNs_));
+    const quint64 recordOffset = writeOffset_;
+
+    // 先写数据和时间戳，最后写方向字节，使未写完的记录在读取端表现为数据结束
+    char* record = mapping_ + writeOffset_;
+    std::memcpy(record + sizeof(RecordHeader), data, static_cast<size_t>(size));
+
+    RecordHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.timestampNs = timestampNs;
+    header.length = static_cast<uint32_t>(size);
+    std::memcpy(record, &header, sizeof(header));
+    reinterpret_cast<RecordHeader*>(record)->direction = static_cast<uint8_t>(direction);
+
+    writeOffset_ += needed;
+    ++recordCount_;
+
+    // 索引点在记录写完之后追加，进程在两者之间退出时索引不会指向未写入的数据
+    if (!indexed_ || timestampNs - lastIndexNs_ >= INDEX_INTERVAL_NS) {
+        appendIndexEntry(timestampNs, recordOffset);
+    }
+    return true;
+}
+
+bool LinkCaptureWriter::growMapping(size_t minimumSize)
+{
+    size_t newSize = qMax(mappedSize_, GROW_CHUNK_SIZE);
+    while (newSize < minimumSize) {
+        newSize += GROW_CHUNK_SIZE;
+    }
+    if (mapping_ && newSize == mappedSize_) {
+        return true;
+    }
+
+    if (::ftruncate(fd_, static_cast<off_t>(newSize)) < 0) {
+        lastError_ = QString("Cannot extend capture file: %1").arg(errnoString());
+        return false;
+    }
+
+    if (mapping_) {
+        ::munmap(mapping_, mappedSize_);
+        mapping_ = nullptr;
+    }
+
+    void* mapping = ::mmap(nullptr, newSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (mapping == MAP_FAILED) {
+        lastError_ = QString("Cannot map capture file: %1").arg(errnoString());
+        mappedSize_ = 0;
+        return false;
+    }
+
+    mapping_ = static_cast<char*>(mapping);
+    mappedSize_ = newSize;
+    return true;
+}
+
+void LinkCaptureWriter::appendIndexEntry(quint64 timestampNs, quint64 offset)
+{
+    IndexEntry entry;
+    entry.timestampNs = timestampNs;
+    entry.offset = offset;
+
+    if (::write(indexFd_, &entry, sizeof(entry)) != static_cast<ssize_t>(sizeof(entry))) {
+        qWarning() << "Failed to write capture index entry:" << errnoString();
+        return;
+    }
+
+    lastIndexNs_ = timestampNs;
+    indexed_ = true;
+}
+
+// ================================
+// LinkCaptureReader
+// ================================
+
+LinkCaptureReader::LinkCaptureReader()
+    : fd_(-1)
+    , mapping_(nullptr)
+    , mappedSize_(0)
+    , readOffset_(0)
+    , firstTimestampNs_(0)
+    , lastTimestampNs_(0)
+{
+}
+
+LinkCaptureReader::~LinkCaptureReader()
+{
+    close();
+}
+
+bool LinkCaptureReader::open(const QString& path)
+{
+    close();
+
+    QByteArray nativePath = path.toLocal8Bit();
+    fd_ = ::open(nativePath.constData(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+        lastError_ = QString("Cannot open capture file: %1").arg(errnoString());
+        return false;
+    }
+
+    struct stat info;
+    if (::fstat(fd_, &info) < 0 || static_cast<size_t>(info.st_size) < sizeof(FileHeader)) {
+        lastError_ = "Capture file is too small";
+        close();
+        return false;
+    }
+
+    void* mapping = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd_, 0);
+    if (mapping == MAP_FAILED) {
+        lastError_ = QString("Cannot map capture file: %1").arg(errnoString());
+        close();
+        return false;
+    }
+
+    mapping_ = static_cast<const char*>(mapping);
+    mappedSize_ = static_cast<size_t>(info.st_size);
+    ::madvise(mapping, mappedSize_, MADV_SEQUENTIAL);
+
+    const FileHeader* header = reinterpret_cast<const FileHeader*>(mapping_);
+    if (std::memcmp(header->magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 ||
+        header->version != FILE_VERSION || header->headerSize < sizeof(FileHeader)) {
+        lastError_ = "Not a capture file or unsupported version";
+        close();
+        return false;
+    }
+
+    loadIndex(path);
+    rewind();
+
+    // 首条记录时间戳，末条记录从最后一个索引点向后扫描
+    Record record;
+    quint64 nextOffset = 0;
+    firstTimestampNs_ = readAt(header->headerSize, record, nextOffset) ? record.timestampNs : 0;
+    lastTimestampNs_ = firstTimestampNs_;
+    quint64 offset = index_.empty() ? header->headerSize : index_.back().offset;
+    while (readAt(offset, record, nextOffset)) {
+        lastTimestampNs_ = record.timestampNs;
+        offset = nextOffset;
+    }
+
+    lastError_.clear();
+    return true;
+}
+
+void LinkCaptureReader::close()
+{
+    if (mapping_) {
+        ::munmap(const_cast<char*>(mapping_), mappedSize_);
+        mapping_ = nullptr;
+        mappedSize_ = 0;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    index_.clear();
+    readOffset_ = 0;
+    firstTimestampNs_ = 0;
+    lastTimestampNs_ = 0;
+}
+
+bool LinkCaptureReader::next(Record& record)
+{
+    if (!mapping_) {
+        return false;
+    }
+
+    quint64 nextOffset = 0;
+    if (!readAt(readOffset_, record, nextOffset)) {
+        return false;
+    }
+    readOffset_ = nextOffset;
+    return true;
+}
+
+void LinkCaptureReader::rewind()
+{
+    if (mapping_) {
+        readOffset_ = reinterpret_cast<const FileHeader*>(mapping_)->headerSize;
+    }
+}
+
+void LinkCaptureReader::seek(quint64 timestampNs)
+{
+    if (!mapping_) {
+        return;
+    }
+
+    // 二分查找不晚于目标时间的最后一个索引点，再顺序扫描
+    rewind();
+    auto it = std::upper_bound(index_.begin(), index_.end(), timestampNs,
+                               [](quint64 value, const IndexEntry& entry) {
+                                   return value < entry.timestampNs;
+                               });
+    if (it != index_.begin()) {
+        readOffset_ = std::prev(it)->offset;
+    }
+
+    Record record;
+    quint64 nextOffset = 0;
+    while (readAt(readOffset_, record, nextOffset) && record.timestampNs < timestampNs) {
+        readOffset_ = nextOffset;
+    }
+}
+
+qint64 LinkCaptureReader::startWallClockMs() const
+{
+    return mapping_ ? reinterpret_cast<const FileHeader*>(mapping_)->startWallClockMs : 0;
+}
+
+bool LinkCaptureReader::readAt(quint64 offset, Record& record, quint64& nextOffset) const
+{
+    if (offset + sizeof(RecordHeader) > mappedSize_) {
+        return false;
+    }
+
+    RecordHeader header;
+    std::memcpy(&header, mapping_ + offset, sizeof(header));
+
+    Direction direction = static_cast<Direction>(header.direction);
+    if (direction != Direction::Received && direction != Direction::Sent) {
+        return false;
+    }
+
+    const quint64 end = offset + sizeof(RecordHeader) + alignRecord(header.length);
+    if (end > mappedSize_) {
+        return false;  // 记录被截断
+    }
+
+    record.timestampNs = header.timestampNs;
+    record.direction = direction;
+    record.data = mapping_ + offset + sizeof(RecordHeader);
+    record.size = static_cast<int>(header.length);
+    nextOffset = end;
+    return true;
+}
+
+void LinkCaptureReader::loadIndex(const QString& path)
+{
+    index_.clear();
+
+    QByteArray indexPath = path.toLocal8Bit() + ".idx";
+    int fd = ::open(indexPath.constData(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        struct stat info;
+        if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+            index_.resize(static_cast<size_t>(info.st_size) / sizeof(IndexEntry));
+            ssize_t expected = static_cast<ssize_t>(index_.size() * sizeof(IndexEntry));
+            if (::read(fd, index_.data(), static_cast<size_t>(expected)) != expected) {
+                index_.clear();
+            }
+        }
+        ::close(fd);
+    }
+
+    // 丢弃不指向完整记录的索引点（旧版本写入器异常退出时可能出现）
+    Record record;
+    quint64 nextOffset = 0;
+    while (!index_.empty() && !readAt(index_.back().offset, record, nextOffset)) {
+        index_.pop_back();
+    }
+
+    if (index_.empty()) {
+        qWarning() << "Capture index missing, rebuilding:" << path;
+        rebuildIndex();
+    }
+}
+
+void LinkCaptureReader::rebuildIndex()
+{
+    Record record;
+    quint64 offset = reinterpret_cast<const FileHeader*>(mapping_)->headerSize;
+    quint64 nextOffset = 0;
+    bool first = true;
+    quint64 lastIndexNs = 0;
+
+    while (readAt(offset, record, nextOffset)) {
+        if (first || record.timestampNs - lastIndexNs >= INDEX_INTERVAL_NS) {
+            index_.push_back(IndexEntry{record.timestampNs, offset});
+            lastIndexNs = record.timestampNs;
+            first = false;
+        }
+        offset = nextOffset;
+    }
+}
@@ -0,0 +1,170 @@
+#ifndef LINK_CAPTURE_H
+#define LINK_CAPTURE_H
+
+#include <QMutex>
+#include <QString>
+#include <QtGlobal>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief 链路抓包文件格式
+ *
+ * 数据文件（mmap追加写入）：
+ *   [FileHeader][RecordHeader + 数据 + 填充到8字节]...
+ * 索引文件（<path>.idx）：
+ *   [IndexEntry]...  每隔INDEX_INTERVAL_NS记录一次时间戳到文件偏移的映射
+ *
+ * 时间戳为相对抓包开始的单调时钟纳秒数；direction为0的记录头表示数据结束
+ * （进程异常退出时文件尾部是预分配的零页）。
+ */
+namespace LinkCapture {
+
+enum class Direction : uint8_t {
+    End = 0,        // 数据结束
+    Received = 1,   // 传输层接收
+    Sent = 2        // 传输层发送
+};
+
+struct FileHeader {
+    char magic[8];              // "ERNCCAP1"
+    uint32_t version;
+    uint32_t headerSize;
+    int64_t startWallClockMs;   // 抓包开始的墙上时间（毫秒）
+    uint64_t reserved[5];
+};
+
+struct RecordHeader {
+    uint64_t timestampNs;
+    uint32_t length;
+    uint8_t direction;
+    uint8_t reserved[3];
+};
+
+struct IndexEntry {
+    uint64_t timestampNs;
+    uint64_t offset;
+};
+
+static_assert(sizeof(FileHeader) == 64, "capture file header must stay 64 bytes");
+static_assert(sizeof(RecordHeader) == 16, "capture record header must stay 16 bytes");
+
+/**
+ * @brief 回放时读出的一条记录
+ *
+ * data指向只读映射，在读取器关闭前有效。
+ */
+struct Record {
+    quint64 timestampNs = 0;
+    Direction direction = Direction::End;
+    const char* data = nullptr;
+    int size = 0;
+};
+
+} // namespace LinkCapture
+
+/**
+ * @brief 链路抓包写入器
+ *
+ * 以mmap方式追加写入，文件按块预分配；每条记录只有一次内存拷贝，不经过write系统调用。
+ * 线程安全，收发两个方向可以在不同线程写入。
+ */
+class LinkCaptureWriter
+{
+public:
+    LinkCaptureWriter();
+    ~LinkCaptureWriter();
+
+    bool open(const QString& path);
+    void close();
+    bool isOpen() const { return fd_ >= 0; }
+
+    /**
+     * @brief 追加一条记录
+     * @param direction 方向
+     * @param data 原始字节
+     * @param size 长度
+     * @return 成功返回true
+     */
+    bool append(LinkCapture::Direction direction, const char* data, int size);
+
+    quint64 recordCount() const { return recordCount_; }
+    quint64 bytesWritten() const { return writeOffset_; }
+    QString path() const { return path_; }
+    QString lastErrorString() const { return lastError_; }
+
+private:
+    bool growMapping(size_t minimumSize);
+    void appendIndexEntry(quint64 timestampNs, quint64 offset);
+
+    QString path_;
+    int fd_;
+    int indexFd_;
+    char* mapping_;
+    size_t mappedSize_;
+    quint64 writeOffset_;
+    quint64 recordCount_;
+    qint64 startNs_;
+    quint64 lastIndexNs_;
+    bool indexed_;
+    QString lastError_;
+    QMutex mutex_;
+
+    static const size_t GROW_CHUNK_SIZE;
+};
+
+/**
+ * @brief 链路抓包读取器
+ *
+ * 整个文件只读映射，借助稀疏时间索引可以在多小时的抓包中直接定位到任意时间点。
+ */
+class LinkCaptureReader
+{
+public:
+    LinkCaptureReader();
+    ~LinkCaptureReader();
+
+    bool open(const QString& path);
+    void close();
+    bool isOpen() const { return mapping_ != nullptr; }
+
+    /**
+     * @brief 顺序读取下一条记录
+     * @return 已到文件末尾返回false
+     */
+    bool next(LinkCapture::Record& record);
+
+    /**
+     * @brief 回到第一条记录
+     */
+    void rewind();
+
+    /**
+     * @brief 定位到不早于指定时间的第一条记录
+     * @param timestampNs 相对抓包开始的时间
+     */
+    void seek(quint64 timestampNs);
+
+    // 首末记录时间戳
+    quint64 firstTimestampNs() const { return firstTimestampNs_; }
+    quint64 lastTimestampNs() const { return lastTimestampNs_; }
+
+    qint64 startWallClockMs() const;
+    QString lastErrorString() const { return lastError_; }
+
+private:
+    bool readAt(quint64 offset, LinkCapture::Record& record, quint64& nextOffset) const;
+    void loadIndex(const QString& path);
+    void rebuildIndex();
+
+    int fd_;
+    const char* mapping_;
+    size_t mappedSize_;
+    quint64 readOffset_;
+    quint64 firstTimestampNs_;
+    quint64 lastTimestampNs_;
+    std::vector<LinkCapture::IndexEntry> index_;
+    QString lastError_;
+};
+
+#endif // LINK_CAPTURE_H
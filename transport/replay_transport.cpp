@@ -0,0 +1,232 @@
+#include "replay_transport.h"
+#include <QDebug>
+#include <QFileInfo>
+
+// 常量定义
+const int ReplayTransport::MAX_RECORDS_PER_BATCH = 4096;
+const qint64 ReplayTransport::TIMER_RESOLUTION_NS = 1000000;
+
+ReplayTransport::ReplayTransport(QObject* parent)
+    : ITransport(parent)
+    , captureFile_()
+    , timing_(Timing::Original)
+    , speedFactor_(1.0)
+    , loop_(false)
+    , replayTimer_(new QTimer(this))
+    , baseTimestampNs_(0)
+    , positionNs_(0)
+    , hasPending_(false)
+    , open_(false)
+    , replayedRecords_(0)
+    , replayedBytes_(0)
+{
+    replayTimer_->setSingleShot(true);
+    replayTimer_->setTimerType(Qt::PreciseTimer);
+    connect(replayTimer_, &QTimer::timeout, this, &ReplayTransport::replayNext);
+}
+
+ReplayTransport::ReplayTransport(const QString& captureFile, QObject* parent)
+    : ReplayTransport(parent)
+{
+    captureFile_ = captureFile;
+}
+
+ReplayTransport::~ReplayTransport()
+{
+    close();
+}
+
+void ReplayTransport::setCaptureFile(const QString& path)
+{
+    if (isOpen()) {
+        qWarning() << "Cannot change capture file while replaying";
+        return;
+    }
+    captureFile_ = path;
+}
+
+void ReplayTransport::setTiming(Timing timing)
+{
+    timing_ = timing;
+    if (isOpen()) {
+        restartClock(positionNs_);
+        replayTimer_->start(0);
+    }
+}
+
+void ReplayTransport::setSpeedFactor(double factor)
+{
+    if (factor <= 0.0) {
+        qWarning() << "Invalid replay speed factor:" << factor;
+        return;
+    }
+    speedFactor_ = factor;
+    if (isOpen()) {
+        restartClock(positionNs_);
+    }
+}
+
+bool ReplayTransport::seek(qint64 positionMs)
+{
+    if (!isOpen()) {
+        return false;
+    }
+
+    quint64 targetNs = static_cast<quint64>(qMax<qint64>(0, positionMs)) * 1000000ULL;
+    reader_.seek(targetNs);
+    hasPending_ = false;
+    positionNs_ = targetNs;
+    restartClock(targetNs);
+    replayTimer_->start(0);
+
+    qDebug() << "Replay seek to" << positionMs << "ms";
+    return true;
+}
+
+qint64 ReplayTransport::position() const
+{
+    return static_cast<qint64>(positionNs_ / 1000000ULL);
+}
+
+qint64 ReplayTransport::duration() const
+{
+    return static_cast<qint64>(reader_.lastTimestampNs() / 1000000ULL);
+}
+
+bool ReplayTransport::open()
+{
+    if (isOpen()) {
+        return true;
+    }
+
+    if (!reader_.open(captureFile_)) {
+        lastError_ = reader_.lastErrorString();
+        qWarning() << "Failed to open capture for replay:" << captureFile_ << "-" << lastError_;
+        emitTransportError(QString("Failed to open capture: %1").arg(lastError_));
+        return false;
+    }
+
+    open_ = true;
+    hasPending_ = false;
+    replayedRecords_ = 0;
+    replayedBytes_ = 0;
+    positionNs_ = reader_.firstTimestampNs();
+    restartClock(positionNs_);
+
+    qInfo() << "Replay opened:" << description() << "duration:" << duration() << "ms";
+    emitConnectionStatusChanged(true);
+
+    replayTimer_->start(0);
+    return true;
+}
+
+void ReplayTransport::close()
+{
+    if (!open_) {
+        return;
+    }
+
+    open_ = false;
+    replayTimer_->stop();
+    hasPending_ = false;
+    reader_.close();
+
+    qInfo() << "Replay closed:" << captureFile_ << "records:" << replayedRecords_;
+    emitConnectionStatusChanged(false);
+}
+
+bool ReplayTransport::isOpen() const
+{
+    return open_;
+}
+
+bool ReplayTransport::send(const QByteArray& data)
+{
+    // 回放时上层的发送请求被丢弃
+    Q_UNUSED(data);
+    return isOpen();
+}
+
+QString ReplayTransport::description() const
+{
+    QString timingName;
+    switch (timing_) {
+    case Timing::Original:
+        timingName = "original";
+        break;
+    case Timing::Scaled:
+        timingName = QString("x%1").arg(speedFactor_);
+        break;
+    case Timing::MaxSpeed:
+        timingName = "max speed";
+        break;
+    }
+    return QString("Replay: %1 (%2)").arg(QFileInfo(captureFile_).fileName(), timingName);
+}
+
+QString ReplayTransport::transportType() const
+{
+    return "Replay";
+}
+
+void ReplayTransport::replayNext()
+{
+    int budget = MAX_RECORDS_PER_BATCH;
+
+    while (open_ && (hasPending_ || reader_.next(pending_))) {
+        hasPending_ = true;
+
+        // 只有接收方向需要回放，发送方向直接跳过
+        if (pending_.direction != LinkCapture::Direction::Received) {
+            hasPending_ = false;
+            continue;
+        }
+
+        if (timing_ != Timing::MaxSpeed && pending_.timestampNs > baseTimestampNs_) {
+            double scale = (timing_ == Timing::Scaled) ? speedFactor_ : 1.0;
+            qint64 dueNs = static_cast<qint64>((pending_.timestampNs - baseTimestampNs_) / scale);
+            qint64 waitNs = dueNs - clock_.nsecsElapsed();
+            // 定时器精度为毫秒，不足一个精度的间隔不再等待，与已到期的记录一起发出，
+            // 否则亚毫秒间隔的记录会以start(0)空转事件循环
+            if (waitNs > TIMER_RESOLUTION_NS) {
+                replayTimer_->start(static_cast<int>((waitNs + TIMER_RESOLUTION_NS - 1) / TIMER_RESOLUTION_NS));
+                return;
+            }
+        }
+
+        hasPending_ = false;
+        positionNs_ = pending_.timestampNs;
+        ++replayedRecords_;
+        replayedBytes_ += static_cast<quint64>(pending_.size);
+        deliverReceived(pending_.data, pending_.size);
+
+        // 批量上限，让出事件循环
+        if (--budget == 0) {
+            if (open_) {
+                replayTimer_->start(0);
+            }
+            return;
+        }
+    }
+
+    if (!open_) {
+        return;
+    }
+
+    if (loop_ && replayedRecords_ > 0) {
+        reader_.rewind();
+        positionNs_ = reader_.firstTimestampNs();
+        restartClock(positionNs_);
+        replayTimer_->start(0);
+        return;
+    }
+
+    qInfo() << "Replay finished:" << captureFile_ << "records:" << replayedRecords_;
+    emit replayFinished();
+}
+
+void ReplayTransport::restartClock(quint64 baseTimestampNs)
+{
+    baseTimestampNs_ = baseTimestampNs;
+    clock_.restart();
+}
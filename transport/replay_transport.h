@@ -0,0 +1,115 @@
+#ifndef REPLAY_TRANSPORT_H
+#define REPLAY_TRANSPORT_H
+
+#include "itransport.h"
+#include "link_capture.h"
+#include <QElapsedTimer>
+#include <QTimer>
+
+/**
+ * @brief 抓包回放传输
+ *
+ * 把CapturingTransport录制的接收方向字节流重新送入协议栈，用于复现现场问题
+ * 以及为帧解析/解码路径提供可重复的性能负载：
+ * - 原始时序、按比例缩放时序或最高速度回放
+ * - 借助稀疏时间索引可立即定位到多小时抓包中的任意时间点
+ * - 接收回调直接借用只读映射中的数据，不做拷贝
+ * - 发送的数据被丢弃，仅计数
+ */
+class ReplayTransport : public ITransport
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 回放时序
+     */
+    enum class Timing {
+        Original,   // 按录制时的时间间隔
+        Scaled,     // 按speedFactor缩放时间间隔
+        MaxSpeed    // 不等待，尽快回放
+    };
+
+    explicit ReplayTransport(QObject* parent = nullptr);
+    explicit ReplayTransport(const QString& captureFile, QObject* parent = nullptr);
+    ~ReplayTransport() override;
+
+    /**
+     * @brief 回放配置接口
+     */
+
+    void setCaptureFile(const QString& path);
+    QString captureFile() const { return captureFile_; }
+
+    void setTiming(Timing timing);
+    Timing timing() const { return timing_; }
+
+    // 时序缩放系数（Scaled模式有效，2.0表示两倍速）
+    void setSpeedFactor(double factor);
+    double speedFactor() const { return speedFactor_; }
+
+    // 回放结束后从头循环
+    void setLoop(bool loop) { loop_ = loop; }
+    bool loop() const { return loop_; }
+
+    /**
+     * @brief 定位到抓包中的指定时间（毫秒，相对抓包开始）
+     */
+    bool seek(qint64 positionMs);
+
+    // 当前回放位置与抓包总时长（毫秒）
+    qint64 position() const;
+    qint64 duration() const;
+
+    // 已回放的记录数与字节数
+    quint64 replayedRecords() const { return replayedRecords_; }
+    quint64 replayedBytes() const { return replayedBytes_; }
+
+    QString lastErrorString() const { return lastError_; }
+
+    /**
+     * @brief ITransport接口实现
+     */
+    bool open() override;
+    void close() override;
+    bool isOpen() const override;
+    bool send(const QByteArray& data) override;
+    QString description() const override;
+    QString transportType() const override;
+
+signals:
+    /**
+     * @brief 回放到达文件末尾（循环模式下不发射）
+     */
+    void replayFinished();
+
+private slots:
+    void replayNext();
+
+private:
+    void restartClock(quint64 baseTimestampNs);
+
+    QString captureFile_;
+    Timing timing_;
+    double speedFactor_;
+    bool loop_;
+
+    LinkCaptureReader reader_;
+    QTimer* replayTimer_;
+    QElapsedTimer clock_;
+    quint64 baseTimestampNs_;
+    quint64 positionNs_;
+    LinkCapture::Record pending_;
+    bool hasPending_;
+    bool open_;
+
+    quint64 replayedRecords_;
+    quint64 replayedBytes_;
+    QString lastError_;
+
+    // 常量
+    static const int MAX_RECORDS_PER_BATCH;
+    static const qint64 TIMER_RESOLUTION_NS;    // 回放定时器精度，早于该时间到期的记录提前发出
+};
+
+#endif // REPLAY_TRANSPORT_H
@@ -0,0 +1,719 @@
+#include "shared_memory_transport.h"
+#include <QDebug>
+
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+// 常量定义
+const int SharedMemoryTransport::MAX_SUBSCRIBERS = 8;
+const int SharedMemoryTransport::DEFAULT_RING_CAPACITY = 256 * 1024;
+const int SharedMemoryTransport::WAIT_TIMEOUT_MS = 100;
+
+namespace {
+
+constexpr uint32_t SEGMENT_MAGIC = 0x45524E43;   // "ERNC"
+constexpr uint32_t SEGMENT_LAYOUT_VERSION = 1;
+constexpr uint32_t WRAP_MARKER = 0xFFFFFFFFu;
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+enum SlotState : uint32_t {
+    SLOT_FREE = 0,
+    SLOT_ATTACHING = 1,
+    SLOT_ACTIVE = 2
+};
+
+/**
+ * @brief futex唤醒字
+ *
+ * 写端每发布一次递增sequence；等待端登记waiters后在sequence上futex等待，
+ * 写端只有在waiters非零时才执行FUTEX_WAKE，空闲路径没有系统调用。
+ */
+struct alignas(CACHE_LINE_SIZE) WakeWord {
+    std::atomic<uint32_t> sequence;
+    std::atomic<uint32_t> waiters;
+};
+
+/**
+ * @brief 订阅者槽位
+ *
+ * 三个游标各占一个缓存行，避免Owner与订阅者之间的伪共享。
+ */
+struct alignas(CACHE_LINE_SIZE) SubscriberSlot {
+    std::atomic<uint32_t> state;
+    std::atomic<int32_t> pid;
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> downlinkRead;
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> uplinkWrite;
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> uplinkRead;
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "futex word must be lock-free");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring cursors must be lock-free");
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(int), "futex word must be int-sized");
+
+inline uint32_t alignRecord(uint32_t length)
+{
+    return (static_cast<uint32_t>(sizeof(uint32_t)) + length + 7u) & ~7u;
+}
+
+int futexWait(std::atomic<uint32_t>* word, uint32_t expected, int timeoutMs)
+{
+    struct timespec timeout;
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_nsec = static_cast<long>(timeoutMs % 1000) * 1000000L;
+    return static_cast<int>(::syscall(SYS_futex, reinterpret_cast<int*>(word), FUTEX_WAIT,
+                                      static_cast<int>(expected), &timeout, nullptr, 0));
+}
+
+void futexWake(std::atomic<uint32_t>* word)
+{
+    ::syscall(SYS_futex, reinterpret_cast<int*>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+void publish(WakeWord& wake)
+{
+    wake.sequence.fetch_add(1, std::memory_order_seq_cst);
+    if (wake.waiters.load(std::memory_order_seq_cst) > 0) {
+        futexWake(&wake.sequence);
+    }
+}
+
+/**
+ * @brief 向环形缓冲区写入一帧（单写者）
+ *
+ * 记录格式为[uint32长度][数据][填充到8字节]，尾部空间不足时写入回绕标记并从头开始。
+ * @return 剩余空间不足时返回false，不修改任何游标
+ */
+bool ringWrite(uchar* data, uint32_t capacity, uint64_t write, uint64_t minRead,
+               const QByteArray& frame, uint64_t& newWrite)
+{
+    const uint32_t length = static_cast<uint32_t>(frame.size());
+    const uint32_t needed = alignRecord(length);
+    uint32_t offset = static_cast<uint32_t>(write & (capacity - 1));
+    const uint32_t tail = capacity - offset;
+    const uint64_t total = tail < needed ? static_cast<uint64_t>(tail) + needed : needed;
+
+    if (write + total - minRead > capacity) {
+        return false;
+    }
+
+    if (tail < needed) {
+        std::memcpy(data + offset, &WRAP_MARKER, sizeof(uint32_t));
+        write += tail;
+        offset = 0;
+    }
+
+    std::memcpy(data + offset, &length, sizeof(uint32_t));
+    std::memcpy(data + offset + sizeof(uint32_t), frame.constData(), length);
+    newWrite = write + needed;
+    return true;
+}
+
+/**
+ * @brief 从环形缓冲区读取[read, write)之间的所有帧
+ *
+ * 帧以指向共享内存的指针交给emitFrame，读游标在回调返回后才推进，回调期间数据不会被覆盖。
+ * emitFrame返回false时停止（接收方在回调中关闭了传输）。
+ * @return 新的读游标
+ */
+template<typename Emit>
+uint64_t ringDrain(const uchar* data, uint32_t capacity, uint64_t read, uint64_t write, Emit emitFrame)
+{
+    while (read != write) {
+        const uint32_t offset = static_cast<uint32_t>(read & (capacity - 1));
+        uint32_t length = 0;
+        std::memcpy(&length, data + offset, sizeof(uint32_t));
+
+        if (length == WRAP_MARKER) {
+            read += capacity - offset;
+            continue;
+        }
+
+        const char* frame = reinterpret_cast<const char*>(data + offset + sizeof(uint32_t));
+        read += alignRecord(length);
+        if (!emitFrame(frame, static_cast<int>(length))) {
+            break;
+        }
+    }
+    return read;
+}
+
+bool processAlive(int32_t pid)
+{
+    return pid > 0 && (::kill(pid, 0) == 0 || errno != ESRCH);
+}
+
+} // namespace
+
+/**
+ * @brief 共享内存段头部
+ *
+ * 段布局：[Segment][下行环 capacity][上行环 capacity * MAX_SUBSCRIBERS]
+ */
+struct SharedMemoryTransport::Segment {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t ringCapacity;
+    uint32_t maxSubscribers;
+    std::atomic<uint32_t> ready;
+    std::atomic<int32_t> ownerPid;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> downlinkWrite;
+    WakeWord downlinkWake;  // Owner发布下行帧，订阅者等待
+    WakeWord uplinkWake;    // 订阅者发布上行帧，Owner等待
+
+    SubscriberSlot subscriberSlots[SharedMemoryTransport::MAX_SUBSCRIBERS];
+};
+
+SharedMemoryTransport::SharedMemoryTransport(QObject* parent)
+    : ITransport(parent)
+    , name_()
+    , role_(Role::Owner)
+    , ringCapacity_(DEFAULT_RING_CAPACITY)
+    , shmFd_(-1)
+    , mapping_(nullptr)
+    , mappingSize_(0)
+    , segment_(nullptr)
+    , downlinkData_(nullptr)
+    , uplinkData_(nullptr)
+    , slotIndex_(-1)
+    , eventFd_(-1)
+    , stopWaiter_(false)
+{
+}
+
+SharedMemoryTransport::SharedMemoryTransport(const QString& name, Role role, QObject* parent)
+    : SharedMemoryTransport(parent)
+{
+    name_ = name;
+    role_ = role;
+}
+
+SharedMemoryTransport::~SharedMemoryTransport()
+{
+    close();
+}
+
+void SharedMemoryTransport::setName(const QString& name)
+{
+    if (isOpen()) {
+        qWarning() << "Cannot change shared memory name while open";
+        return;
+    }
+    name_ = name;
+}
+
+QString SharedMemoryTransport::name() const
+{
+    return name_;
+}
+
+void SharedMemoryTransport::setRole(Role role)
+{
+    if (isOpen()) {
+        qWarning() << "Cannot change shared memory role while open";
+        return;
+    }
+    role_ = role;
+}
+
+SharedMemoryTransport::Role SharedMemoryTransport::role() const
+{
+    return role_;
+}
+
+void SharedMemoryTransport::setRingCapacity(int bytes)
+{
+    if (isOpen()) {
+        qWarning() << "Cannot change ring capacity while open";
+        return;
+    }
+
+    int capacity = 4096;
+    while (capacity < bytes && capacity < (1 << 26)) {
+        capacity <<= 1;
+    }
+    ringCapacity_ = capacity;
+}
+
+int SharedMemoryTransport::ringCapacity() const
+{
+    return segment_ ? static_cast<int>(segment_->ringCapacity) : ringCapacity_;
+}
+
+int SharedMemoryTransport::maxFrameSize() const
+{
+    // 限制为容量的1/4，保证回绕时仍有空间容纳多帧
+    return ringCapacity() / 4;
+}
+
+bool SharedMemoryTransport::open()
+{
+    if (isOpen()) {
+        qDebug() << "Shared memory transport already open:" << description();
+        return true;
+    }
+
+    if (name_.isEmpty()) {
+        lastError_ = "Shared memory name is not configured";
+        emitTransportError(lastError_);
+        return false;
+    }
+
+    bool success = (role_ == Role::Owner) ? createSegment() : attachSegment();
+    if (!success) {
+        unmapSegment();
+        qWarning() << "Failed to open shared memory transport:" << description() << "-" << lastError_;
+        emitTransportError(QString("Failed to open shared memory: %1").arg(lastError_));
+        return false;
+    }
+
+    eventFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (eventFd_ < 0) {
+        lastError_ = QString("eventfd failed: %1").arg(QString::fromLocal8Bit(strerror(errno)));
+        close();
+        emitTransportError(lastError_);
+        return false;
+    }
+
+    eventNotifier_.reset(new QSocketNotifier(eventFd_, QSocketNotifier::Read, this));
+    connect(eventNotifier_.data(), &QSocketNotifier::activated, this, &SharedMemoryTransport::handleWakeup);
+
+    startWaiter();
+
+    lastError_.clear();
+    qDebug() << "Shared memory transport opened:" << description();
+    emitConnectionStatusChanged(true);
+    return true;
+}
+
+void SharedMemoryTransport::close()
+{
+    if (!segment_) {
+        return;
+    }
+
+    stopWaiter();
+    eventNotifier_.reset();
+    if (eventFd_ >= 0) {
+        ::close(eventFd_);
+        eventFd_ = -1;
+    }
+
+    if (role_ == Role::Owner) {
+        segment_->ready.store(0, std::memory_order_release);
+        segment_->ownerPid.store(0, std::memory_order_release);
+        publish(segment_->downlinkWake);
+    } else if (slotIndex_ >= 0) {
+        segment_->subscriberSlots[slotIndex_].state.store(SLOT_FREE, std::memory_order_release);
+        segment_->subscriberSlots[slotIndex_].pid.store(0, std::memory_order_release);
+        slotIndex_ = -1;
+    }
+
+    unmapSegment();
+
+    if (role_ == Role::Owner) {
+        QByteArray shmName = "/" + name_.toLocal8Bit();
+        ::shm_unlink(shmName.constData());
+    }
+
+    qDebug() << "Shared memory transport closed:" << description();
+    emitConnectionStatusChanged(false);
+}
+
+bool SharedMemoryTransport::isOpen() const
+{
+    return segment_ != nullptr;
+}
+
+bool SharedMemoryTransport::send(const QByteArray& data)
+{
+    if (!isOpen()) {
+        lastError_ = "Shared memory transport is not open";
+        emitTransportError(lastError_);
+        return false;
+    }
+
+    if (data.isEmpty()) {
+        return true;
+    }
+
+    if (data.size() > maxFrameSize()) {
+        lastError_ = QString("Frame too large: %1 > %2 bytes").arg(data.size()).arg(maxFrameSize());
+        emitTransportError(lastError_);
+        return false;
+    }
+
+    const uint32_t capacity = segment_->ringCapacity;
+
+    if (role_ == Role::Owner) {
+        // 下行广播：受最慢的活跃订阅者限制
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            uint64_t write = segment_->downlinkWrite.load(std::memory_order_relaxed);
+            uint64_t minRead = write;
+            for (int i = 0; i < MAX_SUBSCRIBERS; ++i) {
+                const SubscriberSlot& slot = segment_->subscriberSlots[i];
+                if (slot.state.load(std::memory_order_acquire) == SLOT_ACTIVE) {
+                    minRead = qMin(minRead, slot.downlinkRead.load(std::memory_order_acquire));
+                }
+            }
+
+            uint64_t newWrite = 0;
+            if (ringWrite(downlinkData_, capacity, write, minRead, data, newWrite)) {
+                segment_->downlinkWrite.store(newWrite, std::memory_order_release);
+                publish(segment_->downlinkWake);
+                return true;
+            }
+
+            // 环满时回收已退出的订阅者后重试一次
+            reapDeadSubscribers();
+        }
+
+        lastError_ = "Downlink ring full";
+        emitTransportError(lastError_);
+        return false;
+    }
+
+    SubscriberSlot& slot = segment_->subscriberSlots[slotIndex_];
+    uchar* ring = uplinkData_ + static_cast<size_t>(slotIndex_) * capacity;
+    uint64_t write = slot.uplinkWrite.load(std::memory_order_relaxed);
+    uint64_t read = slot.uplinkRead.load(std::memory_order_acquire);
+    uint64_t newWrite = 0;
+
+    if (!ringWrite(ring, capacity, write, read, data, newWrite)) {
+        lastError_ = "Uplink ring full";
+        emitTransportError(lastError_);
+        return false;
+    }
+
+    slot.uplinkWrite.store(newWrite, std::memory_order_release);
+    publish(segment_->uplinkWake);
+    return true;
+}
+
+QString SharedMemoryTransport::description() const
+{
+    QString roleName = (role_ == Role::Owner) ? "owner" : QString("subscriber #%1").arg(slotIndex_);
+    return QString("SHM: /%1 (%2)").arg(name_, roleName);
+}
+
+QString SharedMemoryTransport::transportType() const
+{
+    return "SharedMemory";
+}
+
+int SharedMemoryTransport::activeSubscriberCount() const
+{
+    if (!segment_) {
+        return 0;
+    }
+
+    int count = 0;
+    for (int i = 0; i < MAX_SUBSCRIBERS; ++i) {
+        if (segment_->subscriberSlots[i].state.load(std::memory_order_acquire) == SLOT_ACTIVE) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+QString SharedMemoryTransport::lastErrorString() const
+{
+    return lastError_;
+}
+
+void SharedMemoryTransport::handleWakeup()
+{
+    uint64_t counter = 0;
+    while (::read(eventFd_, &counter, sizeof(counter)) < 0 && errno == EINTR) {
+    }
+
+    if (!segment_) {
+        return;
+    }
+
+    if (role_ == Role::Subscriber && segment_->ready.load(std::memory_order_acquire) == 0) {
+        drainIncoming();
+        handleSegmentFailure("Shared memory owner closed the segment");
+        return;
+    }
+
+    drainIncoming();
+}
+
+bool SharedMemoryTransport::createSegment()
+{
+    QByteArray shmName = "/" + name_.toLocal8Bit();
+    const size_t capacity = static_cast<size_t>(ringCapacity_);
+    const size_t size = sizeof(Segment) + capacity * (1 + MAX_SUBSCRIBERS);
+
+    shmFd_ = ::shm_open(shmName.constData(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+    if (shmFd_ < 0 && errno == EEXIST) {
+        // 上次异常退出残留的段
+        qWarning() << "Removing stale shared memory segment:" << shmName;
+        ::shm_unlink(shmName.constData());
+        shmFd_ = ::shm_open(shmName.constData(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+    }
+    if (shmFd_ < 0) {
+        lastError_ = QString("shm_open failed: %1").arg(QString::fromLocal8Bit(strerror(errno)));
+        return false;
+    }
+
+    if (::ftruncate(shmFd_, static_cast<off_t>(size)) < 0) {
+        lastError_ = QString("ftruncate failed: %1").arg(QString::fromLocal8Bit(strerror(errno)));
+        ::shm_unlink(shmName.constData());
+        return false;
+    }
+
+    if (!mapSegment(size)) {
+        ::shm_unlink(shmName.constData());
+        return false;
+    }
+
+    segment_ = new (mapping_) Segment();
+    segment_->magic = SEGMENT_MAGIC;
+    segment_->version = SEGMENT_LAYOUT_VERSION;
+    segment_->ringCapacity = static_cast<uint32_t>(capacity);
+    segment_->maxSubscribers = static_cast<uint32_t>(MAX_SUBSCRIBERS);
+    segment_->ownerPid.store(static_cast<int32_t>(::getpid()), std::memory_order_relaxed);
+
+    uchar* base = static_cast<uchar*>(mapping_);
+    downlinkData_ = base + sizeof(Segment);
+    uplinkData_ = downlinkData_ + capacity;
+
+    segment_->ready.store(1, std::memory_order_release);
+    return true;
+}
+
+bool SharedMemoryTransport::attachSegment()
+{
+    QByteArray shmName = "/" + name_.toLocal8Bit();
+
+    shmFd_ = ::shm_open(shmName.constData(), O_RDWR | O_CLOEXEC, 0);
+    if (shmFd_ < 0) {
+        lastError_ = QString("shm_open failed: %1").arg(QString::fromLocal8Bit(strerror(errno)));
+        return false;
+    }
+
+    struct stat info;
+    if (::fstat(shmFd_, &info) < 0 || static_cast<size_t>(info.st_size) < sizeof(Segment)) {
+        lastError_ = "Shared memory segment is too small";
+        return false;
+    }
+
+    if (!mapSegment(static_cast<size_t>(info.st_size))) {
+        return false;
+    }
+
+    Segment* segment = static_cast<Segment*>(mapping_);
+    if (segment->magic != SEGMENT_MAGIC || segment->version != SEGMENT_LAYOUT_VERSION ||
+        segment->maxSubscribers != static_cast<uint32_t>(MAX_SUBSCRIBERS) ||
+        segment->ready.load(std::memory_order_acquire) == 0) {
+        lastError_ = "Shared memory segment is not ready or has incompatible layout";
+        return false;
+    }
+
+    const size_t capacity = segment->ringCapacity;
+    if (static_cast<size_t>(info.st_size) != sizeof(Segment) + capacity * (1 + MAX_SUBSCRIBERS)) {
+        lastError_ = "Shared memory segment size mismatch";
+        return false;
+    }
+
+    segment_ = segment;
+    uchar* base = static_cast<uchar*>(mapping_);
+    downlinkData_ = base + sizeof(Segment);
+    uplinkData_ = downlinkData_ + capacity;
+
+    if (!claimSubscriberSlot()) {
+        segment_ = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool SharedMemoryTransport::mapSegment(size_t size)
+{
+    void* mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, shmFd_, 0);
+    if (mapping == MAP_FAILED) {
+        lastError_ = QString("mmap failed: %1").arg(QString::fromLocal8Bit(strerror(errno)));
+        return false;
+    }
+
+    mapping_ = mapping;
+    mappingSize_ = size;
+    return true;
+}
+
+void SharedMemoryTransport::unmapSegment()
+{
+    if (mapping_) {
+        ::munmap(mapping_, mappingSize_);
+        mapping_ = nullptr;
+        mappingSize_ = 0;
+    }
+    if (shmFd_ >= 0) {
+        ::close(shmFd_);
+        shmFd_ = -1;
+    }
+    segment_ = nullptr;
+    downlinkData_ = nullptr;
+    uplinkData_ = nullptr;
+}
+
+bool SharedMemoryTransport::claimSubscriberSlot()
+{
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        for (int i = 0; i < MAX_SUBSCRIBERS; ++i) {
+            SubscriberSlot& slot = segment_->subscriberSlots[i];
+            uint32_t expected = SLOT_FREE;
+            if (!slot.state.compare_exchange_strong(expected, SLOT_ATTACHING, std::memory_order_acq_rel)) {
+                continue;
+            }
+
+            // 新订阅者从当前写位置开始接收，不回放历史帧
+            slot.pid.store(static_cast<int32_t>(::getpid()), std::memory_order_relaxed);
+            slot.downlinkRead.store(segment_->downlinkWrite.load(std::memory_order_acquire),
+                                    std::memory_order_relaxed);
+            uint64_t uplink = slot.uplinkWrite.load(std::memory_order_relaxed);
+            slot.uplinkRead.store(uplink, std::memory_order_relaxed);
+            slot.state.store(SLOT_ACTIVE, std::memory_order_release);
+
+            slotIndex_ = i;
+            return true;
+        }
+
+        reapDeadSubscribers();
+    }
+
+    lastError_ = QString("No free subscriber slot (max %1)").arg(MAX_SUBSCRIBERS);
+    return false;
+}
+
+void SharedMemoryTransport::reapDeadSubscribers()
+{
+    for (int i = 0; i < MAX_SUBSCRIBERS; ++i) {
+        SubscriberSlot& slot = segment_->subscriberSlots[i];
+        if (slot.state.load(std::memory_order_acquire) != SLOT_ACTIVE) {
+            continue;
+        }
+
+        int32_t pid = slot.pid.load(std::memory_order_relaxed);
+        if (!processAlive(pid)) {
+            uint32_t expected = SLOT_ACTIVE;
+            if (slot.state.compare_exchange_strong(expected, SLOT_FREE, std::memory_order_acq_rel)) {
+                qWarning() << "Reclaimed shared memory slot" << i << "of dead subscriber pid" << pid;
+            }
+        }
+    }
+}
+
+void SharedMemoryTransport::drainIncoming()
+{
+    const uint32_t capacity = segment_->ringCapacity;
+    auto emitFrame = [this](const char* frame, int length) {
+        deliverReceived(frame, length);
+        return segment_ != nullptr;
+    };
+
+    if (role_ == Role::Subscriber) {
+        SubscriberSlot& slot = segment_->subscriberSlots[slotIndex_];
+        uint64_t read = slot.downlinkRead.load(std::memory_order_relaxed);
+        uint64_t write = segment_->downlinkWrite.load(std::memory_order_acquire);
+
+        if (write - read > capacity) {
+            // 附加期间被Owner覆盖，跳到最新位置
+            qWarning() << "Shared memory subscriber overrun, skipped" << (write - read) << "bytes";
+            read = write;
+        }
+
+        read = ringDrain(downlinkData_, capacity, read, write, emitFrame);
+        if (segment_) {
+            slot.downlinkRead.store(read, std::memory_order_release);
+        }
+        return;
+    }
+
+    for (int i = 0; i < MAX_SUBSCRIBERS && segment_; ++i) {
+        SubscriberSlot& slot = segment_->subscriberSlots[i];
+        if (slot.state.load(std::memory_order_acquire) != SLOT_ACTIVE) {
+            continue;
+        }
+
+        const uchar* ring = uplinkData_ + static_cast<size_t>(i) * capacity;
+        uint64_t read = slot.uplinkRead.load(std::memory_order_relaxed);
+        uint64_t write = slot.uplinkWrite.load(std::memory_order_acquire);
+        read = ringDrain(ring, capacity, read, write, emitFrame);
+        if (segment_) {
+            slot.uplinkRead.store(read, std::memory_order_release);
+        }
+    }
+}
+
+void SharedMemoryTransport::startWaiter()
+{
+    stopWaiter_.store(false, std::memory_order_release);
+    waiterThread_ = std::thread(&SharedMemoryTransport::waiterLoop, this);
+}
+
+void SharedMemoryTransport::stopWaiter()
+{
+    if (!waiterThread_.joinable()) {
+        return;
+    }
+
+    stopWaiter_.store(true, std::memory_order_release);
+    WakeWord& wake = (role_ == Role::Owner) ? segment_->uplinkWake : segment_->downlinkWake;
+    wake.sequence.fetch_add(1, std::memory_order_seq_cst);
+    futexWake(&wake.sequence);
+    waiterThread_.join();
+}
+
+void SharedMemoryTransport::waiterLoop()
+{
+    WakeWord& wake = (role_ == Role::Owner) ? segment_->uplinkWake : segment_->downlinkWake;
+    uint32_t lastSeen = wake.sequence.load(std::memory_order_acquire);
+    const uint64_t one = 1;
+    bool timedOut = false;
+
+    while (!stopWaiter_.load(std::memory_order_acquire)) {
+        uint32_t sequence = wake.sequence.load(std::memory_order_acquire);
+
+        // Owner异常退出时不会清除ready，订阅者在空闲超时时检查其进程是否存在
+        if (role_ == Role::Subscriber && timedOut &&
+            !processAlive(segment_->ownerPid.load(std::memory_order_relaxed))) {
+            segment_->ready.store(0, std::memory_order_release);
+        }
+
+        bool ownerGone = (role_ == Role::Subscriber) &&
+                         segment_->ready.load(std::memory_order_acquire) == 0;
+
+        if (sequence != lastSeen || ownerGone) {
+            lastSeen = sequence;
+            ssize_t ignored = ::write(eventFd_, &one, sizeof(one));
+            Q_UNUSED(ignored);
+        }
+
+        wake.waiters.fetch_add(1, std::memory_order_seq_cst);
+        timedOut = futexWait(&wake.sequence, sequence, WAIT_TIMEOUT_MS) < 0 && errno == ETIMEDOUT;
+        wake.waiters.fetch_sub(1, std::memory_order_seq_cst);
+    }
+}
+
+void SharedMemoryTransport::handleSegmentFailure(const QString& error)
+{
+    lastError_ = error;
+    qWarning() << "Shared memory transport error:" << error;
+    emitTransportError(error);
+    close();
+}
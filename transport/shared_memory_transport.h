@@ -0,0 +1,138 @@
+#ifndef SHARED_MEMORY_TRANSPORT_H
+#define SHARED_MEMORY_TRANSPORT_H
+
+#include "itransport.h"
+#include <QScopedPointer>
+#include <QSocketNotifier>
+#include <atomic>
+#include <thread>
+
+/**
+ * @brief 共享内存传输实现（同机进程间通信）
+ *
+ * 基于POSIX共享内存的环形缓冲区对，用于同一主机上协议守护进程与标定界面进程之间交换帧：
+ * - Owner（守护进程）创建共享内存段，发送的帧广播给所有订阅者
+ * - Subscriber（界面进程）附加到已存在的段，每个订阅者拥有独立的读游标和上行SPSC环
+ * - 帧直接写入共享内存，跨进程不经过内核拷贝
+ * - 跨进程唤醒使用futex，仅在对端等待时才发起系统调用
+ * - 等待线程通过eventfd把唤醒转发到Qt事件循环
+ *
+ * 仅支持Linux平台
+ */
+class SharedMemoryTransport : public ITransport
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 共享内存角色
+     */
+    enum class Role {
+        Owner,      // 创建共享内存段，下行广播、上行汇聚
+        Subscriber  // 附加到已有共享内存段
+    };
+
+    explicit SharedMemoryTransport(QObject* parent = nullptr);
+    explicit SharedMemoryTransport(const QString& name, Role role, QObject* parent = nullptr);
+    ~SharedMemoryTransport() override;
+
+    /**
+     * @brief 共享内存配置接口
+     */
+
+    // 设置共享内存名称（不含前导'/'）
+    void setName(const QString& name);
+    QString name() const;
+
+    // 设置角色
+    void setRole(Role role);
+    Role role() const;
+
+    // 单个环形缓冲区容量（字节，需为2的幂，仅Owner有效）
+    void setRingCapacity(int bytes);
+    int ringCapacity() const;
+
+    // 单帧最大长度
+    int maxFrameSize() const;
+
+    /**
+     * @brief ITransport接口实现
+     */
+    bool open() override;
+    void close() override;
+    bool isOpen() const override;
+    bool send(const QByteArray& data) override;
+    QString description() const override;
+    QString transportType() const override;
+
+    /**
+     * @brief 共享内存特有功能
+     */
+
+    // 当前订阅者槽位索引（仅Subscriber有效，未附加时为-1）
+    int subscriberIndex() const { return slotIndex_; }
+
+    // 活跃订阅者数量
+    int activeSubscriberCount() const;
+
+    // 获取最后错误信息
+    QString lastErrorString() const;
+
+    // 最大订阅者数量
+    static const int MAX_SUBSCRIBERS;
+
+private slots:
+    /**
+     * @brief 内部信号处理
+     */
+    void handleWakeup();
+
+private:
+    struct Segment;
+
+    /**
+     * @brief 私有方法
+     */
+    bool createSegment();
+    bool attachSegment();
+    bool mapSegment(size_t size);
+    void unmapSegment();
+    bool claimSubscriberSlot();
+    void reapDeadSubscribers();
+    void drainIncoming();
+    void startWaiter();
+    void stopWaiter();
+    void waiterLoop();
+    void handleSegmentFailure(const QString& error);
+
+    /**
+     * @brief 成员变量
+     */
+    QString name_;
+    Role role_;
+    int ringCapacity_;
+
+    // 共享内存映射
+    int shmFd_;
+    void* mapping_;
+    size_t mappingSize_;
+    Segment* segment_;
+    uchar* downlinkData_;   // 下行环数据区（Owner写，所有订阅者读）
+    uchar* uplinkData_;     // 上行环数据区起始（每个订阅者一个）
+    int slotIndex_;
+
+    // 唤醒转发
+    int eventFd_;
+    QScopedPointer<QSocketNotifier> eventNotifier_;
+    std::thread waiterThread_;
+    std::atomic<bool> stopWaiter_;
+
+    // 状态信息
+    QString lastError_;
+
+    // 常量
+    static const int DEFAULT_RING_CAPACITY;
+    static const int WAIT_TIMEOUT_MS;
+};
+
+#endif // SHARED_MEMORY_TRANSPORT_H
@@ -0,0 +1,110 @@
+#ifndef SINK_LIST_H
+#define SINK_LIST_H
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 可在分发过程中增删的回调列表
+ *
+ * 回调内部可以注册或注销回调（包括注销自身）：分发期间注销只做标记，
+ * 正在执行的std::function不会被销毁；分发期间注册的回调先放入待加入列表，
+ * 不会使正在遍历的数组重新分配，从下一次分发开始生效。
+ * 最外层分发结束时统一删除已注销的回调并加入新回调。
+ *
+ * 非线程安全，注册、注销和分发须在同一线程进行。
+ */
+template <typename... Args>
+class SinkList
+{
+public:
+    using Callback = std::function<void(Args...)>;
+
+    // 注册回调，返回回调ID
+    int add(Callback callback) {
+        const int id = nextId_++;
+        Entry entry{id, std::move(callback), true};
+        if (dispatchDepth_ > 0) {
+            pending_.push_back(std::move(entry));
+        } else {
+            entries_.push_back(std::move(entry));
+        }
+        return id;
+    }
+
+    // 注销回调（可在回调内部调用）
+    void remove(int id) {
+        for (Entry& entry : entries_) {
+            if (entry.id == id) {
+                entry.active = false;
+            }
+        }
+        for (Entry& entry : pending_) {
+            if (entry.id == id) {
+                entry.active = false;
+            }
+        }
+        if (dispatchDepth_ == 0) {
+            settle();
+        }
+    }
+
+    // 是否存在有效回调
+    bool isEmpty() const {
+        for (const Entry& entry : entries_) {
+            if (entry.active) {
+                return false;
+            }
+        }
+        for (const Entry& entry : pending_) {
+            if (entry.active) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 依次调用分发开始时已注册且未注销的回调
+    void dispatch(Args... args) {
+        ++dispatchDepth_;
+        const size_t count = entries_.size();
+        for (size_t i = 0; i < count; ++i) {
+            if (entries_[i].active) {
+                entries_[i].callback(args...);
+            }
+        }
+        if (--dispatchDepth_ == 0) {
+            settle();
+        }
+    }
+
+private:
+    struct Entry {
+        int id;
+        Callback callback;
+        bool active;
+    };
+
+    // 删除已注销的回调，加入分发期间注册的回调（仅在没有分发进行时调用）
+    void settle() {
+        entries_.erase(std::remove_if(entries_.begin(), entries_.end(),
+                                      [](const Entry& entry) { return !entry.active; }),
+                       entries_.end());
+
+        for (Entry& entry : pending_) {
+            if (entry.active) {
+                entries_.push_back(std::move(entry));
+            }
+        }
+        pending_.clear();
+    }
+
+    std::vector<Entry> entries_;
+    std::vector<Entry> pending_;    // 分发期间注册、尚未加入的回调
+    int nextId_ = 1;
+    int dispatchDepth_ = 0;
+};
+
+#endif // SINK_LIST_H
@@ -0,0 +1,477 @@
+#include "tcp_transport.h"
+#include <QDebug>
+#include <QTimer>
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// 常量定义
+const int TcpTransport::DEFAULT_CONNECT_TIMEOUT_MS = 3000;
+const int TcpTransport::DEFAULT_MAX_PENDING_BYTES = 1024 * 1024;
+const int TcpTransport::READ_CHUNK_SIZE = 64 * 1024;
+const int TcpTransport::MAX_IOV_PER_WRITE = 64;
+
+TcpTransport::TcpTransport(QObject* parent)
+    : ITransport(parent)
+    , socketFd_(-1)
+    , host_()
+    , port_(0)
+    , noDelay_(true)
+    , sendBufferSize_(0)
+    , receiveBufferSize_(0)
+    , writeCoalescing_(true)
+    , connectTimeoutMs_(DEFAULT_CONNECT_TIMEOUT_MS)
+    , maxPendingBytes_(DEFAULT_MAX_PENDING_BYTES)
+    , pendingOffset_(0)
+    , pendingBytes_(0)
+    , flushScheduled_(false)
+{
+}
+
+TcpTransport::TcpTransport(const QString& host, quint16 port, QObject* parent)
+    : TcpTransport(parent)
+{
+    host_ = host;
+    port_ = port;
+}
+
+TcpTransport::~TcpTransport()
+{
+    close();
+}
+
+void TcpTransport::setHost(const QString& host)
+{
+    if (isOpen()) {
+        qWarning() << "Cannot change host while connection is open";
+        return;
+    }
+    host_ = host;
+}
+
+void TcpTransport::setPort(quint16 port)
+{
+    if (isOpen()) {
+        qWarning() << "Cannot change port while connection is open";
+        return;
+    }
+    port_ = port;
+}
+
+QString TcpTransport::host() const
+{
+    return host_;
+}
+
+quint16 TcpTransport::port() const
+{
+    return port_;
+}
+
+void TcpTransport::setNoDelay(bool enable)
+{
+    noDelay_ = enable;
+    if (isOpen()) {
+        applySocketOptions();
+    }
+}
+
+bool TcpTransport::noDelay() const
+{
+    return noDelay_;
+}
+
+void TcpTransport::setSendBufferSize(int bytes)
+{
+    sendBufferSize_ = qMax(0, bytes);
+    if (isOpen()) {
+        applySocketOptions();
+    }
+}
+
+void TcpTransport::setReceiveBufferSize(int bytes)
+{
+    receiveBufferSize_ = qMax(0, bytes);
+    if (isOpen()) {
+        applySocketOptions();
+    }
+}
+
+int TcpTransport::sendBufferSize() const
+{
+    return sendBufferSize_;
+}
+
+int TcpTransport::receiveBufferSize() const
+{
+    return receiveBufferSize_;
+}
+
+void TcpTransport::setWriteCoalescing(bool enable)
+{
+    writeCoalescing_ = enable;
+}
+
+bool TcpTransport::writeCoalescing() const
+{
+    return writeCoalescing_;
+}
+
+void TcpTransport::setConnectTimeout(int timeoutMs)
+{
+    connectTimeoutMs_ = timeoutMs;
+}
+
+int TcpTransport::connectTimeout() const
+{
+    return connectTimeoutMs_;
+}
+
+void TcpTransport::setMaxPendingBytes(int bytes)
+{
+    maxPendingBytes_ = bytes;
+}
+
+int TcpTransport::maxPendingBytes() const
+{
+    return maxPendingBytes_;
+}
+
+bool TcpTransport::open()
+{
+    if (isOpen()) {
+        qDebug() << "TCP connection already open:" << description();
+        return true;
+    }
+
+    if (host_.isEmpty() || port_ == 0) {
+        lastError_ = "Host or port is not configured";
+        emitTransportError(lastError_);
+        return false;
+    }
+
+    if (!connectSocket()) {
+        qWarning() << "Failed to connect TCP transport:" << description() << "-" << lastError_;
+        emitTransportError(QString("Failed to connect: %1").arg(lastError_));
+        return false;
+    }
+
+    readBuffer_.resize(READ_CHUNK_SIZE);
+
+    readNotifier_.reset(new QSocketNotifier(socketFd_, QSocketNotifier::Read, this));
+    connect(readNotifier_.data(), &QSocketNotifier::activated, this, &TcpTransport::handleReadyRead);
+
+    writeNotifier_.reset(new QSocketNotifier(socketFd_, QSocketNotifier::Write, this));
+    writeNotifier_->setEnabled(false);
+    connect(writeNotifier_.data(), &QSocketNotifier::activated, this, &TcpTransport::handleReadyWrite);
+
+    lastError_.clear();
+    qDebug() << "TCP connection opened:" << description() << "nodelay:" << noDelay_;
+    emitConnectionStatusChanged(true);
+    return true;
+}
+
+void TcpTransport::close()
+{
+    if (socketFd_ < 0) {
+        return;
+    }
+
+    readNotifier_.reset();
+    writeNotifier_.reset();
+
+    ::close(socketFd_);
+    socketFd_ = -1;
+
+    pendingFrames_.clear();
+    pendingOffset_ = 0;
+    pendingBytes_ = 0;
+    flushScheduled_ = false;
+
+    qDebug() << "TCP connection closed:" << description();
+    emitConnectionStatusChanged(false);
+}
+
+bool TcpTransport::isOpen() const
+{
+    return socketFd_ >= 0;
+}
+
+bool TcpTransport::send(const QByteArray& data)
+{
+    if (!isOpen()) {
+        lastError_ = "TCP connection is not open";
+        emitTransportError(lastError_);
+        return false;
+    }
+
+    if (data.isEmpty()) {
+        return true;
+    }
+
+    if (pendingBytes_ + data.size() > maxPendingBytes_) {
+        lastError_ = QString("Send queue full: %1 bytes pending").arg(pendingBytes_);
+        emitTransportError(lastError_);
+        return false;
+    }
+
+    pendingFrames_.enqueue(data);
+    pendingBytes_ += data.size();
+
+    // 写通知已启用说明内核缓冲区已满，等待可写后继续
+    if (writeNotifier_ && writeNotifier_->isEnabled()) {
+        return true;
+    }
+
+    if (writeCoalescing_) {
+        scheduleFlush();
+        return true;
+    }
+
+    return writePending();
+}
+
+QString TcpTransport::description() const
+{
+    return QString("TCP: %1:%2").arg(host_).arg(port_);
+}
+
+QString TcpTransport::transportType() const
+{
+    return "TCP";
+}
+
+bool TcpTransport::flush()
+{
+    flushScheduled_ = false;
+    if (!isOpen()) {
+        return false;
+    }
+    return writePending();
+}
+
+QString TcpTransport::lastErrorString() const
+{
+    return lastError_;
+}
+
+void TcpTransport::handleReadyRead()
+{
+    if (!isOpen()) {
+        return;
+    }
+
+    // 一次性读空内核缓冲区，减少事件循环往返
+    for (;;) {
+        ssize_t n = ::recv(socketFd_, readBuffer_.data(), readBuffer_.size(), 0);
+        if (n > 0) {
+            // 直接借出读缓冲区，回调保留租约时下次recv会自动分离
+            deliverReceived(readBuffer_.constData(), static_cast<int>(n), &readBuffer_);
+            if (!isOpen()) {
+                return; // 回调中关闭了传输
+            }
+            if (n < readBuffer_.size()) {
+                break;
+            }
+            continue;
+        }
+
+        if (n == 0) {
+            handleSocketFailure("Connection closed by peer");
+            return;
+        }
+
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        }
+
+        handleSocketFailure(QString("Read error: %1").arg(QString::fromLocal8Bit(strerror(errno))));
+        return;
+    }
+}
+
+void TcpTransport::handleReadyWrite()
+{
+    writePending();
+}
+
+bool TcpTransport::connectSocket()
+{
+    struct addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo* results = nullptr;
+    QByteArray hostName = host_.toLocal8Bit();
+    QByteArray portName = QByteArray::number(port_);
+    int rc = ::getaddrinfo(hostName.constData(), portName.constData(), &hints, &results);
+    if (rc != 0) {
+        lastError_ = QString("Cannot resolve host: %1").arg(QString::fromLocal8Bit(gai_strerror(rc)));
+        return false;
+    }
+
+    for (struct addrinfo* ai = results; ai != nullptr; ai = ai->ai_next) {
+        int fd = ::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) {
+            lastError_ = QString::fromLocal8Bit(strerror(errno));
+            continue;
+        }
+
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+        // 缓冲区大小需在connect之前设置才能影响窗口协商
+        socketFd_ = fd;
+        applySocketOptions();
+
+        rc = ::connect(fd, ai->ai_addr, ai->ai_addrlen);
+        if (rc < 0 && errno == EINPROGRESS) {
+            struct pollfd pfd;
+            pfd.fd = fd;
+            pfd.events = POLLOUT;
+            pfd.revents = 0;
+            rc = ::poll(&pfd, 1, connectTimeoutMs_);
+            if (rc == 1) {
+                int soError = 0;
+                socklen_t len = sizeof(soError);
+                ::getsockopt(fd, SOL_SOCKET, SO_ERROR, &soError, &len);
+                rc = soError == 0 ? 0 : -1;
+                errno = soError;
+            } else {
+                if (rc == 0) {
+                    errno = ETIMEDOUT;
+                }
+                rc = -1;
+            }
+        }
+
+        if (rc == 0) {
+            ::freeaddrinfo(results);
+            return true;
+        }
+
+        lastError_ = QString::fromLocal8Bit(strerror(errno ? errno : ETIMEDOUT));
+        ::close(fd);
+        socketFd_ = -1;
+    }
+
+    ::freeaddrinfo(results);
+    return false;
+}
+
+void TcpTransport::applySocketOptions()
+{
+    if (socketFd_ < 0) {
+        return;
+    }
+
+    int flag = noDelay_ ? 1 : 0;
+    if (::setsockopt(socketFd_, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag)) < 0) {
+        qWarning() << "Failed to set TCP_NODELAY:" << strerror(errno);
+    }
+
+    if (sendBufferSize_ > 0 &&
+        ::setsockopt(socketFd_, SOL_SOCKET, SO_SNDBUF, &sendBufferSize_, sizeof(sendBufferSize_)) < 0) {
+        qWarning() << "Failed to set SO_SNDBUF:" << strerror(errno);
+    }
+
+    if (receiveBufferSize_ > 0 &&
+        ::setsockopt(socketFd_, SOL_SOCKET, SO_RCVBUF, &receiveBufferSize_, sizeof(receiveBufferSize_)) < 0) {
+        qWarning() << "Failed to set SO_RCVBUF:" << strerror(errno);
+    }
+
+#ifdef SO_NOSIGPIPE
+    int noSigPipe = 1;
+    ::setsockopt(socketFd_, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+#endif
+}
+
+void TcpTransport::scheduleFlush()
+{
+    if (flushScheduled_) {
+        return;
+    }
+    flushScheduled_ = true;
+    QTimer::singleShot(0, this, [this]() { flush(); });
+}
+
+bool TcpTransport::writePending()
+{
+    while (!pendingFrames_.isEmpty()) {
+        // 将队列中的帧聚合为iovec，一次系统调用发送
+        struct iovec iov[MAX_IOV_PER_WRITE];
+        int iovCount = 0;
+        for (int i = 0; i < pendingFrames_.size() && iovCount < MAX_IOV_PER_WRITE; ++i) {
+            const QByteArray& frame = pendingFrames_.at(i);
+            int offset = (i == 0) ? pendingOffset_ : 0;
+            iov[iovCount].iov_base = const_cast<char*>(frame.constData() + offset);
+            iov[iovCount].iov_len = static_cast<size_t>(frame.size() - offset);
+            ++iovCount;
+        }
+
+        struct msghdr msg;
+        std::memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iovCount;
+
+        int sendFlags = 0;
+#ifdef MSG_NOSIGNAL
+        sendFlags |= MSG_NOSIGNAL;
+#endif
+        ssize_t written = ::sendmsg(socketFd_, &msg, sendFlags);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // 内核缓冲区已满，等待可写通知
+                if (writeNotifier_) {
+                    writeNotifier_->setEnabled(true);
+                }
+                return true;
+            }
+            handleSocketFailure(QString("Write error: %1").arg(QString::fromLocal8Bit(strerror(errno))));
+            return false;
+        }
+
+        // 根据实际写入字节数出队
+        pendingBytes_ -= static_cast<int>(written);
+        ssize_t remaining = written;
+        while (remaining > 0 && !pendingFrames_.isEmpty()) {
+            int frameLeft = pendingFrames_.head().size() - pendingOffset_;
+            if (remaining >= frameLeft) {
+                remaining -= frameLeft;
+                pendingFrames_.dequeue();
+                pendingOffset_ = 0;
+            } else {
+                pendingOffset_ += static_cast<int>(remaining);
+                remaining = 0;
+            }
+        }
+    }
+
+    if (writeNotifier_) {
+        writeNotifier_->setEnabled(false);
+    }
+    return true;
+}
+
+void TcpTransport::handleSocketFailure(const QString& error)
+{
+    lastError_ = error;
+    qWarning() << "TCP transport error:" << error;
+    emitTransportError(error);
+    close();
+}
@@ -0,0 +1,137 @@
+#ifndef TCP_TRANSPORT_H
+#define TCP_TRANSPORT_H
+
+#include "itransport.h"
+#include <QQueue>
+#include <QScopedPointer>
+#include <QSocketNotifier>
+
+/**
+ * @brief TCP传输实现（低延迟）
+ *
+ * 基于原生BSD socket + QSocketNotifier实现，主要用于经串口转以太网桥访问DSP：
+ * - 默认启用TCP_NODELAY，关闭Nagle算法
+ * - 可配置内核收发缓冲区大小（SO_SNDBUF/SO_RCVBUF）
+ * - 同一事件循环周期内排队的帧合并为一次writev发送
+ * - 非阻塞读写，发送缓冲区满时由写通知继续发送
+ *
+ * 仅支持类Unix平台（Linux/macOS）
+ */
+class TcpTransport : public ITransport
+{
+    Q_OBJECT
+
+public:
+    explicit TcpTransport(QObject* parent = nullptr);
+    explicit TcpTransport(const QString& host, quint16 port, QObject* parent = nullptr);
+    ~TcpTransport() override;
+
+    /**
+     * @brief TCP配置接口
+     */
+
+    // 设置远端地址
+    void setHost(const QString& host);
+    void setPort(quint16 port);
+    QString host() const;
+    quint16 port() const;
+
+    // TCP_NODELAY（默认开启）
+    void setNoDelay(bool enable);
+    bool noDelay() const;
+
+    // 内核发送/接收缓冲区大小（字节，0表示使用系统默认值）
+    void setSendBufferSize(int bytes);
+    void setReceiveBufferSize(int bytes);
+    int sendBufferSize() const;
+    int receiveBufferSize() const;
+
+    // 启用/禁用发送合并（开启时send()仅入队，在事件循环返回时统一writev）
+    void setWriteCoalescing(bool enable);
+    bool writeCoalescing() const;
+
+    // 连接超时时间
+    void setConnectTimeout(int timeoutMs);
+    int connectTimeout() const;
+
+    // 发送队列上限（字节），超过时send()返回失败
+    void setMaxPendingBytes(int bytes);
+    int maxPendingBytes() const;
+
+    /**
+     * @brief ITransport接口实现
+     */
+    bool open() override;
+    void close() override;
+    bool isOpen() const override;
+    bool send(const QByteArray& data) override;
+    QString description() const override;
+    QString transportType() const override;
+
+    /**
+     * @brief TCP特有功能
+     */
+
+    // 立即发送队列中所有数据
+    bool flush();
+
+    // 获取待发送字节数
+    int pendingBytes() const { return pendingBytes_; }
+
+    // 获取最后错误信息
+    QString lastErrorString() const;
+
+private slots:
+    /**
+     * @brief 内部信号处理
+     */
+    void handleReadyRead();
+    void handleReadyWrite();
+
+private:
+    /**
+     * @brief 私有方法
+     */
+    bool connectSocket();
+    void applySocketOptions();
+    void scheduleFlush();
+    bool writePending();
+    void handleSocketFailure(const QString& error);
+
+    /**
+     * @brief 成员变量
+     */
+    int socketFd_;                                  // socket文件描述符
+    QScopedPointer<QSocketNotifier> readNotifier_;  // 可读通知
+    QScopedPointer<QSocketNotifier> writeNotifier_; // 可写通知
+
+    // 连接配置
+    QString host_;
+    quint16 port_;
+    bool noDelay_;
+    int sendBufferSize_;
+    int receiveBufferSize_;
+    bool writeCoalescing_;
+    int connectTimeoutMs_;
+    int maxPendingBytes_;
+
+    // 发送队列
+    QQueue<QByteArray> pendingFrames_;  // 待发送帧
+    int pendingOffset_;                 // 队首帧已发送的字节数
+    int pendingBytes_;                  // 队列中未发送的总字节数
+    bool flushScheduled_;               // 是否已安排合并发送
+
+    // 接收缓冲
+    QByteArray readBuffer_;
+
+    // 状态信息
+    QString lastError_;
+
+    // 常量
+    static const int DEFAULT_CONNECT_TIMEOUT_MS;
+    static const int DEFAULT_MAX_PENDING_BYTES;
+    static const int READ_CHUNK_SIZE;
+    static const int MAX_IOV_PER_WRITE;
+};
+
+#endif // TCP_TRANSPORT_H
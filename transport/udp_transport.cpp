@@ -0,0 +1,551 @@
+#include "udp_transport.h"
+#include <QDebug>
+#include <QTimer>
+
+#include <cerrno>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace {
+
+// connect()过的UDP socket收到ICMP不可达后，下一次收发返回这些错误；
+// 对端暂时未监听等情况只影响已发出的数据报，socket仍然可用
+bool isTransientUnreachable(int error)
+{
+    return error == ECONNREFUSED || error == EHOSTUNREACH || error == ENETUNREACH;
+}
+
+} // namespace
+
+// 常量定义
+const int UdpTransport::DEFAULT_BATCH_SIZE = 32;
+const int UdpTransport::DEFAULT_MAX_DATAGRAM_SIZE = 2048;
+const int UdpTransport::MAX_PENDING_DATAGRAMS = 4096;
+
+UdpTransport::UdpTransport(QObject* parent)
+    : ITransport(parent)
+    , socketFd_(-1)
+    , remoteHost_()
+    , remotePort_(0)
+    , localPort_(0)
+    , sendBufferSize_(0)
+    , receiveBufferSize_(0)
+    , batchSize_(DEFAULT_BATCH_SIZE)
+    , maxDatagramSize_(DEFAULT_MAX_DATAGRAM_SIZE)
+    , writeCoalescing_(true)
+    , flushScheduled_(false)
+{
+}
+
+UdpTransport::UdpTransport(const QString& remoteHost, quint16 remotePort, quint16 localPort, QObject* parent)
+    : UdpTransport(parent)
+{
+    remoteHost_ = remoteHost;
+    remotePort_ = remotePort;
+    localPort_ = localPort;
+}
+
+UdpTransport::~UdpTransport()
+{
+    close();
+}
+
+void UdpTransport::setRemoteHost(const QString& host)
+{
+    if (isOpen()) {
+        qWarning() << "Cannot change remote host while socket is open";
+        return;
+    }
+    remoteHost_ = host;
+}
+
+void UdpTransport::setRemotePort(quint16 port)
+{
+    if (isOpen()) {
+        qWarning() << "Cannot change remote port while socket is open";
+        return;
+    }
+    remotePort_ = port;
+}
+
+QString UdpTransport::remoteHost() const
+{
+    return remoteHost_;
+}
+
+quint16 UdpTransport::remotePort() const
+{
+    return remotePort_;
+}
+
+void UdpTransport::setLocalPort(quint16 port)
+{
+    if (isOpen()) {
+        qWarning() << "Cannot change local port while socket is open";
+        return;
+    }
+    localPort_ = port;
+}
+
+quint16 UdpTransport::localPort() const
+{
+    return localPort_;
+}
+
+void UdpTransport::setSendBufferSize(int bytes)
+{
+    sendBufferSize_ = qMax(0, bytes);
+    if (isOpen()) {
+        applySocketOptions();
+    }
+}
+
+void UdpTransport::setReceiveBufferSize(int bytes)
+{
+    receiveBufferSize_ = qMax(0, bytes);
+    if (isOpen()) {
+        applySocketOptions();
+    }
+}
+
+int UdpTransport::sendBufferSize() const
+{
+    return sendBufferSize_;
+}
+
+int UdpTransport::receiveBufferSize() const
+{
+    return receiveBufferSize_;
+}
+
+void UdpTransport::setBatchSize(int datagrams)
+{
+    if (isOpen()) {
+        qWarning() << "Cannot change batch size while socket is open";
+        return;
+    }
+    batchSize_ = qBound(1, datagrams, 1024);
+}
+
+int UdpTransport::batchSize() const
+{
+    return batchSize_;
+}
+
+void UdpTransport::setMaxDatagramSize(int bytes)
+{
+    if (isOpen()) {
+        qWarning() << "Cannot change datagram size while socket is open";
+        return;
+    }
+    maxDatagramSize_ = qBound(64, bytes, 65507);
+}
+
+int UdpTransport::maxDatagramSize() const
+{
+    return maxDatagramSize_;
+}
+
+void UdpTransport::setWriteCoalescing(bool enable)
+{
+    writeCoalescing_ = enable;
+}
+
+bool UdpTransport::writeCoalescing() const
+{
+    return writeCoalescing_;
+}
+
+bool UdpTransport::open()
+{
+    if (isOpen()) {
+        qDebug() << "UDP socket already open:" << description();
+        return true;
+    }
+
+    if (remoteHost_.isEmpty() || remotePort_ == 0) {
+        lastError_ = "Remote host or port is not configured";
+        emitTransportError(lastError_);
+        return false;
+    }
+
+    if (!createSocket()) {
+        qWarning() << "Failed to open UDP transport:" << description() << "-" << lastError_;
+        emitTransportError(QString("Failed to open UDP socket: %1").arg(lastError_));
+        return false;
+    }
+
+    readBuffer_.resize(batchSize_ * maxDatagramSize_);
+
+    readNotifier_.reset(new QSocketNotifier(socketFd_, QSocketNotifier::Read, this));
+    connect(readNotifier_.data(), &QSocketNotifier::activated, this, &UdpTransport::handleReadyRead);
+
+    writeNotifier_.reset(new QSocketNotifier(socketFd_, QSocketNotifier::Write, this));
+    writeNotifier_->setEnabled(false);
+    connect(writeNotifier_.data(), &QSocketNotifier::activated, this, &UdpTransport::handleReadyWrite);
+
+    lastError_.clear();
+    qDebug() << "UDP socket opened:" << description() << "batch:" << batchSize_;
+    emitConnectionStatusChanged(true);
+    return true;
+}
+
+void UdpTransport::close()
+{
+    if (socketFd_ < 0) {
+        return;
+    }
+
+    readNotifier_.reset();
+    writeNotifier_.reset();
+
+    ::close(socketFd_);
+    socketFd_ = -1;
+
+    pendingDatagrams_.clear();
+    flushScheduled_ = false;
+
+    qDebug() << "UDP socket closed:" << description();
+    emitConnectionStatusChanged(false);
+}
+
+bool UdpTransport::isOpen() const
+{
+    return socketFd_ >= 0;
+}
+
+bool UdpTransport::send(const QByteArray& data)
+{
+    if (!isOpen()) {
+        lastError_ = "UDP socket is not open";
+        emitTransportError(lastError_);
+        return false;
+    }
+
+    if (data.isEmpty()) {
+        return true;
+    }
+
+    if (data.size() > maxDatagramSize_) {
+        lastError_ = QString("Datagram too large: %1 > %2 bytes").arg(data.size()).arg(maxDatagramSize_);
+        emitTransportError(lastError_);
+        return false;
+    }
+
+    if (pendingDatagrams_.size() >= MAX_PENDING_DATAGRAMS) {
+        lastError_ = "Send queue full";
+        emitTransportError(lastError_);
+        return false;
+    }
+
+    pendingDatagrams_.enqueue(data);
+
+    if (writeNotifier_ && writeNotifier_->isEnabled()) {
+        return true;
+    }
+
+    if (writeCoalescing_) {
+        scheduleFlush();
+        return true;
+    }
+
+    return writePending();
+}
+
+QString UdpTransport::description() const
+{
+    return QString("UDP: %1:%2 (local port %3)").arg(remoteHost_).arg(remotePort_).arg(localPort_);
+}
+
+QString UdpTransport::transportType() const
+{
+    return "UDP";
+}
+
+bool UdpTransport::flush()
+{
+    flushScheduled_ = false;
+    if (!isOpen()) {
+        return false;
+    }
+    return writePending();
+}
+
+QString UdpTransport::lastErrorString() const
+{
+    return lastError_;
+}
+
+void UdpTransport::handleReadyRead()
+{
+    if (!isOpen()) {
+        return;
+    }
+
+#if defined(Q_OS_LINUX)
+    // 批量接收：每个数据报占用readBuffer_中一个固定大小的槽位
+    std::vector<struct mmsghdr> msgs(batchSize_);
+    std::vector<struct iovec> iovs(batchSize_);
+
+    for (;;) {
+        for (int i = 0; i < batchSize_; ++i) {
+            iovs[i].iov_base = readBuffer_.data() + i * maxDatagramSize_;
+            iovs[i].iov_len = static_cast<size_t>(maxDatagramSize_);
+            std::memset(&msgs[i], 0, sizeof(struct mmsghdr));
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int received = ::recvmmsg(socketFd_, msgs.data(), static_cast<unsigned int>(batchSize_), MSG_DONTWAIT, nullptr);
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (isTransientUnreachable(errno)) {
+                // 读取已清除socket上的错误，继续接收
+                qDebug() << "UDP peer unreachable:" << strerror(errno);
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                handleSocketFailure(QString("Receive error: %1").arg(QString::fromLocal8Bit(strerror(errno))));
+            }
+            return;
+        }
+
+        for (int i = 0; i < received; ++i) {
+            if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+                qWarning() << "UDP datagram truncated, increase maxDatagramSize";
+            }
+            int length = static_cast<int>(msgs[i].msg_len);
+            if (length > 0) {
+                deliverReceived(readBuffer_.constData() + i * maxDatagramSize_, length, &readBuffer_);
+                if (!isOpen()) {
+                    return; // 回调中关闭了传输
+                }
+            }
+        }
+
+        if (received < batchSize_) {
+            return;
+        }
+    }
+#else
+    for (;;) {
+        ssize_t n = ::recv(socketFd_, readBuffer_.data(), static_cast<size_t>(maxDatagramSize_), MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (isTransientUnreachable(errno)) {
+                qDebug() << "UDP peer unreachable:" << strerror(errno);
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                handleSocketFailure(QString("Receive error: %1").arg(QString::fromLocal8Bit(strerror(errno))));
+            }
+            return;
+        }
+        if (n > 0) {
+            deliverReceived(readBuffer_.constData(), static_cast<int>(n), &readBuffer_);
+            if (!isOpen()) {
+                return; // 回调中关闭了传输
+            }
+        }
+    }
+#endif
+}
+
+void UdpTransport::handleReadyWrite()
+{
+    writePending();
+}
+
+bool UdpTransport::createSocket()
+{
+    struct addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    struct addrinfo* results = nullptr;
+    QByteArray hostName = remoteHost_.toLocal8Bit();
+    QByteArray portName = QByteArray::number(remotePort_);
+    int rc = ::getaddrinfo(hostName.constData(), portName.constData(), &hints, &results);
+    if (rc != 0) {
+        lastError_ = QString("Cannot resolve host: %1").arg(QString::fromLocal8Bit(gai_strerror(rc)));
+        return false;
+    }
+
+    for (struct addrinfo* ai = results; ai != nullptr; ai = ai->ai_next) {
+        int fd = ::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) {
+            lastError_ = QString::fromLocal8Bit(strerror(errno));
+            continue;
+        }
+
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+        if (localPort_ != 0) {
+            int reuse = 1;
+            ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+            struct sockaddr_storage local;
+            std::memset(&local, 0, sizeof(local));
+            socklen_t localLen = 0;
+            if (ai->ai_family == AF_INET6) {
+                auto* addr6 = reinterpret_cast<struct sockaddr_in6*>(&local);
+                addr6->sin6_family = AF_INET6;
+                addr6->sin6_addr = in6addr_any;
+                addr6->sin6_port = htons(localPort_);
+                localLen = sizeof(struct sockaddr_in6);
+            } else {
+                auto* addr4 = reinterpret_cast<struct sockaddr_in*>(&local);
+                addr4->sin_family = AF_INET;
+                addr4->sin_addr.s_addr = htonl(INADDR_ANY);
+                addr4->sin_port = htons(localPort_);
+                localLen = sizeof(struct sockaddr_in);
+            }
+
+            if (::bind(fd, reinterpret_cast<struct sockaddr*>(&local), localLen) < 0) {
+                lastError_ = QString("Bind failed: %1").arg(QString::fromLocal8Bit(strerror(errno)));
+                ::close(fd);
+                continue;
+            }
+        }
+
+        // connect()后内核只投递来自该对端的数据报，send()无需指定地址
+        if (::connect(fd, ai->ai_addr, ai->ai_addrlen) < 0) {
+            lastError_ = QString::fromLocal8Bit(strerror(errno));
+            ::close(fd);
+            continue;
+        }
+
+        socketFd_ = fd;
+        applySocketOptions();
+        ::freeaddrinfo(results);
+        return true;
+    }
+
+    ::freeaddrinfo(results);
+    return false;
+}
+
+void UdpTransport::applySocketOptions()
+{
+    if (socketFd_ < 0) {
+        return;
+    }
+
+    if (sendBufferSize_ > 0 &&
+        ::setsockopt(socketFd_, SOL_SOCKET, SO_SNDBUF, &sendBufferSize_, sizeof(sendBufferSize_)) < 0) {
+        qWarning() << "Failed to set SO_SNDBUF:" << strerror(errno);
+    }
+
+    if (receiveBufferSize_ > 0 &&
+        ::setsockopt(socketFd_, SOL_SOCKET, SO_RCVBUF, &receiveBufferSize_, sizeof(receiveBufferSize_)) < 0) {
+        qWarning() << "Failed to set SO_RCVBUF:" << strerror(errno);
+    }
+}
+
+void UdpTransport::scheduleFlush()
+{
+    if (flushScheduled_) {
+        return;
+    }
+    flushScheduled_ = true;
+    QTimer::singleShot(0, this, [this]() { flush(); });
+}
+
+bool UdpTransport::writePending()
+{
+#if defined(Q_OS_LINUX)
+    std::vector<struct mmsghdr> msgs;
+    std::vector<struct iovec> iovs;
+
+    while (!pendingDatagrams_.isEmpty()) {
+        int count = qMin(pendingDatagrams_.size(), batchSize_);
+        msgs.assign(count, mmsghdr());
+        iovs.resize(count);
+
+        for (int i = 0; i < count; ++i) {
+            const QByteArray& datagram = pendingDatagrams_.at(i);
+            iovs[i].iov_base = const_cast<char*>(datagram.constData());
+            iovs[i].iov_len = static_cast<size_t>(datagram.size());
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int sent = ::sendmmsg(socketFd_, msgs.data(), static_cast<unsigned int>(count), MSG_DONTWAIT);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+                if (writeNotifier_) {
+                    writeNotifier_->setEnabled(true);
+                }
+                return true;
+            }
+            if (isTransientUnreachable(errno)) {
+                // 报告的是之前数据报引起的ICMP错误，当前数据报尚未发出，重试
+                qDebug() << "UDP peer unreachable:" << strerror(errno);
+                continue;
+            }
+            // 其他错误仅丢弃当前数据报，不关闭socket
+            lastError_ = QString("Send error: %1").arg(QString::fromLocal8Bit(strerror(errno)));
+            emitTransportError(lastError_);
+            pendingDatagrams_.dequeue();
+            return false;
+        }
+
+        for (int i = 0; i < sent; ++i) {
+            pendingDatagrams_.dequeue();
+        }
+    }
+#else
+    while (!pendingDatagrams_.isEmpty()) {
+        const QByteArray& datagram = pendingDatagrams_.head();
+        ssize_t n = ::send(socketFd_, datagram.constData(), static_cast<size_t>(datagram.size()), MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+                if (writeNotifier_) {
+                    writeNotifier_->setEnabled(true);
+                }
+                return true;
+            }
+            if (isTransientUnreachable(errno)) {
+                qDebug() << "UDP peer unreachable:" << strerror(errno);
+                continue;
+            }
+            lastError_ = QString("Send error: %1").arg(QString::fromLocal8Bit(strerror(errno)));
+            emitTransportError(lastError_);
+            pendingDatagrams_.dequeue();
+            return false;
+        }
+        pendingDatagrams_.dequeue();
+    }
+#endif
+
+    if (writeNotifier_) {
+        writeNotifier_->setEnabled(false);
+    }
+    return true;
+}
+
+void UdpTransport::handleSocketFailure(const QString& error)
+{
+    lastError_ = error;
+    qWarning() << "UDP transport error:" << error;
+    emitTransportError(error);
+    close();
+}
@@ -0,0 +1,132 @@
+#ifndef UDP_TRANSPORT_H
+#define UDP_TRANSPORT_H
+
+#include "itransport.h"
+#include <QQueue>
+#include <QScopedPointer>
+#include <QSocketNotifier>
+
+/**
+ * @brief UDP传输实现（批量收发）
+ *
+ * 基于原生BSD socket + QSocketNotifier实现，每个数据报承载一个或多个协议帧：
+ * - Linux下使用recvmmsg/sendmmsg批量收发，一次系统调用处理多个数据报
+ * - 其他Unix平台退化为逐个recv/send
+ * - socket通过connect()绑定远端地址，仅接收该对端的数据报
+ * - 可配置内核收发缓冲区大小（SO_SNDBUF/SO_RCVBUF）
+ *
+ * 仅支持类Unix平台（Linux/macOS）
+ */
+class UdpTransport : public ITransport
+{
+    Q_OBJECT
+
+public:
+    explicit UdpTransport(QObject* parent = nullptr);
+    explicit UdpTransport(const QString& remoteHost, quint16 remotePort,
+                          quint16 localPort = 0, QObject* parent = nullptr);
+    ~UdpTransport() override;
+
+    /**
+     * @brief UDP配置接口
+     */
+
+    // 设置远端地址
+    void setRemoteHost(const QString& host);
+    void setRemotePort(quint16 port);
+    QString remoteHost() const;
+    quint16 remotePort() const;
+
+    // 设置本地绑定端口（0表示由系统分配）
+    void setLocalPort(quint16 port);
+    quint16 localPort() const;
+
+    // 内核发送/接收缓冲区大小（字节，0表示使用系统默认值）
+    void setSendBufferSize(int bytes);
+    void setReceiveBufferSize(int bytes);
+    int sendBufferSize() const;
+    int receiveBufferSize() const;
+
+    // 每次批量收发的最大数据报数
+    void setBatchSize(int datagrams);
+    int batchSize() const;
+
+    // 单个数据报最大长度
+    void setMaxDatagramSize(int bytes);
+    int maxDatagramSize() const;
+
+    // 启用/禁用发送合并（开启时send()仅入队，在事件循环返回时统一sendmmsg）
+    void setWriteCoalescing(bool enable);
+    bool writeCoalescing() const;
+
+    /**
+     * @brief ITransport接口实现
+     */
+    bool open() override;
+    void close() override;
+    bool isOpen() const override;
+    bool send(const QByteArray& data) override;
+    QString description() const override;
+    QString transportType() const override;
+
+    /**
+     * @brief UDP特有功能
+     */
+
+    // 立即发送队列中所有数据报
+    bool flush();
+
+    // 获取最后错误信息
+    QString lastErrorString() const;
+
+private slots:
+    /**
+     * @brief 内部信号处理
+     */
+    void handleReadyRead();
+    void handleReadyWrite();
+
+private:
+    /**
+     * @brief 私有方法
+     */
+    bool createSocket();
+    void applySocketOptions();
+    void scheduleFlush();
+    bool writePending();
+    void handleSocketFailure(const QString& error);
+
+    /**
+     * @brief 成员变量
+     */
+    int socketFd_;                                  // socket文件描述符
+    QScopedPointer<QSocketNotifier> readNotifier_;  // 可读通知
+    QScopedPointer<QSocketNotifier> writeNotifier_; // 可写通知
+
+    // 连接配置
+    QString remoteHost_;
+    quint16 remotePort_;
+    quint16 localPort_;
+    int sendBufferSize_;
+    int receiveBufferSize_;
+    int batchSize_;
+    int maxDatagramSize_;
+    bool writeCoalescing_;
+
+    // 发送队列（每个元素为一个数据报）
+    QQueue<QByteArray> pendingDatagrams_;
+    bool flushScheduled_;
+
+    // 接收缓冲（batchSize_ * maxDatagramSize_的连续区域）
+    QByteArray readBuffer_;
+
+    // 状态信息
+    QString lastError_;
+
+    // 常量
+    static const int DEFAULT_BATCH_SIZE;
+    static const int DEFAULT_MAX_DATAGRAM_SIZE;
+    static const int MAX_PENDING_DATAGRAMS;
+};
+
+#endif // UDP_TRANSPORT_H